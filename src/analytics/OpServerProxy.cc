@@ -7,6 +7,7 @@
 #include "OpServerProxy.h"
 #include <tbb/mutex.h>
 #include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/assign/list_of.hpp>
 #include "base/util.h"
 #include "base/logging.h"
@@ -24,6 +25,7 @@
 #include <base/connection_info.h>
 #include "redis_connection.h"
 #include "redis_processor_vizd.h"
+#include "redis_uve_coalescer.h"
 #include "viz_sandesh.h"
 #include "viz_collector.h"
 
@@ -124,6 +126,15 @@ class OpServerProxy::OpServerImpl {
                 redis_uve_info.set_conn_cb_failed(to_ops_conn_->CallbackFailed());
                 redis_uve_info.set_conn_cb_succeeded(to_ops_conn_->CallbackSucceeded());
             }
+            if (uve_coalescer_) {
+                redis_uve_info.set_update_coalesced(uve_coalescer_->Coalesced());
+                redis_uve_info.set_update_batches(uve_coalescer_->Batches());
+                redis_uve_info.set_update_batch_cmds(uve_coalescer_->BatchCommands());
+                redis_uve_info.set_update_batch_failed(uve_coalescer_->BatchFailed());
+                redis_uve_info.set_update_queue_depth(uve_coalescer_->QueueDepth());
+                redis_uve_info.set_update_queue_depth_max(uve_coalescer_->QueueDepthMax());
+                redis_uve_info.set_update_coalesce_ratio(uve_coalescer_->CoalesceRatio());
+            }
         }
 
         void ToOpsConnUpPostProcess() {
@@ -187,6 +198,9 @@ class OpServerProxy::OpServerImpl {
                 tbb::mutex::scoped_lock lock(rac_mutex_);
                 redis_uve_.RedisStatusUpdate(RAC_DOWN);
             }
+            // Generators resend the UVEs once Redis is back up
+            if (uve_coalescer_)
+                uve_coalescer_->Clear();
             collector_->RedisUpdate(false);
             // Update connection info
             ConnectionState::GetInstance()->Update(ConnectionType::REDIS,
@@ -297,6 +311,10 @@ class OpServerProxy::OpServerImpl {
             return to_ops_conn_;
         }
 
+        RedisUVECoalescer *uve_coalescer() {
+            return uve_coalescer_.get();
+        }
+
         shared_ptr<RedisAsyncConnection> from_ops_conn() {
             tbb::mutex::scoped_lock lock(rac_mutex_);
             return from_ops_conn_;
@@ -320,6 +338,8 @@ class OpServerProxy::OpServerImpl {
                 "To", ConnectionStatus::INIT, to_ops_conn_->Endpoint(),
                 std::string());
             to_ops_conn_.get()->RAC_Connect();
+            uve_coalescer_.reset(new RedisUVECoalescer(evm_,
+                to_ops_conn_.get()));
             from_ops_conn_.reset(new RedisAsyncConnection(evm_, 
                 redis_uve_ip, redis_uve_port, 
                 boost::bind(&OpServerProxy::OpServerImpl::FromOpsConnUp, this),
@@ -342,6 +362,8 @@ class OpServerProxy::OpServerImpl {
         bool started_;
         shared_ptr<RedisAsyncConnection> to_ops_conn_;
         shared_ptr<RedisAsyncConnection> from_ops_conn_;
+        // Declared after to_ops_conn_, so that it is destroyed first
+        boost::scoped_ptr<RedisUVECoalescer> uve_coalescer_;
         RedisAsyncConnection::ClientAsyncCmdCbFn analytics_cb_proc_fn;
         RedisAsyncConnection::ClientAsyncCmdCbFn processor_cb_proc_fn;
         tbb::mutex rac_mutex_;
@@ -373,8 +395,8 @@ OpServerProxy::UVEUpdate(const std::string &type, const std::string &attr,
         return false;
     }
 
-    bool ret = RedisProcessorExec::UVEUpdate(prac.get(), NULL, type, attr,
-            source, node_type, module, instance_id, key, message, seq, agg, atyp, ts);
+    bool ret = impl_->uve_coalescer()->UVEUpdate(type, attr, source,
+            node_type, module, instance_id, key, message, seq, agg, atyp, ts);
     ret ? impl_->redis_uve_.RedisUveUpdate() : impl_->redis_uve_.RedisUveUpdateFail(); 
     return ret;
 }
@@ -392,6 +414,9 @@ OpServerProxy::UVEDelete(const std::string &type,
         return false;
     }
 
+    // Pending updates to the UVE must reach Redis before the delete
+    impl_->uve_coalescer()->Flush();
+
     bool ret = RedisProcessorExec::UVEDelete(prac.get(), NULL, type, source, 
             node_type, module, instance_id, key, seq);
     ret ? impl_->redis_uve_.RedisUveDelete() : impl_->redis_uve_.RedisUveDeleteFail(); 
@@ -408,6 +433,7 @@ OpServerProxy::GetSeq(const string &source, const string &node_type,
 
     if (!impl_->to_ops_conn()) return false;
 
+    impl_->uve_coalescer()->Flush();
     return RedisProcessorExec::SyncGetSeq(impl_->redis_uve_.GetIp(), 
             impl_->redis_uve_.GetPort(), source, node_type, module, 
             instance_id, seqReply);
@@ -420,6 +446,7 @@ OpServerProxy::DeleteUVEs(const string &source, const string &module,
     shared_ptr<RedisAsyncConnection> prac = impl_->to_ops_conn();
     if  (!(prac && prac->IsConnUp())) return false;
 
+    impl_->uve_coalescer()->Flush();
     return RedisProcessorExec::SyncDeleteUVEs(impl_->redis_uve_.GetIp(), 
             impl_->redis_uve_.GetPort(), source, node_type, 
             module, instance_id);
@@ -318,13 +318,17 @@ void Collector::GetGeneratorStats(vector<SandeshMessageStat> &smslist,
         // DB stats
         vector<GenDb::DbTableInfo> vdbti;
         GenDb::DbErrors dbe;
-        gen->GetDbStats(vdbti, dbe);
+        GenDb::DbBatchStats dbbs;
+        gen->GetDbStats(vdbti, dbe, dbbs);
         vector<GenDb::DbErrors> vdbe;
         vdbe.push_back(dbe);
+        vector<GenDb::DbBatchStats> vdbbs;
+        vdbbs.push_back(dbbs);
         GeneratorDbStats gdbstats;
         gdbstats.set_name(gen->ToString());
         gdbstats.set_table_info(vdbti);
         gdbstats.set_errors(vdbe); 
+        gdbstats.set_batch_stats(vdbbs);
         gdbslist.push_back(gdbstats);
     }
 }
@@ -47,6 +47,9 @@ using process::ConnectionState;
 using process::ConnectionType;
 using process::ConnectionStatus;
 
+size_t DbHandler::batch_max_bytes_ = 0;
+uint64_t DbHandler::batch_window_usec_ = 0;
+
 DbHandler::DbHandler(EventManager *evm,
         GenDb::GenDbIf::DbErrorHandler err_handler,
         const std::vector<std::string> &cassandra_ips,
@@ -58,6 +61,9 @@ DbHandler::DbHandler(EventManager *evm,
     drop_level_(SandeshLevel::INVALID) {
         error_code error;
         col_name_ = boost::asio::ip::host_name(error);
+        if (batch_max_bytes_ && batch_window_usec_) {
+            dbif_->Db_SetBatchParams(batch_max_bytes_, batch_window_usec_);
+        }
 }
 
 DbHandler::DbHandler(GenDb::GenDbIf *dbif) :
@@ -272,8 +278,8 @@ bool DbHandler::GetStats(uint64_t &queue_count, uint64_t &enqueues,
 }
 
 bool DbHandler::GetStats(std::vector<GenDb::DbTableInfo> &vdbti,
-    GenDb::DbErrors &dbe) {
-    return dbif_->Db_GetStats(vdbti, dbe);
+    GenDb::DbErrors &dbe, GenDb::DbBatchStats &dbbs) {
+    return dbif_->Db_GetStats(vdbti, dbe, dbbs);
 }
 
 bool DbHandler::AllowMessageTableInsert(const SandeshHeader &header) {
@@ -1100,14 +1106,36 @@ bool FlowDataIpv4ObjectWalker<T>::for_each(pugi::xml_node& node) {
 }
 
 /*
- * process the flow message and insert into appropriate tables
+ * process the flow message and insert into appropriate tables. The message
+ * carries either a single FlowDataIpv4 (FlowDataIpv4Object) or a list of
+ * them (FlowDataIpv4ListObject), in which case all the flow records in the
+ * list are inserted in one pass
  */
 bool DbHandler::FlowTableInsert(const pugi::xml_node &parent,
+    const SandeshHeader& header) {
+    pugi::xml_node flow_list(parent.child("flowdata").child("list"));
+    if (!flow_list) {
+        return FlowDataIpv4Insert(parent, header);
+    }
+    bool success = true;
+    for (pugi::xml_node flow = flow_list.first_child(); flow;
+         flow = flow.next_sibling()) {
+        if (!FlowDataIpv4Insert(flow, header)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+/*
+ * process a single flow record and insert into appropriate tables
+ */
+bool DbHandler::FlowDataIpv4Insert(const pugi::xml_node &flow,
     const SandeshHeader& header) {
     // Traverse and populate the flow entry values
     FlowValueArray flow_entry_values;
     FlowDataIpv4ObjectWalker<FlowValueArray> flow_msg_walker(flow_entry_values);
-    pugi::xml_node &mnode = const_cast<pugi::xml_node &>(parent);
+    pugi::xml_node &mnode = const_cast<pugi::xml_node &>(flow);
     if (!mnode.traverse(flow_msg_walker)) {
         VIZD_ASSERT(0);
     }
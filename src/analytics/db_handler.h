@@ -86,6 +86,14 @@ public:
     DbHandler(GenDb::GenDbIf *dbif);
     virtual ~DbHandler();
 
+    // Write combining parameters of the database interfaces created by
+    // the DbHandlers constructed afterwards. The interface defaults are
+    // kept until both are set
+    static void SetBatchParams(size_t max_bytes, uint64_t window_usec) {
+        batch_max_bytes_ = max_bytes;
+        batch_window_usec_ = window_usec;
+    }
+
     bool DropMessage(const SandeshHeader &header, const VizMsg *vmsg);
     bool Init(bool initial, int instance);
     void UnInit(int instance);
@@ -123,7 +131,7 @@ public:
     bool GetStats(uint64_t &queue_count, uint64_t &enqueues,
         std::string &drop_level, std::vector<SandeshStats> &vdropmstats) const;
     bool GetStats(std::vector<GenDb::DbTableInfo> &vdbti,
-        GenDb::DbErrors &dbe);
+        GenDb::DbErrors &dbe, GenDb::DbBatchStats &dbbs);
 
     void SetDbQueueWaterMarkInfo(Sandesh::QueueWaterMarkInfo &wm);
     void ResetDbQueueWaterMarkInfo();
@@ -141,6 +149,8 @@ private:
         const std::pair<std::string,DbHandler::Var>& stag,
         uint32_t t1, const boost::uuids::uuid& unm,
         const std::string& jsonline);
+    bool FlowDataIpv4Insert(const pugi::xml_node& flow,
+        const SandeshHeader &header);
 
     boost::scoped_ptr<GenDb::GenDbIf> dbif_;
 
@@ -151,6 +161,8 @@ private:
     SandeshLevel::type drop_level_;
     VizMsgStatistics dropped_msg_stats_;
     mutable tbb::mutex smutex_;
+    static size_t batch_max_bytes_;
+    static uint64_t batch_window_usec_;
 
     DISALLOW_COPY_AND_ASSIGN(DbHandler);
 };
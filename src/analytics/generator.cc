@@ -264,8 +264,8 @@ bool SandeshGenerator::GetDbStats(uint64_t &queue_count, uint64_t &enqueues,
 }
 
 bool SandeshGenerator::GetDbStats(std::vector<GenDb::DbTableInfo> &vdbti,
-    GenDb::DbErrors &dbe) {
-    return db_handler_->GetStats(vdbti, dbe);
+    GenDb::DbErrors &dbe, GenDb::DbBatchStats &dbbs) {
+    return db_handler_->GetStats(vdbti, dbe, dbbs);
 }
 
 void SandeshGenerator::GetGeneratorInfo(ModuleServerState &genlist) const {
@@ -65,7 +65,7 @@ public:
     bool GetDbStats(uint64_t &queue_count, uint64_t &enqueues,
         std::string &drop_level, std::vector<SandeshStats> &vdropmstats) const;
     bool GetDbStats(std::vector<GenDb::DbTableInfo> &vdbti,
-        GenDb::DbErrors &dbe);
+        GenDb::DbErrors &dbe, GenDb::DbBatchStats &dbbs);
 
     const std::string &instance_id() const { return instance_id_; }
     const std::string &node_type() const { return node_type_; }
@@ -24,6 +24,7 @@
 #include <sandesh/common/vns_types.h>
 #include <sandesh/common/vns_constants.h>
 #include "gendb_if.h"
+#include "db_handler.h"
 #include "viz_collector.h"
 #include "viz_sandesh.h"
 #include "ruleeng.h"
@@ -309,10 +310,14 @@ int main(int argc, char *argv[])
             boost::bind(&GetProcessStateCb, _1, _2, _3,
             protobuf_server_enabled ? 6 : 5));
 
+    DbHandler::SetBatchParams(options.db_batch_max_bytes(),
+        static_cast<uint64_t>(options.db_batch_window_msec()) * 1000);
+
     VizCollector analytics(a_evm,
             options.collector_port(),
             protobuf_server_enabled,
             protobuf_port,
+            options.collector_protobuf_batch_size(),
             cassandra_ips,
             cassandra_ports,
             string("127.0.0.1"),
@@ -79,6 +79,9 @@ void Options::Initialize(EventManager &evm,
             opt::value<uint16_t>()->default_value(
                 default_collector_protobuf_port),
          "Listener port of Google Protocol Buffer collector server")
+        ("COLLECTOR.protobuf_batch_size",
+            opt::value<uint32_t>()->default_value(1),
+         "Datagrams read at once by Google Protocol Buffer collector server")
 
         ("DEFAULT.analytics_data_ttl",
              opt::value<int>()->default_value(ANALYTICS_DATA_TTL_DEFAULT),
@@ -87,6 +90,13 @@ void Options::Initialize(EventManager &evm,
            opt::value<vector<string> >()->default_value(
                default_cassandra_server_list, "127.0.0.1:9160"),
              "Cassandra server list")
+        ("DEFAULT.db_batch_max_bytes",
+             opt::value<uint32_t>()->default_value(DB_BATCH_MAX_BYTES_DEFAULT),
+             "Maximum size in bytes of a combined cassandra write")
+        ("DEFAULT.db_batch_window_msec",
+             opt::value<uint32_t>()->default_value(
+                 DB_BATCH_WINDOW_MSEC_DEFAULT),
+             "Maximum time in msec writes are held back to be combined")
         ("DEFAULT.dup", opt::bool_switch(&dup_), "Internal use flag")
         ("DEFAULT.hostip", opt::value<string>()->default_value(host_ip),
              "IP address of collector")
@@ -239,11 +249,17 @@ void Options::Process(int argc, char *argv[],
     } else {
         collector_protobuf_port_configured_ = false;
     }
+    GetOptValue<uint32_t>(var_map, collector_protobuf_batch_size_,
+                          "COLLECTOR.protobuf_batch_size");
     GetOptValue<int>(var_map, analytics_data_ttl_,
                      "DEFAULT.analytics_data_ttl");
 
     GetOptValue< vector<string> >(var_map, cassandra_server_list_,
                                   "DEFAULT.cassandra_server_list");
+    GetOptValue<uint32_t>(var_map, db_batch_max_bytes_,
+                          "DEFAULT.db_batch_max_bytes");
+    GetOptValue<uint32_t>(var_map, db_batch_window_msec_,
+                          "DEFAULT.db_batch_window_msec");
     GetOptValue<string>(var_map, host_ip_, "DEFAULT.hostip");
     GetOptValue<string>(var_map, hostname_, "DEFAULT.hostname");
     GetOptValue<uint16_t>(var_map, http_server_port_,
@@ -6,6 +6,8 @@
 #include "io/event_manager.h"
 
 #define ANALYTICS_DATA_TTL_DEFAULT 48 // g_viz_constants.AnalyticsTTL
+#define DB_BATCH_MAX_BYTES_DEFAULT (1024U * 1024) // CdbIf::kBatchMaxBytes
+#define DB_BATCH_WINDOW_MSEC_DEFAULT 100U // CdbIf::kBatchWindowUsec
 
 // Process command line/configuration file options for collector.
 class Options {
@@ -24,6 +26,9 @@ public:
         }
         return collector_protobuf_port_configured_;
     }
+    const uint32_t collector_protobuf_batch_size() const {
+        return collector_protobuf_batch_size_;
+    }
     const std::string config_file() const { return config_file_; };
     const std::string discovery_server() const { return discovery_server_; }
     const uint16_t discovery_port() const { return discovery_port_; }
@@ -43,6 +48,10 @@ public:
     const std::string syslog_facility() const { return syslog_facility_; }
     const bool dup() const { return dup_; }
     const int analytics_data_ttl() const { return analytics_data_ttl_; }
+    const uint32_t db_batch_max_bytes() const { return db_batch_max_bytes_; }
+    const uint32_t db_batch_window_msec() const {
+        return db_batch_window_msec_;
+    }
     const int syslog_port() const { return syslog_port_; }
     const int sflow_port() const { return sflow_port_; }
     const int ipfix_port() const { return ipfix_port_; }
@@ -78,6 +87,7 @@ private:
     uint16_t collector_port_;
     uint16_t collector_protobuf_port_;
     bool collector_protobuf_port_configured_;
+    uint32_t collector_protobuf_batch_size_;
     std::string config_file_;
     std::string discovery_server_;
     uint16_t discovery_port_;
@@ -102,6 +112,8 @@ private:
     bool dup_;
     int analytics_data_ttl_;
     std::vector<std::string> cassandra_server_list_;
+    uint32_t db_batch_max_bytes_;
+    uint32_t db_batch_window_msec_;
 
     boost::program_options::options_description config_file_options_;
 };
@@ -15,14 +15,14 @@ const int ProtobufCollector::kDbTaskInstance(-1);
 const std::string ProtobufCollector::kDbTaskName("protobuf_collector::Db");
 
 ProtobufCollector::ProtobufCollector(EventManager *evm,
-    uint16_t protobuf_udp_port,
+    uint16_t protobuf_udp_port, size_t protobuf_udp_batch_size,
     const std::vector<std::string> &cassandra_ips,
     const std::vector<int> &cassandra_ports, int analytics_ttl) :
     db_initializer_(new DbHandlerInitializer(evm, kDbName, kDbTaskInstance,
         kDbTaskName, boost::bind(&ProtobufCollector::DbInitializeCb, this),
         cassandra_ips, cassandra_ports, analytics_ttl)),
     server_(new protobuf::ProtobufServer(evm, protobuf_udp_port,
-        boost::bind(&DbHandler::StatTableInsert,
+        protobuf_udp_batch_size, boost::bind(&DbHandler::StatTableInsert,
             db_initializer_->GetDbHandler(), _1, _2, _3, _4, _5))) {
 }
 
@@ -16,6 +16,7 @@ class DbHandlerInitializer;
 class ProtobufCollector {
  public:
     ProtobufCollector(EventManager *evm, uint16_t udp_server_port,
+        size_t udp_batch_size,
         const std::vector<std::string> &cassandra_ips,
         const std::vector<int> &cassandra_ports, int analytics_ttl);
     virtual ~ProtobufCollector();
@@ -356,9 +356,10 @@ void ProcessProtobufMessage(const Message& message,
 class ProtobufServer::ProtobufServerImpl {
  public:
     ProtobufServerImpl(EventManager *evm, uint16_t udp_server_port,
+        size_t udp_batch_size,
         StatWalker::StatTableInsertFn stat_db_callback) :
         udp_server_(new ProtobufUdpServer(evm, udp_server_port,
-            stat_db_callback)) {
+            udp_batch_size, stat_db_callback)) {
     }
 
     bool Initialize() {
@@ -395,10 +396,12 @@ class ProtobufServer::ProtobufServerImpl {
     class ProtobufUdpServer : public UdpServer {
      public:
         ProtobufUdpServer(EventManager *evm, uint16_t port,
+            size_t batch_size,
             StatWalker::StatTableInsertFn stat_db_callback) :
             UdpServer(evm, kBufferSize),
             port_(port),
             stat_db_callback_(stat_db_callback) {
+            set_batch_size(batch_size);
         }
 
         bool Initialize() {
@@ -635,10 +638,12 @@ static void ProtobufLibraryLog(google::protobuf::LogLevel level,
 }
 
 ProtobufServer::ProtobufServer(EventManager *evm,
-    uint16_t udp_server_port, StatWalker::StatTableInsertFn stat_db_fn) {
+    uint16_t udp_server_port, size_t udp_batch_size,
+    StatWalker::StatTableInsertFn stat_db_fn) {
     GOOGLE_PROTOBUF_VERIFY_VERSION;
     google::protobuf::SetLogHandler(&ProtobufLibraryLog);
-    impl_ = new ProtobufServerImpl(evm, udp_server_port, stat_db_fn);
+    impl_ = new ProtobufServerImpl(evm, udp_server_port, udp_batch_size,
+        stat_db_fn);
 }
 
 ProtobufServer::~ProtobufServer() {
@@ -22,8 +22,10 @@ namespace protobuf {
 //
 class ProtobufServer {
  public:
+    // Up to udp_batch_size datagrams are read at once, 1 reads one datagram
+    // at a time
     ProtobufServer(EventManager *evm, uint16_t udp_server_port,
-        StatWalker::StatTableInsertFn stat_db_cb);
+        size_t udp_batch_size, StatWalker::StatTableInsertFn stat_db_cb);
     virtual ~ProtobufServer();
     bool Initialize();
     void Shutdown();
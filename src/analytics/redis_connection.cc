@@ -320,6 +320,41 @@ bool RedisAsyncConnection::RedisAsyncArgCmd(void *rpi,
     return status;
 }
 
+size_t RedisAsyncConnection::RedisAsyncArgCmdBatch(void *rpi,
+        const vector<vector<string> > &cmds) {
+
+    tbb::mutex::scoped_lock lock(mutex_);
+
+    if (state_ != REDIS_ASYNC_CONNECTION_CONNECTED) {
+        callDisconnected_ += cmds.size();
+        return 0;
+    }
+
+    size_t queued = 0;
+    vector<const char *> argv;
+    for (vector<vector<string> >::const_iterator it = cmds.begin();
+         it != cmds.end(); ++it) {
+        const vector<string> &args(*it);
+        argv.resize(args.size());
+        for (size_t i = 0; i < args.size(); i++) {
+            argv[i] = args[i].c_str();
+        }
+        int ret = redisAsyncCommandArgv(context_,
+                RedisAsyncConnection::RAC_AsyncCmdCallback,
+                rpi,
+                args.size(),
+                &argv[0],
+                NULL);
+        if (REDIS_ERR == ret) {
+            LOG(INFO, "Could NOT apply " << args[0] << " to Redis : ");
+            callFailed_++;
+        } else {
+            queued++;
+            callSucceeded_++;
+        }
+    }
+    return queued;
+}
 
 bool RedisAsyncConnection::RedisAsyncCommand(void *rpi, const char *format, ...) {
     tbb::mutex::scoped_lock lock(mutex_);
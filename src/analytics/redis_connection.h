@@ -56,6 +56,10 @@ public:
     bool SetClientAsyncCmdCb(ClientAsyncCmdCbFn cb_fn);
     bool RedisAsyncCommand(void *rpi, const char *format, ...);
     bool RedisAsyncArgCmd(void *rpi, const std::vector<std::string> &args);
+    // Queues all the commands under one lock, so that they are written to
+    // Redis back to back as a pipeline. Returns the number of commands queued
+    size_t RedisAsyncArgCmdBatch(void *rpi,
+            const std::vector<std::vector<std::string> > &cmds);
     void RAC_StatUpdate(const redisReply *reply);
 
     static RAC_CbFnsMap& rac_cb_fns_map() {
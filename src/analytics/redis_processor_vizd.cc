@@ -24,17 +24,17 @@ using std::map;
 using std::make_pair;
 using boost::assign::list_of;
 
-bool
-RedisProcessorExec::UVEUpdate(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
-                       const std::string &type, const std::string &attr,
+void
+RedisProcessorExec::UVEUpdateCmd(const std::string &type,
+                       const std::string &attr,
                        const std::string &source, const std::string &node_type,
                        const std::string &module, 
                        const std::string &instance_id,
                        const std::string &key, const std::string &msg,
                        int32_t seq, const std::string &agg,
-                       const std::string &hist, int64_t ts) {
+                       const std::string &hist, int64_t ts,
+                       std::vector<std::string> *args) {
     
-    bool ret = false;
     size_t sep = key.find(":");
     string table = key.substr(0, sep);
     std::ostringstream seqstr;
@@ -61,8 +61,7 @@ RedisProcessorExec::UVEUpdate(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
              ":" + tsbinstr.str();
 
         string lua_scr(reinterpret_cast<char *>(uveupdate_st_lua), uveupdate_st_lua_len);
-        ret = rac->RedisAsyncArgCmd(rpi,
-            list_of(string("EVAL"))(lua_scr)("8")(
+        list_of(string("EVAL"))(lua_scr)("8")(
                 string("TYPES:") + source + ":" + node_type + ":" + module + ":" + instance_id)(
                 string("ORIGINS:") + key)(
                 string("TABLE:") + table)(
@@ -73,13 +72,12 @@ RedisProcessorExec::UVEUpdate(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
                 ss)(sc)(sp)(
                 source)(node_type)(module)(instance_id)(type)(attr)(key)
                 (seqstr.str())(lhist)(tsstr.str())(msg)
-                (integerToString(REDIS_DB_UVE)));
+                (integerToString(REDIS_DB_UVE)).to_container(*args);
 
     } else {
 
         string lua_scr(reinterpret_cast<char *>(uveupdate_lua), uveupdate_lua_len);
-        ret = rac->RedisAsyncArgCmd(rpi,
-            list_of(string("EVAL"))(lua_scr)("5")(
+        list_of(string("EVAL"))(lua_scr)("5")(
                 string("TYPES:") + source + ":" + node_type + ":" + module + ":" + instance_id)(
                 string("ORIGINS:") + key)(
                 string("TABLE:") + table)(
@@ -88,9 +86,24 @@ RedisProcessorExec::UVEUpdate(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
                 string("VALUES:") + key + ":" + source + ":" + node_type + 
                 ":" + module + ":" + instance_id + ":" + type)(
                 source)(node_type)(module)(instance_id)(type)(attr)(key)
-                (seqstr.str())(msg)(integerToString(REDIS_DB_UVE)));        
+                (seqstr.str())(msg)(integerToString(REDIS_DB_UVE))
+                .to_container(*args);
     }
-    return ret;
+}
+
+bool
+RedisProcessorExec::UVEUpdate(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
+                       const std::string &type, const std::string &attr,
+                       const std::string &source, const std::string &node_type,
+                       const std::string &module, 
+                       const std::string &instance_id,
+                       const std::string &key, const std::string &msg,
+                       int32_t seq, const std::string &agg,
+                       const std::string &hist, int64_t ts) {
+    vector<string> args;
+    UVEUpdateCmd(type, attr, source, node_type, module, instance_id, key, msg,
+                 seq, agg, hist, ts, &args);
+    return rac->RedisAsyncArgCmd(rpi, args);
 }
 
 bool
@@ -26,6 +26,16 @@ public:
                        int32_t seq, const std::string &agg,
                        const std::string &atyp, int64_t ts);
 
+    // Builds the arguments of the command used by UVEUpdate
+    static void
+    UVEUpdateCmd(const std::string &type, const std::string &attr,
+                       const std::string &source, const std::string &node_type,
+                       const std::string &module, const std::string &instance_id,
+                       const std::string &key, const std::string &message,
+                       int32_t seq, const std::string &agg,
+                       const std::string &atyp, int64_t ts,
+                       std::vector<std::string> *args);
+
     static bool
     UVEDelete(RedisAsyncConnection * rac, RedisProcessorIf *rpi,
             const std::string &type,
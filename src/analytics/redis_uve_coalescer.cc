@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "redis_uve_coalescer.h"
+
+#include <boost/bind.hpp>
+#include "base/logging.h"
+#include "redis_connection.h"
+#include "redis_processor_vizd.h"
+
+using std::string;
+using std::vector;
+using std::make_pair;
+
+const int RedisUVECoalescer::kCoalesceWindow;
+const size_t RedisUVECoalescer::kMaxBatchSize;
+
+RedisUVECoalescer::RedisUVECoalescer(EventManager *evm,
+        RedisAsyncConnection *rac) :
+    rac_(rac),
+    window_(kCoalesceWindow),
+    timer_running_(false),
+    timer_(*evm->io_service()),
+    received_(0),
+    coalesced_(0),
+    batches_(0),
+    batch_cmds_(0),
+    batch_failed_(0),
+    queue_depth_(0),
+    queue_depth_max_(0) {
+}
+
+RedisUVECoalescer::~RedisUVECoalescer() {
+    Flush();
+    boost::system::error_code ec;
+    tbb::mutex::scoped_lock lock(mutex_);
+    timer_.cancel(ec);
+}
+
+bool RedisUVECoalescer::UVEUpdate(const string &type, const string &attr,
+        const string &source, const string &node_type, const string &module,
+        const string &instance_id, const string &key, const string &message,
+        int32_t seq, const string &agg, const string &atyp, int64_t ts) {
+    if (window_ == 0) {
+        Flush();
+        return RedisProcessorExec::UVEUpdate(rac_, NULL, type, attr, source,
+            node_type, module, instance_id, key, message, seq, agg, atyp, ts);
+    }
+    if (!rac_->IsConnUp()) {
+        return false;
+    }
+
+    // Build the command outside the lock
+    PendingUpdate update;
+    RedisProcessorExec::UVEUpdateCmd(type, attr, source, node_type, module,
+        instance_id, key, message, seq, agg, atyp, ts, &update.cmd);
+
+    bool flush = false;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        received_++;
+        if (agg == "stats") {
+            queue_depth_++;
+        } else {
+            string ukey(key + ":" + source + ":" + node_type + ":" + module +
+                ":" + instance_id + ":" + type + ":" + attr);
+            std::pair<PendingMap::iterator, bool> ret =
+                pending_map_.insert(make_pair(ukey, pending_.size()));
+            if (ret.second) {
+                queue_depth_++;
+            } else {
+                // Drop the older update and queue the new one at the tail,
+                // so that the sequence numbers reach Redis in order
+                PendingUpdate &older(pending_[ret.first->second]);
+                older.valid = false;
+                older.cmd.clear();
+                ret.first->second = pending_.size();
+                coalesced_++;
+            }
+        }
+        pending_.push_back(PendingUpdate());
+        pending_.back().cmd.swap(update.cmd);
+        if (queue_depth_ > queue_depth_max_) {
+            queue_depth_max_ = queue_depth_;
+        }
+        if (pending_.size() >= kMaxBatchSize) {
+            flush = true;
+        } else {
+            StartTimer();
+        }
+    }
+    if (flush) {
+        Flush();
+    }
+    return true;
+}
+
+void RedisUVECoalescer::Flush() {
+    tbb::mutex::scoped_lock flush_lock(flush_mutex_);
+    PendingList pending;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        if (pending_.empty()) {
+            return;
+        }
+        pending.swap(pending_);
+        pending_map_.clear();
+        queue_depth_ = 0;
+    }
+
+    vector<vector<string> > cmds;
+    cmds.reserve(pending.size());
+    for (PendingList::iterator it = pending.begin(); it != pending.end();
+         ++it) {
+        if (!it->valid) {
+            continue;
+        }
+        cmds.push_back(vector<string>());
+        cmds.back().swap(it->cmd);
+    }
+    size_t sent = rac_->RedisAsyncArgCmdBatch(NULL, cmds);
+    batches_++;
+    batch_cmds_ += sent;
+    batch_failed_ += cmds.size() - sent;
+}
+
+void RedisUVECoalescer::Clear() {
+    tbb::mutex::scoped_lock lock(mutex_);
+    pending_.clear();
+    pending_map_.clear();
+    queue_depth_ = 0;
+}
+
+double RedisUVECoalescer::CoalesceRatio() const {
+    if (received_ == 0) {
+        return 0;
+    }
+    return static_cast<double>(coalesced_) / received_;
+}
+
+// Called with mutex_ held
+void RedisUVECoalescer::StartTimer() {
+    if (timer_running_) {
+        return;
+    }
+    boost::system::error_code ec;
+    timer_.expires_from_now(boost::posix_time::milliseconds(window_), ec);
+    if (ec) {
+        LOG(ERROR, "RedisUVECoalescer timer start error: " << ec.message());
+        return;
+    }
+    timer_running_ = true;
+    timer_.async_wait(boost::bind(&RedisUVECoalescer::TimerExpired, this,
+        boost::asio::placeholders::error));
+}
+
+void RedisUVECoalescer::TimerExpired(const boost::system::error_code &error) {
+    if (error) {
+        if (error.value() == boost::system::errc::operation_canceled) {
+            return;
+        }
+        LOG(ERROR, "RedisUVECoalescer timer error: " << error.message());
+    }
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        timer_running_ = false;
+    }
+    Flush();
+}
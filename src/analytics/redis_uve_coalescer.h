@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __REDIS_UVE_COALESCER_H__
+#define __REDIS_UVE_COALESCER_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <boost/asio.hpp>
+#include <tbb/mutex.h>
+#include "io/event_manager.h"
+
+class RedisAsyncConnection;
+
+/*
+ * Coalesces UVE updates sent to Redis. Updates are held for upto the
+ * coalesce window, and an update to a UVE attribute that is already pending
+ * replaces the pending one. Pending updates are sent to Redis as one
+ * pipelined batch of commands when the window expires, or earlier if the
+ * batch fills up. Aggregated stats updates carry history and are never
+ * merged, but are batched in order with the other updates.
+ */
+class RedisUVECoalescer {
+public:
+    static const int kCoalesceWindow = 100;     // in ms
+    static const size_t kMaxBatchSize = 1024;
+
+    RedisUVECoalescer(EventManager *evm, RedisAsyncConnection *rac);
+    ~RedisUVECoalescer();
+
+    // Returns false if the update could not be queued because the
+    // connection to Redis is down
+    bool UVEUpdate(const std::string &type, const std::string &attr,
+                   const std::string &source, const std::string &node_type,
+                   const std::string &module, const std::string &instance_id,
+                   const std::string &key, const std::string &message,
+                   int32_t seq, const std::string &agg,
+                   const std::string &atyp, int64_t ts);
+
+    // Sends all the pending updates to Redis. Must be called before
+    // sending any command that depends on the pending updates
+    void Flush();
+
+    // Drops the pending updates. Called when the connection to Redis goes
+    // down, as Redis is resynced from the generators once it is back up
+    void Clear();
+
+    // A window of 0 sends every update to Redis right away
+    void set_window(int window) { window_ = window; }
+    int window() const { return window_; }
+
+    uint64_t Received() const { return received_; }
+    uint64_t Coalesced() const { return coalesced_; }
+    uint64_t Batches() const { return batches_; }
+    uint64_t BatchCommands() const { return batch_cmds_; }
+    uint64_t BatchFailed() const { return batch_failed_; }
+    uint32_t QueueDepth() const { return queue_depth_; }
+    uint32_t QueueDepthMax() const { return queue_depth_max_; }
+    double CoalesceRatio() const;
+
+private:
+    struct PendingUpdate {
+        PendingUpdate() : valid(true) { }
+        std::vector<std::string> cmd;
+        bool valid;
+    };
+    typedef std::vector<PendingUpdate> PendingList;
+    typedef std::map<std::string, size_t> PendingMap;
+
+    void StartTimer();
+    void TimerExpired(const boost::system::error_code &error);
+
+    RedisAsyncConnection *rac_;
+    int window_;
+    // Protects the pending updates and the timer
+    tbb::mutex mutex_;
+    // Serializes Flush, so that batches reach Redis in order
+    tbb::mutex flush_mutex_;
+    PendingList pending_;
+    // Index in pending_ of the latest update to a UVE attribute
+    PendingMap pending_map_;
+    bool timer_running_;
+    boost::asio::deadline_timer timer_;
+
+    uint64_t received_;
+    uint64_t coalesced_;
+    uint64_t batches_;
+    uint64_t batch_cmds_;
+    uint64_t batch_failed_;
+    uint32_t queue_depth_;
+    uint32_t queue_depth_max_;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <pthread.h>
 #include <boost/bind.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/assign/list_of.hpp>
 #include <boost/assign/ptr_list_of.hpp>
 #include <boost/uuid/uuid.hpp>
 #include "testing/gunit.h"
@@ -24,6 +25,7 @@ using ::testing::AnyOf;
 using ::testing::AnyNumber;
 using ::testing::_;
 using ::testing::Eq;
+using ::testing::Not;
 using ::testing::ElementsAre;
 using ::testing::Pointee;
 using ::testing::ElementsAreArray;
@@ -674,6 +676,53 @@ TEST_F(DbHandlerTest, FlowTableInsertTest) {
     delete msg;
 }
 
+TEST_F(DbHandlerTest, FlowTableInsertListTest) {
+    init_vizd_tables();
+
+    SandeshHeader hdr;
+    hdr.set_Module("VizdTest");
+    hdr.set_Source("127.0.0.1");
+    std::string flowu1_str = "555788e0-513c-4351-8711-3fc481cf2eb4";
+    std::string flowu2_str = "58745ee7-d616-4e59-b8f7-96f896487c9f";
+    std::string xmlmessage = "<FlowDataIpv4ListObject type=\"sandesh\"><flowdata type=\"list\" identifier=\"1\"><list type=\"struct\" size=\"2\"><FlowDataIpv4><flowuuid type=\"string\" identifier=\"1\">" + flowu1_str + "</flowuuid><direction_ing type=\"byte\" identifier=\"2\">0</direction_ing><sourcevn type=\"string\" identifier=\"3\">default-domain:demo:vn1</sourcevn><sourceip type=\"i32\" identifier=\"4\">-1062731011</sourceip><destvn type=\"string\" identifier=\"5\">default-domain:demo:vn0</destvn><destip type=\"i32\" identifier=\"6\">-1062731267</destip><protocol type=\"byte\" identifier=\"7\">6</protocol><sport type=\"i16\" identifier=\"8\">5201</sport><dport type=\"i16\" identifier=\"9\">-24590</dport><bytes type=\"i64\" identifier=\"23\">0</bytes><packets type=\"i64\" identifier=\"24\">0</packets><diff_bytes type=\"i64\" identifier=\"26\">0</diff_bytes><diff_packets type=\"i64\" identifier=\"27\">0</diff_packets></FlowDataIpv4><FlowDataIpv4><flowuuid type=\"string\" identifier=\"1\">" + flowu2_str + "</flowuuid><direction_ing type=\"byte\" identifier=\"2\">1</direction_ing><sourcevn type=\"string\" identifier=\"3\">default-domain:demo:vn0</sourcevn><sourceip type=\"i32\" identifier=\"4\">-1062731267</sourceip><destvn type=\"string\" identifier=\"5\">default-domain:demo:vn1</destvn><destip type=\"i32\" identifier=\"6\">-1062731011</destip><protocol type=\"byte\" identifier=\"7\">6</protocol><sport type=\"i16\" identifier=\"8\">-24590</sport><dport type=\"i16\" identifier=\"9\">5201</dport><bytes type=\"i64\" identifier=\"23\">0</bytes><packets type=\"i64\" identifier=\"24\">0</packets></FlowDataIpv4></list></flowdata></FlowDataIpv4ListObject>";
+
+    SandeshXMLMessageTest *msg = dynamic_cast<SandeshXMLMessageTest *>(
+        builder_->Create(
+            reinterpret_cast<const uint8_t *>(xmlmessage.c_str()),
+            xmlmessage.size()));
+    msg->SetHeader(hdr);
+
+    // Both flow records are written to the flow table, only the first one
+    // has diff_bytes and diff_packets and is written to the index tables
+    EXPECT_CALL(*dbif_mock(),
+            Db_AddColumnProxy(
+                Pointee(
+                    Field(&GenDb::ColList::cfname_,
+                        Not(g_viz_constants.FLOW_TABLE)))))
+        .Times(5)
+        .WillRepeatedly(Return(true));
+
+    std::vector<std::string> flows = boost::assign::list_of
+        (flowu1_str)(flowu2_str);
+    for (std::vector<std::string>::const_iterator it = flows.begin();
+         it != flows.end(); ++it) {
+        GenDb::DbDataValueVec rowkey;
+        rowkey.push_back(boost::uuids::string_generator()(*it));
+
+        EXPECT_CALL(*dbif_mock(),
+                Db_AddColumnProxy(
+                    Pointee(
+                        AllOf(Field(&GenDb::ColList::cfname_, g_viz_constants.FLOW_TABLE),
+                            Field(&GenDb::ColList::rowkey_, rowkey)))))
+            .Times(1)
+            .WillOnce(Return(true));
+    }
+
+    EXPECT_TRUE(db_handler()->FlowTableInsert(msg->GetMessageNode(),
+        msg->GetHeader()));
+    delete msg;
+}
+
 class UUIDRandomGenTest : public ::testing::Test {
  public:
     bool PopulateUUIDMap(std::map<std::string, unsigned int>& uuid_map,
@@ -72,11 +72,14 @@ TEST_F(OptionsTest, NoArguments) {
     EXPECT_EQ(options_.log_level(), "SYS_NOTICE");
     EXPECT_EQ(options_.log_local(), false);
     EXPECT_EQ(options_.analytics_data_ttl(), ANALYTICS_DATA_TTL_DEFAULT);
+    EXPECT_EQ(options_.db_batch_max_bytes(), DB_BATCH_MAX_BYTES_DEFAULT);
+    EXPECT_EQ(options_.db_batch_window_msec(), DB_BATCH_WINDOW_MSEC_DEFAULT);
     EXPECT_EQ(options_.syslog_port(), -1);
     EXPECT_EQ(options_.dup(), false);
     EXPECT_EQ(options_.test_mode(), false);
     uint16_t protobuf_port(0);
     EXPECT_FALSE(options_.collector_protobuf_port(&protobuf_port));
+    EXPECT_EQ(options_.collector_protobuf_batch_size(), 1U);
 }
 
 TEST_F(OptionsTest, DefaultConfFile) {
@@ -110,11 +113,14 @@ TEST_F(OptionsTest, DefaultConfFile) {
     EXPECT_EQ(options_.log_level(), "SYS_NOTICE");
     EXPECT_EQ(options_.log_local(), true);
     EXPECT_EQ(options_.analytics_data_ttl(), ANALYTICS_DATA_TTL_DEFAULT);
+    EXPECT_EQ(options_.db_batch_max_bytes(), DB_BATCH_MAX_BYTES_DEFAULT);
+    EXPECT_EQ(options_.db_batch_window_msec(), DB_BATCH_WINDOW_MSEC_DEFAULT);
     EXPECT_EQ(options_.syslog_port(), -1);
     EXPECT_EQ(options_.dup(), false);
     EXPECT_EQ(options_.test_mode(), false);
     uint16_t protobuf_port(0);
     EXPECT_FALSE(options_.collector_protobuf_port(&protobuf_port));
+    EXPECT_EQ(options_.collector_protobuf_batch_size(), 1U);
 }
 
 TEST_F(OptionsTest, OverrideStringFromCommandLine) {
@@ -150,11 +156,14 @@ TEST_F(OptionsTest, OverrideStringFromCommandLine) {
     EXPECT_EQ(options_.log_level(), "SYS_NOTICE");
     EXPECT_EQ(options_.log_local(), true);
     EXPECT_EQ(options_.analytics_data_ttl(), ANALYTICS_DATA_TTL_DEFAULT);
+    EXPECT_EQ(options_.db_batch_max_bytes(), DB_BATCH_MAX_BYTES_DEFAULT);
+    EXPECT_EQ(options_.db_batch_window_msec(), DB_BATCH_WINDOW_MSEC_DEFAULT);
     EXPECT_EQ(options_.syslog_port(), -1);
     EXPECT_EQ(options_.dup(), false);
     EXPECT_EQ(options_.test_mode(), false);
     uint16_t protobuf_port(0);
     EXPECT_FALSE(options_.collector_protobuf_port(&protobuf_port));
+    EXPECT_EQ(options_.collector_protobuf_batch_size(), 1U);
 }
 
 TEST_F(OptionsTest, OverrideBooleanFromCommandLine) {
@@ -190,11 +199,14 @@ TEST_F(OptionsTest, OverrideBooleanFromCommandLine) {
     EXPECT_EQ(options_.log_level(), "SYS_NOTICE");
     EXPECT_EQ(options_.log_local(), true);
     EXPECT_EQ(options_.analytics_data_ttl(), ANALYTICS_DATA_TTL_DEFAULT);
+    EXPECT_EQ(options_.db_batch_max_bytes(), DB_BATCH_MAX_BYTES_DEFAULT);
+    EXPECT_EQ(options_.db_batch_window_msec(), DB_BATCH_WINDOW_MSEC_DEFAULT);
     EXPECT_EQ(options_.syslog_port(), -1);
     EXPECT_EQ(options_.dup(), false);
     EXPECT_EQ(options_.test_mode(), true); // Overridden from command line.
     uint16_t protobuf_port(0);
     EXPECT_FALSE(options_.collector_protobuf_port(&protobuf_port));
+    EXPECT_EQ(options_.collector_protobuf_batch_size(), 1U);
 }
 
 TEST_F(OptionsTest, CustomConfigFile) {
@@ -203,6 +215,8 @@ TEST_F(OptionsTest, CustomConfigFile) {
         "cassandra_server_list=10.10.10.1:100\n"
         "cassandra_server_list=20.20.20.2:200\n"
         "cassandra_server_list=30.30.30.3:300\n"
+        "db_batch_max_bytes=65536\n"
+        "db_batch_window_msec=20\n"
         "dup=1\n"
         "hostip=1.2.3.4\n"
         "hostname=test\n"
@@ -271,6 +285,8 @@ TEST_F(OptionsTest, CustomConfigFile) {
     EXPECT_EQ(options_.log_level(), "SYS_DEBUG");
     EXPECT_EQ(options_.log_local(), true);
     EXPECT_EQ(options_.analytics_data_ttl(), ANALYTICS_DATA_TTL_DEFAULT);
+    EXPECT_EQ(options_.db_batch_max_bytes(), DB_BATCH_MAX_BYTES_DEFAULT);
+    EXPECT_EQ(options_.db_batch_window_msec(), DB_BATCH_WINDOW_MSEC_DEFAULT);
     EXPECT_EQ(options_.syslog_port(), 101);
     EXPECT_EQ(options_.dup(), true);
     EXPECT_EQ(options_.test_mode(), true);
@@ -286,6 +302,8 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
         "cassandra_server_list=10.10.10.1:100\n"
         "cassandra_server_list=20.20.20.2:200\n"
         "cassandra_server_list=30.30.30.3:300\n"
+        "db_batch_max_bytes=65536\n"
+        "db_batch_window_msec=20\n"
         "dup=1\n"
         "hostip=1.2.3.4\n"
         "hostname=test\n"
@@ -304,6 +322,7 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
         "port=100\n"
         "server=3.4.5.6\n"
         "protobuf_port=3333\n"
+        "protobuf_batch_size=16\n"
         "\n"
         "[DISCOVERY]\n"
         "port=100\n"
@@ -367,12 +386,15 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
     EXPECT_EQ(options_.log_level(), "SYS_DEBUG");
     EXPECT_EQ(options_.log_local(), true);
     EXPECT_EQ(options_.analytics_data_ttl(), 30);
+    EXPECT_EQ(options_.db_batch_max_bytes(), 65536U);
+    EXPECT_EQ(options_.db_batch_window_msec(), 20U);
     EXPECT_EQ(options_.syslog_port(), 102);
     EXPECT_EQ(options_.dup(), true);
     EXPECT_EQ(options_.test_mode(), true);
     uint16_t protobuf_port(0);
     EXPECT_TRUE(options_.collector_protobuf_port(&protobuf_port));
     EXPECT_EQ(protobuf_port, 3334);
+    EXPECT_EQ(options_.collector_protobuf_batch_size(), 16U);
 }
 
 TEST_F(OptionsTest, MultitokenVector) {
@@ -457,8 +457,8 @@ class ProtobufServerTest : public ::testing::Test {
         }
         evm_.reset(new EventManager());
         server_.reset(new protobuf::ProtobufServer(evm_.get(), 0,
-            boost::bind(&StatCbTester::Cb, &stats_tester_, _1, _2, _3,
-            _4, _5)));
+            UdpBatchSize(), boost::bind(&StatCbTester::Cb, &stats_tester_,
+            _1, _2, _3, _4, _5)));
         client_ = new ProtobufMockClient(evm_.get());
         thread_.reset(new ServerThread(evm_.get()));
     }
@@ -480,12 +480,76 @@ class ProtobufServerTest : public ::testing::Test {
         task_util::WaitForIdle();
     }
 
+    virtual size_t UdpBatchSize() const {
+        return 1;
+    }
+
     size_t GetServerReceivedMessageStatisticsSize() {
         std::vector<SocketEndpointMessageStats> va_rx_msg_stats;
         server_->GetReceivedMessageStatistics(&va_rx_msg_stats);
         return va_rx_msg_stats.size();
     }
 
+    void SendAndCheckMessage() {
+        EXPECT_TRUE(server_->Initialize());
+        task_util::WaitForIdle();
+        boost::system::error_code ec;
+        boost::asio::ip::udp::endpoint server_endpoint =
+            server_->GetLocalEndpoint(&ec);
+        EXPECT_TRUE(ec == 0);
+        LOG(ERROR, "ProtobufServer: " << server_endpoint);
+        thread_->Start();
+        client_->Initialize(0);
+        // Create TestMessage and serialize it
+        uint8_t data[1024];
+        int serialized_data_size(0);
+        CreateAndSerializeTestMessage(data, sizeof(data),
+            &serialized_data_size);
+        // Create SelfDescribingMessageTest for TestMessage and serialize it
+        uint8_t sdm_data[1024];
+        int serialized_sdm_data_size(0);
+        CreateAndSerializeSelfDescribingMessage("TestMessage", sdm_data,
+            sizeof(sdm_data), &serialized_sdm_data_size,
+            d_desc_file_.c_str(), data, serialized_data_size);
+        std::string snd(reinterpret_cast<const char *>(sdm_data),
+            serialized_sdm_data_size);
+        client_->Send(snd, server_endpoint);
+        TASK_UTIL_EXPECT_EQ(client_->GetTxPackets(), 1);
+        TASK_UTIL_EXPECT_VECTOR_EQ(stats_tester_.match_, match_);
+        // Compare statistics
+        std::vector<SocketIOStats> va_rx_stats, va_tx_stats;
+        server_->GetStatistics(&va_tx_stats, &va_rx_stats, NULL);
+        EXPECT_EQ(1, va_tx_stats.size());
+        EXPECT_EQ(1, va_rx_stats.size());
+        const SocketIOStats &a_rx_io_stats(va_rx_stats[0]);
+        EXPECT_EQ(1, a_rx_io_stats.get_calls());
+        EXPECT_EQ(serialized_sdm_data_size, a_rx_io_stats.get_bytes());
+        EXPECT_EQ(serialized_sdm_data_size,
+                  a_rx_io_stats.get_average_bytes());
+        const SocketIOStats &a_tx_io_stats(va_tx_stats[0]);
+        EXPECT_EQ(0, a_tx_io_stats.get_calls());
+        EXPECT_EQ(0, a_tx_io_stats.get_bytes());
+        EXPECT_EQ(0, a_tx_io_stats.get_average_bytes());
+        EXPECT_EQ(1, GetServerReceivedMessageStatisticsSize());
+        std::vector<SocketEndpointMessageStats> va_rx_msg_stats;
+        server_->GetReceivedMessageStatistics(&va_rx_msg_stats);
+        const SocketEndpointMessageStats &a_rx_msg_stats(
+            va_rx_msg_stats[0]);
+        boost::asio::ip::udp::endpoint client_endpoint =
+            client_->GetLocalEndpoint(&ec);
+        EXPECT_TRUE(ec == 0);
+        boost::asio::ip::address local_client_addr =
+            boost::asio::ip::address::from_string("127.0.0.1", ec);
+        EXPECT_TRUE(ec == 0);
+        client_endpoint.address(local_client_addr);
+        std::stringstream ss;
+        ss << client_endpoint;
+        EXPECT_EQ(ss.str(), a_rx_msg_stats.get_endpoint_name());
+        EXPECT_EQ(1, a_rx_msg_stats.get_messages());
+        EXPECT_EQ(serialized_sdm_data_size, a_rx_msg_stats.get_bytes());
+        EXPECT_EQ("TestMessage", a_rx_msg_stats.get_message_name());
+    }
+
     std::vector<bool> match_;
     StatCbTester stats_tester_;
     std::auto_ptr<ServerThread> thread_;
@@ -495,68 +559,26 @@ class ProtobufServerTest : public ::testing::Test {
 };
 
 TEST_F(ProtobufServerTest, Basic) {
-    EXPECT_TRUE(server_->Initialize());
-    task_util::WaitForIdle();
-    boost::system::error_code ec;
-    boost::asio::ip::udp::endpoint server_endpoint =
-        server_->GetLocalEndpoint(&ec);
-    EXPECT_TRUE(ec == 0);
-    LOG(ERROR, "ProtobufServer: " << server_endpoint);
-    thread_->Start();
-    client_->Initialize(0);
-    // Create TestMessage and serialize it
-    uint8_t data[1024];
-    int serialized_data_size(0);
-    CreateAndSerializeTestMessage(data, sizeof(data),
-        &serialized_data_size);
-    // Create SelfDescribingMessageTest for TestMessage and serialize it
-    uint8_t sdm_data[1024];
-    int serialized_sdm_data_size(0);
-    CreateAndSerializeSelfDescribingMessage("TestMessage", sdm_data,
-        sizeof(sdm_data), &serialized_sdm_data_size, d_desc_file_.c_str(),
-        data, serialized_data_size);
-    std::string snd(reinterpret_cast<const char *>(sdm_data),
-        serialized_sdm_data_size);
-    client_->Send(snd, server_endpoint);
-    TASK_UTIL_EXPECT_EQ(client_->GetTxPackets(), 1);
-    TASK_UTIL_EXPECT_VECTOR_EQ(stats_tester_.match_, match_);
-    // Compare statistics
-    std::vector<SocketIOStats> va_rx_stats, va_tx_stats;
-    server_->GetStatistics(&va_tx_stats, &va_rx_stats, NULL);
-    EXPECT_EQ(1, va_tx_stats.size());
-    EXPECT_EQ(1, va_rx_stats.size());
-    const SocketIOStats &a_rx_io_stats(va_rx_stats[0]);
-    EXPECT_EQ(1, a_rx_io_stats.get_calls());
-    EXPECT_EQ(serialized_sdm_data_size, a_rx_io_stats.get_bytes());
-    EXPECT_EQ(serialized_sdm_data_size, a_rx_io_stats.get_average_bytes());
-    const SocketIOStats &a_tx_io_stats(va_tx_stats[0]);
-    EXPECT_EQ(0, a_tx_io_stats.get_calls());
-    EXPECT_EQ(0, a_tx_io_stats.get_bytes());
-    EXPECT_EQ(0, a_tx_io_stats.get_average_bytes());
-    EXPECT_EQ(1, GetServerReceivedMessageStatisticsSize());
-    std::vector<SocketEndpointMessageStats> va_rx_msg_stats;
-    server_->GetReceivedMessageStatistics(&va_rx_msg_stats);
-    const SocketEndpointMessageStats &a_rx_msg_stats(va_rx_msg_stats[0]);
-    boost::asio::ip::udp::endpoint client_endpoint =
-        client_->GetLocalEndpoint(&ec);
-    EXPECT_TRUE(ec == 0);
-    boost::asio::ip::address local_client_addr =
-        boost::asio::ip::address::from_string("127.0.0.1", ec);
-    EXPECT_TRUE(ec == 0);
-    client_endpoint.address(local_client_addr);
-    std::stringstream ss;
-    ss << client_endpoint;
-    EXPECT_EQ(ss.str(), a_rx_msg_stats.get_endpoint_name());
-    EXPECT_EQ(1, a_rx_msg_stats.get_messages());
-    EXPECT_EQ(serialized_sdm_data_size, a_rx_msg_stats.get_bytes());
-    EXPECT_EQ("TestMessage", a_rx_msg_stats.get_message_name());
+    SendAndCheckMessage();
+}
+
+// Datagrams are read in batches
+class ProtobufServerBatchTest : public ProtobufServerTest {
+ protected:
+    virtual size_t UdpBatchSize() const {
+        return UdpServer::kDefaultBatchSize;
+    }
+};
+
+TEST_F(ProtobufServerBatchTest, Basic) {
+    SendAndCheckMessage();
 }
 
 class ProtobufServerSizeTest : public ::testing::Test {
  protected:
     virtual void SetUp() {
         evm_.reset(new EventManager());
-        server_.reset(new protobuf::ProtobufServer(evm_.get(), 0, NULL));
+        server_.reset(new protobuf::ProtobufServer(evm_.get(), 0, 1, NULL));
         client_ = new ProtobufMockClient(evm_.get());
         thread_.reset(new ServerThread(evm_.get()));
     }
@@ -0,0 +1,333 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
+#include <testing/gunit.h>
+#include <base/logging.h>
+#include <base/util.h>
+#include <base/test/task_test_util.h>
+#include <io/test/event_manager_test.h>
+
+#include "analytics/redis_connection.h"
+#include "analytics/redis_uve_coalescer.h"
+
+using std::string;
+using std::vector;
+using boost::asio::ip::tcp;
+
+namespace {
+
+// Stand-in for redis-server. Parses the commands sent to it and replies to
+// each with an integer, which is what the UVE scripts return. Keeps the
+// commands received, and the number of reads that carried more than one
+// command, to verify pipelining
+class RedisServerStandIn {
+public:
+    explicit RedisServerStandIn(EventManager *evm) :
+        acceptor_(*evm->io_service(),
+            tcp::endpoint(boost::asio::ip::address::from_string("127.0.0.1"),
+                0)),
+        pipelined_reads_() {
+        pipelined_reads_ = 0;
+        Accept();
+    }
+
+    void Shutdown() {
+        boost::system::error_code ec;
+        acceptor_.close(ec);
+        tbb::mutex::scoped_lock lock(mutex_);
+        for (vector<SessionPtr>::iterator it = sessions_.begin();
+             it != sessions_.end(); ++it) {
+            (*it)->socket.close(ec);
+        }
+    }
+
+    unsigned short port() const { return acceptor_.local_endpoint().port(); }
+
+    size_t CommandCount() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        return commands_.size();
+    }
+
+    vector<vector<string> > Commands() {
+        tbb::mutex::scoped_lock lock(mutex_);
+        return commands_;
+    }
+
+    int pipelined_reads() const { return pipelined_reads_; }
+
+private:
+    struct Session {
+        explicit Session(boost::asio::io_service &io) : socket(io) { }
+        tcp::socket socket;
+        char data[65536];
+        string buf;
+    };
+    typedef boost::shared_ptr<Session> SessionPtr;
+
+    void Accept() {
+        SessionPtr session(new Session(acceptor_.get_io_service()));
+        acceptor_.async_accept(session->socket,
+            boost::bind(&RedisServerStandIn::AcceptHandler, this, session,
+                boost::asio::placeholders::error));
+    }
+
+    void AcceptHandler(SessionPtr session,
+                       const boost::system::error_code &error) {
+        if (error) {
+            return;
+        }
+        {
+            tbb::mutex::scoped_lock lock(mutex_);
+            sessions_.push_back(session);
+        }
+        Read(session);
+        Accept();
+    }
+
+    void Read(SessionPtr session) {
+        session->socket.async_read_some(
+            boost::asio::buffer(session->data, sizeof(session->data)),
+            boost::bind(&RedisServerStandIn::ReadHandler, this, session,
+                boost::asio::placeholders::error,
+                boost::asio::placeholders::bytes_transferred));
+    }
+
+    // Parses one multi bulk command from the head of buf, returns false if
+    // buf does not have a complete command yet
+    static bool ParseCommand(string *buf, vector<string> *args) {
+        size_t pos = buf->find("\r\n");
+        if ((*buf)[0] != '*' || pos == string::npos) {
+            return false;
+        }
+        int argc = atoi(buf->c_str() + 1);
+        size_t offset = pos + 2;
+        for (int i = 0; i < argc; i++) {
+            pos = buf->find("\r\n", offset);
+            if (pos == string::npos) {
+                return false;
+            }
+            size_t len = atoi(buf->c_str() + offset + 1);
+            offset = pos + 2;
+            if (buf->size() < offset + len + 2) {
+                return false;
+            }
+            args->push_back(buf->substr(offset, len));
+            offset += len + 2;
+        }
+        buf->erase(0, offset);
+        return true;
+    }
+
+    void ReadHandler(SessionPtr session, const boost::system::error_code &error,
+                     size_t length) {
+        if (error) {
+            return;
+        }
+        session->buf.append(session->data, length);
+        string reply;
+        int count = 0;
+        while (!session->buf.empty()) {
+            vector<string> args;
+            if (!ParseCommand(&session->buf, &args)) {
+                break;
+            }
+            if (args[0] == "SUBSCRIBE") {
+                reply += "*3\r\n$9\r\nsubscribe\r\n$" +
+                    integerToString(args[1].size()) + "\r\n" + args[1] +
+                    "\r\n:1\r\n";
+            } else {
+                reply += ":1\r\n";
+            }
+            tbb::mutex::scoped_lock lock(mutex_);
+            commands_.push_back(args);
+            count++;
+        }
+        if (count > 1) {
+            pipelined_reads_++;
+        }
+        boost::system::error_code ec;
+        boost::asio::write(session->socket, boost::asio::buffer(reply), ec);
+        Read(session);
+    }
+
+    tcp::acceptor acceptor_;
+    tbb::mutex mutex_;
+    vector<SessionPtr> sessions_;
+    vector<vector<string> > commands_;
+    tbb::atomic<int> pipelined_reads_;
+};
+
+class RedisUVECoalescerTest : public ::testing::Test {
+protected:
+    virtual void SetUp() {
+        redis_evm_.reset(new EventManager());
+        redis_thread_.reset(new ServerThread(redis_evm_.get()));
+        redis_.reset(new RedisServerStandIn(redis_evm_.get()));
+        redis_thread_->Start();
+
+        evm_.reset(new EventManager());
+        thread_.reset(new ServerThread(evm_.get()));
+        thread_->Start();
+        rac_.reset(new RedisAsyncConnection(evm_.get(), "127.0.0.1",
+            redis_->port()));
+        rac_->RAC_Connect();
+        TASK_UTIL_EXPECT_TRUE(rac_->IsConnUp());
+        coalescer_.reset(new RedisUVECoalescer(evm_.get(), rac_.get()));
+    }
+
+    virtual void TearDown() {
+        coalescer_.reset();
+        rac_.reset();
+        task_util::WaitForIdle();
+        evm_->Shutdown();
+        thread_->Join();
+        redis_->Shutdown();
+        redis_evm_->Shutdown();
+        redis_thread_->Join();
+        redis_.reset();
+    }
+
+    bool Update(const string &attr, const string &msg, int32_t seq,
+                const string &agg = "") {
+        return coalescer_->UVEUpdate("VrouterAgent", attr, "host1",
+            "Compute", "VRouterAgent", "0", "ObjectVRouter:host1", msg, seq,
+            agg, "", UTCTimestampUsec());
+    }
+
+    // Values written by the updates received by Redis, in order
+    vector<string> ReceivedValues() {
+        vector<string> values;
+        vector<vector<string> > cmds(redis_->Commands());
+        for (vector<vector<string> >::const_iterator it = cmds.begin();
+             it != cmds.end(); ++it) {
+            if ((*it)[0] == "EVAL") {
+                // The value is followed by the Redis db
+                values.push_back((*it)[it->size() - 2]);
+            }
+        }
+        return values;
+    }
+
+    boost::scoped_ptr<EventManager> redis_evm_;
+    boost::scoped_ptr<ServerThread> redis_thread_;
+    boost::scoped_ptr<RedisServerStandIn> redis_;
+    boost::scoped_ptr<EventManager> evm_;
+    boost::scoped_ptr<ServerThread> thread_;
+    boost::scoped_ptr<RedisAsyncConnection> rac_;
+    boost::scoped_ptr<RedisUVECoalescer> coalescer_;
+};
+
+// Repeated updates to an attribute are merged and sent in one batch
+TEST_F(RedisUVECoalescerTest, Coalesce) {
+    coalescer_->set_window(60 * 1000);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(Update("attr1", "a" + integerToString(i), i));
+    }
+    EXPECT_TRUE(Update("attr2", "b0", 10));
+    EXPECT_TRUE(Update("stats1", "s0", 11, "stats"));
+    EXPECT_TRUE(Update("stats1", "s1", 12, "stats"));
+    EXPECT_EQ(13U, coalescer_->Received());
+    EXPECT_EQ(9U, coalescer_->Coalesced());
+    EXPECT_EQ(4U, coalescer_->QueueDepth());
+    EXPECT_EQ(0U, redis_->CommandCount());
+
+    coalescer_->Flush();
+    EXPECT_EQ(0U, coalescer_->QueueDepth());
+    EXPECT_EQ(1U, coalescer_->Batches());
+    EXPECT_EQ(4U, coalescer_->BatchCommands());
+    EXPECT_EQ(0U, coalescer_->BatchFailed());
+    EXPECT_DOUBLE_EQ(9.0 / 13, coalescer_->CoalesceRatio());
+
+    // Only the latest update to attr1 is sent, in the order queued
+    TASK_UTIL_EXPECT_EQ(4U, redis_->CommandCount());
+    vector<string> values(ReceivedValues());
+    ASSERT_EQ(4U, values.size());
+    EXPECT_EQ("a9", values[0]);
+    EXPECT_EQ("b0", values[1]);
+    EXPECT_EQ("s0", values[2]);
+    EXPECT_EQ("s1", values[3]);
+
+    // Update queued after a pending one to the same attribute goes behind
+    // the updates queued in between
+    EXPECT_TRUE(Update("attr1", "a10", 13));
+    EXPECT_TRUE(Update("attr2", "b1", 14));
+    EXPECT_TRUE(Update("attr1", "a11", 15));
+    coalescer_->Flush();
+    TASK_UTIL_EXPECT_EQ(6U, redis_->CommandCount());
+    values = ReceivedValues();
+    EXPECT_EQ("b1", values[4]);
+    EXPECT_EQ("a11", values[5]);
+    EXPECT_LE(1, redis_->pipelined_reads());
+    TASK_UTIL_EXPECT_EQ(6U, rac_->CallbackSucceeded());
+}
+
+// Pending updates are sent when the window expires
+TEST_F(RedisUVECoalescerTest, Window) {
+    coalescer_->set_window(10);
+    EXPECT_TRUE(Update("attr1", "a0", 1));
+    EXPECT_TRUE(Update("attr1", "a1", 2));
+    TASK_UTIL_EXPECT_EQ(1U, redis_->CommandCount());
+    EXPECT_EQ("a1", ReceivedValues()[0]);
+    EXPECT_EQ(1U, coalescer_->Batches());
+
+    EXPECT_TRUE(Update("attr1", "a2", 3));
+    TASK_UTIL_EXPECT_EQ(2U, redis_->CommandCount());
+    EXPECT_EQ("a2", ReceivedValues()[1]);
+}
+
+// A full batch is sent without waiting for the window
+TEST_F(RedisUVECoalescerTest, BatchFull) {
+    coalescer_->set_window(60 * 1000);
+    for (size_t i = 0; i < RedisUVECoalescer::kMaxBatchSize; i++) {
+        EXPECT_TRUE(Update("attr" + integerToString(i), "a", i));
+    }
+    EXPECT_EQ(1U, coalescer_->Batches());
+    EXPECT_EQ(RedisUVECoalescer::kMaxBatchSize, coalescer_->BatchCommands());
+    EXPECT_EQ(RedisUVECoalescer::kMaxBatchSize,
+              coalescer_->QueueDepthMax());
+    TASK_UTIL_EXPECT_EQ(RedisUVECoalescer::kMaxBatchSize,
+                        redis_->CommandCount());
+}
+
+// Cleared updates are not sent
+TEST_F(RedisUVECoalescerTest, Clear) {
+    coalescer_->set_window(60 * 1000);
+    EXPECT_TRUE(Update("attr1", "a0", 1));
+    EXPECT_TRUE(Update("stats1", "s0", 2, "stats"));
+    EXPECT_EQ(2U, coalescer_->QueueDepth());
+    coalescer_->Clear();
+    EXPECT_EQ(0U, coalescer_->QueueDepth());
+    coalescer_->Flush();
+    EXPECT_EQ(0U, coalescer_->Batches());
+
+    // Updates queued after the clear are sent
+    EXPECT_TRUE(Update("attr1", "a1", 3));
+    coalescer_->Flush();
+    TASK_UTIL_EXPECT_EQ(1U, redis_->CommandCount());
+    EXPECT_EQ("a1", ReceivedValues()[0]);
+}
+
+// Window of 0 sends every update right away
+TEST_F(RedisUVECoalescerTest, NoWindow) {
+    coalescer_->set_window(0);
+    EXPECT_TRUE(Update("attr1", "a0", 1));
+    EXPECT_TRUE(Update("attr1", "a1", 2));
+    TASK_UTIL_EXPECT_EQ(2U, redis_->CommandCount());
+    EXPECT_EQ(0U, coalescer_->Batches());
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    LoggingInit();
+    int result = RUN_ALL_TESTS();
+    return result;
+}
@@ -28,6 +28,7 @@ using boost::system::error_code;
 VizCollector::VizCollector(EventManager *evm, unsigned short listen_port,
             bool protobuf_collector_enabled,
             unsigned short protobuf_listen_port,
+            size_t protobuf_batch_size,
             const std::vector<std::string> &cassandra_ips,
             const std::vector<int> &cassandra_ports,
             const std::string &redis_uve_ip, unsigned short redis_uve_port,
@@ -57,8 +58,8 @@ VizCollector::VizCollector(EventManager *evm, unsigned short listen_port,
         name_ = boost::asio::ip::host_name(error);
     if (protobuf_collector_enabled) {
         protobuf_collector_.reset(new ProtobufCollector(evm,
-            protobuf_listen_port, cassandra_ips, cassandra_ports,
-            analytics_ttl));
+            protobuf_listen_port, protobuf_batch_size, cassandra_ips,
+            cassandra_ports, analytics_ttl));
     }
 }
 
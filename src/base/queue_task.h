@@ -9,9 +9,16 @@
 // that drains the queue. The dequeue task runs a maximum of kMaxIterations
 // before yielding.
 //
+// Entries are handed to the client one at a time through the Callback, or
+// in vectors of up to batch_size entries through the BatchCallback when one
+// is set. With SetAdaptiveMaxIterations() the number of entries processed
+// before yielding is derived from the time spent per run instead of being
+// fixed.
+//
 #ifndef __QUEUE_TASK_H__
 #define __QUEUE_TASK_H__
 
+#include <algorithm>
 #include <vector>
 
 #include <tbb/atomic.h>
@@ -46,25 +53,69 @@ private:
             return queue_->RunnerDone();
         }
 
+        uint64_t start_time = 0;
+        if (queue_->adaptive_run_time_usec_) {
+            start_time = ClockMonotonicUsec();
+        }
+
+        size_t count;
+        if (queue_->batch_callback_.empty()) {
+            count = RunEntries();
+        } else {
+            count = RunBatches();
+        }
+
+        if (queue_->adaptive_run_time_usec_) {
+            queue_->UpdateMaxIterations(count,
+                                        ClockMonotonicUsec() - start_time);
+        }
+
+        // Running is done if queue_ is empty
+        // While notification is being run, its possible that more entries
+        // are added into queue_
+        return queue_->RunnerDone();
+    }
+
+    // Returns number of entries processed
+    size_t RunEntries() {
+        const typename QueueT::Callback &callback = queue_->GetCallback();
         QueueEntryT entry = QueueEntryT();
         size_t count = 0;
         while (queue_->Dequeue(&entry)) {
+            count++;
             // Process the entry
-            if (!queue_->GetCallback()(entry)) {
+            if (!callback(entry)) {
                 break;
             }
-            if (++count == queue_->max_iterations_) {
-                return queue_->RunnerDone();
+            if (count == queue_->max_iterations_) {
+                break;
             }
         }
+        return count;
+    }
 
-        // Running is done if queue_ is empty
-        // While notification is being run, its possible that more entries
-        // are added into queue_
-        return queue_->RunnerDone();
+    // Returns number of entries processed
+    size_t RunBatches() {
+        size_t count = 0;
+        while (count < queue_->max_iterations_) {
+            size_t max = std::min(queue_->batch_size_,
+                                  queue_->max_iterations_ - count);
+            if (queue_->DequeueBatch(&batch_, max) == 0) {
+                break;
+            }
+            count += batch_.size();
+            // Process the batch
+            bool more = queue_->batch_callback_(batch_);
+            batch_.clear();
+            if (!more) {
+                break;
+            }
+        }
+        return count;
     }
 
     QueueT *queue_;
+    std::vector<QueueEntryT> batch_;
 };
 
 template <typename QueueEntryT>
@@ -91,8 +142,15 @@ class WorkQueue {
 public:
     static const int kMaxSize = 1024;
     static const int kMaxIterations = 32;
+    static const int kMaxBatchSize = 32;
+    static const int kMinAdaptiveIterations = 8;
+    static const int kMaxAdaptiveIterations = 16 * 1024;
     typedef tbb::concurrent_queue<QueueEntryT> Queue;
+    typedef std::vector<QueueEntryT> EntryList;
     typedef boost::function<bool (QueueEntryT)> Callback;
+    // Entries in the list are owned by the callback once invoked. Return
+    // false to yield, like Callback.
+    typedef boost::function<bool (EntryList &)> BatchCallback;
     typedef boost::function<bool (void)> StartRunnerFunc;
     typedef boost::function<void (bool)> TaskExitCallback;
     typedef boost::function<bool ()> TaskEntryCallback;
@@ -124,7 +182,10 @@ public:
         enqueues_(0),
         dequeues_(0),
         drops_(0),
+        batches_(0),
+        batch_size_(kMaxBatchSize),
         max_iterations_(max_iterations),
+        adaptive_run_time_usec_(0),
         size_(size),
         bounded_(false),
         shutdown_scheduled_(false),
@@ -246,6 +307,22 @@ public:
         return success;
     }
 
+    // Pops up to max entries into entries. Returns number of entries popped.
+    size_t DequeueBatch(EntryList *entries, size_t max) {
+        QueueEntryT entry = QueueEntryT();
+        while (entries->size() < max && queue_.try_pop(entry)) {
+            entries->push_back(entry);
+        }
+        size_t count = entries->size();
+        if (count) {
+            dequeues_ += count;
+            batches_++;
+            size_t ocount = count_.fetch_and_add(-count);
+            ProcessLowWaterMarks(ocount, count);
+        }
+        return count;
+    }
+
     int GetTaskId() const {
         return taskId_;
     }
@@ -267,10 +344,29 @@ public:
         scheduler->Enqueue(current_runner_);
     }
 
-    Callback GetCallback() const {
+    const Callback &GetCallback() const {
         return callback_;
     }
 
+    // Process entries in batches of up to batch_size instead of one at a
+    // time. Should be set before entries are enqueued.
+    void SetBatchCallback(BatchCallback callback,
+                          size_t batch_size = kMaxBatchSize) {
+        assert(batch_size > 0);
+        batch_callback_ = callback;
+        batch_size_ = batch_size;
+    }
+
+    // Adjust max_iterations after every run such that a run takes about
+    // run_time_usec. 0 restores a fixed max_iterations.
+    void SetAdaptiveMaxIterations(uint64_t run_time_usec) {
+        adaptive_run_time_usec_ = run_time_usec;
+    }
+
+    size_t max_iterations() const {
+        return max_iterations_;
+    }
+
     void SetEntryCallback(TaskEntryCallback on_entry) {
         on_entry_cb_ = on_entry;
     }
@@ -329,6 +425,10 @@ public:
         return drops_;
     }
 
+    size_t NumBatches() const {
+        return batches_;
+    }
+
 private:
     void ShutdownLocked(bool delete_entries) {
         // Cancel QueueTaskRunner from the scheduler
@@ -372,6 +472,40 @@ private:
         ProcessWaterMarks(low_water_, count);
     }
 
+    // Dequeue of num entries moves the count from count down to
+    // count - num + 1 as seen by Dequeue(); invoke every water mark crossed.
+    void ProcessLowWaterMarks(size_t count, size_t num) {
+        tbb::spin_rw_mutex::scoped_lock read_lock(lwater_mutex_, false);
+        for (size_t i = 0; i < low_water_.size(); i++) {
+            if (low_water_[i].count_ <= count &&
+                low_water_[i].count_ + num > count) {
+                low_water_[i].cb_(low_water_[i].count_);
+            }
+        }
+    }
+
+    // Scale max_iterations_ towards the number of entries that fit in
+    // adaptive_run_time_usec_ based on the last run, moving half way at a
+    // time to damp variations between runs. Runs that stopped short of
+    // max_iterations_ within the budget carry no information about it.
+    void UpdateMaxIterations(size_t count, uint64_t run_time_usec) {
+        if (count < max_iterations_ &&
+            run_time_usec <= adaptive_run_time_usec_) {
+            return;
+        }
+        size_t target = kMaxAdaptiveIterations;
+        if (run_time_usec) {
+            target = (count * adaptive_run_time_usec_) / run_time_usec;
+        }
+        target = (max_iterations_ + target) / 2;
+        if (target < (size_t)kMinAdaptiveIterations) {
+            target = kMinAdaptiveIterations;
+        } else if (target > (size_t)kMaxAdaptiveIterations) {
+            target = kMaxAdaptiveIterations;
+        }
+        max_iterations_ = target;
+    }
+
     bool EnqueueInternal(QueueEntryT entry) {
         queue_.push(entry);
         enqueues_++;
@@ -429,6 +563,7 @@ private:
     int taskId_;
     int taskInstance_;
     Callback callback_;
+    BatchCallback batch_callback_;
     TaskEntryCallback on_entry_cb_;
     TaskExitCallback on_exit_cb_;
     StartRunnerFunc start_runner_;
@@ -439,7 +574,10 @@ private:
     size_t enqueues_;
     size_t dequeues_;
     size_t drops_;
+    size_t batches_;
+    size_t batch_size_;
     size_t max_iterations_;
+    uint64_t adaptive_run_time_usec_;
     size_t size_;
     bool bounded_;
     bool shutdown_scheduled_;
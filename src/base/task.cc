@@ -3,11 +3,15 @@
  */
 
 #include <assert.h>
+#include <strings.h>
+#include <algorithm>
 #include <fstream>
 #include <map>
+#include <new>
 #include <iostream>
 #include <boost/intrusive/set.hpp>
 
+#include "tbb/cache_aligned_allocator.h"
 #include "tbb/task.h"
 #include "tbb/enumerable_thread_specific.h"
 #include "base/logging.h"
@@ -34,6 +38,41 @@ typedef tbb::enumerable_thread_specific<Task *> TaskInfo;
 
 static TaskInfo task_running;
 
+// Small index given to each thread on its first task measurement. Picks the
+// latency histogram shard and the trace ring the thread records into.
+typedef tbb::enumerable_thread_specific<int> ThreadShard;
+
+static ThreadShard thread_shard(-1);
+static tbb::atomic<int> thread_shard_count;
+
+static int GetThreadShard() {
+    ThreadShard::reference shard = thread_shard.local();
+    if (shard < 0) {
+        shard = thread_shard_count.fetch_and_increment();
+    }
+    return shard;
+}
+
+// Slot of a trace ring. seq_ is 0 while the entry is being written, and is
+// then set to one more than the ring index the entry was written at. A
+// reader discards the entry if seq_ is 0 or changed while it was copied.
+struct TraceSlot {
+    tbb::atomic<uint64_t> seq_;
+    TaskTraceEntry entry_;
+};
+
+struct TaskScheduler::TraceRing {
+    TraceRing() {
+        index_ = 0;
+        for (int i = 0; i < TaskScheduler::kTraceBufferSize; i++) {
+            slot_[i].seq_ = 0;
+        }
+    }
+
+    tbb::atomic<uint64_t> index_;
+    TraceSlot slot_[TaskScheduler::kTraceBufferSize];
+};
+
 // Vector of Task entries
 typedef std::vector<TaskEntry *> TaskEntryList;
 
@@ -96,6 +135,7 @@ public:
     void RunCombinedDeferQ();
     void RunWaitQ();
     void RunDeferEntry();
+    void RunDeferQueues(TaskGroup *group);
     void TaskExited(Task *t, TaskGroup *group);
     TaskStats *GetTaskStats();
     void ClearTaskStats();
@@ -121,7 +161,7 @@ private:
 
     int             task_id_;
     int             task_instance_;
-    int             run_count_; // # of tasks running
+    tbb::atomic<int> run_count_; // # of tasks running
 
     Task            *run_task_; // Task currently running
     TaskList        waitq_;     // Tasks waiting to run on some condition
@@ -147,6 +187,8 @@ struct TaskDeferEntryCmp {
 // TaskGroup maintains per <task-id> information including,
 // polic_set_   : Boolean used to ensure policy is set only once per task
 //                Task policy change is not yet supported
+// policy_present_ : Set once the group is part of any policy rule, either
+//                   its own or a complementary one
 // policy_      : List of policy rules for the task
 // run_count_   : Number of tasks running in context of this task-group
 // deferq_      : Tasks deferred till run_count_ on this task becomes 0
@@ -168,6 +210,10 @@ public:
     void RunDeferQ();
     void TaskExited(Task *t);
     void PolicySet();
+    void PolicyAdded() { policy_present_ = true; }
+    // Tasks without instance in a group that does not take part in any
+    // policy are never deferred and may bypass the scheduler mutex.
+    bool LockFreeEligible() const { return !policy_present_; }
     void TaskStarted() {run_count_++;};
     TaskStats *GetTaskGroupStats();
     TaskStats *GetTaskStats();
@@ -206,7 +252,8 @@ private:
     static const int        kVectorGrowSize = 16;
     int                     task_id_;
     bool                    policy_set_;// policy already set?
-    int                     run_count_; // # of tasks running in the group
+    tbb::atomic<bool>       policy_present_;
+    tbb::atomic<int>        run_count_; // # of tasks running in the group
 
     TaskGroupPolicyList     policy_;    // Policy rules for the group
     TaskDeferList           deferq_;    // Tasks deferred till run_count_ is 0
@@ -227,9 +274,15 @@ private:
 tbb::task *TaskImpl::execute() {
     TaskInfo::reference running = task_running.local();
     running = parent_;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    bool measure = scheduler->task_measurement();
+    uint64_t start_time = measure ? ClockMonotonicUsec() : 0;
     try {
         bool is_complete = parent_->Run();
         running = NULL;
+        if (measure) {
+            scheduler->OnTaskRun(parent_, start_time, ClockMonotonicUsec());
+        }
         if (is_complete == true) {
             parent_->SetTaskComplete();
         } else {
@@ -283,6 +336,16 @@ int TaskScheduler::GetThreadCount() {
     return num_cores_;
 }
 
+// Scheduling mode used when the scheduler is created implicitly. Defaults
+// to LOCKED and can be overridden with TASK_SCHEDULER_MODE=lockfree
+TaskScheduler::Mode TaskScheduler::GetDefaultMode() {
+    char *mode_str = getenv("TASK_SCHEDULER_MODE");
+    if (mode_str && strcasecmp(mode_str, "lockfree") == 0) {
+        return LOCKFREE;
+    }
+    return LOCKED;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Implementation for class TaskScheduler 
 ////////////////////////////////////////////////////////////////////////////
@@ -293,7 +356,23 @@ int TaskScheduler::GetThreadCount() {
 // part of tbb. So, initialize TBB with one thread more than its default
 TaskScheduler::TaskScheduler() : 
     task_scheduler_(GetThreadCount() + 1),
-    running_(true), seqno_(0), id_max_(0) {
+    mode_(GetDefaultMode()), id_max_(0),
+    trace_rings_(GetThreadCount() + 1) {
+    running_ = true;
+    seqno_ = 0;
+    measure_ = true;
+    hw_thread_count_ = GetThreadCount();
+    task_group_db_.resize(TaskScheduler::kVectorGrowSize);
+    stop_entry_ = new TaskEntry(-1);
+}
+
+TaskScheduler::TaskScheduler(Mode mode) :
+    task_scheduler_(GetThreadCount() + 1),
+    mode_(mode), id_max_(0),
+    trace_rings_(GetThreadCount() + 1) {
+    running_ = true;
+    seqno_ = 0;
+    measure_ = true;
     hw_thread_count_ = GetThreadCount();
     task_group_db_.resize(TaskScheduler::kVectorGrowSize);
     stop_entry_ = new TaskEntry(-1);
@@ -320,6 +399,12 @@ TaskScheduler::~TaskScheduler() {
     stop_entry_ = NULL;
     task_group_db_.clear();
 
+    for (TraceRingList::iterator iter = trace_rings_.begin();
+         iter != trace_rings_.end(); ++iter) {
+        delete *iter;
+        *iter = NULL;
+    }
+
     return;
 }
 
@@ -328,6 +413,11 @@ void TaskScheduler::Initialize() {
     singleton_.reset(new TaskScheduler());
 }
 
+void TaskScheduler::Initialize(Mode mode) {
+    assert(singleton_.get() == NULL);
+    singleton_.reset(new TaskScheduler(mode));
+}
+
 TaskScheduler *TaskScheduler::GetInstance() {
     if (singleton_.get() == NULL) {
         singleton_.reset(new TaskScheduler());
@@ -340,7 +430,8 @@ TaskGroup *TaskScheduler::GetTaskGroup(int task_id) {
     assert(task_id >= 0);
     int size = task_group_db_.size();
     if (size <= task_id) {
-        task_group_db_.resize(task_id + TaskScheduler::kVectorGrowSize);
+        task_group_db_.grow_to_at_least(task_id +
+                                        TaskScheduler::kVectorGrowSize);
     }
 
     TaskGroup *group = task_group_db_[task_id];
@@ -386,11 +477,13 @@ void TaskScheduler::SetPolicy(int task_id, TaskPolicy &policy) {
     TaskGroup *group = GetTaskGroup(task_id);
     TaskEntry *group_entry = group->GetTaskEntry(-1);
     group->PolicySet();
+    group->PolicyAdded();
 
     for (TaskPolicy::iterator it = policy.begin(); it != policy.end(); ++it) {
 
         if (it->match_instance == -1) {
             TaskGroup *policy_group = GetTaskGroup(it->match_id);
+            policy_group->PolicyAdded();
             group->AddPolicy(policy_group);
             policy_group->AddPolicy(group);
         } else {
@@ -409,15 +502,50 @@ void TaskScheduler::SetPolicy(int task_id, TaskPolicy &policy) {
 // Enqueue a Task for running. Starts task if all policy rules are met else 
 // puts task in waitq
 void TaskScheduler::Enqueue(Task *t) {
+    if (mode_ == LOCKFREE && EnqueueLockFree(t)) {
+        return;
+    }
+
     tbb::mutex::scoped_lock     lock(mutex_);
 
     EnqueueUnLocked(t);
 }
 
+// Start a task without taking the scheduler mutex. Only tasks that can
+// never be deferred qualify, i.e. tasks without instance whose TaskGroup is
+// not part of any policy, when the scheduler is running. Returns false if
+// the task must go through EnqueueUnLocked()
+//
+// Tasks of such groups run concurrently with each other, so the only
+// ordering relaxed here is against tasks parked while the scheduler was
+// stopped and not yet restarted by Start()
+bool TaskScheduler::EnqueueLockFree(Task *t) {
+    if (t->GetTaskInstance() != Task::kTaskInstanceAny || !running_) {
+        return false;
+    }
+
+    // The TaskGroup is created on the first enqueue under mutex_
+    if (t->GetTaskId() >= (int)task_group_db_.size()) {
+        return false;
+    }
+    TaskGroup *group = task_group_db_[t->GetTaskId()];
+    if (group == NULL || !group->LockFreeEligible()) {
+        return false;
+    }
+
+    // Ensure that task is enqueued only once.
+    assert(t->GetSeqno() == 0);
+    t->SetSeqNo(seqno_.fetch_and_increment() + 1);
+    t->SetEnqueueTime(measure_ ? ClockMonotonicUsec() : 0);
+    group->task_entry_->RunTask(t);
+    return true;
+}
+
 void TaskScheduler::EnqueueUnLocked(Task *t) {
     // Ensure that task is enqueued only once.
     assert(t->GetSeqno() == 0);
-    t->SetSeqNo(++seqno_);
+    t->SetSeqNo(seqno_.fetch_and_increment() + 1);
+    t->SetEnqueueTime(measure_ ? ClockMonotonicUsec() : 0);
     TaskGroup *group = GetTaskGroup(t->GetTaskId());
 
 
@@ -507,14 +635,150 @@ TaskScheduler::CancelReturnCode TaskScheduler::Cancel(Task *t) {
 // Method invoked on exit of a Task.
 // Exit of a task can potentially start tasks in pendingq.
 void TaskScheduler::OnTaskExit(Task *t) {
+    if (mode_ == LOCKFREE && OnTaskExitLockFree(t)) {
+        return;
+    }
+
     tbb::mutex::scoped_lock lock(mutex_);
 
     TaskEntry *entry = QueryTaskEntry(t->GetTaskId(), t->GetTaskInstance());
     entry->TaskExited(t, GetTaskGroup(t->GetTaskId()));
 
-    //
-    // Delete the task it is not marked for recycling or already cancelled.
-    //
+    if (ReleaseTask(t)) {
+        EnqueueUnLocked(t);
+    }
+}
+
+// Counterpart of EnqueueLockFree() on task exit. Nothing can be deferred on
+// a TaskEntry that is not part of any policy, so dropping the run counts is
+// all that is needed. If a policy was added to the group meanwhile, some
+// other task may have deferred on these counts and the deferq_ must be
+// processed under mutex_ as usual.
+//
+// Cancel() inspects and marks the task under mutex_, so the task is still
+// released under mutex_. Otherwise a Cancel() racing with the exit can be
+// lost on a recycled task, or mark a task that has already been deleted.
+// Only the run count bookkeeping is lock free here, the mutex is held just
+// long enough to release the task.
+bool TaskScheduler::OnTaskExitLockFree(Task *t) {
+    if (t->GetTaskInstance() != Task::kTaskInstanceAny) {
+        return false;
+    }
+
+    TaskGroup *group = QueryTaskGroup(t->GetTaskId());
+    if (!group->LockFreeEligible()) {
+        return false;
+    }
+
+    TaskEntry *entry = group->task_entry_;
+    entry->run_count_--;
+    group->TaskExited(t);
+
+    bool recycle;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        if (!group->LockFreeEligible()) {
+            entry->RunDeferQueues(group);
+        }
+        recycle = ReleaseTask(t);
+    }
+
+    if (recycle) {
+        Enqueue(t);
+    }
+    return true;
+}
+
+// Invoked from the tbb worker after Run() returns, when task measurement is
+// enabled. Records wait and run latency of the task in its TaskEntry and
+// TaskGroup stats, and the execution in the trace ring of the thread. Only
+// the shards of the current thread are written, the scheduler mutex is not
+// taken. The wait time is not known for tasks enqueued while measurement
+// was disabled.
+void TaskScheduler::OnTaskRun(Task *t, uint64_t start_time,
+                              uint64_t end_time) {
+    int shard = GetThreadShard();
+    uint64_t run_time = end_time - start_time;
+    TaskStats *entry_stats = &t->task_entry_->stats_;
+    TaskStats *group_stats = &QueryTaskGroup(t->GetTaskId())->stats_;
+
+    if (t->enqueue_time_ != 0) {
+        uint64_t wait_time = 0;
+        if (start_time > t->enqueue_time_)
+            wait_time = start_time - t->enqueue_time_;
+        entry_stats->wait_time_.Add(shard, wait_time);
+        group_stats->wait_time_.Add(shard, wait_time);
+    }
+    entry_stats->run_time_.Add(shard, run_time);
+    group_stats->run_time_.Add(shard, run_time);
+
+    TraceRing *ring = GetTraceRing(shard);
+    uint64_t index = ring->index_.fetch_and_increment();
+    TraceSlot &slot = ring->slot_[index % kTraceBufferSize];
+    slot.seq_ = 0;
+    // Order the invalidation of the slot before the writes to the entry.
+    // The store of the new seq_ below has release semantics
+    __sync_synchronize();
+    slot.entry_.task_id_ = t->GetTaskId();
+    slot.entry_.task_instance_ = t->GetTaskInstance();
+    slot.entry_.seqno_ = t->GetSeqno();
+    slot.entry_.enqueue_time_ = t->enqueue_time_;
+    slot.entry_.start_time_ = start_time;
+    slot.entry_.run_time_ = run_time;
+    slot.seq_ = index + 1;
+}
+
+// Get the trace ring for a thread shard, allocating it on first use
+TaskScheduler::TraceRing *TaskScheduler::GetTraceRing(int shard) {
+    tbb::atomic<TraceRing *> &ring = trace_rings_[shard % trace_rings_.size()];
+    if (ring == NULL) {
+        TraceRing *new_ring = new TraceRing();
+        if (ring.compare_and_swap(new_ring, NULL) != NULL) {
+            delete new_ring;
+        }
+    }
+    return ring;
+}
+
+static bool TraceEntryLess(const TaskTraceEntry &lhs,
+                           const TaskTraceEntry &rhs) {
+    return lhs.start_time_ < rhs.start_time_;
+}
+
+// Merge the trace rings of all threads, oldest execution first. Slots that
+// are being written while copied are skipped.
+void TaskScheduler::GetTaskTrace(std::vector<TaskTraceEntry> *trace) const {
+    trace->clear();
+    for (TraceRingList::const_iterator iter = trace_rings_.begin();
+         iter != trace_rings_.end(); ++iter) {
+        const TraceRing *ring = *iter;
+        if (ring == NULL) {
+            continue;
+        }
+        for (int i = 0; i < kTraceBufferSize; i++) {
+            const TraceSlot &slot = ring->slot_[i];
+            uint64_t seq = slot.seq_;
+            if (seq == 0) {
+                continue;
+            }
+            TaskTraceEntry entry = slot.entry_;
+            __sync_synchronize();
+            if (slot.seq_ != seq) {
+                continue;
+            }
+            trace->push_back(entry);
+        }
+    }
+
+    std::sort(trace->begin(), trace->end(), TraceEntryLess);
+    if (trace->size() > (size_t)kTraceBufferSize) {
+        trace->erase(trace->begin(), trace->end() - kTraceBufferSize);
+    }
+}
+
+// Delete the task if it is not marked for recycling or already cancelled.
+// Returns true if the task is to be enqueued again.
+bool TaskScheduler::ReleaseTask(Task *t) {
     if ((t->task_recycle_ == false) || (t->task_cancel_ == true)) {
         // Delete the container Task object, if the 
         // task is not marked to be recycled (or) 
@@ -523,14 +787,14 @@ void TaskScheduler::OnTaskExit(Task *t) {
             t->OnTaskCancel();
         }
         delete t;
-        return;
+        return false;
     }
 
     // Task is being recycled, reset the state, seq_no and TBB task handle
     t->task_impl_ = NULL;
     t->SetSeqNo(0);
     t->state_ = Task::INIT;
-    EnqueueUnLocked(t);
+    return true;
 }
 
 void TaskScheduler::Stop() {
@@ -775,11 +1039,11 @@ void TaskScheduler::ClearRunningTask() {
 // Implementation for class TaskGroup 
 ////////////////////////////////////////////////////////////////////////////
 
-TaskGroup::TaskGroup(int task_id) : task_id_(task_id), policy_set_(false), 
-    run_count_(0) {
+TaskGroup::TaskGroup(int task_id) : task_id_(task_id), policy_set_(false) {
+    policy_present_ = false;
+    run_count_ = 0;
     task_entry_db_.resize(TaskGroup::kVectorGrowSize);
     task_entry_ = new TaskEntry(task_id);
-    memset(&stats_, 0, sizeof(stats_));
 }
 
 TaskGroup::~TaskGroup() {
@@ -927,7 +1191,7 @@ bool TaskGroup::IsWaitQEmpty() {
 }
 
 void TaskGroup::ClearTaskGroupStats() {
-    memset(&stats_, 0, sizeof(stats_));
+    stats_.Reset();
 }
 
 void TaskGroup::ClearTaskStats() {
@@ -958,22 +1222,22 @@ TaskStats *TaskGroup::GetTaskStats(int task_instance) {
 ////////////////////////////////////////////////////////////////////////////
 
 TaskEntry::TaskEntry(int task_id, int task_instance) : task_id_(task_id),
-    task_instance_(task_instance), run_count_(0), run_task_(NULL),
+    task_instance_(task_instance), run_task_(NULL),
     deferq_task_entry_(NULL), deferq_task_group_(NULL) {
+    run_count_ = 0;
     // When a new TaskEntry is created, adds an implicit rule into policyq_ to
     // ensure that only one Task of an instance is run at a time
     if (task_instance != -1) {
         policyq_.push_back(this);
     }
-    memset(&stats_, 0, sizeof(stats_));
     // allocate memory for deferq
     deferq_ = new TaskDeferList;
 }
 
 TaskEntry::TaskEntry(int task_id) : task_id_(task_id),
-    task_instance_(-1), run_count_(0), run_task_(NULL),
+    task_instance_(-1), run_task_(NULL),
     deferq_task_entry_(NULL), deferq_task_group_(NULL) {
-    memset(&stats_, 0, sizeof(stats_));
+    run_count_ = 0;
     // allocate memory for deferq
     deferq_ = new TaskDeferList;
 }
@@ -1054,6 +1318,7 @@ void TaskEntry::DeleteFromDeferQ(TaskEntry &entry) {
 // If there are more entries in waitq_ add them to deferq_
 void TaskEntry::RunTask (Task *t) {
     stats_.run_count_++;
+    t->task_entry_ = this;
     if (t->GetTaskInstance() != -1) {
         assert(run_task_ == NULL);
         assert (run_count_ == 0);
@@ -1177,7 +1442,12 @@ void TaskEntry::TaskExited(Task *t, TaskGroup *group) {
     
     run_count_--;
     group->TaskExited(t);
+    RunDeferQueues(group);
+}
 
+// Run the deferq_ of the TaskEntry and/or TaskGroup whose run count
+// dropped to 0
+void TaskEntry::RunDeferQueues(TaskGroup *group) {
     if (!group->run_count_ && !run_count_) {
         RunCombinedDeferQ();
     } else if (!group->run_count_) {
@@ -1194,7 +1464,7 @@ void TaskEntry::ClearQueues() {
 }
 
 void TaskEntry::ClearTaskStats() {
-    memset(&stats_, 0, sizeof(stats_));
+    stats_.Reset();
 }
 
 TaskStats *TaskEntry::GetTaskStats() {
@@ -1214,16 +1484,149 @@ int TaskEntry::GetTaskDeferEntrySeqno() const {
     return -1;
 }
 
+////////////////////////////////////////////////////////////////////////////
+// Implementation for class TaskLatencyHistogram
+////////////////////////////////////////////////////////////////////////////
+
+// Counters stay atomic since threads beyond the shard count wrap onto the
+// same shard, and Clear() may run from introspect. They are normally only
+// updated by one thread, so the cache line is not contended.
+struct TaskLatencyHistogram::Shard {
+    Shard() { Clear(); }
+
+    void Clear() {
+        count_ = 0;
+        total_usec_ = 0;
+        max_usec_ = 0;
+        for (int i = 0; i < kBucketCount; i++) {
+            bucket_[i] = 0;
+        }
+    }
+
+    tbb::atomic<uint64_t> count_;
+    tbb::atomic<uint64_t> total_usec_;
+    tbb::atomic<uint64_t> max_usec_;
+    tbb::atomic<uint32_t> bucket_[kBucketCount];
+};
+
+TaskLatencyHistogram::Totals::Totals()
+    : count_(0), total_usec_(0), max_usec_(0) {
+    for (int i = 0; i < kBucketCount; i++) {
+        bucket_[i] = 0;
+    }
+}
+
+TaskLatencyHistogram::TaskLatencyHistogram()
+    : shards_(TaskScheduler::GetThreadCount() + 1) {
+}
+
+TaskLatencyHistogram::~TaskLatencyHistogram() {
+    for (ShardList::iterator iter = shards_.begin(); iter != shards_.end();
+         ++iter) {
+        Shard *shard = *iter;
+        if (shard != NULL) {
+            FreeShard(shard);
+        }
+    }
+}
+
+// Shards are cache line aligned so that shards of different threads never
+// share a cache line
+TaskLatencyHistogram::Shard *TaskLatencyHistogram::AllocateShard() {
+    tbb::cache_aligned_allocator<Shard> allocator;
+    return new (allocator.allocate(1)) Shard();
+}
+
+void TaskLatencyHistogram::FreeShard(Shard *shard) {
+    tbb::cache_aligned_allocator<Shard> allocator;
+    shard->~Shard();
+    allocator.deallocate(shard, 1);
+}
+
+void TaskLatencyHistogram::Add(int shard_index, uint64_t usec) {
+    tbb::atomic<Shard *> &slot = shards_[shard_index % shards_.size()];
+    if (slot == NULL) {
+        Shard *new_shard = AllocateShard();
+        if (slot.compare_and_swap(new_shard, NULL) != NULL) {
+            FreeShard(new_shard);
+        }
+    }
+    Shard *shard = slot;
+
+    shard->count_++;
+    shard->total_usec_ += usec;
+
+    uint64_t max = shard->max_usec_;
+    while (usec > max) {
+        if (shard->max_usec_.compare_and_swap(usec, max) == max)
+            break;
+        max = shard->max_usec_;
+    }
+
+    int bucket = 0;
+    if (usec)
+        bucket = 64 - __builtin_clzll(usec);
+    if (bucket >= kBucketCount)
+        bucket = kBucketCount - 1;
+    shard->bucket_[bucket]++;
+}
+
+// Sum the shards. Samples recorded meanwhile may be partially included
+void TaskLatencyHistogram::Get(Totals *totals) const {
+    *totals = Totals();
+    for (ShardList::const_iterator iter = shards_.begin();
+         iter != shards_.end(); ++iter) {
+        const Shard *shard = *iter;
+        if (shard == NULL) {
+            continue;
+        }
+        totals->count_ += shard->count_;
+        totals->total_usec_ += shard->total_usec_;
+        if (shard->max_usec_ > totals->max_usec_)
+            totals->max_usec_ = shard->max_usec_;
+        for (int i = 0; i < kBucketCount; i++) {
+            totals->bucket_[i] += shard->bucket_[i];
+        }
+    }
+}
+
+void TaskLatencyHistogram::Clear() {
+    for (ShardList::iterator iter = shards_.begin(); iter != shards_.end();
+         ++iter) {
+        Shard *shard = *iter;
+        if (shard != NULL) {
+            shard->Clear();
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////
+// Implementation for class TaskStats
+////////////////////////////////////////////////////////////////////////////
+TaskStats::TaskStats() {
+    Reset();
+}
+
+void TaskStats::Reset() {
+    wait_count_ = 0;
+    run_count_ = 0;
+    defer_count_ = 0;
+    wait_time_.Clear();
+    run_time_.Clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////
 // Implementation for class Task
 ////////////////////////////////////////////////////////////////////////////
 Task::Task(int task_id, int task_instance) : task_id_(task_id),
-    task_instance_(task_instance), task_impl_(NULL), state_(INIT), seqno_(0),
+    task_instance_(task_instance), task_impl_(NULL), task_entry_(NULL),
+    enqueue_time_(0), state_(INIT), seqno_(0),
     task_recycle_(false), task_cancel_(false) {
 }
 
 Task::Task(int task_id) : task_id_(task_id),
-    task_instance_(-1), task_impl_(NULL), state_(INIT), seqno_(0),
+    task_instance_(-1), task_impl_(NULL), task_entry_(NULL),
+    enqueue_time_(0), state_(INIT), seqno_(0),
     task_recycle_(false), task_cancel_(false) {
 }
 
@@ -1280,6 +1683,35 @@ static const string TaskStateToString(Task::State state) {
     }
 }
 
+static void GetLatencySandeshData(const TaskLatencyHistogram &histogram,
+                                  SandeshTaskLatency *resp) {
+    TaskLatencyHistogram::Totals totals;
+    histogram.Get(&totals);
+    resp->set_count(totals.count_);
+    resp->set_total_usec(totals.total_usec_);
+    resp->set_max_usec(totals.max_usec_);
+    std::vector<uint32_t> buckets;
+    for (int i = 0; i < TaskLatencyHistogram::kBucketCount; i++) {
+        buckets.push_back(totals.bucket_[i]);
+    }
+    resp->set_buckets(buckets);
+}
+
+void TaskScheduler::GetTaskStatsSandeshData(const TaskStats *stats,
+                                            SandeshTaskStats *resp) {
+    resp->set_wait_count(stats->wait_count_);
+    resp->set_run_count(stats->run_count_);
+    resp->set_defer_count(stats->defer_count_);
+
+    SandeshTaskLatency wait_time;
+    GetLatencySandeshData(stats->wait_time_, &wait_time);
+    resp->set_wait_time(wait_time);
+
+    SandeshTaskLatency run_time;
+    GetLatencySandeshData(stats->run_time_, &run_time);
+    resp->set_run_time(run_time);
+}
+
 void TaskScheduler::GetTaskEntrySummary(TaskEntry *entry,
                                         SandeshTaskEntrySummary *summary) {
     summary->set_task_entry_key(TaskEntryToString(entry));
@@ -1390,9 +1822,7 @@ void TaskScheduler::GetTaskEntrySandeshData(int task_id, int instance_id,
     resp->set_defer_list(defer_list);
 
     SandeshTaskStats stats;
-    stats.set_wait_count(entry->GetTaskStats()->wait_count_);
-    stats.set_run_count(entry->GetTaskStats()->run_count_);
-    stats.set_defer_count(entry->GetTaskStats()->defer_count_);
+    GetTaskStatsSandeshData(entry->GetTaskStats(), &stats);
     resp->set_summary_stats(stats);
 
     if (entry->deferq_task_entry_) {
@@ -27,6 +27,17 @@
 //
 // When there are multiple tasks ready to run, they are scheduled in their
 // order of enqueue
+//
+// The scheduler runs in one of two modes, selected when it is created,
+// - LOCKED   : every Enqueue/OnTaskExit/Cancel serializes on one mutex
+// - LOCKFREE : tasks that can never be deferred (no instance and a task
+//              group without any exclusion policy) are enqueued without the
+//              mutex. Their readiness is tracked with atomic run counters
+//              and they are spawned straight onto the tbb run queues. Their
+//              exit still takes the mutex briefly to release the task, as
+//              do Cancel() and all other tasks, hence TaskPolicy semantics
+//              are unchanged. The scheduler keeps no per-worker queues of
+//              its own and relies on tbb for load balancing.
 
 #ifndef ctrlplane_task_h
 #define ctrlplane_task_h
@@ -34,6 +45,8 @@
 #include <boost/scoped_ptr.hpp>
 #include <map>
 #include <vector>
+#include <tbb/atomic.h>
+#include <tbb/concurrent_vector.h>
 #include <tbb/mutex.h>
 #include <tbb/reader_writer_lock.h>
 #include <tbb/task.h>
@@ -47,11 +60,67 @@ class SandeshTaskGroupResp;
 class SandeshTaskEntryResp;
 class SandeshTaskEntrySummary;
 class SandeshTaskResp;
+class SandeshTaskStats;
+
+// Latency histogram with log2 buckets. Bucket 0 counts samples of 0 usec
+// and bucket i counts samples in [2^(i-1), 2^i) usec. The last bucket also
+// takes every sample beyond its range. Samples are counted in per-thread
+// shards, allocated on first use and summed by Get(), so that concurrent
+// workers do not contend on the same cache lines.
+class TaskLatencyHistogram {
+public:
+    static const int kBucketCount = 24;
+
+    struct Totals {
+        Totals();
+        uint64_t count_;
+        uint64_t total_usec_;
+        uint64_t max_usec_;
+        uint32_t bucket_[kBucketCount];
+    };
+
+    TaskLatencyHistogram();
+    ~TaskLatencyHistogram();
+
+    // shard is a small per-thread index, wrapped to the number of shards
+    void Add(int shard, uint64_t usec);
+    void Get(Totals *totals) const;
+    void Clear();
+
+private:
+    struct Shard;
+    typedef std::vector<tbb::atomic<Shard *> > ShardList;
+
+    static Shard *AllocateShard();
+    static void FreeShard(Shard *shard);
+
+    ShardList shards_;
+
+    DISALLOW_COPY_AND_ASSIGN(TaskLatencyHistogram);
+};
 
+// Counters are atomic since tasks running in LOCKFREE mode update them
+// without holding the scheduler mutex.
 struct TaskStats {
-    int     wait_count_;
-    int     run_count_;
-    int     defer_count_;
+    TaskStats();
+    void Reset();
+
+    tbb::atomic<int> wait_count_;
+    tbb::atomic<int> run_count_;
+    tbb::atomic<int> defer_count_;
+    TaskLatencyHistogram wait_time_;    // Enqueue to start of Run()
+    TaskLatencyHistogram run_time_;     // Duration of Run()
+};
+
+// Record of a task execution kept in the scheduler trace buffer. Times are
+// in usec from ClockMonotonicUsec()
+struct TaskTraceEntry {
+    int         task_id_;
+    int         task_instance_;
+    uint32_t    seqno_;
+    uint64_t    enqueue_time_;
+    uint64_t    start_time_;
+    uint64_t    run_time_;
 };
 
 struct TaskExclusion {
@@ -104,6 +173,7 @@ private:
     friend class TaskScheduler;
     friend class TaskImpl;
     void SetSeqNo(int seqno) {seqno_ = seqno;};
+    void SetEnqueueTime(uint64_t time) { enqueue_time_ = time; };
     void SetState(State s) { state_ = s; };
     void SetTaskRecycle() { task_recycle_ = true; };
     void SetTaskComplete() { task_recycle_ = false; };
@@ -112,6 +182,8 @@ private:
     int                 task_id_;       // The code path executed by the task.
     int                 task_instance_; // The dataset id within a code path.
     tbb::task           *task_impl_;
+    TaskEntry           *task_entry_;   // TaskEntry the task is running in.
+    uint64_t            enqueue_time_;
     State               state_;
     uint32_t            seqno_;
     bool                task_recycle_;
@@ -130,10 +202,17 @@ private:
 // task id or task instance to have a 0 count.
 class TaskScheduler {
 public:
+    enum Mode {
+        LOCKED,
+        LOCKFREE,
+    };
+
     TaskScheduler();
+    explicit TaskScheduler(Mode mode);
     ~TaskScheduler();
 
     static void Initialize();
+    static void Initialize(Mode mode);
     static TaskScheduler *GetInstance();
 
     // Enqueue a task. This may result in the task being immedietly added to
@@ -176,15 +255,29 @@ public:
     void Terminate();
 
     int HardwareThreadCount() { return hw_thread_count_; }
+    Mode mode() const { return mode_; }
 
     // Get number of tbb worker threads.
     static int GetThreadCount();
 
+    // Get the default scheduling mode.
+    static Mode GetDefaultMode();
+
+    // Number of task executions kept in the trace buffer.
+    static const int kTraceBufferSize = 1024;
+    void GetTaskTrace(std::vector<TaskTraceEntry> *trace) const;
+
+    // Latency histograms and the trace buffer are recorded in per-thread
+    // shards and merged when read, so measurement is on by default.
+    void EnableTaskMeasurement(bool enable) { measure_ = enable; }
+    bool task_measurement() const { return measure_; }
+
 private:
     friend class SandeshTaskSchedulerReq;
     friend class SandeshTaskGroupReq;
     friend class SandeshTaskEntryReq;
     friend class SandeshTaskReq;
+    friend class SandeshTaskMeasureReq;
     void GetTaskGroupSandeshData(int task_id, SandeshTaskGroupResp *resp);
     void GetTaskEntrySandeshData(int task_id, int instance_id,
                                  SandeshTaskEntryResp *resp);
@@ -192,10 +285,17 @@ private:
                             SandeshTaskResp *resp);
     void GetTaskEntrySummary(TaskEntry *entry,
                              SandeshTaskEntrySummary *summary);
+    static void GetTaskStatsSandeshData(const TaskStats *stats,
+                                        SandeshTaskStats *resp);
 private:
+    friend class TaskImpl;
     friend class ConcurrencyScope;
-    typedef std::vector<TaskGroup *> TaskGroupDb;
+    // Entries are atomic and the vector never relocates them, so that the
+    // LOCKFREE paths can look up a TaskGroup without holding mutex_
+    typedef tbb::concurrent_vector<tbb::atomic<TaskGroup *> > TaskGroupDb;
     typedef std::map<std::string, int> TaskIdMap;
+    struct TraceRing;
+    typedef std::vector<tbb::atomic<TraceRing *> > TraceRingList;
 
     static const int        kVectorGrowSize = 16;
     static boost::scoped_ptr<TaskScheduler> singleton_;
@@ -210,12 +310,19 @@ private:
 
     int CountThreadsPerPid(pid_t pid);
 
+    bool EnqueueLockFree(Task *task);
+    bool OnTaskExitLockFree(Task *task);
+    bool ReleaseTask(Task *task);
+    void OnTaskRun(Task *task, uint64_t start_time, uint64_t end_time);
+    TraceRing *GetTraceRing(int shard);
+
     TaskEntry               *stop_entry_;
 
     tbb::task_scheduler_init task_scheduler_;
     tbb::mutex              mutex_;
-    bool                    running_;
-    int                     seqno_;
+    Mode                    mode_;
+    tbb::atomic<bool>       running_;
+    tbb::atomic<int>        seqno_;
     TaskGroupDb             task_group_db_;
 
     tbb::reader_writer_lock id_map_mutex_;
@@ -224,6 +331,11 @@ private:
 
     int                     hw_thread_count_;
 
+    // Per-thread rings of the last kTraceBufferSize task executions,
+    // allocated on first use. GetTaskTrace() merges them by start time
+    TraceRingList           trace_rings_;
+    tbb::atomic<bool>       measure_;
+
     DISALLOW_COPY_AND_ASSIGN(TaskScheduler);
 };
 
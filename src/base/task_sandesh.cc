@@ -34,12 +34,6 @@ void DecodeTaskKey(const string &key, int *task_id, int *instance_id,
     sscanf(key.c_str(), "%d:%d:%d", task_id, instance_id, seqno);
 }
 
-static void SetStats(SandeshTaskStats &dest, TaskStats *src) {
-    dest.set_wait_count(src->wait_count_);
-    dest.set_run_count(src->run_count_);
-    dest.set_defer_count(src->defer_count_);
-}
-
 void SandeshTaskSchedulerReq::HandleRequest() const {
     TaskScheduler *scheduler = TaskScheduler::GetInstance();
     tbb::mutex::scoped_lock lock(scheduler->mutex_);
@@ -48,6 +42,7 @@ void SandeshTaskSchedulerReq::HandleRequest() const {
     resp->set_running(scheduler->running_);
     resp->set_seqno(scheduler->seqno_);
     resp->set_thread_count(scheduler->hw_thread_count_);
+    resp->set_measure(scheduler->task_measurement());
 
     std::vector<SandeshTaskGroupNameSummary> list;
     for (TaskScheduler::TaskIdMap::const_iterator it = 
@@ -60,6 +55,42 @@ void SandeshTaskSchedulerReq::HandleRequest() const {
     }
     resp->set_task_group_list(list);
 
+    if (get_trace()) {
+        std::vector<TaskTraceEntry> trace;
+        scheduler->GetTaskTrace(&trace);
+        std::vector<SandeshTaskTrace> trace_list;
+        for (std::vector<TaskTraceEntry>::const_iterator it = trace.begin();
+             it != trace.end(); ++it) {
+            SandeshTaskTrace entry;
+            entry.set_task_id(it->task_id_);
+            entry.set_instance_id(it->task_instance_);
+            entry.set_seqno(it->seqno_);
+            entry.set_enqueue_time(it->enqueue_time_);
+            entry.set_start_time(it->start_time_);
+            // enqueue_time_ is 0 if measurement was off at enqueue
+            if (it->enqueue_time_ != 0 &&
+                it->start_time_ > it->enqueue_time_) {
+                entry.set_wait_usec(it->start_time_ - it->enqueue_time_);
+            } else {
+                entry.set_wait_usec(0);
+            }
+            entry.set_run_usec(it->run_time_);
+            trace_list.push_back(entry);
+        }
+        resp->set_trace_list(trace_list);
+    }
+
+    resp->set_context(context());
+    resp->set_more(false);
+    resp->Response();
+}
+
+void SandeshTaskMeasureReq::HandleRequest() const {
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->EnableTaskMeasurement(get_enable());
+
+    SandeshTaskMeasureResp *resp = new SandeshTaskMeasureResp;
+    resp->set_measure(scheduler->task_measurement());
     resp->set_context(context());
     resp->set_more(false);
     resp->Response();
@@ -75,7 +106,8 @@ void SandeshTaskGroupReq::HandleRequest() const {
     if (group != NULL) {
         resp->set_task_id(get_task_id());
         SandeshTaskStats stats;
-        SetStats(stats, scheduler->GetTaskGroupStats(get_task_id()));
+        TaskScheduler::GetTaskStatsSandeshData(
+            scheduler->GetTaskGroupStats(get_task_id()), &stats);
         resp->set_summary_stats(stats);
         scheduler->GetTaskGroupSandeshData(get_task_id(), resp);
     }
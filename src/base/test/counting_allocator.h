@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __BASE__COUNTING_ALLOCATOR_H__
+#define __BASE__COUNTING_ALLOCATOR_H__
+
+#include <cstddef>
+#include <memory>
+
+// Heap memory held by all the CountingAllocators, for comparing the memory
+// used by a standard container with that of a replacement
+inline size_t &CountingAllocatorBytes() {
+    static size_t bytes;
+    return bytes;
+}
+
+template <typename T>
+class CountingAllocator : public std::allocator<T> {
+public:
+    template <typename U> struct rebind {
+        typedef CountingAllocator<U> other;
+    };
+
+    CountingAllocator() { }
+    CountingAllocator(const CountingAllocator &rhs) : std::allocator<T>(rhs) { }
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &rhs) { }
+
+    T *allocate(size_t n, const void *hint = 0) {
+        CountingAllocatorBytes() += n * sizeof(T);
+        return std::allocator<T>::allocate(n);
+    }
+    void deallocate(T *p, size_t n) {
+        CountingAllocatorBytes() -= n * sizeof(T);
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+#endif // __BASE__COUNTING_ALLOCATOR_H__
@@ -64,6 +64,11 @@ public:
         dequeues_++;
         return true;
     }
+    bool DequeueBatch(std::vector<int> &entries) {
+        dequeues_ += entries.size();
+        batch_sizes_.push_back(entries.size());
+        return true;
+    }
     bool StartRunnerAlways() {
         return true;
     }
@@ -82,6 +87,13 @@ public:
     void SetWorkQueueMaxIterations(size_t niterations) {
         work_queue_.max_iterations_ = niterations;
     }
+    size_t WorkQueueMaxIterations() {
+        return work_queue_.max_iterations_;
+    }
+    // Account a run of count entries taking run_time_usec
+    void UpdateWorkQueueMaxIterations(size_t count, uint64_t run_time_usec) {
+        work_queue_.UpdateMaxIterations(count, run_time_usec);
+    }
     void WaterMarkCallback(size_t wm_count) {
         wm_cb_count_ = wm_count;
     }
@@ -133,6 +145,7 @@ public:
     int wq_task_id_;
     WorkQueue<int> work_queue_;
     size_t dequeues_;
+    std::vector<size_t> batch_sizes_;
     size_t wm_cb_count_;
     tbb::atomic<int> exit_callback_counter_;
     tbb::atomic<bool> exit_callback_running_;
@@ -449,6 +462,100 @@ TEST_F(QueueTaskTest, ScheduleShutdownTest) {
     scheduler->Start();
 }
 
+TEST_F(QueueTaskTest, BatchCallbackTest) {
+    work_queue_.SetBatchCallback(
+        boost::bind(&QueueTaskTest::DequeueBatch, this, _1), 4);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+    for (int idx = 0; idx < 10; idx++) {
+        work_queue_.Enqueue(idx);
+    }
+    scheduler->Start();
+    task_util::WaitForIdle(1);
+    // Verify entries were handed over in batches of up to 4
+    EXPECT_EQ(10, dequeues_);
+    EXPECT_EQ(3, batch_sizes_.size());
+    EXPECT_EQ(4, batch_sizes_[0]);
+    EXPECT_EQ(4, batch_sizes_[1]);
+    EXPECT_EQ(2, batch_sizes_[2]);
+    // Verify WorkQueue
+    EXPECT_EQ(3, work_queue_.NumBatches());
+    EXPECT_EQ(10, work_queue_.NumDequeues());
+    EXPECT_EQ(0, work_queue_.Length());
+}
+
+TEST_F(QueueTaskTest, BatchMaxIterationsTest) {
+    // Batches are cut at max_iterations, which ends the run
+    SetWorkQueueMaxIterations(6);
+    work_queue_.SetBatchCallback(
+        boost::bind(&QueueTaskTest::DequeueBatch, this, _1), 4);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+    for (int idx = 0; idx < 12; idx++) {
+        work_queue_.Enqueue(idx);
+    }
+    scheduler->Start();
+    task_util::WaitForIdle(1);
+    EXPECT_EQ(12, dequeues_);
+    EXPECT_EQ(4, batch_sizes_.size());
+    EXPECT_EQ(4, batch_sizes_[0]);
+    EXPECT_EQ(2, batch_sizes_[1]);
+    TaskStats *tstats = scheduler->GetTaskStats(wq_task_id_);
+    EXPECT_EQ(2, tstats->run_count_);
+}
+
+TEST_F(QueueTaskTest, AdaptiveMaxIterationsTest) {
+    // A run should take about 10ms
+    work_queue_.SetAdaptiveMaxIterations(10000);
+    SetWorkQueueMaxIterations(32);
+
+    // Queue drained within the budget, nothing learnt
+    UpdateWorkQueueMaxIterations(10, 2000);
+    EXPECT_EQ(32, WorkQueueMaxIterations());
+
+    // Runs cut at max_iterations under the budget move half way towards
+    // the number of entries that fit in it
+    UpdateWorkQueueMaxIterations(32, 5000);
+    EXPECT_EQ(48, WorkQueueMaxIterations());
+    UpdateWorkQueueMaxIterations(48, 5000);
+    EXPECT_EQ(72, WorkQueueMaxIterations());
+
+    // Runs over the budget shrink it, even if the queue was drained
+    UpdateWorkQueueMaxIterations(72, 40000);
+    EXPECT_EQ(45, WorkQueueMaxIterations());
+    UpdateWorkQueueMaxIterations(20, 100000);
+    EXPECT_EQ(23, WorkQueueMaxIterations());
+
+    // Bounded below by kMinAdaptiveIterations
+    for (int idx = 0; idx < 10; idx++) {
+        UpdateWorkQueueMaxIterations(WorkQueueMaxIterations(), 1000000);
+    }
+    EXPECT_EQ((size_t)WorkQueue<int>::kMinAdaptiveIterations,
+              WorkQueueMaxIterations());
+
+    // A run that took no measurable time moves towards
+    // kMaxAdaptiveIterations
+    UpdateWorkQueueMaxIterations(WorkQueueMaxIterations(), 0);
+    EXPECT_EQ((size_t)(WorkQueue<int>::kMinAdaptiveIterations +
+                       WorkQueue<int>::kMaxAdaptiveIterations) / 2,
+              WorkQueueMaxIterations());
+
+    // Restoring a fixed max_iterations stops the adjustment
+    work_queue_.SetAdaptiveMaxIterations(0);
+    SetWorkQueueMaxIterations(32);
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    scheduler->Stop();
+    for (int idx = 0; idx < 100; idx++) {
+        work_queue_.Enqueue(idx);
+    }
+    scheduler->Start();
+    task_util::WaitForIdle(1);
+    EXPECT_EQ(100, dequeues_);
+    EXPECT_EQ(32, WorkQueueMaxIterations());
+    TaskStats *tstats = scheduler->GetTaskStats(wq_task_id_);
+    EXPECT_EQ(4, tstats->run_count_);
+}
+
 class QueueTaskShutdownTest : public ::testing::Test {
 public:
     QueueTaskShutdownTest() :
@@ -8,6 +8,7 @@
 #include "base/task.h"
 #include "base/logging.h"
 #include "testing/gunit.h"
+#include "base/test/task_test_util.h"
 
 void TestWait(int max);
 
@@ -43,6 +44,11 @@ int                 expected_state[16][16];
 vector<TestTask *>  task_start_seq_actual;
 vector<TestTask *>  task_start_seq_expected;
 
+static TestTaskState GetTaskState(int i) {
+    tbb::mutex::scoped_lock lock(m1);
+    return task_state[i];
+}
+
 class TestUT : public ::testing::Test {
 public:
     TestUT() { cout << "Creating TestTask" << endl; };
@@ -71,6 +77,7 @@ public:
     void Validate();
     void ValidateTaskStartSeq();
     void ValidateTaskRun();
+    void WaitForCancel();
 
 private:
     void TestTaskInternal(int id, int inst, int val, int sleep_time, int num_runs);
@@ -150,6 +157,9 @@ bool TestTask::Run() {
         case 33:
             ValidateTaskRun();
             break;
+        case 34:
+            WaitForCancel();
+            break;
 
         default:
             assert(0);
@@ -354,6 +364,25 @@ void TestTask::ValidateTaskRun()
     cout << "Final result is " << test_done << ". Result is " << result << endl;
 }
 
+// Stay in Run() till the test has cancelled the task
+void TestTask::WaitForCancel()
+{
+    {
+        tbb::mutex::scoped_lock lock(m1);
+        task_state[val_] = STARTED;
+    }
+
+    while (true) {
+        {
+            tbb::mutex::scoped_lock lock(m1);
+            if (task_state[val_] == FINISHED) {
+                break;
+            }
+        }
+        usleep(1000);
+    }
+}
+
 void MatchStats(int task_id, int task_instance, int run_count, int defer_count, 
                 int wait_count) {
     TaskStats *stats;
@@ -1353,9 +1382,85 @@ TEST_F(TestUT, test9_1)
     EXPECT_TRUE(scheduler->IsEmpty());
 }
 
+/* Recycle tasks of a group without any policy. In LOCKFREE mode these bypass
+ * the scheduler mutex; verify that run counts and IsEmpty stay consistent */
+TEST_F(TestUT, test9_2)
+{
+#define TEST9_2_MAX_RUNS 1000
+    task_ptr[0] = new TestTask(93, -1, 0, 0, TEST9_2_MAX_RUNS);
+    task_ptr[1] = new TestTask(93, -1, 1, 0, TEST9_2_MAX_RUNS);
+    task_ptr[2] = new TestTask(93, -1, 2, 0, TEST9_2_MAX_RUNS);
+    TaskStats *stats;
+
+    TestTask *task_seq_expected[] = { };
+    TestInit(32, 0, task_seq_expected);
+    EXPECT_TRUE(scheduler->task_measurement());
+    scheduler->Enqueue(task_ptr[0]);
+    scheduler->Enqueue(task_ptr[1]);
+    scheduler->Enqueue(task_ptr[2]);
+
+    stats = scheduler->GetTaskStats(93);
+    TASK_UTIL_EXPECT_EQ(3 * TEST9_2_MAX_RUNS, (int)stats->run_count_);
+    TASK_UTIL_EXPECT_TRUE(scheduler->IsEmpty());
+
+    // Every run is accounted in the latency histograms and the trace buffer,
+    // merged across the worker shards
+    TaskLatencyHistogram::Totals wait_time;
+    stats->wait_time_.Get(&wait_time);
+    TaskLatencyHistogram::Totals run_time;
+    stats->run_time_.Get(&run_time);
+    EXPECT_EQ(3 * TEST9_2_MAX_RUNS, (int)wait_time.count_);
+    EXPECT_EQ(3 * TEST9_2_MAX_RUNS, (int)run_time.count_);
+    uint64_t bucket_total = 0;
+    for (int i = 0; i < TaskLatencyHistogram::kBucketCount; i++) {
+        bucket_total += run_time.bucket_[i];
+    }
+    EXPECT_EQ(run_time.count_, bucket_total);
+
+    vector<TaskTraceEntry> trace;
+    scheduler->GetTaskTrace(&trace);
+    EXPECT_EQ(TaskScheduler::kTraceBufferSize, (int)trace.size());
+    EXPECT_EQ(93, trace.back().task_id_);
+    for (size_t i = 1; i < trace.size(); i++) {
+        EXPECT_LE(trace[i - 1].start_time_, trace[i].start_time_);
+    }
+
+    scheduler->ClearTaskGroupStats(93);
+    stats->run_time_.Get(&run_time);
+    EXPECT_EQ(0U, run_time.count_);
+}
+
+/* Cancel a recycled task of a group without any policy while it runs. The
+ * task must be deleted on exit and not enqueued again */
+TEST_F(TestUT, test9_3)
+{
+#define TEST9_3_MAX_RUNS 100
+    TestTask *task_seq_expected[] = { };
+    TestInit(34, 0, task_seq_expected);
+    {
+        tbb::mutex::scoped_lock lock(m1);
+        task_state[0] = NOT_STARTED;
+    }
+    task_ptr[0] = new TestTask(94, -1, 0, 0, TEST9_3_MAX_RUNS);
+    scheduler->Enqueue(task_ptr[0]);
+    TASK_UTIL_EXPECT_EQ(STARTED, GetTaskState(0));
+
+    EXPECT_EQ(TaskScheduler::QUEUED, scheduler->Cancel(task_ptr[0]));
+    {
+        tbb::mutex::scoped_lock lock(m1);
+        task_state[0] = FINISHED;
+    }
+
+    TASK_UTIL_EXPECT_TRUE(scheduler->IsEmpty());
+    MatchStats(94, -1, 1, -1, -1);
+}
+
 int main(int argc, char *argv[])
 {
     ::testing::InitGoogleTest(&argc, argv);
+#if defined(TASK_TEST_LOCKFREE)
+    TaskScheduler::Initialize(TaskScheduler::LOCKFREE);
+#endif
     scheduler = TaskScheduler::GetInstance();
     LoggingInit();
     return RUN_ALL_TESTS();
@@ -166,6 +166,16 @@ static inline uint64_t ClockMonotonicUsec() {
     return ts.tv_sec * 1000000 + ts.tv_nsec/1000;
 }
 
+// Same clock as ClockMonotonicUsec, in nsec
+static inline uint64_t ClockMonotonicNsec() {
+    struct timespec ts;
+    if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0) {
+        assert(0);
+    }
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 static inline boost::posix_time::ptime UTCUsecToPTime(uint64_t tusec) {
     boost::posix_time::ptime pt(boost::gregorian::date(1970, 1, 1), 
                    boost::posix_time::time_duration(0, 0, 
@@ -121,8 +121,11 @@ private:
     friend int intrusive_ptr_add_ref(const AsPath *cpath);
     friend int intrusive_ptr_del_ref(const AsPath *cpath);
     friend void intrusive_ptr_release(const AsPath *cpath);
+    template <class, class, class, typename, class>
+    friend class BgpPathAttributeDB;
 
     mutable tbb::atomic<int> refcount_;
+    mutable BgpPathAttributeHash db_hash_;
     AsPathDB *aspath_db_;
     AsPathSpec path_;
 };
@@ -534,8 +534,11 @@ private:
     friend int intrusive_ptr_add_ref(const BgpAttr *cattrp);
     friend int intrusive_ptr_del_ref(const BgpAttr *cattrp);
     friend void intrusive_ptr_release(const BgpAttr *cattrp);
+    template <class, class, class, typename, class>
+    friend class BgpPathAttributeDB;
 
     mutable tbb::atomic<int> refcount_;
+    mutable BgpPathAttributeHash db_hash_;
     BgpAttrDB *attr_db_;
     BgpAttrOrigin::OriginType origin_;
     IpAddress nexthop_;
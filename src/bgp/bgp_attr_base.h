@@ -9,10 +9,11 @@
 #include <boost/scoped_array.hpp>
 #include <set>
 #include <string>
-#include <tbb/mutex.h>
+#include <tbb/spin_rw_mutex.h>
 #include <vector>
 #include "base/parse_object.h"
 #include "base/task.h"
+#include "db/db.h"
 
 class BgpAttr;
 
@@ -88,40 +89,78 @@ struct BgpProtoPrefix : public ParseObject {
     uint8_t type;
 };
 
+//
+// Hash of the contents of a path attribute, computed when the attribute is
+// first located in its BgpPathAttributeDB. The DB reuses it to pick the
+// bucket, to order entries within the bucket and when the attribute is
+// deleted, so the contents are hashed only once. Copies do not inherit the
+// hash as they are typically modified before being located themselves.
+//
+class BgpPathAttributeHash {
+public:
+    BgpPathAttributeHash() : value_(0), valid_(false) { }
+    BgpPathAttributeHash(const BgpPathAttributeHash &rhs)
+        : value_(0), valid_(false) {
+    }
+    BgpPathAttributeHash &operator=(const BgpPathAttributeHash &rhs) {
+        valid_ = false;
+        return *this;
+    }
+
+    bool valid() const { return valid_; }
+    size_t value() const { return value_; }
+    void set(size_t value) { value_ = value; valid_ = true; }
+
+private:
+    size_t value_;
+    bool valid_;
+};
+
 //
 // Base class to manage BGP Path Attributes database. This class provides
 // thread safe access to the data base.
 //
+// The data base is split in buckets based on the attribute hash, each with
+// its own reader-writer lock. Locate() first looks for an existing entry
+// holding the lock for read only, which lets lookups of attributes that are
+// already present (the common case) proceed in parallel. The lock is taken
+// for write only to insert new entries.
+//
 // Lock contention can be tuned by varying the hash table size passed to the
-// constructor.
+// constructor. By default it scales with the number of DB partitions, as
+// those are the tasks locating attributes concurrently.
 //
 // Attribute contents must be hashable via hash_value() and hashed using
-// boost::hash_combine() to partition the attribute database.
+// boost::hash_combine() to partition the attribute database. Type must have
+// a mutable BgpPathAttributeHash db_hash_ accessible to this class.
 //
 template <class Type, class TypePtr, class TypeSpec, typename TypeCompare,
           class TypeDB>
 class BgpPathAttributeDB {
 public:
+    static const int kHashSizePerPartition = 4;
+
     BgpPathAttributeDB(int hash_size = GetHashSize()) :
-            hash_size_(hash_size), set_(new Set[hash_size]),
-            mutex_(new tbb::mutex[hash_size]) {
+            hash_size_(hash_size), bucket_(new Bucket[hash_size]) {
     }
 
     size_t Size() {
         size_t size = 0;
 
         for (size_t i = 0; i < hash_size_; i++) {
-            tbb::mutex::scoped_lock lock(mutex_[i]);
-            size += set_[i].size();
+            tbb::spin_rw_mutex::scoped_lock lock(bucket_[i].mutex, false);
+            size += bucket_[i].set.size();
         }
         return size;
     }
 
+    size_t hash_size() const { return hash_size_; }
+
     void Delete(Type *attr) {
-        size_t hash = HashCompute(attr);
+        Bucket &bucket = bucket_[HashCompute(attr) % hash_size_];
 
-        tbb::mutex::scoped_lock lock(mutex_[hash]);
-        set_[hash].erase(attr);
+        tbb::spin_rw_mutex::scoped_lock lock(bucket.mutex, true);
+        bucket.set.erase(attr);
     }
 
     // Locate passed in attribute in the data base based on the attr ptr.
@@ -136,22 +175,71 @@ public:
     }
 
 private:
-    const size_t HashCompute(Type *attr) const {
-        if (hash_size_ <= 1) return 0;
+    // Order entries on the cached hash first, so that most comparisons
+    // within a bucket do not need to look at the attribute contents.
+    struct HashCompare {
+        bool operator()(const Type *lhs, const Type *rhs) const {
+            if (lhs->db_hash_.value() != rhs->db_hash_.value()) {
+                return lhs->db_hash_.value() < rhs->db_hash_.value();
+            }
+            TypeCompare compare;
+            return compare(lhs, rhs);
+        }
+    };
+    typedef std::set<Type *, HashCompare> Set;
+
+    struct Bucket {
+        tbb::spin_rw_mutex mutex;
+        Set set;
+    };
 
-        size_t hash = 0;
-        boost::hash_combine(hash, *attr);
-        return hash % hash_size_;
+    static size_t HashCompute(const Type *attr) {
+        if (!attr->db_hash_.valid()) {
+            size_t hash = 0;
+            boost::hash_combine(hash, *attr);
+            attr->db_hash_.set(hash);
+        }
+        return attr->db_hash_.value();
     }
 
     static size_t GetHashSize() {
         char *str = getenv("BGP_PATH_ATTRIBUTE_DB_HASH_SIZE");
 
-        // Use just one bucket for now.
-        if (!str) return 1;
+        if (!str) return kHashSizePerPartition * DB::PartitionCount();
         return strtoul(str, NULL, 0);
     }
 
+    // Take a reference to an entry found in the database. Returns NULL if
+    // the entry is about to get deleted i.e. its refcount already dropped to
+    // 0. This can happen because attribute intrusive pointer is released
+    // without taking the mutex.
+    static Type *AcquireEntry(Type *entry) {
+
+        // Take a reference to prevent this entry from getting deleted.
+        // Counter is automatically incremented, hence we get thread safety
+        // here.
+        int prev = intrusive_ptr_add_ref(entry);
+        if (prev > 0) {
+            return entry;
+        }
+
+        // Decrement the counter bumped up above as we can't use this entry.
+        intrusive_ptr_del_ref(entry);
+        return NULL;
+    }
+
+    // Convert the reference taken by AcquireEntry into an intrusive pointer.
+    static TypePtr EntryToPtr(Type *entry) {
+
+        // Take intrusive pointer, thereby incrementing the refcount.
+        TypePtr ptr = TypePtr(entry);
+
+        // Release redundant refcount taken above to protect this entry
+        // from getting deleted, as we have now bumped up refcount above
+        intrusive_ptr_del_ref(entry);
+        return ptr;
+    }
+
     // This template safely retrieves an attribute entry from its data base.
     // If the entry is not found, it is inserted into the database.
     //
@@ -160,69 +248,57 @@ private:
     TypePtr LocateInternal(Type *attr) {
 
         // Hash attribute contents to to avoid potential mutex contention.
-        size_t hash = HashCompute(attr);
+        Bucket &bucket = bucket_[HashCompute(attr) % hash_size_];
+
+        // Fast path: look for an existing entry holding the lock for read.
+        Type *entry = NULL;
+        {
+            tbb::spin_rw_mutex::scoped_lock lock(bucket.mutex, false);
+            typename Set::iterator it = bucket.set.find(attr);
+            if (it != bucket.set.end()) {
+                entry = AcquireEntry(*it);
+            }
+        }
+        if (entry) {
+            // Free passed in attribute, as it is already in the database.
+            delete attr;
+            return EntryToPtr(entry);
+        }
+
         while (true) {
 
-            // Grab mutex to keep db access thread safe.
-            tbb::mutex::scoped_lock lock(mutex_[hash]);
+            // Grab mutex for write to keep db access thread safe.
+            tbb::spin_rw_mutex::scoped_lock lock(bucket.mutex, true);
             std::pair<typename Set::iterator, bool> ret;
 
             // Try to insert the passed entry into the database.
-            ret = set_[hash].insert(attr);
-
-            // Take a reference to prevent this entry from getting deleted.
-            // Counter is automatically incremented, hence we get thread safety
-            // here.
-            int prev = intrusive_ptr_add_ref(*ret.first);
+            ret = bucket.set.insert(attr);
 
             // Check if passed in entry did get into the data base.
             if (ret.second) {
-
-                // Take intrusive pointer, thereby incrementing the refcount.
-                TypePtr ptr = TypePtr(*ret.first);
-
-                // Release redundant refcount taken above to protect this entry
-                // from getting deleted, as we have now bumped up refcount above
-                intrusive_ptr_del_ref(*ret.first);
-                return ptr;
+                intrusive_ptr_add_ref(attr);
+                return EntryToPtr(attr);
             }
 
             // Make sure that this entry, though in the database is not
-            // undergoing deletion. This can happen because attribute intrusive
-            // pointer is released without taking the mutex.
-            //
-            // If the previous refcount is 0, it implies that this entry is
-            // about to get deleted (after we release the mutex). In such
-            // cases, we retry inserting the passed attribute pointer into the
-            // data base.
-            if (prev > 0) {
+            // undergoing deletion. If it is, retry inserting the passed
+            // attribute pointer into the data base once its removed.
+            entry = AcquireEntry(*ret.first);
+            if (entry) {
+                lock.release();
 
                 // Free passed in attribute, as it is already in the database.
                 delete attr;
-
-                // Take intrusive pointer, thereby incrementing the refcount.
-                TypePtr ptr = TypePtr(*ret.first);
-
-                // Release redundant refcount taken above to protect this entry
-                // from getting deleted, as we have now bumped up refcount above
-                intrusive_ptr_del_ref(*ret.first);
-                return ptr;
+                return EntryToPtr(entry);
             }
-
-            // Decrement the counter bumped up above as we can't use this entry
-            // which is above to be deleted. Instead, retry inserting the passed
-            // entry again, into the database.
-            intrusive_ptr_del_ref(*ret.first);
         }
 
         assert(false);
         return NULL;
     }
 
-    typedef std::set<Type *, TypeCompare> Set;
     size_t hash_size_;
-    boost::scoped_array<Set> set_;
-    boost::scoped_array<tbb::mutex> mutex_;
+    boost::scoped_array<Bucket> bucket_;
 };
 
 #endif
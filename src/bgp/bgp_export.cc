@@ -169,10 +169,10 @@ void BgpExport::Export(DBTablePartBase *root, DBEntryBase *db_entry) {
     }
 
     // Associate the new UpdateInfos we want to send with the RouteUpdate
-    // and enqueue the RouteUpdate.
+    // and enqueue the RouteUpdate to the queue for this DB partition.
     assert(!uinfo_slist->empty());
     rt_update->SetUpdateInfo(uinfo_slist);
-    updates->Enqueue(db_entry, rt_update);
+    updates->PartitionEnqueue(root->index(), db_entry, rt_update);
 }
 
 //
@@ -13,6 +13,7 @@
 #include "bgp/bgp_update_monitor.h"
 #include "bgp/message_builder.h"
 #include "bgp/scheduling_group.h"
+#include "db/db.h"
 
 using namespace std;
 
@@ -25,14 +26,20 @@ RibOutUpdates::RibOutUpdates(RibOut *ribout) : ribout_(ribout) {
         UpdateQueue *queue = new UpdateQueue(i);
         queue_vec_.push_back(queue);
     }
-    monitor_.reset(new RibUpdateMonitor(ribout, &queue_vec_));
+    for (int i = 0; i < DB::PartitionCount(); i++) {
+        PartitionUpdateQueue *pqueue = new PartitionUpdateQueue(i);
+        partition_queue_vec_.push_back(pqueue);
+    }
+    monitor_.reset(new RibUpdateMonitor(ribout, &queue_vec_,
+                                        &partition_queue_vec_));
     builder_ = MessageBuilder::GetInstance(ribout->ExportPolicy().encoding);
 }
 
 //
-// Destructor.  Get rid of all the UpdateQueues.
+// Destructor.  Get rid of all the UpdateQueues and PartitionUpdateQueues.
 //
 RibOutUpdates::~RibOutUpdates() {
+    STLDeleteValues(&partition_queue_vec_);
     STLDeleteValues(&queue_vec_);
 }
 
@@ -58,6 +65,45 @@ void RibOutUpdates::Enqueue(DBEntryBase *db_entry, RouteUpdate *rt_update) {
     }
 }
 
+//
+// Concurrency: Called in the context of the routing table partition task.
+//
+// Enqueue the RouteUpdate corresponding to the DBEntryBase into the
+// PartitionUpdateQueue for the DB partition. The DBState is set without
+// going through the monitor since the RouteUpdate is new or has already
+// been dequeued by the monitor, and no other task looks at the DBState of
+// a DBEntryBase in this DB partition without the entry lock.
+//
+// If the PartitionUpdateQueue was previously empty, we kick the scheduling
+// group so that the scheduling group task merges it to QUPDATE and performs
+// a tail dequeue for the RibOut.
+//
+void RibOutUpdates::PartitionEnqueue(int part_id, DBEntryBase *db_entry,
+        RouteUpdate *rt_update) {
+    CHECK_CONCURRENCY("db::DBTable");
+
+    assert(rt_update->queue_id() == QUPDATE);
+    db_entry->SetState(ribout_->table(), ribout_->listener_id(), rt_update);
+    PartitionUpdateQueue *pqueue = partition_queue_vec_[part_id];
+    if (pqueue->Enqueue(rt_update)) {
+        SchedulingGroup *group = ribout_->GetSchedulingGroup();
+        assert(group != NULL);
+        group->RibOutActive(ribout_, QUPDATE);
+    }
+}
+
+//
+// Concurrency: Called in the context of the scheduling group task.
+//
+// Merge all PartitionUpdateQueues to the QUPDATE UpdateQueue.  Returns true
+// if the UpdateQueue had no updates after the tail marker before the merge.
+//
+bool RibOutUpdates::MergePartitionQueues() {
+    CHECK_CONCURRENCY("bgp::SendTask");
+
+    return monitor_->MergePartitionQueues();
+}
+
 //
 // Concurrency: Called in the context of the scheduling group task.
 //
@@ -155,6 +201,9 @@ bool RibOutUpdates::TailDequeue(int queue_id, const RibPeerSet &msync,
         RibPeerSet *blocked) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
+    if (queue_id == QUPDATE)
+        MergePartitionQueues();
+
     UpdateQueue *queue = queue_vec_[queue_id];
     UpdateMarker *start_marker = queue->tail_marker();
     RouteUpdatePtr update = monitor_->GetNextUpdate(queue_id, start_marker);
@@ -385,17 +434,25 @@ void RibOutUpdates::UpdatePack(int queue_id, Message *message,
 // message to each of them.  Update the blocked RibPeerSet with peers that
 // become blocked after sending the message.
 //
+// The body of the message is shared by all the peers. The bytes that peers
+// copy to send it are accounted in the send statistics of the group.
+//
 void RibOutUpdates::UpdateSend(Message *message, const RibPeerSet &dst,
         RibPeerSet *blocked) {
     CHECK_CONCURRENCY("bgp::SendTask");
 
+    uint64_t peer_sends = 0, bytes_sent = 0, bytes_copied = 0;
+    TcpMessageBuffer *body = message->GetBody();
     RibOut::PeerIterator iter(ribout_, dst);
     while (iter.HasNext()) {
         int ix_current = iter.index();
         IPeerUpdate *peer = iter.Next();
-        size_t msgsize;
-        const uint8_t *data = message->GetData(peer, &msgsize);
-        bool more = peer->SendUpdate(data, msgsize);
+        size_t header_size, copied;
+        const uint8_t *header = message->GetHeader(peer, &header_size);
+        bool more = peer->SendUpdateParts(header, header_size, body, &copied);
+        peer_sends++;
+        bytes_sent += header_size + (body ? body->size() : 0);
+        bytes_copied += copied;
         if (!more) {
             blocked->set(ix_current);
         }
@@ -407,6 +464,10 @@ void RibOutUpdates::UpdateSend(Message *message, const RibPeerSet &dst,
             stats->UpdateTxUnreachRoute(message->num_unreach_routes());
         }
     }
+
+    SchedulingGroup *group = ribout_->GetSchedulingGroup();
+    if (group)
+        group->UpdateSendStats(peer_sends, bytes_sent, bytes_copied);
 }
 
 //
@@ -555,6 +616,13 @@ bool RibOutUpdates::Empty() const {
             return false;
         }
     }
+    for (PartitionQueueVec::const_iterator iter =
+         partition_queue_vec_.begin(); iter != partition_queue_vec_.end();
+         ++iter) {
+        if (!(*iter)->empty()) {
+            return false;
+        }
+    }
     return true;
 }
 
@@ -10,6 +10,7 @@
 class BgpTable;
 class Message;
 class MessageBuilder;
+class PartitionUpdateQueue;
 class RibUpdateMonitor;
 class RouteUpdate;
 class RouteUpdatePtr;
@@ -30,9 +31,16 @@ struct UpdateMarker;
 // all the concurrency constraints.  There's an exception for UpdateMarker
 // which are accessed directly through the UpdateQueue.
 //
+// Updates for QUPDATE are first enqueued to a PartitionUpdateQueue for the
+// DB partition that exported the route, so that exports from different DB
+// partitions do not serialize on the QUPDATE UpdateQueue.  The scheduling
+// group task merges the PartitionUpdateQueues to QUPDATE before it starts
+// a tail dequeue for QUPDATE.
+//
 class RibOutUpdates {
 public:
     typedef std::vector<UpdateQueue *> QueueVec;
+    typedef std::vector<PartitionUpdateQueue *> PartitionQueueVec;
     static const int kQueueIdInvalid = -1;
     enum QueueId {
         QFIRST   = 0,
@@ -44,6 +52,9 @@ public:
     virtual ~RibOutUpdates();
 
     void Enqueue(DBEntryBase *db_entry, RouteUpdate *rt_update);
+    void PartitionEnqueue(int part_id, DBEntryBase *db_entry,
+                          RouteUpdate *rt_update);
+    bool MergePartitionQueues();
 
     virtual bool TailDequeue(int queue_id,
                              const RibPeerSet &msync, RibPeerSet *blocked);
@@ -64,6 +75,10 @@ public:
 
     QueueVec &queue_vec() { return queue_vec_; }
 
+    PartitionUpdateQueue *partition_queue(int part_id) {
+        return partition_queue_vec_[part_id];
+    }
+
     // Testing only
     void SetMessageBuilder(MessageBuilder *builder) { builder_ = builder; }
 
@@ -96,6 +111,7 @@ private:
     RibOut *ribout_;
     MessageBuilder *builder_;
     QueueVec queue_vec_;
+    PartitionQueueVec partition_queue_vec_;
     boost::scoped_ptr<RibUpdateMonitor> monitor_;
     DISALLOW_COPY_AND_ASSIGN(RibOutUpdates);
 };
@@ -18,6 +18,7 @@
 #include "bgp/bgp_path.h"
 #include "bgp/bgp_peer_types.h"
 #include "bgp/bgp_peer_membership.h"
+#include "bgp/bgp_ribout.h"
 #include "bgp/bgp_route.h"
 #include "bgp/bgp_sandesh.h"
 #include "bgp/bgp_session_manager.h"
@@ -26,9 +27,11 @@
 #include "bgp/ermvpn/ermvpn_table.h"
 #include "bgp/inet/inet_route.h"
 #include "bgp/inet/inet_table.h"
+#include "bgp/ipeer.h"
 #include "bgp/routing-instance/peer_manager.h"
 #include "bgp/routing-instance/routing_instance.h"
 #include "bgp/origin-vn/origin_vn.h"
+#include "bgp/scheduling_group.h"
 #include "bgp/security_group/security_group.h"
 #include "bgp/tunnel_encap/tunnel_encap.h"
 #include "db/db_table_partition.h"
@@ -354,6 +357,13 @@ bool ShowRouteSummaryHandler::CallbackS1(const Sandesh *sr,
                 table->database()->GetWalker()->walk_complete_count());
             srt.set_walk_cancels(
                 table->database()->GetWalker()->walk_cancel_count());
+            srt.set_walk_coalesced(
+                table->database()->GetWalker()->walk_coalesced_count());
+            DBTableTaskStats task_stats = table->GetTaskStats();
+            srt.set_db_requests(task_stats.request_count);
+            srt.set_db_request_usecs(task_stats.request_time_usecs);
+            srt.set_db_notifications(task_stats.notify_count);
+            srt.set_db_notify_usecs(task_stats.notify_time_usecs);
             size_t markers;
             srt.set_pending_updates(table->GetPendingRiboutsCount(markers));
             srt.set_markers(markers);
@@ -828,6 +838,8 @@ public:
             table->database()->GetWalker()->walk_complete_count());
         rit.set_walk_cancels(
             table->database()->GetWalker()->walk_cancel_count());
+        rit.set_walk_coalesced(
+            table->database()->GetWalker()->walk_coalesced_count());
         size_t markers;
         rit.set_pending_updates(table->GetPendingRiboutsCount(markers));
         rit.set_markers(markers);
@@ -1608,3 +1620,78 @@ void ShowBgpServerReq::HandleRequest() const {
     ps.stages_ = list_of(s1);
     RequestPipeline rp(ps);
 }
+
+class ShowSchedulingGroupHandler {
+public:
+    static void FillGroupInfo(const SchedulingGroup *group,
+                              ShowSchedulingGroupInfo *info) {
+        SchedulingGroup::PeerList plist;
+        group->GetPeerList(&plist);
+        vector<string> peers;
+        for (SchedulingGroup::PeerList::const_iterator it = plist.begin();
+             it != plist.end(); ++it) {
+            peers.push_back((*it)->ToString());
+        }
+        info->set_peers(peers);
+
+        SchedulingGroup::RibOutList rlist;
+        group->GetRibOutList(&rlist);
+        vector<string> tables;
+        for (SchedulingGroup::RibOutList::const_iterator it = rlist.begin();
+             it != rlist.end(); ++it) {
+            tables.push_back((*it)->table()->name());
+        }
+        info->set_tables(tables);
+
+        const SchedulingGroup::SendStats &stats = group->send_stats();
+        info->set_messages(stats.messages);
+        info->set_peer_sends(stats.peer_sends);
+        info->set_bytes_sent(stats.bytes_sent);
+        info->set_bytes_copied(stats.bytes_copied);
+        if (stats.messages) {
+            info->set_average_bytes_copied(
+                static_cast<double>(stats.bytes_copied) / stats.messages);
+        } else {
+            info->set_average_bytes_copied(0);
+        }
+    }
+
+    static bool CallbackS1(const Sandesh *sr,
+            const RequestPipeline::PipeSpec ps, int stage, int instNum,
+            RequestPipeline::InstData *data) {
+        const ShowSchedulingGroupReq *req =
+            static_cast<const ShowSchedulingGroupReq *>(ps.snhRequest_.get());
+        BgpSandeshContext *bsc =
+            static_cast<BgpSandeshContext *>(req->client_context());
+        SchedulingGroupManager *mgr =
+            bsc->bgp_server->scheduling_group_manager();
+
+        vector<ShowSchedulingGroupInfo> groups;
+        for (SchedulingGroupManager::GroupList::const_iterator it =
+             mgr->groups().begin(); it != mgr->groups().end(); ++it) {
+            ShowSchedulingGroupInfo info;
+            FillGroupInfo(*it, &info);
+            groups.push_back(info);
+        }
+
+        ShowSchedulingGroupResp *resp = new ShowSchedulingGroupResp;
+        resp->set_groups(groups);
+        resp->set_context(req->context());
+        resp->Response();
+        return true;
+    }
+};
+
+void ShowSchedulingGroupReq::HandleRequest() const {
+    RequestPipeline::PipeSpec ps(this);
+
+    // Request pipeline has single stage to collect scheduling group info
+    // and respond to the request
+    RequestPipeline::StageSpec s1;
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    s1.taskId_ = scheduler->GetTaskId("bgp::ShowCommand");
+    s1.cbFn_ = ShowSchedulingGroupHandler::CallbackS1;
+    s1.instances_.push_back(0);
+    ps.stages_ = list_of(s1);
+    RequestPipeline rp(ps);
+}
@@ -28,7 +28,8 @@ RouteUpdate::RouteUpdate(BgpRoute *route, int queue_id)
     : UpdateEntry(UpdateEntry::UPDATE),
     route_(route),
     queue_id_(queue_id),
-    flags_(0) {
+    flags_(0),
+    partition_id_(-1) {
 }
 
 RouteUpdate::~RouteUpdate() {
@@ -231,6 +231,12 @@ public:
     int queue_id() const { return queue_id_; }
     void set_queue_id(int queue_id) { queue_id_ = queue_id; }
 
+    // Index of the PartitionUpdateQueue the RouteUpdate is on, if any.
+    bool OnPartitionQueue() const { return partition_id_ >= 0; }
+    int partition_id() const { return partition_id_; }
+    void set_partition_id(int partition_id) { partition_id_ = partition_id; }
+    void clear_partition_id() { partition_id_ = -1; }
+
     uint64_t tstamp() const { return tstamp_; }
     void set_tstamp_now();
 
@@ -247,6 +253,7 @@ private:
     BgpRoute *route_;
     int8_t queue_id_;
     int8_t flags_;
+    int16_t partition_id_;
     AdvertiseSList history_;  // Update history
     UpdateInfoSList updates_;       // The state we want to advertise
     uint64_t tstamp_;
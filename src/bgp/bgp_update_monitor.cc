@@ -29,8 +29,10 @@ RouteUpdatePtr::~RouteUpdatePtr() {
     }
 }
 
-RibUpdateMonitor::RibUpdateMonitor(RibOut *ribout, QueueVec *queue_vec) :
-        ribout_(ribout), queue_vec_(queue_vec) {
+RibUpdateMonitor::RibUpdateMonitor(RibOut *ribout, QueueVec *queue_vec,
+        PartitionQueueVec *partition_queue_vec) :
+        ribout_(ribout), queue_vec_(queue_vec),
+        partition_queue_vec_(partition_queue_vec) {
 }
 
 //
@@ -58,8 +60,7 @@ DBState *RibUpdateMonitor::GetRouteUpdateAndDequeue(DBEntryBase *db_entry,
     // the queue. Change the queue to QUPDATE since that's where we will
     // re-enqueue the RouteUpdate, if we do it.
     db_entry->SetState(ribout_->table(), ribout_->listener_id(), rt_update);
-    UpdateQueue *queue = queue_vec_->at(rt_update->queue_id());
-    queue->Dequeue(rt_update);
+    DequeueUpdateUnlocked(rt_update);
     rt_update->set_queue_id(RibOutUpdates::QUPDATE);
     return rt_update;
 }
@@ -92,7 +93,7 @@ DBState *RibUpdateMonitor::GetUpdateListAndDequeue(DBEntryBase *db_entry,
         // and move the history to it.  The entry will be reused as if that
         // was the DBState instead of the UpdateList.
         uplist->RemoveUpdate(rt_update);
-        queue_vec_->at(rt_update->queue_id())->Dequeue(rt_update);
+        DequeueUpdateUnlocked(rt_update);
         uplist->MoveHistory(rt_update);
         dbstate = rt_update;
 
@@ -119,7 +120,7 @@ DBState *RibUpdateMonitor::GetUpdateListAndDequeue(DBEntryBase *db_entry,
     for (UpdateList::List::iterator iter = list->begin();
          iter != list->end(); iter++) {
         RouteUpdate *temp_rt_update = *iter;
-        queue_vec_->at(temp_rt_update->queue_id())->Dequeue(temp_rt_update);
+        DequeueUpdateUnlocked(temp_rt_update);
         delete temp_rt_update;
     }
 
@@ -410,8 +411,7 @@ bool RibUpdateMonitor::RouteUpdateMergeUpdate(DBEntryBase *db_entry,
     CHECK_CONCURRENCY("db::DBTable");
 
     if (current_rt_update->queue_id() == rt_update->queue_id()) {
-        UpdateQueue *queue = queue_vec_->at(current_rt_update->queue_id());
-        queue->Dequeue(current_rt_update);
+        DequeueUpdateUnlocked(current_rt_update);
         current_rt_update->MergeUpdateInfo(rt_update->Updates());
         assert(rt_update->Updates()->empty());
         delete rt_update;
@@ -444,8 +444,7 @@ bool RibUpdateMonitor::UpdateListMergeUpdate(DBEntryBase *db_entry,
 
     RouteUpdate *current_rt_update = uplist->FindUpdate(rt_update->queue_id());
     if (current_rt_update) {
-        UpdateQueue *queue = queue_vec_->at(current_rt_update->queue_id());
-        queue->Dequeue(current_rt_update);
+        DequeueUpdateUnlocked(current_rt_update);
         current_rt_update->MergeUpdateInfo(rt_update->Updates());
         assert(rt_update->Updates()->empty());
         delete rt_update;
@@ -566,8 +565,10 @@ void RibUpdateMonitor::UpdateInfoSListClearBits(UpdateInfoSList &uinfo_slist,
         iter->target.Reset(clear);
         if (iter->target.empty()) {
             RouteUpdate *rt_update = iter->update;
-            UpdateQueue *queue = queue_vec_->at(rt_update->queue_id());
-            queue->AttrDequeue(iter.operator->());
+            if (!rt_update->OnPartitionQueue()) {
+                UpdateQueue *queue = queue_vec_->at(rt_update->queue_id());
+                queue->AttrDequeue(iter.operator->());
+            }
             iter = uinfo_slist->erase_and_dispose(iter, UpdateInfoDisposer());
         } else {
             iter++;
@@ -862,16 +863,50 @@ void RibUpdateMonitor::DequeueUpdate(RouteUpdate *rt_update) {
 //
 // Concurrency: must hold the entry lock and the monitor lock.
 //
-// Dequeue the specified RouteUpdate from it's UpdateQueue. This is similar to
-// DequeueUpdate except that this function doesn't lock the mutex.
+// Dequeue the specified RouteUpdate from it's UpdateQueue, or from it's
+// PartitionUpdateQueue if it has not been merged to the UpdateQueue yet.
+// This is similar to DequeueUpdate except that this function doesn't lock
+// the mutex.
 //
 void RibUpdateMonitor::DequeueUpdateUnlocked(RouteUpdate *rt_update) {
     CHECK_CONCURRENCY("db::DBTable");
 
+    if (rt_update->OnPartitionQueue()) {
+        PartitionUpdateQueue *pqueue =
+            partition_queue_vec_->at(rt_update->partition_id());
+        pqueue->Dequeue(rt_update);
+        return;
+    }
     UpdateQueue *queue = queue_vec_->at(rt_update->queue_id());
     queue->Dequeue(rt_update);
 }
 
+//
+// Concurrency: Called in the context of the scheduling group task.
+//
+// Merge the RouteUpdates on all the PartitionUpdateQueues to the end of the
+// QUPDATE UpdateQueue. Holding the monitor lock ensures that the export
+// module doesn't look at a RouteUpdate while it moves between queues.
+//
+// Return true if the UpdateQueue had no RouteUpdates after the tail marker.
+//
+bool RibUpdateMonitor::MergePartitionQueues() {
+    CHECK_CONCURRENCY("bgp::SendTask");
+
+    UpdateQueue *queue = queue_vec_->at(RibOutUpdates::QUPDATE);
+    bool need_tail_dequeue = false;
+    tbb::mutex::scoped_lock lock(mutex_);
+    for (PartitionQueueVec::iterator iter = partition_queue_vec_->begin();
+         iter != partition_queue_vec_->end(); ++iter) {
+        PartitionUpdateQueue *pqueue = *iter;
+        if (pqueue->empty())
+            continue;
+        if (pqueue->Merge(queue))
+            need_tail_dequeue = true;
+    }
+    return need_tail_dequeue;
+}
+
 //
 // Return the appropriate mutex for the RouteUpdate. If the RouteUpdate is
 // part of an UpdateList, we need to use the mutex in the UpdateList.
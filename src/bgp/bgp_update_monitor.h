@@ -18,6 +18,7 @@
 
 class DBEntryBase;
 struct DBState;
+class PartitionUpdateQueue;
 class UpdateQueue;
 
 //
@@ -132,7 +133,9 @@ class RibUpdateMonitor {
 public:
     typedef boost::function<bool(const RouteUpdate *)> UpdateCmp;
     typedef std::vector<UpdateQueue *> QueueVec;
-    explicit RibUpdateMonitor(RibOut *ribout, QueueVec *queue_vec);
+    typedef std::vector<PartitionUpdateQueue *> PartitionQueueVec;
+    RibUpdateMonitor(RibOut *ribout, QueueVec *queue_vec,
+                     PartitionQueueVec *partition_queue_vec);
 
     // Used by export module to obtain exclusive access to the DB state.
     // If an update is currently present and the comparison function
@@ -164,6 +167,11 @@ public:
     void ClearPeerSetCurrentAndScheduled(DBEntryBase *db_entry,
                                          RibPeerSet &mleave);
 
+    // Used by the update dequeue process to move the updates enqueued by
+    // the export module to the PartitionUpdateQueues to QUPDATE. Returns
+    // true if the queue had no updates after the tail marker.
+    bool MergePartitionQueues();
+
     // Used by the update dequeue process to retrieve an update.
     RouteUpdatePtr GetNextUpdate(int queue_id, UpdateEntry *upentry);
 
@@ -223,6 +231,7 @@ private:
     tbb::interface5::condition_variable cond_var_;
     RibOut *ribout_;
     QueueVec *queue_vec_;
+    PartitionQueueVec *partition_queue_vec_;
     DISALLOW_COPY_AND_ASSIGN(RibUpdateMonitor);
 };
 
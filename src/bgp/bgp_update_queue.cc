@@ -303,3 +303,70 @@ size_t UpdateQueue::marker_count() const {
     tbb::mutex::scoped_lock lock(mutex_);
     return marker_count_;
 }
+
+//
+// Initialize the PartitionUpdateQueue for the given DB partition.
+//
+PartitionUpdateQueue::PartitionUpdateQueue(int partition_id)
+    : partition_id_(partition_id) {
+    count_ = 0;
+}
+
+PartitionUpdateQueue::~PartitionUpdateQueue() {
+    assert(queue_.empty());
+}
+
+//
+// Enqueue the specified RouteUpdate to the end of the PartitionUpdateQueue.
+// The timestamp is set when the RouteUpdate is merged to the UpdateQueue.
+//
+// Return true if the PartitionUpdateQueue was empty.
+//
+bool PartitionUpdateQueue::Enqueue(RouteUpdate *rt_update) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    rt_update->set_partition_id(partition_id_);
+    bool was_empty = queue_.empty();
+    queue_.push_back(*rt_update);
+    count_++;
+
+    // Set up the back pointer to the RouteUpdate in each UpdateInfo so that
+    // it's valid even before the RouteUpdate is merged to the UpdateQueue.
+    UpdateInfoSList &uinfo_slist = rt_update->Updates();
+    for (UpdateInfoSList::List::iterator iter = uinfo_slist->begin();
+         iter != uinfo_slist->end(); ++iter) {
+        iter->update = rt_update;
+    }
+    return was_empty;
+}
+
+//
+// Dequeue the specified RouteUpdate from the PartitionUpdateQueue.
+//
+void PartitionUpdateQueue::Dequeue(RouteUpdate *rt_update) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    assert(rt_update->partition_id() == partition_id_);
+    queue_.erase(queue_.iterator_to(*rt_update));
+    rt_update->clear_partition_id();
+    count_--;
+}
+
+//
+// Move all the RouteUpdates on the PartitionUpdateQueue to the end of the
+// UpdateQueue, preserving their order.
+//
+// Return true if the UpdateQueue had no RouteUpdates after the tail marker.
+//
+bool PartitionUpdateQueue::Merge(UpdateQueue *queue) {
+    tbb::mutex::scoped_lock lock(mutex_);
+    bool need_tail_dequeue = false;
+    while (!queue_.empty()) {
+        RouteUpdate *rt_update = static_cast<RouteUpdate *>(&queue_.front());
+        queue_.pop_front();
+        rt_update->clear_partition_id();
+        if (queue->Enqueue(rt_update)) {
+            need_tail_dequeue = true;
+        }
+    }
+    count_ = 0;
+    return need_tail_dequeue;
+}
@@ -5,6 +5,7 @@
 #ifndef ctrlplane_bgp_update_queue_h
 #define ctrlplane_bgp_update_queue_h
 
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 #include "bgp/bgp_update.h"
 
@@ -144,4 +145,48 @@ private:
     DISALLOW_COPY_AND_ASSIGN(UpdateQueue);    
 };
 
+//
+// This class implements a per DB partition queue of RouteUpdates for the
+// QUPDATE UpdateQueue of a RibOut. A RibOutUpdates contains a vector of
+// pointers to PartitionUpdateQueue, one for each DB partition.
+//
+// Export processing in a DB partition task enqueues new RouteUpdates to the
+// PartitionUpdateQueue for the partition instead of the UpdateQueue. Hence
+// the partitions exporting to the same RibOut don't contend on the mutex of
+// the RibUpdateMonitor or of the UpdateQueue. The scheduling group task
+// merges the RouteUpdates on all the PartitionUpdateQueues, in FIFO order,
+// to the end of the UpdateQueue at the start of a tail dequeue.
+//
+// A RouteUpdate on a PartitionUpdateQueue is not reachable by the scheduling
+// group task, which only sees RouteUpdates on the UpdateQueue. It's linked
+// into the PartitionUpdateQueue with the same hook as for the UpdateQueue.
+//
+// The mutex serializes the partition task, which enqueues RouteUpdates, and
+// the scheduling group task, which merges them. Both Merge and Dequeue must
+// be called with the lock on the RibUpdateMonitor, so a RouteUpdate can't
+// move from the PartitionUpdateQueue to the UpdateQueue while the export
+// module is looking at it through the monitor.
+//
+class PartitionUpdateQueue {
+public:
+    explicit PartitionUpdateQueue(int partition_id);
+    ~PartitionUpdateQueue();
+
+    bool Enqueue(RouteUpdate *rt_update);
+    void Dequeue(RouteUpdate *rt_update);
+    bool Merge(UpdateQueue *queue);
+
+    int partition_id() const { return partition_id_; }
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+
+private:
+    mutable tbb::mutex mutex_;
+    int partition_id_;
+    tbb::atomic<size_t> count_;
+    UpdateQueue::UpdatesByOrder queue_;
+
+    DISALLOW_COPY_AND_ASSIGN(PartitionUpdateQueue);
+};
+
 #endif
@@ -311,6 +311,8 @@ public:
     }
 
     virtual bool SendUpdate(const uint8_t *msg, size_t msgsize);
+    virtual bool SendUpdateParts(const uint8_t *header, size_t header_size,
+                                 TcpMessageBuffer *body, size_t *copied);
     virtual std::string ToString() const {
         return parent_->ToString();
     }
@@ -400,12 +402,29 @@ static bool SkipUpdateSend() {
 }
 
 bool BgpXmppChannel::XmppPeer::SendUpdate(const uint8_t *msg, size_t msgsize) {
+    size_t copied;
+    return SendUpdateParts(msg, msgsize, NULL, &copied);
+}
+
+//
+// The body is shared by all the peers the update is sent to, and is passed
+// down to the socket without being copied. If the socket is not write ready
+// the session queues a reference to it and copies the unwritten header
+// bytes, which are returned in copied.
+//
+bool BgpXmppChannel::XmppPeer::SendUpdateParts(const uint8_t *header,
+                                               size_t header_size,
+                                               TcpMessageBuffer *body,
+                                               size_t *copied) {
+    *copied = 0;
     XmppChannel *channel = parent_->channel_;
     if (channel->GetPeerState() == xmps::READY) {
         parent_->stats_[TX].rt_updates ++;
         if (SkipUpdateSend()) return true;
-        send_ready_ = channel->Send(msg, msgsize, xmps::BGP,
-                boost::bind(&BgpXmppChannel::XmppPeer::WriteReadyCb, this, _1));
+        send_ready_ = channel->SendParts(header, header_size, body,
+                xmps::BGP,
+                boost::bind(&BgpXmppChannel::XmppPeer::WriteReadyCb, this, _1),
+                copied);
         if (!send_ready_) {
             BGP_LOG_PEER(Event, this, SandeshLevel::SYS_DEBUG, BGP_LOG_FLAG_ALL,
                          BGP_PEER_DIR_NA, "Send blocked");
@@ -2150,29 +2169,27 @@ void BgpXmppChannel::ReceiveUpdate(const XmppStanza::XmppMessage *msg) {
                 XmlBase *impl = msg->dom.get();
                 stats_[RX].rt_updates++;
                 XmlPugi *pugi = reinterpret_cast<XmlPugi *>(impl);
-                for (xml_node item = pugi->FindNode("item"); item;
-                    item = item.next_sibling()) {
-                    if (strcmp(item.name(), "item") != 0) continue;
-
-                        std::string id(iq->as_node.c_str());
-                        char *str = const_cast<char *>(id.c_str());
-                        char *saveptr;
-                        char *af = strtok_r(str, "/", &saveptr);
-                        char *safi = strtok_r(NULL, "/", &saveptr);
-
-                        if (atoi(af) == BgpAf::IPv4 &&
-                            atoi(safi) == BgpAf::Unicast) {
-                            ProcessItem(iq->node, item, iq->is_as_node);
-                        } else if (atoi(af) == BgpAf::IPv6 &&
-                                   atoi(safi) == BgpAf::Unicast) {
-                            ProcessInet6Item(iq->node, item, iq->is_as_node);
-                        } else if (atoi(af) == BgpAf::IPv4 &&
-                            atoi(safi) == BgpAf::Mcast) {
-                            ProcessMcastItem(iq->node, item, iq->is_as_node);
-                        } else if (atoi(af) == BgpAf::L2Vpn &&
-                                   atoi(safi) == BgpAf::Enet) {
-                            ProcessEnetItem(iq->node, item, iq->is_as_node);
-                        }
+                xml_node item = pugi->FindItem();
+                if (!item)
+                    return;
+
+                // The address family is the same for all the items
+                std::string id(iq->as_node.c_str());
+                char *str = const_cast<char *>(id.c_str());
+                char *saveptr;
+                int af = atoi(strtok_r(str, "/", &saveptr));
+                int safi = atoi(strtok_r(NULL, "/", &saveptr));
+
+                for (; item; item = XmlPugi::NextItem(item)) {
+                    if (af == BgpAf::IPv4 && safi == BgpAf::Unicast) {
+                        ProcessItem(iq->node, item, iq->is_as_node);
+                    } else if (af == BgpAf::IPv6 && safi == BgpAf::Unicast) {
+                        ProcessInet6Item(iq->node, item, iq->is_as_node);
+                    } else if (af == BgpAf::IPv4 && safi == BgpAf::Mcast) {
+                        ProcessMcastItem(iq->node, item, iq->is_as_node);
+                    } else if (af == BgpAf::L2Vpn && safi == BgpAf::Enet) {
+                        ProcessEnetItem(iq->node, item, iq->is_as_node);
+                    }
                 }
             }
         }
@@ -66,8 +66,11 @@ private:
     friend int intrusive_ptr_add_ref(const Community *ccomm);
     friend int intrusive_ptr_del_ref(const Community *ccomm);
     friend void intrusive_ptr_release(const Community *ccomm);
+    template <class, class, class, typename, class>
+    friend class BgpPathAttributeDB;
 
     mutable tbb::atomic<int> refcount_;
+    mutable BgpPathAttributeHash db_hash_;
     CommunityDB *comm_db_;
     std::vector<uint32_t> communities_;
 };
@@ -246,8 +249,11 @@ private:
     friend int intrusive_ptr_add_ref(const ExtCommunity *cextcomm);
     friend int intrusive_ptr_del_ref(const ExtCommunity *cextcomm);
     friend void intrusive_ptr_release(const ExtCommunity *cextcomm);
+    template <class, class, class, typename, class>
+    friend class BgpPathAttributeDB;
 
     mutable tbb::atomic<int> refcount_;
+    mutable BgpPathAttributeHash db_hash_;
     ExtCommunityDB *extcomm_db_;
     ExtCommunityList communities_;
 };
@@ -6,6 +6,7 @@
 #define __IPEER_H__
 
 #include "bgp/bgp_proto.h"
+#include "io/tcp_message_buffer.h"
 #include "tbb/atomic.h"
 
 class BgpServer;
@@ -20,6 +21,22 @@ public:
     // Send an update. Returns true if the peer can send additional messages,
     // false if it is send blocked.
     virtual bool SendUpdate(const uint8_t *msg, size_t msgsize) = 0;
+
+    // Send an update made of a header and a body, which may be NULL, that
+    // follows it. Peers that can send the body without copying it override
+    // this and set copied to the number of bytes they had to copy. Otherwise
+    // the two parts are copied into one buffer.
+    virtual bool SendUpdateParts(const uint8_t *header, size_t header_size,
+                                 TcpMessageBuffer *body, size_t *copied) {
+        if (body == NULL) {
+            *copied = 0;
+            return SendUpdate(header, header_size);
+        }
+        std::vector<uint8_t> msg(header, header + header_size);
+        msg.insert(msg.end(), body->data(), body->data() + body->size());
+        *copied = msg.size();
+        return SendUpdate(&msg[0], msg.size());
+    }
 };
 
 class IPeerDebugStats {
@@ -8,6 +8,7 @@
 #include "bgp/bgp_ribout.h"
 
 class BgpRoute;
+class TcpMessageBuffer;
 
 class Message {
 public:
@@ -18,6 +19,17 @@ public:
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr) = 0;
     virtual void Finish() = 0;
     virtual const uint8_t *GetData(IPeerUpdate *peer_update, size_t *lenp) = 0;
+
+    // The message as a header specific to the peer followed by a body that
+    // is the same for all peers, so that the body can be sent to every peer
+    // without being copied. By default the whole message is the header and
+    // there is no body.
+    virtual const uint8_t *GetHeader(IPeerUpdate *peer_update, size_t *lenp) {
+        return GetData(peer_update, lenp);
+    }
+    virtual TcpMessageBuffer *GetBody() {
+        return NULL;
+    }
     uint32_t num_reach_routes() const { 
         return num_reach_route_; 
     }
@@ -447,6 +447,20 @@ private:
     SchedulingGroup *group_;
 };
 
+SchedulingGroup::SendStats::SendStats() {
+    messages = 0;
+    peer_sends = 0;
+    bytes_sent = 0;
+    bytes_copied = 0;
+}
+
+void SchedulingGroup::SendStats::Merge(const SendStats &rhs) {
+    messages += rhs.messages;
+    peer_sends += rhs.peer_sends;
+    bytes_sent += rhs.bytes_sent;
+    bytes_copied += rhs.bytes_copied;
+}
+
 SchedulingGroup::SchedulingGroup() : running_(false), worker_task_(NULL) {
     if (send_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
@@ -461,6 +475,17 @@ SchedulingGroup::~SchedulingGroup() {
     }
 }
 
+//
+// Concurrency: called in the context of bgp::SendTask.
+//
+void SchedulingGroup::UpdateSendStats(uint64_t peer_sends, uint64_t bytes_sent,
+                                      uint64_t bytes_copied) {
+    send_stats_.messages++;
+    send_stats_.peer_sends += peer_sends;
+    send_stats_.bytes_sent += bytes_sent;
+    send_stats_.bytes_copied += bytes_copied;
+}
+
 void SchedulingGroup::clear() {
     peer_state_imap_.clear();
     rib_state_imap_.clear();
@@ -611,6 +636,7 @@ void SchedulingGroup::Merge(SchedulingGroup *rhs) {
     CHECK_CONCURRENCY("bgp::PeerMembership");
 
     PeerList plist;
+    send_stats_.Merge(rhs->send_stats_);
 
     // Build a list of of all the IPeers in the old SchedulingGroup and go
     // through each of them.
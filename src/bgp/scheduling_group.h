@@ -9,6 +9,7 @@
 #include <map>
 #include <vector>
 #include <boost/ptr_container/ptr_list.hpp>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 
 #include "base/bitset.h"
@@ -59,6 +60,18 @@ public:
     typedef std::vector<RibOut *> RibOutList;
     typedef std::vector<IPeerUpdate *> PeerList;
 
+    // Statistics for the update messages sent to the peers in the group.
+    // Updated by the send task and read by show commands.
+    struct SendStats {
+        SendStats();
+        void Merge(const SendStats &rhs);
+
+        tbb::atomic<uint64_t> messages;
+        tbb::atomic<uint64_t> peer_sends;
+        tbb::atomic<uint64_t> bytes_sent;
+        tbb::atomic<uint64_t> bytes_copied;
+    };
+
     SchedulingGroup();
     ~SchedulingGroup();
 
@@ -99,6 +112,12 @@ public:
 
     bool CheckInvariants() const;
 
+    // Account for a message sent to peer_sends peers, for which bytes_copied
+    // of the bytes_sent were copied.
+    void UpdateSendStats(uint64_t peer_sends, uint64_t bytes_sent,
+                         uint64_t bytes_copied);
+    const SendStats &send_stats() const { return send_stats_; }
+
     void clear();
     bool empty() const;
 
@@ -164,6 +183,8 @@ private:
     PeerStateMap peer_state_imap_;
     RibStateMap rib_state_imap_;
 
+    SendStats send_stats_;
+
     static int send_task_id_;
 
     DISALLOW_COPY_AND_ASSIGN(SchedulingGroup);
@@ -211,6 +232,8 @@ public:
     // Number of SchedulingGroups.
     int size() const { return groups_.size(); }
 
+    const GroupList &groups() const { return groups_; }
+
 private:
     // Merge two existing scheduling groups.
     SchedulingGroup *Merge(SchedulingGroup *sg1, SchedulingGroup *sg2);
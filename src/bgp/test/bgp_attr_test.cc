@@ -1206,6 +1206,90 @@ TEST_F(BgpAttrTest, ExtCommunityDBConcurrency) {
                     ExtCommunitySpec>(extcomm_db_);
 }
 
+// ----- Measure Locate() throughput of path attributes db.
+// Launch a number of threads, that repeatedly locate attributes that are
+// already present in the data base, which is the common case when routes
+// with the same path attributes are learnt from many peers.
+
+struct LocateBenchmarkArgs {
+    CommunityDB *db;
+    int community_count;
+    int iterations;
+};
+
+static void *LocateBenchmarkThreadRun(void *objp) {
+    LocateBenchmarkArgs *args = reinterpret_cast<LocateBenchmarkArgs *>(objp);
+
+    CommunitySpec spec;
+    spec.communities.push_back(0);
+    for (int i = 0; i < args->iterations; i++) {
+        spec.communities[0] = i % args->community_count;
+        CommunityPtr ptr = args->db->Locate(spec);
+        EXPECT_EQ(spec.communities[0], ptr->communities()[0]);
+    }
+    return NULL;
+}
+
+// Return the rate of Locate() calls per second, with thread_count threads
+// locating community_count communities in a db with hash_size buckets.
+static uint64_t LocateBenchmark(BgpServer *server, int hash_size,
+                                int thread_count) {
+    std::ostringstream hash_size_str;
+    hash_size_str << hash_size;
+    setenv("BGP_PATH_ATTRIBUTE_DB_HASH_SIZE", hash_size_str.str().c_str(), 1);
+    CommunityDB db(server);
+    unsetenv("BGP_PATH_ATTRIBUTE_DB_HASH_SIZE");
+    EXPECT_EQ(hash_size, (int) db.hash_size());
+
+    LocateBenchmarkArgs args;
+    args.db = &db;
+    args.community_count = 1024;
+    args.iterations = 100 * 1000;
+    char *str = getenv("LOCATE_ITERATIONS");
+    if (str) args.iterations = strtoul(str, NULL, 0);
+
+    // Keep all communities in the db for the duration of the benchmark.
+    std::vector<CommunityPtr> communities;
+    CommunitySpec spec;
+    spec.communities.push_back(0);
+    for (int i = 0; i < args.community_count; i++) {
+        spec.communities[0] = i;
+        communities.push_back(db.Locate(spec));
+    }
+
+    std::vector<pthread_t> thread_ids;
+    pthread_t tid;
+    uint64_t start = ClockMonotonicUsec();
+    for (int i = 0; i < thread_count; i++) {
+        if (!pthread_create(&tid, NULL, &LocateBenchmarkThreadRun, &args)) {
+            thread_ids.push_back(tid);
+        }
+    }
+    BOOST_FOREACH(tid, thread_ids) { pthread_join(tid, NULL); }
+    uint64_t elapsed = ClockMonotonicUsec() - start;
+
+    EXPECT_EQ(args.community_count, db.Size());
+    communities.clear();
+    EXPECT_EQ(0, db.Size());
+
+    uint64_t rate = (uint64_t) thread_ids.size() * args.iterations * 1000000 /
+        (elapsed ? elapsed : 1);
+    std::cout << "Hash size " << hash_size << ", " << thread_ids.size()
+              << " threads: " << rate << " locates/sec" << std::endl;
+    return rate;
+}
+
+TEST_F(BgpAttrTest, CommunityDBLocateBenchmark) {
+    int thread_count = DB::PartitionCount();
+    char *str = getenv("THREAD_COUNT");
+    if (str) thread_count = strtoul(str, NULL, 0);
+
+    LocateBenchmark(&server_, 1, thread_count);
+    LocateBenchmark(&server_,
+        CommunityDB::kHashSizePerPartition * DB::PartitionCount(),
+        thread_count);
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
@@ -2767,6 +2767,291 @@ TEST_F(BgpExportRouteUpdateTest2, LeaveClear6) {
     }
 }
 
+//
+// Used for a RouteUpdate that is staged on the PartitionUpdateQueue for the
+// DB partition, before the scheduling group task merges it to QUPDATE.
+//
+class BgpExportRouteUpdateTest3 : public BgpExportRouteUpdateCommonTest {
+protected:
+    void Initialize() {
+        SchedulerStop();
+        RunExport(false);
+        table_.VerifyExportResult(true);
+        rt_update_ = ExpectStagedRouteUpdate(&rt_);
+    }
+
+    RouteUpdate *ExpectStagedRouteUpdate(BgpRoute *route) {
+        DBState *dbstate = route->GetState(&table_, ribout_.listener_id());
+        RouteUpdate *rt_update = dynamic_cast<RouteUpdate *>(dbstate);
+        EXPECT_TRUE(rt_update != NULL);
+        EXPECT_EQ(RibOutUpdates::QUPDATE, rt_update->queue_id());
+        EXPECT_TRUE(rt_update->OnPartitionQueue());
+        EXPECT_EQ(tpart_->index(), rt_update->partition_id());
+        EXPECT_TRUE(updates_->queue(RibOutUpdates::QUPDATE)->empty());
+        VerifyStagedCount(1);
+        return rt_update;
+    }
+
+    void VerifyStagedCount(size_t count) {
+        EXPECT_EQ(count, updates_->partition_queue(tpart_->index())->size());
+    }
+};
+
+//
+// Description: Merge of a staged RouteUpdate to QUPDATE.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr A.
+// New DBState: RouteUpdate in QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr A.
+//
+TEST_F(BgpExportRouteUpdateTest3, Merge) {
+    for (int vSchedPeerCount = 1; vSchedPeerCount <= kPeerCount;
+            vSchedPeerCount++) {
+        BuildExportResult(attrA_, 0, vSchedPeerCount-1);
+        Initialize();
+        EXPECT_FALSE(updates_->Empty());
+
+        MergePartitionQueues();
+        VerifyStagedCount(0);
+
+        RouteUpdate *rt_update = ExpectRouteUpdate(&rt_);
+        EXPECT_EQ(rt_update_, rt_update);
+        EXPECT_FALSE(rt_update->OnPartitionQueue());
+        VerifyUpdates(rt_update, roattrA_, 0, vSchedPeerCount-1);
+        VerifyHistory(rt_update);
+
+        DrainAndDeleteRouteState(&rt_);
+        EXPECT_TRUE(updates_->Empty());
+    }
+}
+
+//
+// Description: Handle change in attribute for a RouteUpdate that has not
+//              been merged to QUPDATE yet.  The RouteUpdate is dequeued
+//              from the PartitionUpdateQueue and staged again.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr x.
+// Export Rslt: Accept peer x=[0,kPeerCount-1], alt attr x.
+// New DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,kPeerCount-1], alt attr x.
+//
+TEST_F(BgpExportRouteUpdateTest3, Reexport) {
+    for (int vSchedPeerCount = 1; vSchedPeerCount <= kPeerCount;
+            vSchedPeerCount++) {
+        BuildExportResult(attr_, 0, vSchedPeerCount-1);
+        Initialize();
+
+        BuildExportResult(alt_attr_, 0, kPeerCount-1);
+        RunExport(false);
+        table_.VerifyExportResult(true);
+
+        RouteUpdate *rt_update = ExpectStagedRouteUpdate(&rt_);
+        EXPECT_EQ(rt_update_, rt_update);
+        VerifyUpdates(rt_update, alt_attr_, 0, kPeerCount-1);
+        VerifyHistory(rt_update);
+
+        MergePartitionQueues();
+        rt_update = ExpectRouteUpdate(&rt_);
+        EXPECT_EQ(rt_update_, rt_update);
+        VerifyUpdates(rt_update, alt_attr_, 0, kPeerCount-1);
+
+        DrainAndDeleteRouteState(&rt_);
+    }
+}
+
+//
+// Description: Export policy rejects a route that has a RouteUpdate which
+//              has not been merged to QUPDATE yet.  The RouteUpdate must
+//              be dequeued from the PartitionUpdateQueue before it's freed.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr A.
+// Export Rslt: Reject.
+// New DBState: None.
+//
+TEST_F(BgpExportRouteUpdateTest3, ReexportReject) {
+    for (int vSchedPeerCount = 1; vSchedPeerCount <= kPeerCount;
+            vSchedPeerCount++) {
+        BuildExportResult(attrA_, 0, vSchedPeerCount-1);
+        Initialize();
+
+        table_.SetExportResult(false);
+        RunExport(false);
+        table_.VerifyExportResult(true);
+
+        ExpectNullDBState(&rt_);
+        VerifyStagedCount(0);
+        EXPECT_TRUE(updates_->Empty());
+
+        DrainAndVerifyNoState(&rt_);
+    }
+}
+
+//
+// Description: Join processing for a route that has a RouteUpdate which has
+//              not been merged to QUPDATE yet, followed by a change in the
+//              attribute.  The join builds an UpdateList with the staged
+//              RouteUpdate and a RouteUpdate in QBULK.  The export gets rid
+//              of the one in QBULK and stages the one for QUPDATE again.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[vJoinPeerCount,kPeerCount-1], attr A.
+// Join Peers:  Peers x=[0,vJoinPeerCount-1].
+// Export Rslt: Accept peer x=[0,vJoinPeerCount-1], attr A.
+// Mid DBState: UpdateList with RouteUpdate staged for QUPDATE and
+//              RouteUpdate in QBULK.
+// Export Rslt: Accept peer x=[0,kPeerCount-1], attr B.
+// New DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,kPeerCount-1], attr B.
+//
+TEST_F(BgpExportRouteUpdateTest3, JoinThenReexport) {
+    for (int vJoinPeerCount = 1; vJoinPeerCount < kPeerCount;
+            vJoinPeerCount++) {
+        BuildExportResult(attrA_, vJoinPeerCount, kPeerCount-1);
+        Initialize();
+
+        RibPeerSet join_peerset;
+        BuildPeerSet(join_peerset, 0, vJoinPeerCount-1);
+        BuildExportResult(attrA_, 0, vJoinPeerCount-1);
+        RunJoin(join_peerset);
+        table_.VerifyExportResult(true);
+
+        RouteUpdate *rt_update[RibOutUpdates::QCOUNT];
+        ExpectUpdateList(&rt_, rt_update);
+        EXPECT_EQ(rt_update_, rt_update[RibOutUpdates::QUPDATE]);
+        EXPECT_TRUE(rt_update_->OnPartitionQueue());
+        EXPECT_FALSE(rt_update[RibOutUpdates::QBULK]->OnPartitionQueue());
+        VerifyStagedCount(1);
+
+        BuildExportResult(attrB_, 0, kPeerCount-1);
+        RunExport(false);
+        table_.VerifyExportResult(true);
+
+        RouteUpdate *rt_update_new = ExpectStagedRouteUpdate(&rt_);
+        EXPECT_EQ(rt_update_, rt_update_new);
+        VerifyUpdates(rt_update_new, roattrB_, 0, kPeerCount-1);
+        EXPECT_TRUE(updates_->queue(RibOutUpdates::QBULK)->empty());
+
+        DrainAndDeleteRouteState(&rt_);
+    }
+}
+
+//
+// Description: Leave processing for a route that has a RouteUpdate which
+//              has not been merged to QUPDATE yet.
+//              Different attribute for all scheduled peers.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,kPeerCount-1], attr x.
+// Leave Peers: Peers x=[0,vLeavePeerCount-1].
+// New DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[vLeavePeerCount,kPeerCount-1], attr x.
+//
+TEST_F(BgpExportRouteUpdateTest3, LeaveClear) {
+    for (int vLeavePeerCount = 1; vLeavePeerCount < kPeerCount;
+            vLeavePeerCount++) {
+        BuildExportResult(attr_, 0, kPeerCount-1);
+        Initialize();
+
+        RibPeerSet leave_peerset;
+        BuildPeerSet(leave_peerset, 0, vLeavePeerCount-1);
+        RunLeave(leave_peerset);
+
+        RouteUpdate *rt_update = ExpectStagedRouteUpdate(&rt_);
+        EXPECT_EQ(rt_update_, rt_update);
+        VerifyUpdates(rt_update, attr_, vLeavePeerCount, kPeerCount-1);
+
+        MergePartitionQueues();
+        rt_update = ExpectRouteUpdate(&rt_);
+        VerifyUpdates(rt_update, attr_, vLeavePeerCount, kPeerCount-1);
+
+        DrainAndDeleteRouteState(&rt_);
+    }
+}
+
+//
+// Description: Leave processing for a route that has a RouteUpdate which
+//              has not been merged to QUPDATE yet.  All scheduled peers
+//              leave, so the RouteUpdate is dequeued from the
+//              PartitionUpdateQueue and freed.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vSchedPeerCount-1], attr A.
+// Leave Peers: Peers x=[0,kPeerCount-1].
+// New DBState: None.
+//
+TEST_F(BgpExportRouteUpdateTest3, LeaveAll) {
+    for (int vSchedPeerCount = 1; vSchedPeerCount <= kPeerCount;
+            vSchedPeerCount++) {
+        BuildExportResult(attrA_, 0, vSchedPeerCount-1);
+        Initialize();
+
+        RibPeerSet leave_peerset;
+        BuildPeerSet(leave_peerset, 0, kPeerCount-1);
+        RunLeave(leave_peerset);
+
+        ExpectNullDBState(&rt_);
+        VerifyStagedCount(0);
+        EXPECT_TRUE(updates_->Empty());
+
+        DrainAndVerifyNoState(&rt_);
+    }
+}
+
+//
+// Description: Leave processing for a route with an UpdateList that has a
+//              RouteUpdate which has not been merged to QUPDATE yet.  The
+//              peers of the staged RouteUpdate leave, so it's dequeued from
+//              the PartitionUpdateQueue and the UpdateList is downgraded to
+//              the RouteUpdate in QBULK.
+//
+// Old DBState: RouteUpdate staged for QUPDATE.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[vJoinPeerCount,kPeerCount-1], attr A.
+// Join Peers:  Peers x=[0,vJoinPeerCount-1].
+// Export Rslt: Accept peer x=[0,vJoinPeerCount-1], attr B.
+// Leave Peers: Peers x=[vJoinPeerCount,kPeerCount-1].
+// New DBState: RouteUpdate in QBULK.
+//              No AdvertiseInfo.
+//              UpdateInfo peer x=[0,vJoinPeerCount-1], attr B.
+//
+TEST_F(BgpExportRouteUpdateTest3, JoinThenLeave) {
+    for (int vJoinPeerCount = 1; vJoinPeerCount < kPeerCount;
+            vJoinPeerCount++) {
+        BuildExportResult(attrA_, vJoinPeerCount, kPeerCount-1);
+        Initialize();
+
+        RibPeerSet join_peerset;
+        BuildPeerSet(join_peerset, 0, vJoinPeerCount-1);
+        BuildExportResult(attrB_, 0, vJoinPeerCount-1);
+        RunJoin(join_peerset);
+        table_.VerifyExportResult(true);
+
+        RibPeerSet leave_peerset;
+        BuildPeerSet(leave_peerset, vJoinPeerCount, kPeerCount-1);
+        RunLeave(leave_peerset);
+        VerifyStagedCount(0);
+
+        RouteUpdate *rt_update = ExpectRouteUpdate(&rt_, RibOutUpdates::QBULK);
+        VerifyUpdates(rt_update, roattrB_, 0, vJoinPeerCount-1);
+        VerifyHistory(rt_update);
+
+        DrainAndDeleteRouteState(&rt_);
+    }
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
@@ -213,9 +213,21 @@ protected:
         task_util::WaitForIdle();
     }
 
-    void RunExport() {
-        ConcurrencyScope scope("db::DBTable");
-        export_->Export(tpart_, &rt_);
+    // Export merges the PartitionUpdateQueues to QUPDATE, like the
+    // scheduling group task does before a tail dequeue, unless merge is
+    // false, to leave the RouteUpdate staged on the PartitionUpdateQueue.
+    void RunExport(bool merge = true) {
+        {
+            ConcurrencyScope scope("db::DBTable");
+            export_->Export(tpart_, &rt_);
+        }
+        if (merge)
+            MergePartitionQueues();
+    }
+
+    void MergePartitionQueues() {
+        ConcurrencyScope scope("bgp::SendTask");
+        updates_->MergePartitionQueues();
     }
 
     void RunJoin(RibPeerSet &join_peerset) {
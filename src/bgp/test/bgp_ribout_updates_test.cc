@@ -2417,6 +2417,70 @@ TEST_F(RibOutUpdatesTest, PeerDequeueSplitMerge1) {
     }
 }
 
+// Routes:   Routes x=[0,kRouteCount-1] staged on the PartitionUpdateQueue
+//           for partition x modulo the partition count, attr A.
+// Blocking: None.
+// Result:   Merge moves the routes to QUPDATE in partition order, and in
+//           the order they were staged within each partition.
+//           Routes get sent to all peers in 1 update.
+TEST_F(RibOutUpdatesTest, PartitionMergeOrder) {
+    int part_count = DB::PartitionCount();
+    vector<RouteUpdate *> rt_updates;
+    for (int idx = 0; idx < kRouteCount; idx++) {
+        UpdateInfoSList uinfo_slist;
+        PrependUpdateInfo(uinfo_slist, attrA_, 0, kPeerCount-1);
+        rt_updates.push_back(BuildPartitionRouteUpdate(idx % part_count,
+            routes_[idx], uinfo_slist));
+    }
+
+    // Nothing is on QUPDATE until the merge.
+    UpdateQueue *queue = updates_->queue(RibOutUpdates::QUPDATE);
+    EXPECT_TRUE(queue->empty());
+    EXPECT_TRUE(queue->NextUpdate(queue->tail_marker()) == NULL);
+
+    MergePartitionQueues();
+    RouteUpdate *rt_update = queue->NextUpdate(queue->tail_marker());
+    for (int part_id = 0; part_id < part_count; part_id++) {
+        for (int idx = part_id; idx < kRouteCount; idx += part_count) {
+            ASSERT_TRUE(rt_update != NULL);
+            EXPECT_EQ(rt_updates[idx], rt_update);
+            EXPECT_FALSE(rt_update->OnPartitionQueue());
+            rt_update = queue->NextUpdate(rt_update);
+        }
+        EXPECT_TRUE(updates_->partition_queue(part_id)->empty());
+    }
+    EXPECT_TRUE(rt_update == NULL);
+    EXPECT_EQ(kRouteCount, queue->size());
+
+    UpdateRibOut();
+    VerifyUpdateCount(0, kPeerCount-1, COUNT_1);
+    VerifyPeerInSync(0, kPeerCount-1, true);
+    VerifyMessageCount(1);
+}
+
+// Routes:   Route 0 staged on the PartitionUpdateQueue for the last
+//           partition, attr A.
+// Blocking: None.
+// Result:   RibOutUpdates is not empty while the route is staged. The tail
+//           dequeue merges and sends it, after which it's empty.
+TEST_F(RibOutUpdatesTest, PartitionStagedNotEmpty) {
+    EXPECT_TRUE(updates_->Empty());
+
+    UpdateInfoSList uinfo_slist;
+    PrependUpdateInfo(uinfo_slist, attrA_, 0, kPeerCount-1);
+    BuildPartitionRouteUpdate(DB::PartitionCount() - 1, routes_[0],
+        uinfo_slist);
+    EXPECT_TRUE(updates_->queue(RibOutUpdates::QUPDATE)->empty());
+    EXPECT_FALSE(updates_->Empty());
+
+    UpdateRibOut();
+    VerifyUpdateCount(0, kPeerCount-1, COUNT_1);
+    VerifyMessageCount(1);
+    RouteState *rstate = ExpectRouteState(routes_[0]);
+    VerifyHistory(rstate, attrA_, 0, kPeerCount-1);
+    EXPECT_TRUE(updates_->Empty());
+}
+
 static void SetUp() {
     bgp_log_test::init();
     ControlNode::SetDefaultSchedulingPolicy();
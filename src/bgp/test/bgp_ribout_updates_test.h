@@ -442,6 +442,21 @@ protected:
         return rt_update;
     }
 
+    RouteUpdate *BuildPartitionRouteUpdate(int part_id, BgpRoute *route,
+            UpdateInfoSList &uinfo_slist) {
+        ConcurrencyScope scope("db::DBTable");
+        RouteUpdate *rt_update =
+            new RouteUpdate(route, RibOutUpdates::QUPDATE);
+        rt_update->SetUpdateInfo(uinfo_slist);
+        updates_->PartitionEnqueue(part_id, route, rt_update);
+        return rt_update;
+    }
+
+    void MergePartitionQueues() {
+        ConcurrencyScope scope("bgp::SendTask");
+        updates_->MergePartitionQueues();
+    }
+
     void EnqueueDefaultRoute() {
         UpdateInfoSList uinfo_slist;
         PrependUpdateInfo(uinfo_slist, attrZ_, 0, (int) peers_.size()-1);
@@ -63,18 +63,33 @@ public:
         SendReadyCb cb) {
         bool ret;
 
-        // Simulate write blocked after the first message is sent.
         ret = XmppChannelMux::Send(msg, msgsize, id, cb);
         assert(ret);
+        return WriteBlocked(id, cb);
+    }
+
+    // Route updates are sent as a header and a shared body
+    virtual bool SendParts(const uint8_t *header, size_t header_size,
+        TcpMessageBuffer *body, xmps::PeerId id, SendReadyCb cb,
+        size_t *copied) {
+        bool ret;
+
+        ret = XmppChannelMux::SendParts(header, header_size, body, id, cb,
+                                        copied);
+        assert(ret);
+        return WriteBlocked(id, cb);
+    }
+
+private:
+    // Simulate write blocked after the first message is sent.
+    bool WriteBlocked(xmps::PeerId id, SendReadyCb cb) {
         if (++count_ == 1) {
             XmppChannelMux::RegisterWriteReady(id, cb);
             return false;
         }
-
         return true;
     }
 
-private:
     int count_;
 };
 
@@ -0,0 +1,481 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "bgp/xmpp_message_builder.h"
+
+#include <sstream>
+#include <boost/foreach.hpp>
+#include <pugixml/pugixml.hpp>
+
+#include "base/logging.h"
+#include "base/task.h"
+#include "base/task_annotations.h"
+#include "base/test/task_test_util.h"
+#include "bgp/bgp_attr.h"
+#include "bgp/bgp_log.h"
+#include "bgp/bgp_server.h"
+#include "bgp/ipeer.h"
+#include "bgp/ermvpn/ermvpn_route.h"
+#include "bgp/evpn/evpn_route.h"
+#include "bgp/inet/inet_route.h"
+#include "bgp/inet6/inet6_route.h"
+#include "bgp/routing-instance/routing_instance.h"
+#include "bgp/security_group/security_group.h"
+#include "bgp/test/bgp_server_test_util.h"
+#include "bgp/tunnel_encap/tunnel_encap.h"
+#include "control-node/control_node.h"
+#include "db/db.h"
+#include "ifmap/autogen.h"
+#include "io/event_manager.h"
+#include "schema/xmpp_enet_types.h"
+#include "schema/xmpp_multicast_types.h"
+#include "schema/xmpp_unicast_types.h"
+#include "testing/gunit.h"
+#include "xmpp/xmpp_init.h"
+
+using namespace std;
+using namespace pugi;
+
+class PeerMock : public IPeerUpdate {
+public:
+    explicit PeerMock(const string &name) : name_(name) { }
+    virtual string ToString() const { return name_; }
+    virtual bool SendUpdate(const uint8_t *msg, size_t msgsize) {
+        return true;
+    }
+
+private:
+    string name_;
+};
+
+//
+// Encodes inet routes the way BgpXmppMessage did before it wrote XML text
+// directly: an autogen item is built for each route and encoded into a
+// pugixml document, which is saved and then copied with the "to" attribute
+// replaced for every peer.
+//
+class DomXmppMessage {
+public:
+    DomXmppMessage(const BgpTable *table, const BgpRoute *route)
+        : table_(table) {
+        xml_node message = xdoc_.append_child("message");
+        message.append_attribute("from") = XmppInit::kControlNodeJID;
+        xml_node event = message.append_child("event");
+        event.append_attribute("xmlns") = "http://jabber.org/protocol/pubsub";
+        xitems_ = event.append_child("items");
+        stringstream ss;
+        ss << route->Afi() << "/" << int(route->XmppSafi()) << "/" <<
+              table_->routing_instance()->name();
+        xitems_.append_attribute("node") = ss.str().c_str();
+    }
+
+    void AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
+        autogen::ItemType item;
+        item.entry.nlri.af = route->Afi();
+        item.entry.nlri.safi = route->XmppSafi();
+        item.entry.nlri.address = route->ToString();
+        item.entry.version = 1;
+        item.entry.virtual_network = "unresolved";
+        item.entry.local_preference = roattr->attr()->local_pref();
+        item.entry.sequence_number = 0;
+        BOOST_FOREACH(RibOutAttr::NextHop nexthop, roattr->nexthop_list()) {
+            autogen::NextHopType item_nexthop;
+            item_nexthop.af = route->NexthopAfi();
+            item_nexthop.address = nexthop.address().to_v4().to_string();
+            item_nexthop.label = nexthop.label();
+            item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation =
+                nexthop.encap();
+            item.entry.next_hops.next_hop.push_back(item_nexthop);
+        }
+        xml_node node = xitems_.append_child("item");
+        node.append_attribute("id") = route->ToXmppIdString().c_str();
+        item.Encode(&node);
+    }
+
+    const string &GetData(IPeerUpdate *peer) {
+        string str = peer->ToString() + "/" + XmppInit::kBgpPeer;
+        if (!repr_.empty()) {
+            repr_new_ = string(repr_, 0, repr_part1_) + "to=\"" + str +
+                        "\">" + string(repr_, repr_part2_);
+            return repr_new_;
+        }
+        xml_node message = xdoc_.child("message");
+        message.append_attribute("to") = str.c_str();
+        ostringstream oss;
+        xdoc_.save(oss);
+        repr_ = oss.str();
+        repr_part1_ = repr_.find("to=", 0);
+        repr_part2_ = repr_.find("\n\t<event xmlns");
+        return repr_;
+    }
+
+private:
+    const BgpTable *table_;
+    xml_document xdoc_;
+    xml_node xitems_;
+    string repr_;
+    string repr_new_;
+    size_t repr_part1_;
+    size_t repr_part2_;
+};
+
+class XmppMessageBuilderTest : public ::testing::Test {
+protected:
+    XmppMessageBuilderTest()
+        : server_(&evm_), builder_(BgpXmppMessageBuilder::GetInstance()),
+          peer_("agent-1") {
+    }
+
+    virtual void SetUp() {
+        ConcurrencyScope scope("bgp::Config");
+
+        blue_cfg_.reset(BgpTestUtil::CreateBgpInstanceConfig(
+            "blue", "target:1.2.3.4:1", "target:1.2.3.4:1"));
+
+        TaskScheduler *scheduler = TaskScheduler::GetInstance();
+        scheduler->Stop();
+        server_.routing_instance_mgr()->CreateRoutingInstance(blue_cfg_.get());
+        scheduler->Start();
+        task_util::WaitForIdle();
+    }
+
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        server_.Shutdown();
+        task_util::WaitForIdle();
+        STLDeleteValues(&routes_);
+    }
+
+    // Number of routes for the encode comparison. Can be overridden with
+    // XMPP_MESSAGE_BUILDER_TEST_ROUTES.
+    static size_t RouteCount() {
+        char *str = getenv("XMPP_MESSAGE_BUILDER_TEST_ROUTES");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 64 * 1024;
+    }
+
+    BgpTable *GetTable(const string &name) {
+        return static_cast<BgpTable *>(server_.database()->FindTable(name));
+    }
+
+    BgpAttrPtr BuildAttr(const string &nexthop_str, bool olist = false) {
+        BgpAttrSpec spec;
+        boost::system::error_code ec;
+        BgpAttrNextHop nexthop(
+            Ip4Address::from_string(nexthop_str, ec).to_ulong());
+        spec.push_back(&nexthop);
+        BgpAttrLocalPref local_pref(200);
+        spec.push_back(&local_pref);
+        ExtCommunitySpec ext_community;
+        ext_community.communities.push_back(
+            TunnelEncap("udp").GetExtCommunityValue());
+        ext_community.communities.push_back(
+            SecurityGroup(server_.autonomous_system(), 8000001)
+                .GetExtCommunityValue());
+        spec.push_back(&ext_community);
+        BgpAttrPtr attr = server_.attr_db()->Locate(spec);
+        if (!olist)
+            return attr;
+
+        BgpOList *olist_ptr = new BgpOList;
+        vector<string> encap;
+        encap.push_back("gre");
+        olist_ptr->elements.push_back(BgpOListElem(
+            Ip4Address::from_string("10.1.1.1", ec), 100, encap));
+        olist_ptr->elements.push_back(BgpOListElem(
+            Ip4Address::from_string("10.1.1.2", ec), 200, encap));
+        return server_.attr_db()->ReplaceOListAndLocate(attr.get(),
+                                                        BgpOListPtr(olist_ptr));
+    }
+
+    InetRoute *AddInetRoute(uint32_t index) {
+        Ip4Prefix prefix(Ip4Address(0x0a000000 + index), 32);
+        InetRoute *route = new InetRoute(prefix);
+        routes_.push_back(route);
+        return route;
+    }
+
+    string EncodeMessage(BgpTable *table, const RibOutAttr *roattr,
+                         const vector<BgpRoute *> &routes) {
+        auto_ptr<Message> message(
+            builder_->Create(table, roattr, routes.front()));
+        for (size_t i = 1; i < routes.size(); i++) {
+            message->AddRoute(routes[i], roattr);
+        }
+        message->Finish();
+
+        size_t length, header_length;
+        const uint8_t *data = message->GetData(&peer_, &length);
+        string repr(reinterpret_cast<const char *>(data), length);
+        const uint8_t *header = message->GetHeader(&peer_, &header_length);
+        const TcpMessageBuffer *body = message->GetBody();
+        EXPECT_EQ(repr,
+            string(reinterpret_cast<const char *>(header), header_length) +
+            string(reinterpret_cast<const char *>(body->data()),
+                   body->size()));
+        return repr;
+    }
+
+    // Returns the items node of the message after checking the message
+    // attributes
+    xml_node ParseMessage(xml_document *xdoc, const string &repr,
+                          const string &node) {
+        EXPECT_TRUE(xdoc->load_buffer(repr.data(), repr.size()));
+        xml_node message = xdoc->child("message");
+        EXPECT_STREQ(XmppInit::kControlNodeJID,
+                     message.attribute("from").value());
+        EXPECT_EQ(string("agent-1/") + XmppInit::kBgpPeer,
+                  message.attribute("to").value());
+        xml_node items = message.child("event").child("items");
+        EXPECT_EQ(node, items.attribute("node").value());
+        return items;
+    }
+
+    EventManager evm_;
+    BgpServer server_;
+    boost::scoped_ptr<BgpInstanceConfigTest> blue_cfg_;
+    BgpXmppMessageBuilder *builder_;
+    PeerMock peer_;
+    vector<BgpRoute *> routes_;
+};
+
+TEST_F(XmppMessageBuilderTest, Inet) {
+    BgpTable *table = GetTable("blue.inet.0");
+    RibOutAttr roattr(BuildAttr("192.168.1.1").get(), 1000);
+    vector<BgpRoute *> routes;
+    for (int i = 0; i < 8; i++) {
+        routes.push_back(AddInetRoute(i));
+    }
+    string repr = EncodeMessage(table, &roattr, routes);
+
+    xml_document xdoc;
+    xml_node node = ParseMessage(&xdoc, repr, "1/1/blue");
+    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::ItemsType::XmlParseProperty(node, &xparser));
+    autogen::ItemsType *items =
+        static_cast<autogen::ItemsType *>(xparser.get());
+    ASSERT_EQ(routes.size(), items->item.size());
+    for (size_t i = 0; i < routes.size(); i++) {
+        const autogen::EntryType &entry = items->item[i].entry;
+        EXPECT_EQ(BgpAf::IPv4, entry.nlri.af);
+        EXPECT_EQ(BgpAf::Unicast, entry.nlri.safi);
+        EXPECT_EQ(routes[i]->ToString(), entry.nlri.address);
+        EXPECT_EQ(1, entry.version);
+        EXPECT_EQ("unresolved", entry.virtual_network);
+        EXPECT_EQ(200, entry.local_preference);
+        ASSERT_EQ(1U, entry.next_hops.next_hop.size());
+        const autogen::NextHopType &nexthop = entry.next_hops.next_hop[0];
+        EXPECT_EQ(BgpAf::IPv4, nexthop.af);
+        EXPECT_EQ("192.168.1.1", nexthop.address);
+        EXPECT_EQ(1000, nexthop.label);
+        ASSERT_EQ(1U,
+            nexthop.tunnel_encapsulation_list.tunnel_encapsulation.size());
+        EXPECT_EQ("udp",
+            nexthop.tunnel_encapsulation_list.tunnel_encapsulation[0]);
+        ASSERT_EQ(1U, entry.security_group_list.security_group.size());
+        EXPECT_EQ(8000001, entry.security_group_list.security_group[0]);
+    }
+}
+
+TEST_F(XmppMessageBuilderTest, Inet6) {
+    BgpTable *table = GetTable("blue.inet6.0");
+    RibOutAttr roattr(BuildAttr("192.168.1.1").get(), 1000);
+    boost::system::error_code ec;
+    Inet6Route *route =
+        new Inet6Route(Inet6Prefix::FromString("2001:db8::1/128", &ec));
+    routes_.push_back(route);
+    string repr = EncodeMessage(table, &roattr, routes_);
+
+    xml_document xdoc;
+    xml_node node = ParseMessage(&xdoc, repr, "2/1/blue");
+    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::ItemsType::XmlParseProperty(node, &xparser));
+    autogen::ItemsType *items =
+        static_cast<autogen::ItemsType *>(xparser.get());
+    ASSERT_EQ(1U, items->item.size());
+    const autogen::EntryType &entry = items->item[0].entry;
+    EXPECT_EQ(BgpAf::IPv6, entry.nlri.af);
+    EXPECT_EQ(route->ToString(), entry.nlri.address);
+    ASSERT_EQ(1U, entry.next_hops.next_hop.size());
+    EXPECT_EQ(BgpAf::IPv4, entry.next_hops.next_hop[0].af);
+    EXPECT_EQ("192.168.1.1", entry.next_hops.next_hop[0].address);
+}
+
+TEST_F(XmppMessageBuilderTest, Enet) {
+    BgpTable *table = GetTable("blue.evpn.0");
+    RibOutAttr roattr(BuildAttr("192.168.1.1").get(), 1000);
+    boost::system::error_code ec;
+    EvpnRoute *route = new EvpnRoute(EvpnPrefix::FromString(
+        "2-10.1.1.1:65535-0-11:12:13:14:15:16,192.1.1.1", &ec));
+    routes_.push_back(route);
+    string repr = EncodeMessage(table, &roattr, routes_);
+
+    xml_document xdoc;
+    xml_node node = ParseMessage(&xdoc, repr, "25/242/blue");
+    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::EnetItemsType::XmlParseProperty(node, &xparser));
+    autogen::EnetItemsType *items =
+        static_cast<autogen::EnetItemsType *>(xparser.get());
+    ASSERT_EQ(1U, items->item.size());
+    const autogen::EnetEntryType &entry = items->item[0].entry;
+    EXPECT_EQ(BgpAf::L2Vpn, entry.nlri.af);
+    EXPECT_EQ(BgpAf::Enet, entry.nlri.safi);
+    EXPECT_EQ("11:12:13:14:15:16", entry.nlri.mac);
+    EXPECT_EQ("192.1.1.1/32", entry.nlri.address);
+    ASSERT_EQ(1U, entry.next_hops.next_hop.size());
+    EXPECT_EQ("192.168.1.1", entry.next_hops.next_hop[0].address);
+    EXPECT_EQ(1000, entry.next_hops.next_hop[0].label);
+    EXPECT_EQ(0U, entry.olist.next_hop.size());
+}
+
+TEST_F(XmppMessageBuilderTest, Mcast) {
+    BgpTable *table = GetTable("blue.ermvpn.0");
+    RibOutAttr roattr(BuildAttr("192.168.1.1", true).get(), 1000);
+    ErmVpnRoute *route = new ErmVpnRoute(ErmVpnPrefix::FromString(
+        "0-10.1.1.1:65535-0.0.0.0,224.1.2.3,192.168.1.1"));
+    routes_.push_back(route);
+    string repr = EncodeMessage(table, &roattr, routes_);
+
+    xml_document xdoc;
+    xml_node node = ParseMessage(&xdoc, repr, "1/241/blue");
+    auto_ptr<AutogenProperty> xparser(new AutogenProperty());
+    ASSERT_TRUE(autogen::McastItemsType::XmlParseProperty(node, &xparser));
+    autogen::McastItemsType *items =
+        static_cast<autogen::McastItemsType *>(xparser.get());
+    ASSERT_EQ(1U, items->item.size());
+    const autogen::McastEntryType &entry = items->item[0].entry;
+    EXPECT_EQ("224.1.2.3", entry.nlri.group);
+    EXPECT_EQ("192.168.1.1", entry.nlri.source);
+    EXPECT_EQ(1000, entry.nlri.source_label);
+    ASSERT_EQ(2U, entry.olist.next_hop.size());
+    EXPECT_EQ("10.1.1.1", entry.olist.next_hop[0].address);
+    EXPECT_EQ("100", entry.olist.next_hop[0].label);
+    EXPECT_EQ("10.1.1.2", entry.olist.next_hop[1].address);
+    EXPECT_EQ("200", entry.olist.next_hop[1].label);
+}
+
+TEST_F(XmppMessageBuilderTest, Retract) {
+    BgpTable *table = GetTable("blue.inet.0");
+    RibOutAttr roattr;
+    vector<BgpRoute *> routes;
+    routes.push_back(AddInetRoute(1));
+    routes.push_back(AddInetRoute(2));
+    auto_ptr<Message> message(builder_->Create(table, &roattr, routes[0]));
+    message->AddRoute(routes[1], &roattr);
+    message->Finish();
+    EXPECT_EQ(0U, message->num_reach_routes());
+    EXPECT_EQ(2U, message->num_unreach_routes());
+
+    size_t length;
+    const uint8_t *data = message->GetData(&peer_, &length);
+    xml_document xdoc;
+    xml_node items = ParseMessage(&xdoc,
+        string(reinterpret_cast<const char *>(data), length), "1/1/blue");
+    size_t count = 0;
+    for (xml_node node = items.child("retract"); node;
+         node = node.next_sibling("retract")) {
+        EXPECT_EQ(routes[count]->ToXmppIdString(), node.attribute("id").value());
+        count++;
+    }
+    EXPECT_EQ(2U, count);
+}
+
+// The body is built once and can outlive the message. Peers that do not
+// override SendUpdateParts() copy all of the message.
+TEST_F(XmppMessageBuilderTest, SharedBody) {
+    BgpTable *table = GetTable("blue.inet.0");
+    RibOutAttr roattr(BuildAttr("192.168.1.1").get(), 1000);
+    auto_ptr<Message> message(
+        builder_->Create(table, &roattr, AddInetRoute(1)));
+    message->Finish();
+
+    TcpMessageBufferPtr body(message->GetBody());
+    EXPECT_EQ(body.get(), message->GetBody());
+    size_t header_length, copied;
+    const uint8_t *header = message->GetHeader(&peer_, &header_length);
+    EXPECT_TRUE(peer_.SendUpdateParts(header, header_length, body.get(),
+                                      &copied));
+    EXPECT_EQ(header_length + body->size(), copied);
+
+    string repr(reinterpret_cast<const char *>(body->data()), body->size());
+    message.reset();
+    EXPECT_EQ(repr,
+        string(reinterpret_cast<const char *>(body->data()), body->size()));
+}
+
+// Compare the time taken to encode RouteCount() inet routes and get the
+// data for a number of peers with the DOM based encoding previously used
+// by BgpXmppMessage
+TEST_F(XmppMessageBuilderTest, EncodeRate) {
+    static const size_t kRoutesPerMessage = 64;
+    static const size_t kPeerCount = 16;
+    BgpTable *table = GetTable("blue.inet.0");
+    RibOutAttr roattr(BuildAttr("192.168.1.1").get(), 1000);
+    size_t count = RouteCount();
+    for (size_t i = 0; i < count; i++) {
+        AddInetRoute(i);
+    }
+    vector<PeerMock *> peers;
+    for (size_t i = 0; i < kPeerCount; i++) {
+        stringstream ss;
+        ss << "agent-" << i;
+        peers.push_back(new PeerMock(ss.str()));
+    }
+
+    size_t dom_bytes = 0;
+    uint64_t start = UTCTimestampUsec();
+    for (size_t i = 0; i < count; i += kRoutesPerMessage) {
+        DomXmppMessage message(table, routes_[i]);
+        for (size_t j = i; j < i + kRoutesPerMessage && j < count; j++) {
+            message.AddRoute(routes_[j], &roattr);
+        }
+        for (size_t j = 0; j < kPeerCount; j++) {
+            dom_bytes += message.GetData(peers[j]).size();
+        }
+    }
+    uint64_t dom_time = UTCTimestampUsec() - start;
+
+    size_t bytes = 0;
+    start = UTCTimestampUsec();
+    for (size_t i = 0; i < count; i += kRoutesPerMessage) {
+        auto_ptr<Message> message(
+            builder_->Create(table, &roattr, routes_[i]));
+        for (size_t j = i + 1; j < i + kRoutesPerMessage && j < count; j++) {
+            message->AddRoute(routes_[j], &roattr);
+        }
+        message->Finish();
+        for (size_t j = 0; j < kPeerCount; j++) {
+            size_t header_length;
+            message->GetHeader(peers[j], &header_length);
+            bytes += header_length + message->GetBody()->size();
+        }
+    }
+    uint64_t time = UTCTimestampUsec() - start;
+    STLDeleteValues(&peers);
+
+    if (dom_time == 0)
+        dom_time = 1;
+    if (time == 0)
+        time = 1;
+    cout << count << " routes, " << kRoutesPerMessage << " routes/message, "
+         << kPeerCount << " peers" << endl;
+    cout << "DOM encoder       : " << dom_time << " usec, "
+         << count * 1000000ULL / dom_time << " routes/sec, "
+         << dom_bytes << " bytes" << endl;
+    cout << "Streaming encoder : " << time << " usec, "
+         << count * 1000000ULL / time << " routes/sec, "
+         << bytes << " bytes" << endl;
+    EXPECT_LT(0U, bytes);
+}
+
+int main(int argc, char **argv) {
+    bgp_log_test::init();
+    ::testing::InitGoogleTest(&argc, argv);
+    ControlNode::SetDefaultSchedulingPolicy();
+    int result = RUN_ALL_TESTS();
+    TaskScheduler::GetInstance()->Terminate();
+    return result;
+}
@@ -5,7 +5,6 @@
 #include "bgp/xmpp_message_builder.h"
 
 #include <boost/foreach.hpp>
-#include <pugixml/pugixml.hpp>
 
 #include "base/parse_object.h"
 #include "base/logging.h"
@@ -18,17 +17,73 @@
 #include "bgp/evpn/evpn_route.h"
 #include "bgp/origin-vn/origin_vn.h"
 #include "bgp/security_group/security_group.h"
+#include "io/tcp_message_buffer.h"
 #include "net/bgp_af.h"
-#include "schema/xmpp_unicast_types.h"
-#include "schema/xmpp_multicast_types.h"
-#include "schema/xmpp_enet_types.h"
 #include "xmpp/xmpp_init.h"
 
-using namespace pugi;
 using namespace std;
 
+namespace {
+
+// Appends value with the characters that are not allowed in XML character
+// data and attribute values replaced by entity references.
+void XmlAppendEscaped(string *buffer, const string &value) {
+    const char *start = value.data();
+    const char *end = start + value.size();
+    for (const char *c = start; c != end; ++c) {
+        const char *entity;
+        switch (*c) {
+        case '&': entity = "&amp;"; break;
+        case '<': entity = "&lt;"; break;
+        case '>': entity = "&gt;"; break;
+        case '"': entity = "&quot;"; break;
+        default: continue;
+        }
+        buffer->append(start, c - start);
+        buffer->append(entity);
+        start = c + 1;
+    }
+    buffer->append(start, end - start);
+}
+
+void XmlAppendInteger(string *buffer, int64_t value) {
+    char digits[24];
+    char *end = digits + sizeof(digits);
+    char *p = end;
+    uint64_t abs_value = (value < 0) ? -(uint64_t) value : value;
+    do {
+        *--p = '0' + abs_value % 10;
+        abs_value /= 10;
+    } while (abs_value);
+    if (value < 0) {
+        *--p = '-';
+    }
+    buffer->append(p, end - p);
+}
+
+void XmlAppendAddress(string *buffer, const Ip4Address &address) {
+    uint32_t value = address.to_ulong();
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        XmlAppendInteger(buffer, (value >> shift) & 0xff);
+        if (shift) {
+            buffer->push_back('.');
+        }
+    }
+}
+
+}  // namespace
+
+//
+// Routes are encoded as XML text directly into a buffer, in the form that
+// the autogen types of the xmpp schemas would produce. The buffer holds the
+// body of the message, which is the same for all peers. Only the message
+// header, which has the peer name in the "to" attribute, is built for each
+// peer.
+//
 class BgpXmppMessage : public Message {
 public:
+    static const size_t kInitialBufferSize = 4096;
+
     BgpXmppMessage(const BgpTable *table, const RibOutAttr *roattr)
         : table_(table),
           is_reachable_(roattr->IsReachable()),
@@ -37,20 +92,52 @@ public:
     virtual ~BgpXmppMessage() { }
     void Start(const RibOutAttr *roattr, const BgpRoute *route);
     virtual bool AddRoute(const BgpRoute *route, const RibOutAttr *roattr);
-    virtual void Finish() { }
+    virtual void Finish();
     virtual const uint8_t *GetData(IPeerUpdate *peer, size_t *lenp);
+    virtual const uint8_t *GetHeader(IPeerUpdate *peer, size_t *lenp);
+    virtual TcpMessageBuffer *GetBody();
 
 private:
-    void EncodeNextHop(const BgpRoute *route, RibOutAttr::NextHop nexthop,
-                       autogen::ItemType &item);
+    void BeginElement(const char *name) {
+        body_.push_back('<');
+        body_.append(name);
+        body_.push_back('>');
+    }
+    void EndElement(const char *name) {
+        body_.append("</");
+        body_.append(name);
+        body_.push_back('>');
+    }
+    void AddElement(const char *name, const string &value) {
+        BeginElement(name);
+        XmlAppendEscaped(&body_, value);
+        EndElement(name);
+    }
+    void AddElement(const char *name, int64_t value) {
+        BeginElement(name);
+        XmlAppendInteger(&body_, value);
+        EndElement(name);
+    }
+    void AddElement(const char *name, const Ip4Address &address) {
+        BeginElement(name);
+        XmlAppendAddress(&body_, address);
+        EndElement(name);
+    }
+    void BeginItem(const BgpRoute *route);
+    void EndItem();
+    void AddRetract(const BgpRoute *route);
+    void EncodeTunnelEncap(const vector<string> &encap, bool default_gre);
+
+    void EncodeNextHop(const BgpRoute *route,
+                       const RibOutAttr::NextHop &nexthop);
     void AddIpReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddIpUnreach(const BgpRoute *route);
     bool AddInetRoute(const BgpRoute *route, const RibOutAttr *roattr);
 
     bool AddInet6Route(const BgpRoute *route, const RibOutAttr *roattr);
 
-    void EncodeEnetNextHop(const BgpRoute *route, RibOutAttr::NextHop nexthop,
-                           autogen::EnetItemType &item);
+    void EncodeEnetNextHop(const BgpRoute *route,
+                           const RibOutAttr::NextHop &nexthop);
     void AddEnetReach(const BgpRoute *route, const RibOutAttr *roattr);
     void AddEnetUnreach(const BgpRoute *route);
     bool AddEnetRoute(const BgpRoute *route, const RibOutAttr *roattr);
@@ -90,50 +177,34 @@ private:
 
     const BgpTable *table_;
     bool is_reachable_;
-    xml_document xdoc_;
-    xml_node xitems_;
     uint32_t sequence_number_;
     std::string virtual_network_;
     std::vector<int> security_group_list_;
+    string header_;
+    string body_;
+    TcpMessageBufferPtr body_buffer_;
     string repr_;
-    string repr_new_;
-    size_t repr_part1_;
-    size_t repr_part2_;
 
     DISALLOW_COPY_AND_ASSIGN(BgpXmppMessage);
 };
 
 void BgpXmppMessage::Start(const RibOutAttr *roattr, const BgpRoute *route) {
-    // Build the DOM tree
-    xml_node message = xdoc_.append_child("message");
-    message.append_attribute("from") = XmppInit::kControlNodeJID;
-
-    xml_node event = message.append_child("event");
-    event.append_attribute("xmlns") = "http://jabber.org/protocol/pubsub";
-    xitems_ = event.append_child("items");
+    body_.reserve(kInitialBufferSize);
+    body_.append("<event xmlns=\"http://jabber.org/protocol/pubsub\">");
+    body_.append("<items node=\"");
+    XmlAppendInteger(&body_, route->Afi());
+    body_.push_back('/');
+    XmlAppendInteger(&body_, route->XmppSafi());
+    body_.push_back('/');
+    XmlAppendEscaped(&body_, table_->routing_instance()->name());
+    body_.append("\">");
 
     if (is_reachable_) {
         const BgpAttr *attr = roattr->attr();
         ProcessExtCommunity(attr->ext_community());
     }
 
-    stringstream ss;
-    ss << route->Afi() << "/" << int(route->XmppSafi()) << "/" <<
-          table_->routing_instance()->name();
-    std::string node(ss.str());
-    if (table_->family() == Address::ERMVPN) {
-        xitems_.append_attribute("node") = node.c_str();
-        AddMcastRoute(route, roattr);
-    } else if (table_->family() == Address::EVPN) {
-        xitems_.append_attribute("node") = node.c_str();
-        AddEnetRoute(route, roattr);
-    } else if (table_->family() == Address::INET6) {
-        xitems_.append_attribute("node") = node.c_str();
-        AddInet6Route(route, roattr);
-    } else {
-        xitems_.append_attribute("node") = node.c_str();
-        AddInetRoute(route, roattr);
-    }
+    AddRoute(route, roattr);
 }
 
 bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -148,61 +219,100 @@ bool BgpXmppMessage::AddRoute(const BgpRoute *route, const RibOutAttr *roattr) {
     }
 }
 
-void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
-                                   RibOutAttr::NextHop nexthop,
-                                   autogen::ItemType &item) {
-    autogen::NextHopType item_nexthop;
-
-    item_nexthop.af = route->NexthopAfi();
-    item_nexthop.address = nexthop.address().to_v4().to_string();
-    item_nexthop.label = nexthop.label();
-    if (nexthop.encap().empty()) {
+//
+// The body is moved to a buffer that the peers it is sent to can hold on to
+// after the message is gone.
+//
+void BgpXmppMessage::Finish() {
+    if (body_buffer_)
+        return;
+    body_.append("</items></event>\n</message>\n");
+    body_buffer_.reset(new TcpMessageBuffer(&body_));
+}
+
+void BgpXmppMessage::BeginItem(const BgpRoute *route) {
+    body_.append("<item id=\"");
+    XmlAppendEscaped(&body_, route->ToXmppIdString());
+    body_.append("\">");
+    BeginElement("entry");
+}
+
+void BgpXmppMessage::EndItem() {
+    EndElement("entry");
+    EndElement("item");
+}
+
+void BgpXmppMessage::AddRetract(const BgpRoute *route) {
+    body_.append("<retract id=\"");
+    XmlAppendEscaped(&body_, route->ToXmppIdString());
+    body_.append("\" />");
+}
+
+void BgpXmppMessage::EncodeTunnelEncap(const vector<string> &encap,
+                                       bool default_gre) {
+    BeginElement("tunnel-encapsulation-list");
+    if (encap.empty() && default_gre) {
         // If encap list is empty, routes from non-control-node, 
         // use mpls over gre as default encap
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation.
-            push_back(std::string("gre"));
-    } else {
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation =
-            nexthop.encap();
+        AddElement("tunnel-encapsulation", string("gre"));
+    }
+    for (vector<string>::const_iterator it = encap.begin();
+         it != encap.end(); ++it) {
+        AddElement("tunnel-encapsulation", *it);
     }
+    EndElement("tunnel-encapsulation-list");
+}
 
-    item.entry.next_hops.next_hop.push_back(item_nexthop);
+void BgpXmppMessage::EncodeNextHop(const BgpRoute *route,
+                                   const RibOutAttr::NextHop &nexthop) {
+    BeginElement("next-hop");
+    AddElement("af", route->NexthopAfi());
+    AddElement("address", nexthop.address().to_v4());
+    AddElement("label", nexthop.label());
+    EncodeTunnelEncap(nexthop.encap(), true);
+    EndElement("next-hop");
 }
 
 void BgpXmppMessage::AddIpReach(const BgpRoute *route,
                                 const RibOutAttr *roattr) {
-    autogen::ItemType item;
+    BeginItem(route);
 
-    item.entry.nlri.af = route->Afi();
-    item.entry.nlri.safi = route->XmppSafi();
-    item.entry.nlri.address = route->ToString();
-    item.entry.version = 1;
-    item.entry.virtual_network = GetVirtualNetwork(route);
-    item.entry.local_preference = roattr->attr()->local_pref();
-    item.entry.sequence_number = sequence_number_;
+    BeginElement("nlri");
+    AddElement("af", route->Afi());
+    AddElement("safi", route->XmppSafi());
+    AddElement("address", route->ToString());
+    EndElement("nlri");
 
     assert(!roattr->nexthop_list().empty());
 
     //
     // Encode all next-hops in the list
     //
-    BOOST_FOREACH(RibOutAttr::NextHop nexthop, roattr->nexthop_list()) {
-        EncodeNextHop(route, nexthop, item);
+    BeginElement("next-hops");
+    BOOST_FOREACH(const RibOutAttr::NextHop &nexthop,
+                  roattr->nexthop_list()) {
+        EncodeNextHop(route, nexthop);
     }
+    EndElement("next-hops");
 
+    AddElement("version", 1);
+    AddElement("virtual-network", GetVirtualNetwork(route));
+    AddElement("sequence-number", sequence_number_);
+
+    BeginElement("security-group-list");
     for (std::vector<int>::iterator it = security_group_list_.begin(); 
          it !=  security_group_list_.end(); it++) {
-        item.entry.security_group_list.security_group.push_back(*it);
+        AddElement("security-group", *it);
     }
+    EndElement("security-group-list");
+
+    AddElement("local-preference", roattr->attr()->local_pref());
 
-    xml_node node = xitems_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-    item.Encode(&node);
+    EndItem();
 }
 
 void BgpXmppMessage::AddIpUnreach(const BgpRoute *route) {
-    xml_node node = xitems_.append_child("retract");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    AddRetract(route);
 }
 
 bool BgpXmppMessage::AddInetRoute(const BgpRoute *route,
@@ -230,64 +340,62 @@ bool BgpXmppMessage::AddInet6Route(const BgpRoute *route,
 }
 
 void BgpXmppMessage::EncodeEnetNextHop(const BgpRoute *route,
-                                       RibOutAttr::NextHop nexthop,
-                                       autogen::EnetItemType &item) {
-    autogen::EnetNextHopType item_nexthop;
-
-    item_nexthop.af = BgpAf::IPv4;
-    item_nexthop.address = nexthop.address().to_v4().to_string();
-    item_nexthop.label = nexthop.label();
-    if (nexthop.encap().empty()) {
-        // If encap list is empty, routes from non-control-node, 
-        // use mpls over gre as default encap
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation.push_back(std::string("gre"));
-    } else {
-        item_nexthop.tunnel_encapsulation_list.tunnel_encapsulation= nexthop.encap();
-    }
-    item.entry.next_hops.next_hop.push_back(item_nexthop);
+                                       const RibOutAttr::NextHop &nexthop) {
+    BeginElement("next-hop");
+    AddElement("af", BgpAf::IPv4);
+    AddElement("address", nexthop.address().to_v4());
+    AddElement("label", nexthop.label());
+    EncodeTunnelEncap(nexthop.encap(), true);
+    EndElement("next-hop");
 }
 
 void BgpXmppMessage::AddEnetReach(const BgpRoute *route, const RibOutAttr *roattr) {
+    BeginItem(route);
 
-    autogen::EnetItemType item;
-    item.entry.nlri.af = route->Afi();
-    item.entry.nlri.safi = route->XmppSafi();
-
-    EvpnRoute *evpn_route =
-        static_cast<EvpnRoute *>(const_cast<BgpRoute *>(route));
+    const EvpnRoute *evpn_route = static_cast<const EvpnRoute *>(route);
     const EvpnPrefix &evpn_prefix = evpn_route->GetPrefix();
-    item.entry.nlri.ethernet_tag = evpn_prefix.tag();
-    item.entry.nlri.mac = evpn_prefix.mac_addr().ToString();
-    item.entry.nlri.address = evpn_prefix.ip_address().to_string() + "/" +
-        integerToString(evpn_prefix.ip_address_length());
-    item.entry.virtual_network = GetVirtualNetwork(route);
+    BeginElement("nlri");
+    AddElement("af", route->Afi());
+    AddElement("safi", route->XmppSafi());
+    AddElement("ethernet-tag", evpn_prefix.tag());
+    AddElement("mac", evpn_prefix.mac_addr().ToString());
+    BeginElement("address");
+    XmlAppendEscaped(&body_, evpn_prefix.ip_address().to_string());
+    body_.push_back('/');
+    XmlAppendInteger(&body_, evpn_prefix.ip_address_length());
+    EndElement("address");
+    EndElement("nlri");
 
     const BgpOList *olist = roattr->attr()->olist().get();
     assert((olist == NULL) != roattr->nexthop_list().empty());
 
+    BeginElement("next-hops");
+    BOOST_FOREACH(const RibOutAttr::NextHop &nexthop,
+                  roattr->nexthop_list()) {
+        EncodeEnetNextHop(route, nexthop);
+    }
+    EndElement("next-hops");
+
+    BeginElement("olist");
     if (olist) {
         BOOST_FOREACH(const BgpOListElem &elem, olist->elements) {
-            autogen::EnetNextHopType nh;
-            nh.af = BgpAf::IPv4;
-            nh.address = elem.address.to_string();
-            nh.label = elem.label;
-            nh.tunnel_encapsulation_list.tunnel_encapsulation = elem.encap;
-            item.entry.olist.next_hop.push_back(nh);
+            BeginElement("next-hop");
+            AddElement("af", BgpAf::IPv4);
+            AddElement("address", elem.address);
+            AddElement("label", elem.label);
+            EncodeTunnelEncap(elem.encap, false);
+            EndElement("next-hop");
         }
     }
+    EndElement("olist");
 
-    BOOST_FOREACH(RibOutAttr::NextHop nexthop, roattr->nexthop_list()) {
-        EncodeEnetNextHop(route, nexthop, item);
-    }
+    AddElement("virtual-network", GetVirtualNetwork(route));
 
-    xml_node node = xitems_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-    item.Encode(&node);
+    EndItem();
 }
 
 void BgpXmppMessage::AddEnetUnreach(const BgpRoute *route) {
-    xml_node node = xitems_.append_child("retract");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    AddRetract(route);
 }
 
 bool BgpXmppMessage::AddEnetRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -302,35 +410,34 @@ bool BgpXmppMessage::AddEnetRoute(const BgpRoute *route, const RibOutAttr *roatt
 }
 
 void BgpXmppMessage::AddMcastReach(const BgpRoute *route, const RibOutAttr *roattr) {
+    BeginItem(route);
 
-    autogen::McastItemType item;
-    item.entry.nlri.af = route->Afi();
-    item.entry.nlri.safi = route->XmppSafi();
-
-    ErmVpnRoute *ermvpn_route =
-        static_cast<ErmVpnRoute *>(const_cast<BgpRoute *>(route));
-    item.entry.nlri.group = ermvpn_route->GetPrefix().group().to_string();
-    item.entry.nlri.source =  ermvpn_route->GetPrefix().source().to_string();
-    item.entry.nlri.source_label = roattr->label();
+    const ErmVpnRoute *ermvpn_route = static_cast<const ErmVpnRoute *>(route);
+    BeginElement("nlri");
+    AddElement("af", route->Afi());
+    AddElement("safi", route->XmppSafi());
+    AddElement("group", ermvpn_route->GetPrefix().group());
+    AddElement("source", ermvpn_route->GetPrefix().source());
+    AddElement("source-label", roattr->label());
+    EndElement("nlri");
 
     const BgpOList *olist = roattr->attr()->olist().get();
+    BeginElement("olist");
     BOOST_FOREACH(const BgpOListElem &elem, olist->elements) {
-        autogen::McastNextHopType nh;
-        nh.af = BgpAf::IPv4;
-        nh.address = elem.address.to_string();
-        nh.label = integerToString(elem.label);
-        nh.tunnel_encapsulation_list.tunnel_encapsulation = elem.encap;
-        item.entry.olist.next_hop.push_back(nh);
+        BeginElement("next-hop");
+        AddElement("af", BgpAf::IPv4);
+        AddElement("address", elem.address);
+        AddElement("label", elem.label);
+        EncodeTunnelEncap(elem.encap, false);
+        EndElement("next-hop");
     }
+    EndElement("olist");
 
-    xml_node node = xitems_.append_child("item");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
-    item.Encode(&node);
+    EndItem();
 }
 
 void BgpXmppMessage::AddMcastUnreach(const BgpRoute *route) {
-    xml_node node = xitems_.append_child("retract");
-    node.append_attribute("id") = route->ToXmppIdString().c_str();
+    AddRetract(route);
 }
 
 bool BgpXmppMessage::AddMcastRoute(const BgpRoute *route, const RibOutAttr *roattr) {
@@ -344,35 +451,38 @@ bool BgpXmppMessage::AddMcastRoute(const BgpRoute *route, const RibOutAttr *roat
     return true;
 }
 
-const uint8_t *BgpXmppMessage::GetData(IPeerUpdate *peer, size_t *lenp) {
-    std::string str = peer->ToString() + "/" + XmppInit::kBgpPeer;
-
-    // If the message has already been constructed, just replace the 'to' part.
-    if (!repr_.empty()) {
-        repr_new_ = string(repr_, 0, repr_part1_) + "to=\"" + str + "\">" +
-                    string(repr_, repr_part2_);
-
-        *lenp = repr_new_.size();
-        return reinterpret_cast<const uint8_t *>(repr_new_.c_str());
-    }
+//
+// The header is all of the message up to and including the start tag of the
+// message element, which has the peer specific "to" attribute.
+//
+const uint8_t *BgpXmppMessage::GetHeader(IPeerUpdate *peer, size_t *lenp) {
+    header_.assign("<?xml version=\"1.0\"?>\n<message from=\"");
+    header_.append(XmppInit::kControlNodeJID);
+    header_.append("\" to=\"");
+    XmlAppendEscaped(&header_, peer->ToString());
+    header_.push_back('/');
+    header_.append(XmppInit::kBgpPeer);
+    header_.append("\">");
+
+    *lenp = header_.size();
+    return reinterpret_cast<const uint8_t *>(header_.data());
+}
 
-    xml_node message =  xdoc_.child("message");
-    xml_attribute attr_to = message.attribute("to");
-    if (!attr_to) {
-        attr_to = message.append_attribute("to");
-    }
-    attr_to.set_value(str.c_str());
-    ostringstream oss;
-    xdoc_.save(oss);
-    repr_ = oss.str();
+TcpMessageBuffer *BgpXmppMessage::GetBody() {
+    Finish();
+    return body_buffer_.get();
+}
 
-    repr_part1_ = repr_.find("to=", 0);
-    assert(repr_part1_ != string::npos);
-    repr_part2_ = repr_.find("\n\t<event xmlns");
-    assert(repr_part2_ != string::npos);
+const uint8_t *BgpXmppMessage::GetData(IPeerUpdate *peer, size_t *lenp) {
+    size_t header_len;
+    const uint8_t *header = GetHeader(peer, &header_len);
+    const TcpMessageBuffer *body = GetBody();
+    repr_.reserve(header_len + body->size());
+    repr_.assign(reinterpret_cast<const char *>(header), header_len);
+    repr_.append(reinterpret_cast<const char *>(body->data()), body->size());
 
     *lenp = repr_.size();
-    return reinterpret_cast<const uint8_t *>(repr_.c_str());
+    return reinterpret_cast<const uint8_t *>(repr_.data());
 }
 
 string BgpXmppMessage::GetVirtualNetwork(const BgpRoute *route) const {
@@ -407,6 +407,9 @@ int main(int argc, char *argv[]) {
 
     TaskScheduler::Initialize();
     ControlNode::SetDefaultSchedulingPolicy();
+    if (options.io_threads()) {
+        evm.StartIoServicePool(options.io_threads());
+    }
     // Determine if the number of connections is as expected. At the moment, we
     // consider connections to collector, discovery server and IFMap (irond)
     // servers as critical to the normal functionality of control-node.
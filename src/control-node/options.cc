@@ -92,6 +92,10 @@ void Options::Initialize(EventManager &evm,
              opt::value<uint16_t>()->default_value(default_http_server_port),
              "Sandesh HTTP listener port")
 
+        ("DEFAULT.io_threads",
+             opt::value<uint16_t>()->default_value(0),
+             "Number of threads to spread TCP session IO over, in addition "
+             "to the main IO thread")
         ("DEFAULT.log_category",
              opt::value<string>()->default_value(log_category_),
              "Category filter for local logging of sandesh messages")
@@ -237,6 +241,7 @@ bool Options::Process(int argc, char *argv[],
 
     GetOptValue<uint16_t>(var_map, http_server_port_,
                           "DEFAULT.http_server_port");
+    GetOptValue<uint16_t>(var_map, io_threads_, "DEFAULT.io_threads");
 
     GetOptValue<string>(var_map, log_category_, "DEFAULT.log_category");
     GetOptValue<string>(var_map, log_file_, "DEFAULT.log_file");
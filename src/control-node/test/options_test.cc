@@ -61,6 +61,7 @@ TEST_F(OptionsTest, NoArguments) {
     EXPECT_EQ(options_.hostname(), hostname_);
     EXPECT_EQ(options_.host_ip(), host_ip_);
     EXPECT_EQ(options_.http_server_port(), default_http_server_port);
+    EXPECT_EQ(options_.io_threads(), 0);
     EXPECT_EQ(options_.log_category(), "");
     EXPECT_EQ(options_.log_disable(), false);
     EXPECT_EQ(options_.log_file(), "<stdout>");
@@ -97,6 +98,7 @@ TEST_F(OptionsTest, DefaultConfFile) {
     EXPECT_EQ(options_.hostname(), hostname_);
     EXPECT_EQ(options_.host_ip(), host_ip_);
     EXPECT_EQ(options_.http_server_port(), default_http_server_port);
+    EXPECT_EQ(options_.io_threads(), 0);
     EXPECT_EQ(options_.log_category(), "");
     EXPECT_EQ(options_.log_disable(), false);
     EXPECT_EQ(options_.log_file(), "/var/log/contrail/contrail-control.log");
@@ -135,6 +137,7 @@ TEST_F(OptionsTest, OverrideStringFromCommandLine) {
     EXPECT_EQ(options_.hostname(), hostname_);
     EXPECT_EQ(options_.host_ip(), host_ip_);
     EXPECT_EQ(options_.http_server_port(), default_http_server_port);
+    EXPECT_EQ(options_.io_threads(), 0);
     EXPECT_EQ(options_.log_category(), "");
     EXPECT_EQ(options_.log_disable(), false);
     EXPECT_EQ(options_.log_file(), "test.log"); // Overridden from cmd line.
@@ -173,6 +176,7 @@ TEST_F(OptionsTest, OverrideBooleanFromCommandLine) {
     EXPECT_EQ(options_.hostname(), hostname_);
     EXPECT_EQ(options_.host_ip(), host_ip_);
     EXPECT_EQ(options_.http_server_port(), default_http_server_port);
+    EXPECT_EQ(options_.io_threads(), 0);
     EXPECT_EQ(options_.log_category(), "");
     EXPECT_EQ(options_.log_disable(), false);
     EXPECT_EQ(options_.log_file(), "/var/log/contrail/contrail-control.log");
@@ -199,6 +203,7 @@ TEST_F(OptionsTest, CustomConfigFile) {
         "hostip=1.2.3.4\n"
         "hostname=test\n"
         "http_server_port=800\n"
+        "io_threads=4\n"
         "log_category=bgp\n"
         "log_disable=1\n"
         "log_file=test.log\n"
@@ -249,6 +254,7 @@ TEST_F(OptionsTest, CustomConfigFile) {
     EXPECT_EQ(options_.hostname(), "test");
     EXPECT_EQ(options_.host_ip(), "1.2.3.4");
     EXPECT_EQ(options_.http_server_port(), 800);
+    EXPECT_EQ(options_.io_threads(), 4);
     EXPECT_EQ(options_.log_category(), "bgp");
     EXPECT_EQ(options_.log_disable(), true);
     EXPECT_EQ(options_.log_file(), "test.log");
@@ -275,6 +281,7 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
         "hostip=1.2.3.4\n"
         "hostname=test\n"
         "http_server_port=800\n"
+        "io_threads=4\n"
         "log_category=bgp\n"
         "log_disable=1\n"
         "log_file=test.log\n"
@@ -336,6 +343,7 @@ TEST_F(OptionsTest, CustomConfigFileAndOverrideFromCommandLine) {
     EXPECT_EQ(options_.hostname(), "test");
     EXPECT_EQ(options_.host_ip(), "1.2.3.4");
     EXPECT_EQ(options_.http_server_port(), 800);
+    EXPECT_EQ(options_.io_threads(), 4);
     EXPECT_EQ(options_.log_category(), "bgp");
     EXPECT_EQ(options_.log_disable(), true);
     EXPECT_EQ(options_.log_file(), "new_test.log");
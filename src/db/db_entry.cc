@@ -2,6 +2,7 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <algorithm>
 #include <tbb/mutex.h>
 #include "base/util.h"
 #include <boost/date_time/posix_time/posix_time.hpp>
@@ -10,15 +11,43 @@
 
 using namespace std;
 
+bool DBStateList::Set(ListenerId listener, DBState *state) {
+    assert(listener >= 0 && listener < 0xFFFF - kGrowSize);
+    assert(state != NULL);
+    if ((size_t) listener >= size_) {
+        uint16_t size = listener + kGrowSize - (listener % kGrowSize);
+        DBState **states = new DBState *[size];
+        std::copy(states_, states_ + size_, states);
+        std::fill(states + size_, states + size, (DBState *) NULL);
+        delete [] states_;
+        states_ = states;
+        size_ = size;
+    }
+
+    bool inserted = (states_[listener] == NULL);
+    if (inserted) {
+        count_++;
+    }
+    states_[listener] = state;
+    return inserted;
+}
+
+void DBStateList::Clear(ListenerId listener) {
+    if ((size_t) listener >= size_ || states_[listener] == NULL)
+        return;
+    states_[listener] = NULL;
+    if (--count_ == 0) {
+        delete [] states_;
+        states_ = NULL;
+        size_ = 0;
+    }
+}
+
 void DBEntryBase::SetState(DBTableBase *tbl_base, ListenerId listener,
                            DBState *state) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    pair<StateMap::iterator, bool> res = state_.insert(
-        make_pair(listener, state));
-    if (!res.second) {
-        res.first->second = state;
-    } else {
+    if (state_.Set(listener, state)) {
         assert(!IsDeleted());
     }
 }
@@ -26,11 +55,7 @@ void DBEntryBase::SetState(DBTableBase *tbl_base, ListenerId listener,
 DBState *DBEntryBase::GetState(DBTableBase *tbl_base, ListenerId listener) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    StateMap::iterator loc = state_.find(listener);
-    if (loc != state_.end()) {
-        return loc->second;
-    }
-    return NULL;
+    return state_.Get(listener);
 }
 
 const DBState *DBEntryBase::GetState(const DBTableBase *tbl_base,
@@ -38,11 +63,7 @@ const DBState *DBEntryBase::GetState(const DBTableBase *tbl_base,
     DBTableBase *table = const_cast<DBTableBase *>(tbl_base);
     DBTablePartBase *tpart = table->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    StateMap::const_iterator loc = state_.find(listener);
-    if (loc != state_.end()) {
-        return loc->second;
-    }
-    return NULL;
+    return state_.Get(listener);
 }
 
 //
@@ -62,7 +83,7 @@ const DBState *DBEntryBase::GetState(const DBTableBase *tbl_base,
 void DBEntryBase::ClearState(DBTableBase *tbl_base, ListenerId listener) {
     DBTablePartBase *tpart = tbl_base->GetTablePartition(this);
     tbb::mutex::scoped_lock lock(tpart->dbstate_mutex());
-    state_.erase(listener);
+    state_.Clear(listener);
     if (state_.empty() && IsDeleted() && !is_onlist()) {
         assert(!IsOnRemoveQ());
         tbl_base->EnqueueRemove(this);
@@ -5,8 +5,6 @@
 #ifndef ctrlplane_db_entry_h
 #define ctrlplane_db_entry_h
 
-#include <map>
-
 #include <tbb/atomic.h>
 
 #include "db/db_table.h"
@@ -18,6 +16,42 @@ struct DBState {
     virtual ~DBState() { }
 };
 
+// Per entry DBState of all listeners of a table.
+//
+// ListenerIds are small integers allocated densely (with reuse) by
+// DBTableBase, hence states are kept in an array indexed by ListenerId
+// instead of a tree. The array is allocated on first Set(), grows to the
+// highest ListenerId in use and is released once the last state is
+// cleared, so entries without state do not cost any allocation.
+class DBStateList {
+public:
+    typedef DBTableBase::ListenerId ListenerId;
+    static const int kGrowSize = 4;
+
+    DBStateList() : states_(NULL), size_(0), count_(0) { }
+    ~DBStateList() { delete [] states_; }
+
+    // Returns false if a state already existed for the listener.
+    bool Set(ListenerId listener, DBState *state);
+    DBState *Get(ListenerId listener) const {
+        if ((size_t) listener >= size_)
+            return NULL;
+        return states_[listener];
+    }
+    void Clear(ListenerId listener);
+
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    // Heap memory used by the list.
+    size_t allocated_bytes() const { return size_ * sizeof(DBState *); }
+
+private:
+    DBState **states_;
+    uint16_t size_;     // allocated slots in states_
+    uint16_t count_;    // slots holding a state
+    DISALLOW_COPY_AND_ASSIGN(DBStateList);
+};
+
 // Generic database entry
 class DBEntryBase {
 public:
@@ -73,9 +107,8 @@ private:
         Onlist       = 1 << 0,
         DeleteMarked = 1 << 1,
     };
-    typedef std::map<ListenerId, DBState *> StateMap;
     DBTablePartBase *tpart_;
-    StateMap state_;
+    DBStateList state_;
     uint8_t flags;
     tbb::atomic<bool> onremoveq_;
     uint64_t last_change_at_; // time at which entry was last 'changed'
@@ -16,7 +16,9 @@
 using tbb::concurrent_queue;
 using tbb::atomic;
 
+const uint64_t DBPartition::kDefaultRunBudgetUsecs;
 int DBPartition::db_partition_task_id_ = -1;
+uint64_t DBPartition::run_budget_usecs_ = DBPartition::kDefaultRunBudgetUsecs;
 
 struct RequestQueueEntry {
     // Constructor takes ownership of DBRequest key, data.
@@ -132,20 +134,22 @@ void DBPartition::SetQueueDisable(bool disable) {
 
 class DBPartition::QueueRunner : public Task {
 public:
-    static const int kMaxIterations = 32;
     QueueRunner(WorkQueue *queue) 
         : Task(db_partition_task_id_, queue->db_partition_id()), 
           queue_(queue) {
     }
 
     virtual bool Run() {
-        int count = 0;
-
         //
         // Skip if the queue is disabled from running
         //
         if (queue_->disable()) return false;
 
+        // Yield once the run budget is used up. The time after each request
+        // is also used to account for the time spent on the table.
+        uint64_t now = ClockMonotonicNsec();
+        uint64_t deadline = now + run_budget_usecs_ * 1000;
+
         RemoveQueueEntry *rm_entry = NULL;
         while (queue_->DequeueRemove(&rm_entry)) {
             if (rm_entry->db_entry->IsDeleted() &&
@@ -156,16 +160,21 @@ public:
                 rm_entry->db_entry->ClearOnRemoveQ();
             }
             delete rm_entry;
-            if (++count == kMaxIterations) {
+            now = ClockMonotonicNsec();
+            if (now >= deadline) {
                 return false;
             }
         }
 
         RequestQueueEntry *req_entry = NULL;
         while (queue_->DequeueRequest(&req_entry)) {
-            req_entry->tpart->Process(req_entry->client, &req_entry->request);
+            DBTablePartBase *tpart = req_entry->tpart;
+            tpart->Process(req_entry->client, &req_entry->request);
             delete req_entry;
-            if (++count == kMaxIterations) {
+            uint64_t end = ClockMonotonicNsec();
+            tpart->UpdateRequestStats(end - now);
+            now = end;
+            if (now >= deadline) {
                 return false;
             }
         }
@@ -175,7 +184,7 @@ public:
             if (tpart == NULL) {
                 break;
             }
-            bool done = tpart->RunNotify();
+            bool done = tpart->RunNotify(deadline);
             if (!done) {
                 return false;
             }
@@ -218,6 +227,11 @@ DBPartition::DBPartition(int partition_id)
     if (db_partition_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         db_partition_task_id_ = scheduler->GetTaskId("db::DBTable");
+
+        char *budget = getenv("DB_PARTITION_RUN_BUDGET_USECS");
+        if (budget) {
+            run_budget_usecs_ = strtoull(budget, NULL, 0);
+        }
     }
 }
 
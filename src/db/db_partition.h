@@ -21,6 +21,11 @@ class DBPartition {
 public:
     typedef boost::function<void(void)> Callback;
 
+    // Default time budget for a run of the partition task, which yields
+    // once the budget is used up. Can be overridden with the environment
+    // variable DB_PARTITION_RUN_BUDGET_USECS.
+    static const uint64_t kDefaultRunBudgetUsecs = 1000;
+
     explicit DBPartition(int partition_id);
     ~DBPartition();
 
@@ -36,11 +41,17 @@ public:
     bool IsDBQueueEmpty() const;
     void SetQueueDisable(bool disable);
 
+    // Time budget for a run of the task of any partition. At least one
+    // request or change notification is processed in each run.
+    static void SetRunBudget(uint64_t usecs) { run_budget_usecs_ = usecs; }
+    static uint64_t run_budget() { return run_budget_usecs_; }
+
 private:
     class WorkQueue;
     class QueueRunner;
     std::auto_ptr<WorkQueue> work_queue_;
     static int db_partition_task_id_;
+    static uint64_t run_budget_usecs_;
     DISALLOW_COPY_AND_ASSIGN(DBPartition);
 };
 
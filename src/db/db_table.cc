@@ -221,6 +221,21 @@ size_t DBTable::Size() const {
     return total;
 }
 
+DBTableTaskStats DBTable::GetTaskStats() const {
+    DBTableTaskStats stats;
+    uint64_t request_time_nsecs = 0, notify_time_nsecs = 0;
+    for (vector<DBTablePartition *>::const_iterator iter = partitions_.begin();
+         iter != partitions_.end(); iter++) {
+        stats.request_count += (*iter)->request_count();
+        request_time_nsecs += (*iter)->request_time_nsecs();
+        stats.notify_count += (*iter)->notify_count();
+        notify_time_nsecs += (*iter)->notify_time_nsecs();
+    }
+    stats.request_time_usecs = request_time_nsecs / 1000;
+    stats.notify_time_usecs = notify_time_nsecs / 1000;
+    return stats;
+}
+
 void DBTable::Input(DBTablePartition *tbl_partition, DBClient *client,
                     DBRequest *req) {
     DBRequestKey *key = 
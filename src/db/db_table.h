@@ -95,6 +95,19 @@ private:
     std::auto_ptr<ListenerInfo> info_;
 };
 
+// Requests processed and change notifications run for a table by the
+// db::DBTable task, and the time spent on them.
+struct DBTableTaskStats {
+    DBTableTaskStats()
+        : request_count(0), request_time_usecs(0),
+          notify_count(0), notify_time_usecs(0) {
+    }
+    uint64_t request_count;
+    uint64_t request_time_usecs;
+    uint64_t notify_count;
+    uint64_t notify_time_usecs;
+};
+
 // An implementation of DBTableBase that uses boost::set as data-store
 // Most of the DB Table implementations should derive from here instead of
 // DBTableBase directly.
@@ -176,6 +189,9 @@ public:
     // Calculate the size across all partitions.
     virtual size_t Size() const;
 
+    // Task statistics summed over all partitions.
+    DBTableTaskStats GetTaskStats() const;
+
     // helper functions
 
     // Delete all the state entries of a specific listener.
@@ -37,8 +37,11 @@ void DBTablePartBase::Notify(DBEntryBase *entry) {
 // assuming the DBEntryBase is eligible for removal. The dbstate_mutex is
 // used for synchronization.
 //
-bool DBTablePartBase::RunNotify() {
-    for (int i = 0; ((i < kMaxIterations) && !change_list_.empty()); ++i) {
+bool DBTablePartBase::RunNotify(uint64_t deadline) {
+    uint64_t start = ClockMonotonicNsec();
+    uint64_t now = start;
+    uint64_t count = 0;
+    while (!change_list_.empty() && (count == 0 || now < deadline)) {
         DBEntryBase *entry = &change_list_.front();
         change_list_.pop_front();
 
@@ -57,7 +60,11 @@ bool DBTablePartBase::RunNotify() {
             !entry->IsOnRemoveQ()) {
             Remove(entry);
         }
+        count++;
+        now = ClockMonotonicNsec();
     }
+    notify_count_ += count;
+    notify_time_nsecs_ += now - start;
 
     if (!change_list_.empty()) {
         DB *db = parent()->database();
@@ -6,6 +6,7 @@
 #define ctrlplane_db_table_partition_h
 
 #include <boost/intrusive/list.hpp>
+#include <tbb/atomic.h>
 #include <tbb/mutex.h>
 
 #include "db/db_entry.h"
@@ -16,7 +17,6 @@ class DBTable;
 // Table shard contained within a DBPartition.
 class DBTablePartBase {
 public:
-    static const int kMaxIterations = 256;
     typedef boost::intrusive::member_hook<DBEntryBase, 
             boost::intrusive::list_member_hook<>, 
             &DBEntryBase::chg_list_> ChangeListMember; 
@@ -26,6 +26,10 @@ public:
 
     DBTablePartBase(DBTableBase *tbl_base, int index)
         : parent_(tbl_base), index_(index) {
+        request_count_ = 0;
+        request_time_nsecs_ = 0;
+        notify_count_ = 0;
+        notify_time_nsecs_ = 0;
     }
 
     // Input processing stage for DBRequests. Called from per-partition thread.
@@ -34,8 +38,20 @@ public:
     // Enqueue a change notification. Deferred until the RunNotify stage.
     void Notify(DBEntryBase *entry);
 
-    // Run the notification queue.
-    bool RunNotify();
+    // Run the notification queue until it is empty or the deadline, from
+    // ClockMonotonicNsec(), has passed. Returns true if the queue is empty.
+    bool RunNotify(uint64_t deadline);
+
+    // Requests processed and change notifications run for the partition,
+    // and the time spent on them.
+    void UpdateRequestStats(uint64_t nsecs) {
+        request_count_++;
+        request_time_nsecs_ += nsecs;
+    }
+    uint64_t request_count() const { return request_count_; }
+    uint64_t request_time_nsecs() const { return request_time_nsecs_; }
+    uint64_t notify_count() const { return notify_count_; }
+    uint64_t notify_time_nsecs() const { return notify_time_nsecs_; }
 
     DBTableBase *parent() { return parent_; }
     int index() const { return index_; }
@@ -59,6 +75,10 @@ private:
     DBTableBase *parent_;
     int index_;
     ChangeList change_list_;
+    tbb::atomic<uint64_t> request_count_;
+    tbb::atomic<uint64_t> request_time_nsecs_;
+    tbb::atomic<uint64_t> notify_count_;
+    tbb::atomic<uint64_t> notify_time_nsecs_;
     DISALLOW_COPY_AND_ASSIGN(DBTablePartBase);
 };
 
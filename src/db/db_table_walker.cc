@@ -5,6 +5,7 @@
 #include "db/db_table_walker.h"
 
 #include <list>
+#include <boost/shared_ptr.hpp>
 #include <tbb/atomic.h>
 
 #include "base/logging.h"
@@ -25,12 +26,13 @@ DBTableWalker::DBTableWalker() {
     walk_request_count_ = 0;
     walk_complete_count_ = 0;
     walk_cancel_count_ = 0;
+    walk_coalesced_count_ = 0;
 }
+
 class DBTableWalker::Walker {
 public:
     Walker(WalkId id, DBTableWalker *wkmgr, DBTable *table,
-           const DBRequestKey *key, WalkFn walker, 
-           WalkCompleteFn walk_done);
+           WalkFn walker, WalkCompleteFn walk_done);
 
     void StopWalk() {
         should_stop_.fetch_and_store(true);
@@ -44,9 +46,6 @@ public:
     // Table on which walk is done
     DBTable *table_;
 
-    // Take the ownership of key passed
-    std::auto_ptr<DBRequestKey> key_start_;
-
     WalkFn walker_fn_;
     WalkCompleteFn done_fn_;
 
@@ -57,30 +56,120 @@ public:
     tbb::atomic<long> status_;
 };
 
+class DBTableWalker::TableWalk {
+public:
+    // State of a walker in the traversal of a table partition
+    struct WalkerState {
+        explicit WalkerState(Walker *walker) : walker(walker), wrapped(false) {
+        }
+
+        Walker *walker;
+
+        // Entry at which the walker joined, NULL if it joined at the start
+        // of a pass over the partition
+        boost::shared_ptr<const DBEntry> start;
+
+        // Set when the traversal wraps around to the first entry
+        bool wrapped;
+    };
+    typedef std::list<WalkerState> WalkerStateList;
+
+    struct PartitionWalk {
+        PartitionWalk() : lap_start(true), running(false) {
+        }
+
+        // Walkers that joined since the worker last took on new walkers
+        WalkerStateList pending;
+
+        // Walkers in the traversal, only accessed by the worker
+        WalkerStateList active;
+
+        // Key of the next entry to visit, NULL to start a pass
+        boost::shared_ptr<DBRequestKey> cursor;
+
+        // True until the worker starts visiting entries in a pass
+        bool lap_start;
+
+        // Whether a worker is scheduled for the partition
+        bool running;
+    };
+
+    // Walks started with a 'key_start' are not shared.
+    TableWalk(DBTableWalker *wkmgr, DBTable *table, DBRequestKey *key_start)
+        : wkmgr_(wkmgr), table_(table), key_start_(key_start),
+          partitions_(DB::PartitionCount()), running_count_(0) {
+    }
+
+    // Called with walkers_mutex_ held
+    void AddWalker(Walker *walker);
+
+    DBTableWalker *wkmgr() { return wkmgr_; }
+    DBTable *table() { return table_; }
+    const DBRequestKey *key_start() const { return key_start_.get(); }
+    PartitionWalk *partition(int id) { return &partitions_[id]; }
+    bool shared() const { return key_start_.get() == NULL; }
+
+    // Called with walkers_mutex_ held when a worker is done. Returns true
+    // if no worker is left for the traversal.
+    bool WorkerDone() {
+        return (--running_count_ == 0);
+    }
+
+private:
+    DBTableWalker *wkmgr_;
+    DBTable *table_;
+    std::auto_ptr<DBRequestKey> key_start_;
+    std::vector<PartitionWalk> partitions_;
+    int running_count_;
+
+    DISALLOW_COPY_AND_ASSIGN(TableWalk);
+};
+
 class DBTableWalker::Worker : public Task {
 public:
-    Worker(Walker *walker, int db_partition_id, const DBRequestKey *key) 
-        : Task(walker_task_id_, db_partition_id), walker_(walker), 
-          key_start_(key) {
+    Worker(TableWalk *walk, int db_partition_id)
+        : Task(walker_task_id_, db_partition_id), walk_(walk),
+          part_walk_(walk->partition(db_partition_id)) {
         tbl_partition_ = static_cast<DBTablePartition *>(
-            walker_->table_->GetTablePartition(db_partition_id));
+            walk->table()->GetTablePartition(db_partition_id));
     }
 
     virtual bool Run();
 
 private:
-    DBTableWalker::Walker *walker_;
+    typedef TableWalk::WalkerStateList WalkerStateList;
+
+    // Visit the entry for each active walker, and move the walkers that are
+    // done to done_list.
+    void Visit(DBEntry *entry, WalkerStateList *done_list);
+
+    // Move the walkers that completed a pass over the partition to
+    // done_list when the traversal reaches the end of the partition.
+    void Wrap(WalkerStateList *done_list);
 
-    // Store the last visited node to continue walk
-    std::auto_ptr<DBRequestKey> walk_ctx_;
+    TableWalk *walk_;
 
-    // This is where the walk started
-    const DBRequestKey *key_start_;
+    // Traversal state of the partition, in walk_
+    TableWalk::PartitionWalk *part_walk_;
 
     // Table partition for which this worker was created
     DBTablePartition *tbl_partition_;
 };
 
+void DBTableWalker::TableWalk::AddWalker(Walker *walker) {
+    for (size_t i = 0; i < partitions_.size(); i++) {
+        PartitionWalk *part_walk = &partitions_[i];
+        part_walk->pending.push_back(WalkerState(walker));
+        if (!part_walk->running) {
+            part_walk->running = true;
+            running_count_++;
+            Worker *task = new Worker(this, i);
+            TaskScheduler *scheduler = TaskScheduler::GetInstance();
+            scheduler->Enqueue(task);
+        }
+    }
+}
+
 static void db_walker_wait() {
     static int walk_sleep_usecs_;
     static bool once;
@@ -97,90 +186,157 @@ static void db_walker_wait() {
     }
 }
 
-bool DBTableWalker::Worker::Run() {
-    int count = 0;
-    DBRequestKey *key_resume;
+void DBTableWalker::Worker::Visit(DBEntry *entry, WalkerStateList *done_list) {
+    WalkerStateList::iterator it = part_walk_->active.begin();
+    while (it != part_walk_->active.end()) {
+        WalkerStateList::iterator current = it++;
+        Walker *walker = current->walker;
+        // Check whether Walker was requested to be cancelled, or is back
+        // where it joined the traversal
+        if (walker->should_stop_ ||
+            (current->wrapped && !(*entry < *current->start))) {
+            done_list->splice(done_list->end(), part_walk_->active, current);
+            continue;
+        }
+        // Invoke walker function
+        bool more = walker->walker_fn_(tbl_partition_, entry);
+        if (!more) {
+            done_list->splice(done_list->end(), part_walk_->active, current);
+        }
+    }
+}
+
+void DBTableWalker::Worker::Wrap(WalkerStateList *done_list) {
+    WalkerStateList::iterator it = part_walk_->active.begin();
+    while (it != part_walk_->active.end()) {
+        WalkerStateList::iterator current = it++;
+        if (current->start.get() == NULL || current->wrapped) {
+            done_list->splice(done_list->end(), part_walk_->active, current);
+        } else {
+            current->wrapped = true;
+        }
+    }
+    part_walk_->cursor.reset();
+    part_walk_->lap_start = true;
+}
 
-    // Check whether Walker was requested to be cancelled
-    if (walker_->should_stop_) {
-        goto walk_done;
+bool DBTableWalker::Worker::Run() {
+    DBTableWalker *wkmgr = walk_->wkmgr();
+    DBTable *table = walk_->table();
+    WalkerStateList done_list;
+
+    // Take on the walkers that joined the traversal. They start at the
+    // current position of the cursor.
+    {
+        tbb::mutex::scoped_lock lock(wkmgr->walkers_mutex_);
+        for (WalkerStateList::iterator it = part_walk_->pending.begin();
+             it != part_walk_->pending.end(); ++it) {
+            if (!part_walk_->lap_start) {
+                it->start.reset(
+                    table->AllocEntry(part_walk_->cursor.get()).release());
+            }
+        }
+        part_walk_->active.splice(part_walk_->active.end(),
+                                  part_walk_->pending);
     }
 
     // Check where we left in last iteration
-    if ((key_resume = walk_ctx_.get()) == NULL) {
-        // First time invoke of worker thread, start from key_start_
-        key_resume = const_cast <DBRequestKey *>(key_start_);
-    }
-
-    DBEntry *entry;
-    if (key_resume != NULL) {
-        DBTable *table = walker_->table_;
-        std::auto_ptr<const DBEntryBase> start;
-        start = table->AllocEntry(key_resume);
-        // Find matching or next in sort order
-        entry = tbl_partition_->lower_bound(start.get());
-    } else {
-        entry = tbl_partition_->GetFirst();
-    }
-    if (entry == NULL) {
-        goto walk_done;
+    const DBRequestKey *key_resume = part_walk_->cursor.get();
+    if (key_resume == NULL && part_walk_->lap_start) {
+        // First pass of a walk that is not shared, start from key_start
+        key_resume = walk_->key_start();
     }
 
-    for (DBEntry *next = NULL; entry; entry = next) {
-        next = tbl_partition_->GetNext(entry);
-        // Check whether Walker was requested to be cancelled
-        if (walker_->should_stop_) {
-            break; 
+    DBEntry *entry = NULL;
+    if (!part_walk_->active.empty()) {
+        part_walk_->lap_start = false;
+        if (key_resume != NULL) {
+            std::auto_ptr<const DBEntryBase> start;
+            start = table->AllocEntry(key_resume);
+            // Find matching or next in sort order
+            entry = tbl_partition_->lower_bound(start.get());
+        } else {
+            entry = tbl_partition_->GetFirst();
         }
-        if (count == GetIterationToYield()) {
+
+        int count = 0;
+        for (DBEntry *next = NULL; entry; entry = next) {
+            next = tbl_partition_->GetNext(entry);
+            if (count == GetIterationToYield()) {
+                break;
+            }
+            Visit(entry, &done_list);
+            if (part_walk_->active.empty()) {
+                entry = next;
+                break;
+            }
+            db_walker_wait();
+            count++;
+        }
+
+        if (entry == NULL) {
+            Wrap(&done_list);
+        } else {
             // store the context
-            walk_ctx_ = entry->GetDBRequestKey();
-            return false;
+            part_walk_->cursor.reset(entry->GetDBRequestKey().release());
         }
+    }
 
-        // Invoke walker function
-        bool more = walker_->walker_fn_(tbl_partition_, entry);
-        if (!more) {
-            break;
+    bool running;
+    bool purge_walk = false;
+    {
+        tbb::mutex::scoped_lock lock(wkmgr->walkers_mutex_);
+        running = !part_walk_->active.empty() ||
+            !part_walk_->pending.empty();
+        if (!running) {
+            part_walk_->running = false;
+            part_walk_->cursor.reset();
+            part_walk_->lap_start = true;
+            if (walk_->WorkerDone()) {
+                // No walker is left, later walks start a new traversal
+                if (walk_->shared()) {
+                    wkmgr->table_walks_.erase(table);
+                }
+                purge_walk = true;
+            }
         }
+    }
 
-        db_walker_wait();
-        count++;
+    for (WalkerStateList::iterator it = done_list.begin();
+         it != done_list.end(); ++it) {
+        wkmgr->WalkerDone(it->walker);
+    }
+    if (purge_walk) {
+        delete walk_;
     }
+    return !running;
+}
 
-walk_done:
+void DBTableWalker::WalkerDone(Walker *walker) {
     // Check whether all other walks on the table is completed
-    long num_walkers_on_tpart = walker_->status_.fetch_and_decrement();
+    long num_walkers_on_tpart = walker->status_.fetch_and_decrement();
     if (num_walkers_on_tpart == 1) {
         // Invoke Walker_Complete callback
-        if (!walker_->should_stop_) {
-            walker_->wkmgr_->update_walk_complete_count(+1);
+        if (!walker->should_stop_) {
+            update_walk_complete_count(+1);
         }
-        if (walker_->done_fn_ != NULL) {
-            if (!walker_->should_stop_) {
-                walker_->done_fn_(walker_->table_);
+        if (walker->done_fn_ != NULL) {
+            if (!walker->should_stop_) {
+                walker->done_fn_(walker->table_);
             }
         }
         // Release the memory for walker and bitmap
-        walker_->wkmgr_->PurgeWalker(walker_->id_);
+        PurgeWalker(walker->id_);
     }
-    return true;
 }
 
 DBTableWalker::Walker::Walker(WalkId id, DBTableWalker *wkmgr,
-                              DBTable *table, const DBRequestKey *key,
-                              WalkFn walker, WalkCompleteFn walk_done)
+                              DBTable *table, WalkFn walker,
+                              WalkCompleteFn walk_done)
     : id_(id), wkmgr_(wkmgr), table_(table),
-      key_start_(const_cast<DBRequestKey *>(key)), 
       walker_fn_(walker), done_fn_(walk_done) {
-    int num_worker = DB::PartitionCount(); 
     should_stop_ = false;
-    status_ = num_worker;
-    for (int i = 0; i < num_worker; i++) {
-        Worker *task = new Worker(this, i, key);
-        TaskScheduler *scheduler = TaskScheduler::GetInstance();
-        scheduler->Enqueue(task);
-    }
+    status_ = DB::PartitionCount();
 }
 
 DBTableWalker::WalkId DBTableWalker::WalkTable(DBTable *table, 
@@ -192,18 +348,32 @@ DBTableWalker::WalkId DBTableWalker::WalkTable(DBTable *table,
     size_t i = walker_map_.find_first();
     if (i == walker_map_.npos) {
         i = walkers_.size();
-        Walker *walker = new Walker(i, this, table, key_start, 
-                                    walkerfn, walk_complete);
-        walkers_.push_back(walker);
+        walkers_.push_back(NULL);
     } else {
         walker_map_.reset(i);
         if (walker_map_.none()) {
             walker_map_.clear();
         }
-        Walker *walker = new Walker(i, this, table, key_start, 
-                                    walkerfn, walk_complete);
-        walkers_[i] = walker;
     }
+    Walker *walker = new Walker(i, this, table, walkerfn, walk_complete);
+    walkers_[i] = walker;
+
+    // Take the ownership of key passed
+    TableWalk *walk;
+    if (key_start != NULL) {
+        walk = new TableWalk(this, table,
+                             const_cast<DBRequestKey *>(key_start));
+    } else {
+        TableWalkMap::iterator loc = table_walks_.find(table);
+        if (loc != table_walks_.end()) {
+            walk = loc->second;
+            walk_coalesced_count_++;
+        } else {
+            walk = new TableWalk(this, table, NULL);
+            table_walks_.insert(std::make_pair(table, walk));
+        }
+    }
+    walk->AddWalker(walker);
     return i;
 }
 
@@ -5,6 +5,7 @@
 #ifndef ctrlplane_db_table_walker_h
 #define ctrlplane_db_table_walker_h
 
+#include <map>
 #include <boost/function.hpp>
 #include <boost/dynamic_bitset.hpp>
 #include <tbb/task.h>
@@ -15,6 +16,13 @@
 
 // A DB contains a TableWalker that is able to iterate though all the
 // entries in a certain routing table.
+//
+// Walks of the whole table that are requested while another one is in
+// progress on the same table are coalesced: there is one traversal of each
+// table partition, and each entry is passed to the WalkFn of all the walks
+// on the table. A walk that joins a traversal in progress starts at the
+// current position in each partition, and is complete on the partition
+// once the traversal has wrapped around to that position.
 class DBTableWalker {
 public:
 
@@ -33,7 +41,8 @@ public:
     static const WalkId kInvalidWalkerId = -1;
 
     // Start a walk request on the specified table. If non null, 'key_start'
-    // specifies the starting point for the walk. The walk is performed in
+    // specifies the starting point for the walk, and the walk is not
+    // coalesced with other walks on the table. The walk is performed in
     // all table shards in parallel.
     WalkId WalkTable(DBTable *table, const DBRequestKey *key_start,
                      WalkFn walker, WalkCompleteFn walk_complete);
@@ -51,6 +60,8 @@ public:
         walk_complete_count_ += inc;
     }
     uint64_t walk_cancel_count() { return walk_cancel_count_; }
+    // Walks that joined a traversal already in progress
+    uint64_t walk_coalesced_count() { return walk_coalesced_count_; }
 
 private:
     static const int kIterationToYield = 1024;
@@ -75,11 +86,18 @@ private:
     // A Walker allocated to iterator through a DBTable
     class Walker;
 
+    // Traversal of a DBTable shared by Walkers
+    class TableWalk;
+
     // A Job for walking through the DBTablePartition
     class Worker;
 
     typedef std::vector<Walker *> WalkerList;
     typedef boost::dynamic_bitset<> WalkerMap;
+    typedef std::map<DBTable *, TableWalk *> TableWalkMap;
+
+    // Called when the walker is done with a table partition
+    void WalkerDone(Walker *walker);
 
     // Purge the walker after the walk is completed/cancelled
     void PurgeWalker(WalkId id);
@@ -89,9 +107,13 @@ private:
     WalkerList walkers_;
     WalkerMap walker_map_;
 
+    // Shared traversals in progress, protected by walkers_mutex_
+    TableWalkMap table_walks_;
+
     uint64_t walk_request_count_;
     uint64_t walk_complete_count_;
     uint64_t walk_cancel_count_;
+    uint64_t walk_coalesced_count_;
 
     static int walker_task_id_;
 };
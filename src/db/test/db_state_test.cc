@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <boost/scoped_array.hpp>
+
+#include "base/logging.h"
+#include "base/util.h"
+#include "base/test/counting_allocator.h"
+#include "db/db_entry.h"
+#include "testing/gunit.h"
+
+using namespace std;
+
+typedef DBTableBase::ListenerId ListenerId;
+
+struct TestState : public DBState {
+};
+
+// The listener state container used by DBEntryBase before DBStateList
+typedef map<ListenerId, DBState *, less<ListenerId>,
+    CountingAllocator<pair<const ListenerId, DBState *> > > StateMap;
+
+class DBStateListTest : public ::testing::Test {
+protected:
+    // Number of entries and listeners for the scale comparison. The entry
+    // count can be overridden with DB_STATE_TEST_ENTRIES.
+    static size_t EntryCount() {
+        char *str = getenv("DB_STATE_TEST_ENTRIES");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 1000 * 1000;
+    }
+    static const int kListenerCount = 8;
+
+    TestState state_[kListenerCount];
+};
+
+TEST_F(DBStateListTest, Basic) {
+    DBStateList list;
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(0, list.allocated_bytes());
+    EXPECT_TRUE(list.Get(0) == NULL);
+    EXPECT_TRUE(list.Get(100) == NULL);
+
+    EXPECT_TRUE(list.Set(2, &state_[0]));
+    EXPECT_FALSE(list.empty());
+    EXPECT_EQ(1, list.size());
+    EXPECT_EQ(&state_[0], list.Get(2));
+    EXPECT_TRUE(list.Get(1) == NULL);
+    EXPECT_TRUE(list.Get(3) == NULL);
+
+    // Replace existing state
+    EXPECT_FALSE(list.Set(2, &state_[1]));
+    EXPECT_EQ(1, list.size());
+    EXPECT_EQ(&state_[1], list.Get(2));
+
+    // Grow beyond the initial allocation
+    EXPECT_TRUE(list.Set(9, &state_[2]));
+    EXPECT_EQ(2, list.size());
+    EXPECT_EQ(&state_[1], list.Get(2));
+    EXPECT_EQ(&state_[2], list.Get(9));
+    EXPECT_LE(10 * sizeof(DBState *), list.allocated_bytes());
+
+    // Clearing a listener without state is a no-op
+    list.Clear(5);
+    list.Clear(50);
+    EXPECT_EQ(2, list.size());
+
+    list.Clear(2);
+    EXPECT_TRUE(list.Get(2) == NULL);
+    EXPECT_EQ(1, list.size());
+
+    // Memory is released with the last state
+    list.Clear(9);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(0, list.allocated_bytes());
+    EXPECT_TRUE(list.Get(9) == NULL);
+}
+
+// Compare memory used and lookup time of DBStateList and std::map with
+// kListenerCount states on each of EntryCount() entries.
+TEST_F(DBStateListTest, Scale) {
+    size_t entry_count = EntryCount();
+
+    CountingAllocatorBytes() = 0;
+    vector<StateMap> map_entries(entry_count);
+    uint64_t start = ClockMonotonicUsec();
+    for (size_t i = 0; i < entry_count; i++) {
+        for (int id = 0; id < kListenerCount; id++) {
+            map_entries[i].insert(make_pair(id, &state_[id]));
+        }
+    }
+    uint64_t map_insert_time = ClockMonotonicUsec() - start;
+
+    boost::scoped_array<DBStateList> list_entries(
+        new DBStateList[entry_count]);
+    size_t list_allocated_bytes = 0;
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < entry_count; i++) {
+        for (int id = 0; id < kListenerCount; id++) {
+            list_entries[i].Set(id, &state_[id]);
+        }
+    }
+    uint64_t list_insert_time = ClockMonotonicUsec() - start;
+    for (size_t i = 0; i < entry_count; i++) {
+        list_allocated_bytes += list_entries[i].allocated_bytes();
+    }
+
+    size_t map_found = 0;
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < entry_count; i++) {
+        for (int id = 0; id < kListenerCount; id++) {
+            StateMap::const_iterator loc = map_entries[i].find(id);
+            if (loc != map_entries[i].end() && loc->second == &state_[id]) {
+                map_found++;
+            }
+        }
+    }
+    uint64_t map_lookup_time = ClockMonotonicUsec() - start;
+
+    size_t list_found = 0;
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < entry_count; i++) {
+        for (int id = 0; id < kListenerCount; id++) {
+            if (list_entries[i].Get(id) == &state_[id]) {
+                list_found++;
+            }
+        }
+    }
+    uint64_t list_lookup_time = ClockMonotonicUsec() - start;
+
+    EXPECT_EQ(entry_count * kListenerCount, map_found);
+    EXPECT_EQ(entry_count * kListenerCount, list_found);
+
+    size_t map_bytes =
+        entry_count * sizeof(StateMap) + CountingAllocatorBytes();
+    size_t list_bytes =
+        entry_count * sizeof(DBStateList) + list_allocated_bytes;
+    cout << entry_count << " entries, " << kListenerCount << " listeners"
+         << endl;
+    cout << "std::map    : " << map_bytes / entry_count << " bytes/entry, "
+         << "insert " << map_insert_time << " usec, "
+         << "lookup " << map_lookup_time << " usec" << endl;
+    cout << "DBStateList : " << list_bytes / entry_count << " bytes/entry, "
+         << "insert " << list_insert_time << " usec, "
+         << "lookup " << list_lookup_time << " usec" << endl;
+    EXPECT_LT(list_bytes, map_bytes);
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
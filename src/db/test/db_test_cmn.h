@@ -21,6 +21,12 @@ public:
 
 class DBTest : public ::testing::Test {
 protected:
+    // Notifications one table may run ahead of the other in
+    // DB_RunNotify_Yield, with a run budget small enough for the partition
+    // task to yield after a few notifications
+    static const int kNotifyYieldMaxDiff = 256;
+    static const uint64_t kNotifyYieldRunBudgetUsecs = 1;
+
     tbb::atomic<long> adc_notification;
     tbb::atomic<long> del_notification;
     tbb::atomic<long> add_notification_client1;
@@ -116,7 +122,7 @@ public:
             diff =
                 std::abs(add_notification_client1 - add_notification_client2);
         }
-        if (diff > DBTablePartBase::kMaxIterations) {
+        if (diff > kNotifyYieldMaxDiff) {
             notify_yield = false;
         }
     }
@@ -131,7 +137,7 @@ public:
             diff =
                 std::abs(add_notification_client1 - add_notification_client2);
         }
-        if (diff > DBTablePartBase::kMaxIterations) {
+        if (diff > kNotifyYieldMaxDiff) {
             notify_yield = false;
         }
     }
@@ -559,6 +565,115 @@ TEST_F(DBTest, JWalker) {
     EXPECT_TRUE(del_notification == walk_count);
 }
 
+// Records the entries visited by a walk. Once 'join_after' entries have
+// been visited, calls 'join' from the walk function.
+class WalkRecorder {
+public:
+    explicit WalkRecorder(size_t join_after = 0) : join_after_(join_after) {
+        done_ = false;
+        count_ = 0;
+    }
+
+    bool Walk(DBTablePartBase *root, DBEntryBase *entry) {
+        Vlan *vlan = static_cast<Vlan *>(entry);
+        {
+            tbb::mutex::scoped_lock lock(mutex_);
+            visits_[vlan->getTag()]++;
+        }
+        if (++count_ == join_after_ && !join_.empty()) {
+            join_();
+        }
+        return true;
+    }
+
+    void Done(DBTableBase *tbl) {
+        done_ = true;
+    }
+
+    // Returns true if each of the first 'count' tags was visited once
+    bool VisitedOnce(int count) const {
+        if (visits_.size() != (size_t) count) {
+            return false;
+        }
+        for (std::map<int, int>::const_iterator it = visits_.begin();
+             it != visits_.end(); ++it) {
+            if (it->first >= count || it->second != 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool done() const { return done_; }
+    void set_join(boost::function<void()> join) { join_ = join; }
+
+private:
+    tbb::mutex mutex_;
+    std::map<int, int> visits_;
+    tbb::atomic<bool> done_;
+    tbb::atomic<size_t> count_;
+    size_t join_after_;
+    boost::function<void()> join_;
+};
+
+// To Test:
+// Walks of the same table share one traversal, and a walk that joins the
+// traversal half way through still visits every entry once
+TEST_F(DBTest, CoalescedWalk) {
+    DBTable *table = dynamic_cast<DBTable *>(itbl);
+    if (table == NULL) {
+        return;
+    }
+
+    // More entries per partition than visited before the worker yields
+    int walk_count = 16 * 1024;
+    for (int i = 0; i < walk_count; i++) {
+        DBRequest addReq;
+        addReq.key.reset(new VlanTableReqKey(i));
+        addReq.data.reset(new VlanTableReqData("DB Test Vlan"));
+        addReq.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        EXPECT_TRUE(itbl->Enqueue(&addReq));
+    }
+    task_util::WaitForIdle();
+
+    DBTableWalker *walker = db_.GetWalker();
+    uint64_t coalesced = walker->walk_coalesced_count();
+    WalkRecorder first(walk_count / 2), second, late;
+
+    // Second walk requested before the first one starts running
+    TaskScheduler::GetInstance()->Stop();
+    walker->WalkTable(table, NULL,
+                      boost::bind(&WalkRecorder::Walk, &first, _1, _2),
+                      boost::bind(&WalkRecorder::Done, &first, _1));
+    walker->WalkTable(table, NULL,
+                      boost::bind(&WalkRecorder::Walk, &second, _1, _2),
+                      boost::bind(&WalkRecorder::Done, &second, _1));
+    first.set_join(boost::bind(&DBTableWalker::WalkTable, walker, table,
+        static_cast<const DBRequestKey *>(NULL),
+        DBTableWalker::WalkFn(
+            boost::bind(&WalkRecorder::Walk, &late, _1, _2)),
+        DBTableWalker::WalkCompleteFn(
+            boost::bind(&WalkRecorder::Done, &late, _1))));
+    TaskScheduler::GetInstance()->Start();
+
+    task_util::WaitForIdle();
+    EXPECT_TRUE(first.done());
+    EXPECT_TRUE(second.done());
+    EXPECT_TRUE(late.done());
+    EXPECT_TRUE(first.VisitedOnce(walk_count));
+    EXPECT_TRUE(second.VisitedOnce(walk_count));
+    EXPECT_TRUE(late.VisitedOnce(walk_count));
+    EXPECT_EQ(coalesced + 2, walker->walk_coalesced_count());
+
+    for (int i = 0; i < walk_count; i++) {
+        DBRequest delReq;
+        delReq.key.reset(new VlanTableReqKey(i));
+        delReq.oper = DBRequest::DB_ENTRY_DELETE;
+        EXPECT_TRUE(itbl->Enqueue(&delReq));
+    }
+    task_util::WaitForIdle();
+}
+
 // To Test:
 // Verify Bulk ADD DELETE of objects to DBTable
 TEST_F(DBTest, Bulk) {
@@ -695,7 +810,8 @@ TEST_F(DBTest, DB_RunNotify_Yield) {
         itbl_1->Register(boost::bind(&DBTest::DBTestYieldListener2, this, _1, _2));
     EXPECT_EQ(tid_1_, 0);
 
-    int req_count = DBTablePartBase::kMaxIterations * 3;
+    int req_count = kNotifyYieldMaxDiff * 3;
+    DBPartition::SetRunBudget(kNotifyYieldRunBudgetUsecs);
 
     // Enqueue add requests to db.test.vlan.0
     TaskScheduler::GetInstance()->Stop();
@@ -727,6 +843,11 @@ TEST_F(DBTest, DB_RunNotify_Yield) {
     TASK_UTIL_EXPECT_EQ(req_count, add_notification_client2);
     EXPECT_TRUE(notify_yield);
 
+    // Requests and notifications are accounted to the table partition
+    DBTablePartBase *tpart = itbl->GetTablePartition(0);
+    EXPECT_LE((uint64_t) req_count, tpart->request_count());
+    EXPECT_LE((uint64_t) req_count, tpart->notify_count());
+
     // Enqueue delete requests to db.test.vlan.0
     TaskScheduler::GetInstance()->Stop();
     for (int i = 0; i<req_count; i++) {
@@ -757,6 +878,7 @@ TEST_F(DBTest, DB_RunNotify_Yield) {
 
     itbl->Unregister(tid_);
     itbl_1->Unregister(tid_1_);
+    DBPartition::SetRunBudget(DBPartition::kDefaultRunBudgetUsecs);
 
     // Clear stats at end 
     add_notification_client1 = 0;
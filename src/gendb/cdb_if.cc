@@ -625,7 +625,10 @@ CdbIf::CdbIf(DbErrorHandler errhandler,
     only_sync_(only_sync),
     task_instance_(-1),
     prev_task_instance_(-1),
-    task_instance_initialized_(false) {
+    task_instance_initialized_(false),
+    batch_start_usec_(0),
+    batch_max_bytes_(kBatchMaxBytes),
+    batch_window_usec_(kBatchWindowUsec) {
 
     // reduce connection timeout
     boost::shared_ptr<TSocket> tsocket = 
@@ -642,7 +645,10 @@ CdbIf::CdbIf() :
     only_sync_(false), 
     task_instance_(-1),
     prev_task_instance_(-1),
-    task_instance_initialized_(false) {
+    task_instance_initialized_(false),
+    batch_start_usec_(0),
+    batch_max_bytes_(kBatchMaxBytes),
+    batch_window_usec_(kBatchWindowUsec) {
     db_init_done_ = false;
 }
 
@@ -1230,6 +1236,9 @@ bool CdbIf::Db_AsyncAddColumn(CdbIfColList &cl) {
         return true;
     }
     uint64_t ts(UTCTimestampUsec());
+    if (mutation_map_.empty()) {
+        batch_start_usec_ = ClockMonotonicUsec();
+    }
     std::string cfname(new_colp->cfname_);
     // Does the row key exist in the Cassandra mutation map ?
     std::string key_value;
@@ -1240,6 +1249,7 @@ bool CdbIf::Db_AsyncAddColumn(CdbIfColList &cl) {
         cmm_it = mutation_map_.insert(
             std::pair<std::string, CFMutationMap>(key_value,
                 CFMutationMap())).first;
+        batch_.num_bytes += key_value.size();
     } 
     CFMutationMap &cf_mutation_map(cmm_it->second);
     // Does the column family exist in the column family mutation map ?
@@ -1247,7 +1257,10 @@ bool CdbIf::Db_AsyncAddColumn(CdbIfColList &cl) {
     if (cfmm_it == cf_mutation_map.end()) {
         cfmm_it = cf_mutation_map.insert(
             std::pair<std::string, MutationList>(cfname, MutationList())).first;
+    } else {
+        batch_.num_merged_column_lists++;
     }
+    batch_.num_column_lists++;
     MutationList &mutations(cfmm_it->second);
     mutations.reserve(mutations.size() + new_colp->columns_.size());
 
@@ -1288,6 +1301,8 @@ bool CdbIf::Db_AsyncAddColumn(CdbIfColList &cl) {
             c_or_sc.__set_column(c);
             mutation.__set_column_or_supercolumn(c_or_sc);
             mutations.push_back(mutation);
+            batch_.num_mutations++;
+            batch_.num_bytes += col_name.size() + col_value.size();
         } else if (it->cftype_ == GenDb::NewCf::COLUMN_FAMILY_NOSQL) {
             CDBIF_EXPECT_TRUE_ELSE_RETURN_FALSE(
                 cftype != GenDb::NewCf::COLUMN_FAMILY_SQL);
@@ -1313,6 +1328,8 @@ bool CdbIf::Db_AsyncAddColumn(CdbIfColList &cl) {
             c_or_sc.__set_column(c);
             mutation.__set_column_or_supercolumn(c_or_sc);
             mutations.push_back(mutation);
+            batch_.num_mutations++;
+            batch_.num_bytes += col_name.size() + col_value.size();
         } else {
             stats_.IncrementErrors(
                 CdbIfStats::CDBIF_STATS_ERR_WRITE_COLUMN);
@@ -1329,7 +1346,16 @@ bool CdbIf::Db_AsyncAddColumn(CdbIfColList &cl) {
     return true;
 }
 
+// Called when the queue runner exits, with done set if the queue is empty
 void CdbIf::Db_BatchAddColumn(bool done) {
+    if (mutation_map_.empty()) {
+        return;
+    }
+    // Keep combining while more column lists are pending in the queue
+    if (!done && batch_.num_bytes < batch_max_bytes_ &&
+        ClockMonotonicUsec() - batch_start_usec_ < batch_window_usec_) {
+        return;
+    }
     CDBIF_BEGIN_TRY {
         client_->batch_mutate(mutation_map_,
             org::apache::cassandra::ConsistencyLevel::ONE);
@@ -1337,6 +1363,18 @@ void CdbIf::Db_BatchAddColumn(bool done) {
           false, false, true, CdbIfStats::CDBIF_STATS_ERR_WRITE_BATCH_COLUMN,
           CdbIfStats::CDBIF_STATS_CF_OP_NONE)
     mutation_map_.clear();
+    batch_.num_batches = 1;
+    batch_.max_batch_bytes = batch_.num_bytes;
+    {
+        tbb::mutex::scoped_lock lock(smutex_);
+        stats_.UpdateBatch(batch_);
+    }
+    batch_ = CdbIfStats::BatchStats();
+}
+
+void CdbIf::Db_SetBatchParams(size_t max_bytes, uint64_t window_usec) {
+    batch_max_bytes_ = max_bytes;
+    batch_window_usec_ = window_usec;
 }
 
 bool CdbIf::Db_AddColumn(std::auto_ptr<GenDb::ColList> cl) {
@@ -1632,9 +1670,11 @@ bool CdbIf::Db_GetQueueStats(uint64_t &queue_count, uint64_t &enqueues) const {
     return true;
 }
 
-bool CdbIf::Db_GetStats(std::vector<DbTableInfo> &vdbti, DbErrors &dbe) {
+bool CdbIf::Db_GetStats(std::vector<DbTableInfo> &vdbti, DbErrors &dbe,
+    DbBatchStats &dbbs) {
     tbb::mutex::scoped_lock lock(smutex_);
     stats_.Get(vdbti, dbe);
+    stats_.GetBatch(dbbs);
     return true;
 }
        
@@ -1733,6 +1773,14 @@ void CdbIf::CdbIfStats::Get(std::vector<DbTableInfo> &vdbti,
     derrors.Get(dbe);
 }
 
+void CdbIf::CdbIfStats::UpdateBatch(const BatchStats &batch) {
+    batch_stats_.Update(batch);
+}
+
+void CdbIf::CdbIfStats::GetBatch(DbBatchStats &dbbs) const {
+    batch_stats_.Get(dbbs);
+}
+
 // CfStats
 CdbIf::CdbIfStats::CfStats operator+(const CdbIf::CdbIfStats::CfStats &a,
     const CdbIf::CdbIfStats::CfStats &b) {
@@ -1825,3 +1873,27 @@ void CdbIf::CdbIfStats::Errors::Get(DbErrors &db_errors) const {
     db_errors.set_write_batch_column_fails(write_batch_column_fails);
     db_errors.set_read_column_fails(read_column_fails);
 }
+
+// BatchStats
+void CdbIf::CdbIfStats::BatchStats::Update(const BatchStats &batch) {
+    num_batches += batch.num_batches;
+    num_column_lists += batch.num_column_lists;
+    num_merged_column_lists += batch.num_merged_column_lists;
+    num_mutations += batch.num_mutations;
+    num_bytes += batch.num_bytes;
+    if (batch.max_batch_bytes > max_batch_bytes) {
+        max_batch_bytes = batch.max_batch_bytes;
+    }
+}
+
+void CdbIf::CdbIfStats::BatchStats::Get(DbBatchStats &dbbs) const {
+    dbbs.set_batches(num_batches);
+    dbbs.set_column_lists(num_column_lists);
+    dbbs.set_merged_column_lists(num_merged_column_lists);
+    dbbs.set_mutations(num_mutations);
+    dbbs.set_bytes(num_bytes);
+    dbbs.set_max_batch_bytes(max_batch_bytes);
+    dbbs.set_avg_batch_bytes(num_batches ? num_bytes / num_batches : 0);
+    uint64_t row_cfs = num_column_lists - num_merged_column_lists;
+    dbbs.set_merge_ratio(row_cfs ? (double)num_column_lists / row_cfs : 0);
+}
@@ -64,7 +64,15 @@ public:
     virtual void Db_ResetQueueWaterMarks();
     // Stats
     virtual bool Db_GetStats(std::vector<GenDb::DbTableInfo> &vdbti,
-        GenDb::DbErrors &dbe);
+        GenDb::DbErrors &dbe, GenDb::DbBatchStats &dbbs);
+    // Write combining
+    static const size_t kBatchMaxBytes = 1024 * 1024;
+    static const uint64_t kBatchWindowUsec = 100 * 1000;
+    // Column lists from the queue are merged by row key and column family
+    // into one batch_mutate, which is issued when the queue is drained or,
+    // while column lists are pending, when the batch reaches max_bytes or
+    // window_usec has elapsed since its first column list
+    virtual void Db_SetBatchParams(size_t max_bytes, uint64_t window_usec);
     // Connection
     virtual std::string Db_GetHost() const;
     virtual int Db_GetPort() const;
@@ -209,6 +217,26 @@ private:
             uint64_t num_writes;
             uint64_t num_write_fails; 
         };
+        struct BatchStats {
+            BatchStats() :
+                num_batches(0),
+                num_column_lists(0),
+                num_merged_column_lists(0),
+                num_mutations(0),
+                num_bytes(0),
+                max_batch_bytes(0) {
+            }
+            void Update(const BatchStats &batch);
+            void Get(GenDb::DbBatchStats &dbbs) const;
+            uint64_t num_batches;
+            uint64_t num_column_lists;
+            // Column lists added to the mutations of a row key and column
+            // family already in the batch
+            uint64_t num_merged_column_lists;
+            uint64_t num_mutations;
+            uint64_t num_bytes;
+            uint64_t max_batch_bytes;
+        };
         enum ErrorType {
             CDBIF_STATS_ERR_NO_ERROR,
             CDBIF_STATS_ERR_WRITE_TABLESPACE,
@@ -229,11 +257,14 @@ private:
         void IncrementErrors(ErrorType type);
         void UpdateCf(const std::string &cf_name, bool write, bool fail);
         void Get(std::vector<GenDb::DbTableInfo> &vdbti, GenDb::DbErrors &dbe);
+        void UpdateBatch(const BatchStats &batch);
+        void GetBatch(GenDb::DbBatchStats &dbbs) const;
         typedef boost::ptr_map<const std::string, CfStats> CfStatsMap;
         CfStatsMap cf_stats_map_;
         CfStatsMap ocf_stats_map_;
         Errors db_errors_;
         Errors odb_errors_;
+        BatchStats batch_stats_;
     };
 
     friend CdbIfStats::CfStats operator+(const CdbIfStats::CfStats &a,
@@ -280,6 +311,11 @@ private:
     typedef std::map<std::string, MutationList> CFMutationMap;
     typedef std::map<std::string, CFMutationMap> CassandraMutationMap;
     CassandraMutationMap mutation_map_;
+    // Stats of the batch being built in mutation_map_
+    CdbIfStats::BatchStats batch_;
+    uint64_t batch_start_usec_;
+    size_t batch_max_bytes_;
+    uint64_t batch_window_usec_;
     mutable tbb::mutex smutex_;
     CdbIfStats stats_;
     std::vector<DbQueueWaterMarkInfo> cdbq_wm_info_;
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "embedded_db_if.h"
+
+using namespace GenDb;
+
+#define EMBEDDEDDBIF_LOG_ERR_RETURN_FALSE(_Msg)                           \
+    do {                                                                  \
+        LOG(ERROR, "EmbeddedDbIf: " << __func__ << ": " << _Msg);         \
+        return false;                                                     \
+    } while (false)
+
+static bool DbDataValueIsInteger(const DbDataValue &value) {
+    switch (value.which()) {
+    case DB_VALUE_UINT64:
+    case DB_VALUE_UINT32:
+    case DB_VALUE_UINT16:
+    case DB_VALUE_UINT8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static uint64_t DbDataValueToInteger(const DbDataValue &value) {
+    switch (value.which()) {
+    case DB_VALUE_UINT64:
+        return boost::get<uint64_t>(value);
+    case DB_VALUE_UINT32:
+        return boost::get<uint32_t>(value);
+    case DB_VALUE_UINT16:
+        return boost::get<uint16_t>(value);
+    case DB_VALUE_UINT8:
+        return boost::get<uint8_t>(value);
+    default:
+        assert(0);
+        return 0;
+    }
+}
+
+bool DbDataValueLess::operator()(const DbDataValue &lhs,
+                                 const DbDataValue &rhs) const {
+    if (DbDataValueIsInteger(lhs) && DbDataValueIsInteger(rhs)) {
+        return DbDataValueToInteger(lhs) < DbDataValueToInteger(rhs);
+    }
+    if (lhs.which() != rhs.which()) {
+        return lhs.which() < rhs.which();
+    }
+    return lhs < rhs;
+}
+
+bool DbDataValueVecLess::operator()(const DbDataValueVec &lhs,
+                                    const DbDataValueVec &rhs) const {
+    return std::lexicographical_compare(lhs.begin(), lhs.end(),
+        rhs.begin(), rhs.end(), DbDataValueLess());
+}
+
+// EmbeddedDbStore
+EmbeddedDbStore::EmbeddedDbStore() {
+}
+
+EmbeddedDbStore::~EmbeddedDbStore() {
+}
+
+size_t EmbeddedDbStore::RowCount(const std::string &cfname) {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    TableMap::const_iterator it = tables_.find(cfname);
+    if (it == tables_.end()) {
+        return 0;
+    }
+    return it->second->rows_.size();
+}
+
+size_t EmbeddedDbStore::ColumnCount(const std::string &cfname) {
+    tbb::spin_rw_mutex::scoped_lock lock(rw_mutex_, false);
+    TableMap::const_iterator it = tables_.find(cfname);
+    if (it == tables_.end()) {
+        return 0;
+    }
+    size_t count = 0;
+    const RowMap &rows(it->second->rows_);
+    for (RowMap::const_iterator jt = rows.begin(); jt != rows.end(); ++jt) {
+        count += jt->second.size();
+    }
+    return count;
+}
+
+// EmbeddedDbIf
+EmbeddedDbIf::EmbeddedDbIf() :
+    store_(new EmbeddedDbStore),
+    read_table_fails_(0),
+    write_table_fails_(0) {
+}
+
+EmbeddedDbIf::EmbeddedDbIf(StorePtr store) :
+    store_(store),
+    read_table_fails_(0),
+    write_table_fails_(0) {
+}
+
+EmbeddedDbIf::~EmbeddedDbIf() {
+}
+
+bool EmbeddedDbIf::Db_Init(const std::string& task_id, int task_instance) {
+    return true;
+}
+
+void EmbeddedDbIf::Db_Uninit(const std::string& task_id, int task_instance) {
+}
+
+void EmbeddedDbIf::Db_UninitUnlocked(const std::string& task_id,
+    int task_instance) {
+}
+
+void EmbeddedDbIf::Db_SetInitDone(bool init_done) {
+}
+
+bool EmbeddedDbIf::Db_AddTablespace(const std::string& tablespace,
+    const std::string& replication_factor) {
+    tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, true);
+    store_->tablespaces_.insert(tablespace);
+    return true;
+}
+
+bool EmbeddedDbIf::Db_SetTablespace(const std::string& tablespace) {
+    if (!Db_FindTablespace(tablespace)) {
+        EMBEDDEDDBIF_LOG_ERR_RETURN_FALSE(tablespace << ": NOT FOUND");
+    }
+    tablespace_ = tablespace;
+    return true;
+}
+
+bool EmbeddedDbIf::Db_AddSetTablespace(const std::string& tablespace,
+    const std::string& replication_factor) {
+    Db_AddTablespace(tablespace, replication_factor);
+    return Db_SetTablespace(tablespace);
+}
+
+bool EmbeddedDbIf::Db_FindTablespace(const std::string& tablespace) {
+    tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, false);
+    return store_->tablespaces_.find(tablespace) !=
+        store_->tablespaces_.end();
+}
+
+// The store has a single tablespace worth of column families, as the
+// analytics tables all live in one keyspace
+bool EmbeddedDbIf::AddTable(const NewCf& cf) {
+    tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, true);
+    if (store_->tables_.find(cf.cfname_) == store_->tables_.end()) {
+        std::string cfname(cf.cfname_);
+        store_->tables_.insert(cfname, new EmbeddedDbStore::Table(cf));
+    }
+    return true;
+}
+
+bool EmbeddedDbIf::Db_AddColumnfamily(const NewCf& cf) {
+    return AddTable(cf);
+}
+
+// Column families created by another instance on the same store are used
+// as is, and missing ones are created empty
+bool EmbeddedDbIf::Db_UseColumnfamily(const NewCf& cf) {
+    return AddTable(cf);
+}
+
+bool EmbeddedDbIf::Db_AddColumn(std::auto_ptr<ColList> cl) {
+    const std::string &cfname(cl->cfname_);
+    {
+        tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, true);
+        EmbeddedDbStore::TableMap::iterator it =
+            store_->tables_.find(cfname);
+        if (it != store_->tables_.end()) {
+            EmbeddedDbStore::Row &row(it->second->rows_[cl->rowkey_]);
+            for (NewColVec::iterator jt = cl->columns_.begin();
+                 jt != cl->columns_.end(); ++jt) {
+                // A later write to a column overwrites the earlier one
+                row[*jt->name].swap(*jt->value);
+            }
+            lock.release();
+            UpdateTableStats(cfname, true, false);
+            return true;
+        }
+    }
+    {
+        tbb::mutex::scoped_lock lock(smutex_);
+        write_table_fails_++;
+    }
+    UpdateTableStats(cfname, true, true);
+    EMBEDDEDDBIF_LOG_ERR_RETURN_FALSE(cfname << ": NOT FOUND");
+}
+
+bool EmbeddedDbIf::Db_AddColumnSync(std::auto_ptr<ColList> cl) {
+    return Db_AddColumn(cl);
+}
+
+void EmbeddedDbIf::ReadColumns(const EmbeddedDbStore::Table &table,
+    const EmbeddedDbStore::Row &row, const DbDataValueVec &start,
+    const DbDataValueVec &finish, uint32_t count, NewColVec *columns) {
+    if (!start.empty() && !finish.empty() &&
+        DbDataValueVecLess()(finish, start)) {
+        return;
+    }
+    EmbeddedDbStore::Row::const_iterator it = start.empty() ?
+        row.begin() : row.lower_bound(start);
+    EmbeddedDbStore::Row::const_iterator end = finish.empty() ?
+        row.end() : row.upper_bound(finish);
+    uint32_t read = 0;
+    for (; it != end && (count == 0 || read < count); ++it, ++read) {
+        if (table.cf_.cftype_ == NewCf::COLUMN_FAMILY_SQL) {
+            columns->push_back(new NewCol(
+                boost::get<std::string>(it->first.at(0)),
+                it->second.at(0)));
+        } else {
+            columns->push_back(new NewCol(new DbDataValueVec(it->first),
+                new DbDataValueVec(it->second)));
+        }
+    }
+}
+
+bool EmbeddedDbIf::Db_GetRow(ColList& ret, const std::string& cfname,
+    const DbDataValueVec& rowkey) {
+    {
+        tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, false);
+        EmbeddedDbStore::TableMap::const_iterator it =
+            store_->tables_.find(cfname);
+        if (it != store_->tables_.end()) {
+            const EmbeddedDbStore::Table &table(*it->second);
+            EmbeddedDbStore::RowMap::const_iterator jt =
+                table.rows_.find(rowkey);
+            if (jt != table.rows_.end()) {
+                ReadColumns(table, jt->second, DbDataValueVec(),
+                    DbDataValueVec(), 0, &ret.columns_);
+            }
+            lock.release();
+            UpdateTableStats(cfname, false, false);
+            return true;
+        }
+    }
+    {
+        tbb::mutex::scoped_lock lock(smutex_);
+        read_table_fails_++;
+    }
+    UpdateTableStats(cfname, false, true);
+    EMBEDDEDDBIF_LOG_ERR_RETURN_FALSE(cfname << ": NOT FOUND");
+}
+
+bool EmbeddedDbIf::Db_GetMultiRow(ColListVec& ret, const std::string& cfname,
+    const std::vector<DbDataValueVec>& rowkeys,
+    ColumnNameRange *crange_ptr) {
+    {
+        tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, false);
+        EmbeddedDbStore::TableMap::const_iterator it =
+            store_->tables_.find(cfname);
+        if (it != store_->tables_.end()) {
+            const EmbeddedDbStore::Table &table(*it->second);
+            // Every row key requested gets a column list, same as with
+            // Cassandra, even if the row has no columns in the range
+            for (std::vector<DbDataValueVec>::const_iterator kt =
+                     rowkeys.begin(); kt != rowkeys.end(); ++kt) {
+                std::auto_ptr<ColList> col_list(new ColList);
+                col_list->rowkey_ = *kt;
+                EmbeddedDbStore::RowMap::const_iterator jt =
+                    table.rows_.find(*kt);
+                if (jt != table.rows_.end()) {
+                    if (crange_ptr) {
+                        ReadColumns(table, jt->second, crange_ptr->start_,
+                            crange_ptr->finish_, crange_ptr->count,
+                            &col_list->columns_);
+                    } else {
+                        ReadColumns(table, jt->second, DbDataValueVec(),
+                            DbDataValueVec(), 0, &col_list->columns_);
+                    }
+                }
+                ret.push_back(col_list);
+            }
+            lock.release();
+            UpdateTableStats(cfname, false, false);
+            return true;
+        }
+    }
+    {
+        tbb::mutex::scoped_lock lock(smutex_);
+        read_table_fails_++;
+    }
+    UpdateTableStats(cfname, false, true);
+    EMBEDDEDDBIF_LOG_ERR_RETURN_FALSE(cfname << ": NOT FOUND");
+}
+
+// Returns all the columns in the range, CdbIf pages through the range to
+// do the same
+bool EmbeddedDbIf::Db_GetRangeSlices(ColList& col_list,
+    const std::string& cfname, const ColumnNameRange& crange,
+    const DbDataValueVec& rowkey) {
+    {
+        tbb::spin_rw_mutex::scoped_lock lock(store_->rw_mutex_, false);
+        EmbeddedDbStore::TableMap::const_iterator it =
+            store_->tables_.find(cfname);
+        if (it != store_->tables_.end()) {
+            const EmbeddedDbStore::Table &table(*it->second);
+            EmbeddedDbStore::RowMap::const_iterator jt =
+                table.rows_.find(rowkey);
+            if (jt != table.rows_.end()) {
+                ReadColumns(table, jt->second, crange.start_, crange.finish_,
+                    0, &col_list.columns_);
+            }
+            lock.release();
+            UpdateTableStats(cfname, false, false);
+            return true;
+        }
+    }
+    {
+        tbb::mutex::scoped_lock lock(smutex_);
+        read_table_fails_++;
+    }
+    UpdateTableStats(cfname, false, true);
+    EMBEDDEDDBIF_LOG_ERR_RETURN_FALSE(cfname << ": NOT FOUND");
+}
+
+bool EmbeddedDbIf::Db_GetQueueStats(uint64_t &queue_count,
+    uint64_t &enqueues) const {
+    queue_count = 0;
+    enqueues = 0;
+    return true;
+}
+
+// There is no write queue, so the watermarks are never crossed
+void EmbeddedDbIf::Db_SetQueueWaterMark(bool high, size_t queue_count,
+    DbQueueWaterMarkCb cb) {
+}
+
+void EmbeddedDbIf::Db_ResetQueueWaterMarks() {
+}
+
+// Writes are applied synchronously, there is nothing to batch
+void EmbeddedDbIf::Db_SetBatchParams(size_t max_bytes,
+    uint64_t window_usec) {
+}
+
+void EmbeddedDbIf::UpdateTableStats(const std::string &cfname, bool write,
+    bool fail) {
+    tbb::mutex::scoped_lock lock(smutex_);
+    TableStats &stats(table_stats_[cfname]);
+    if (write) {
+        if (fail) {
+            stats.write_fails++;
+        } else {
+            stats.writes++;
+        }
+    } else {
+        if (fail) {
+            stats.read_fails++;
+        } else {
+            stats.reads++;
+        }
+    }
+}
+
+bool EmbeddedDbIf::Db_GetStats(std::vector<DbTableInfo> &vdbti,
+    DbErrors &dbe, DbBatchStats &dbbs) {
+    tbb::mutex::scoped_lock lock(smutex_);
+    for (TableStatsMap::const_iterator it = table_stats_.begin();
+         it != table_stats_.end(); ++it) {
+        DbTableInfo info;
+        info.set_table_name(it->first);
+        info.set_reads(it->second.reads);
+        info.set_read_fails(it->second.read_fails);
+        info.set_writes(it->second.writes);
+        info.set_write_fails(it->second.write_fails);
+        vdbti.push_back(info);
+    }
+    dbe.set_write_tablespace_fails(0);
+    dbe.set_read_tablespace_fails(0);
+    dbe.set_write_table_fails(write_table_fails_);
+    dbe.set_read_table_fails(read_table_fails_);
+    dbe.set_write_column_fails(0);
+    dbe.set_write_batch_column_fails(0);
+    dbe.set_read_column_fails(0);
+    dbbs.set_batches(0);
+    dbbs.set_column_lists(0);
+    dbbs.set_merged_column_lists(0);
+    dbbs.set_mutations(0);
+    dbbs.set_bytes(0);
+    dbbs.set_max_batch_bytes(0);
+    dbbs.set_avg_batch_bytes(0);
+    dbbs.set_merge_ratio(0);
+    return true;
+}
+
+std::string EmbeddedDbIf::Db_GetHost() const {
+    return "embedded";
+}
+
+int EmbeddedDbIf::Db_GetPort() const {
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __EMBEDDED_DB_IF_H__
+#define __EMBEDDED_DB_IF_H__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <boost/ptr_container/ptr_map.hpp>
+#include <boost/shared_ptr.hpp>
+#include <tbb/mutex.h>
+#include <tbb/spin_rw_mutex.h>
+
+#include "base/util.h"
+#include "gendb_if.h"
+
+namespace GenDb {
+
+// Orders DbDataValues the way Cassandra orders the encoded values: integers
+// of different widths compare by value, strings and uuids bytewise
+struct DbDataValueLess {
+    bool operator()(const DbDataValue &lhs, const DbDataValue &rhs) const;
+};
+
+// Orders composite column names and row keys. A name that is a prefix of
+// another sorts before it, so a range finish that is a prefix of a column
+// name does not include the column, same as with Cassandra
+struct DbDataValueVecLess {
+    bool operator()(const DbDataValueVec &lhs,
+                    const DbDataValueVec &rhs) const;
+};
+
+} // namespace GenDb
+
+/*
+ * In-process column store, shared by all the EmbeddedDbIf instances created
+ * on it. Column families are kept as rows sorted by row key, each row
+ * holding its columns sorted by column name.
+ */
+class EmbeddedDbStore {
+public:
+    EmbeddedDbStore();
+    ~EmbeddedDbStore();
+
+    // Number of rows and columns in a column family, 0 if not present
+    size_t RowCount(const std::string &cfname);
+    size_t ColumnCount(const std::string &cfname);
+
+private:
+    friend class EmbeddedDbIf;
+
+    typedef std::map<GenDb::DbDataValueVec, GenDb::DbDataValueVec,
+        GenDb::DbDataValueVecLess> Row;
+    typedef std::map<GenDb::DbDataValueVec, Row,
+        GenDb::DbDataValueVecLess> RowMap;
+    struct Table {
+        explicit Table(const GenDb::NewCf &cf) : cf_(cf) { }
+        GenDb::NewCf cf_;
+        RowMap rows_;
+    };
+    typedef boost::ptr_map<std::string, Table> TableMap;
+
+    // Protects the tablespaces and tables, readers share it
+    tbb::spin_rw_mutex rw_mutex_;
+    std::set<std::string> tablespaces_;
+    TableMap tables_;
+
+    DISALLOW_COPY_AND_ASSIGN(EmbeddedDbStore);
+};
+
+/*
+ * GenDbIf backed by an EmbeddedDbStore instead of Cassandra. Writes are
+ * applied synchronously, so there is no write queue. Column TTLs are not
+ * enforced.
+ */
+class EmbeddedDbIf : public GenDb::GenDbIf {
+public:
+    typedef boost::shared_ptr<EmbeddedDbStore> StorePtr;
+
+    // Uses a store of its own
+    EmbeddedDbIf();
+    explicit EmbeddedDbIf(StorePtr store);
+    virtual ~EmbeddedDbIf();
+
+    // Init/Uninit
+    virtual bool Db_Init(const std::string& task_id, int task_instance);
+    virtual void Db_Uninit(const std::string& task_id, int task_instance);
+    virtual void Db_UninitUnlocked(const std::string& task_id,
+        int task_instance);
+    virtual void Db_SetInitDone(bool init_done);
+    // Tablespace
+    virtual bool Db_AddTablespace(const std::string& tablespace,
+        const std::string& replication_factor);
+    virtual bool Db_SetTablespace(const std::string& tablespace);
+    virtual bool Db_AddSetTablespace(const std::string& tablespace,
+        const std::string& replication_factor = "1");
+    virtual bool Db_FindTablespace(const std::string& tablespace);
+    // Column family
+    virtual bool Db_AddColumnfamily(const GenDb::NewCf& cf);
+    virtual bool Db_UseColumnfamily(const GenDb::NewCf& cf);
+    // Column
+    virtual bool Db_AddColumn(std::auto_ptr<GenDb::ColList> cl);
+    virtual bool Db_AddColumnSync(std::auto_ptr<GenDb::ColList> cl);
+    // Read
+    virtual bool Db_GetRow(GenDb::ColList& ret, const std::string& cfname,
+        const GenDb::DbDataValueVec& rowkey);
+    virtual bool Db_GetMultiRow(GenDb::ColListVec& ret,
+        const std::string& cfname,
+        const std::vector<GenDb::DbDataValueVec>& key,
+        GenDb::ColumnNameRange *crange_ptr = NULL);
+    virtual bool Db_GetRangeSlices(GenDb::ColList& col_list,
+        const std::string& cfname, const GenDb::ColumnNameRange& crange,
+        const GenDb::DbDataValueVec& key);
+    // Queue
+    virtual bool Db_GetQueueStats(uint64_t &queue_count,
+        uint64_t &enqueues) const;
+    virtual void Db_SetQueueWaterMark(bool high, size_t queue_count,
+        DbQueueWaterMarkCb cb);
+    virtual void Db_ResetQueueWaterMarks();
+    // Write combining
+    virtual void Db_SetBatchParams(size_t max_bytes, uint64_t window_usec);
+    // Stats
+    virtual bool Db_GetStats(std::vector<GenDb::DbTableInfo> &vdbti,
+        GenDb::DbErrors &dbe, GenDb::DbBatchStats &dbbs);
+    // Connection
+    virtual std::string Db_GetHost() const;
+    virtual int Db_GetPort() const;
+
+    const StorePtr &store() const { return store_; }
+
+private:
+    struct TableStats {
+        TableStats() :
+            reads(0), read_fails(0), writes(0), write_fails(0) { }
+        uint64_t reads;
+        uint64_t read_fails;
+        uint64_t writes;
+        uint64_t write_fails;
+    };
+    typedef std::map<std::string, TableStats> TableStatsMap;
+
+    // Copies the columns of row, from start to finish (both inclusive, empty
+    // for unbounded), upto count columns if count is not 0
+    static void ReadColumns(const EmbeddedDbStore::Table &table,
+        const EmbeddedDbStore::Row &row,
+        const GenDb::DbDataValueVec &start,
+        const GenDb::DbDataValueVec &finish, uint32_t count,
+        GenDb::NewColVec *columns);
+    bool AddTable(const GenDb::NewCf& cf);
+    void UpdateTableStats(const std::string &cfname, bool write, bool fail);
+
+    StorePtr store_;
+    std::string tablespace_;
+    mutable tbb::mutex smutex_;
+    TableStatsMap table_stats_;
+    uint64_t read_table_fails_;
+    uint64_t write_table_fails_;
+
+    DISALLOW_COPY_AND_ASSIGN(EmbeddedDbIf);
+};
+
+#endif // __EMBEDDED_DB_IF_H__
@@ -166,9 +166,12 @@ public:
     virtual void Db_SetQueueWaterMark(bool high, size_t queue_count,
         DbQueueWaterMarkCb cb) = 0;
     virtual void Db_ResetQueueWaterMarks() = 0;
+    // Write combining
+    virtual void Db_SetBatchParams(size_t max_bytes,
+        uint64_t window_usec) = 0;
     // Stats
     virtual bool Db_GetStats(std::vector<DbTableInfo> &vdbti,
-        DbErrors &dbe) = 0;
+        DbErrors &dbe, DbBatchStats &dbbs) = 0;
     // Connection
     virtual std::string Db_GetHost() const = 0;
     virtual int Db_GetPort() const = 0;
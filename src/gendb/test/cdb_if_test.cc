@@ -65,6 +65,60 @@ protected:
         const GenDb::DbDataValueVec& input) {
         return dbif_.DbDataValueVecToString(output, composite, input);
     }
+    GenDb::ColList *MakeColList(const std::string &cfname,
+        const std::string &rowkey, const std::string &colname) {
+        GenDb::ColList *cl(new GenDb::ColList);
+        cl->cfname_ = cfname;
+        cl->rowkey_.push_back(rowkey);
+        cl->columns_.push_back(new GenDb::NewCol(colname,
+            GenDb::DbDataValue(std::string("value"))));
+        return cl;
+    }
+    bool AsyncAddColumn(GenDb::ColList *cl) {
+        CdbIf::CdbIfColList qentry;
+        qentry.gendb_cl = cl;
+        return dbif_.Db_AsyncAddColumn(qentry);
+    }
+    size_t MutationCount(const std::string &rowkey,
+        const std::string &cfname) {
+        CdbIf::CassandraMutationMap::const_iterator it =
+            dbif_.mutation_map_.find(rowkey);
+        if (it == dbif_.mutation_map_.end()) {
+            return 0;
+        }
+        CdbIf::CFMutationMap::const_iterator cf_it = it->second.find(cfname);
+        if (cf_it == it->second.end()) {
+            return 0;
+        }
+        return cf_it->second.size();
+    }
+    size_t MutationMapSize() {
+        return dbif_.mutation_map_.size();
+    }
+    void BatchAddColumn(bool done) {
+        dbif_.Db_BatchAddColumn(done);
+    }
+    void GetCurrentBatchStats(GenDb::DbBatchStats &dbbs) {
+        dbif_.batch_.Get(dbbs);
+    }
+    void ClearCurrentBatch() {
+        dbif_.mutation_map_.clear();
+        dbif_.batch_ = CdbIf::CdbIfStats::BatchStats();
+    }
+    void UpdateBatchStats(uint64_t column_lists, uint64_t merged_column_lists,
+        uint64_t mutations, uint64_t bytes) {
+        CdbIf::CdbIfStats::BatchStats batch;
+        batch.num_batches = 1;
+        batch.num_column_lists = column_lists;
+        batch.num_merged_column_lists = merged_column_lists;
+        batch.num_mutations = mutations;
+        batch.num_bytes = bytes;
+        batch.max_batch_bytes = bytes;
+        stats_.UpdateBatch(batch);
+    }
+    void GetBatchStats(GenDb::DbBatchStats &dbbs) {
+        stats_.GetBatch(dbbs);
+    }
  
     CdbIf dbif_;
     CdbIf::CdbIfStats stats_;
@@ -329,6 +383,45 @@ TEST_F(CdbIfTest, Stats) {
     EXPECT_EQ(edbe_diffs, adbe_diffs); 
 }
 
+TEST_F(CdbIfTest, BatchCombine) {
+    dbif_.Db_SetBatchParams(CdbIf::kBatchMaxBytes, CdbIf::kBatchWindowUsec);
+    // Column lists for the same row key and column family are merged
+    EXPECT_TRUE(AsyncAddColumn(MakeColList("FakeCf1", "row1", "col1")));
+    EXPECT_TRUE(AsyncAddColumn(MakeColList("FakeCf1", "row1", "col2")));
+    EXPECT_TRUE(AsyncAddColumn(MakeColList("FakeCf2", "row1", "col1")));
+    EXPECT_TRUE(AsyncAddColumn(MakeColList("FakeCf1", "row2", "col1")));
+    EXPECT_EQ(2, MutationMapSize());
+    EXPECT_EQ(2, MutationCount("row1", "FakeCf1"));
+    EXPECT_EQ(1, MutationCount("row1", "FakeCf2"));
+    EXPECT_EQ(1, MutationCount("row2", "FakeCf1"));
+    GenDb::DbBatchStats dbbs;
+    GetCurrentBatchStats(dbbs);
+    EXPECT_EQ(4, dbbs.get_column_lists());
+    EXPECT_EQ(1, dbbs.get_merged_column_lists());
+    EXPECT_EQ(4, dbbs.get_mutations());
+    EXPECT_LT(0, dbbs.get_bytes());
+    // Batch is held back while the queue has more column lists, within
+    // the window and byte budget
+    BatchAddColumn(false);
+    EXPECT_EQ(2, MutationMapSize());
+    ClearCurrentBatch();
+}
+
+TEST_F(CdbIfTest, BatchStats) {
+    UpdateBatchStats(8, 6, 16, 1000);
+    UpdateBatchStats(8, 6, 16, 3000);
+    GenDb::DbBatchStats dbbs;
+    GetBatchStats(dbbs);
+    EXPECT_EQ(2, dbbs.get_batches());
+    EXPECT_EQ(16, dbbs.get_column_lists());
+    EXPECT_EQ(12, dbbs.get_merged_column_lists());
+    EXPECT_EQ(32, dbbs.get_mutations());
+    EXPECT_EQ(4000, dbbs.get_bytes());
+    EXPECT_EQ(3000, dbbs.get_max_batch_bytes());
+    EXPECT_EQ(2000, dbbs.get_avg_batch_bytes());
+    EXPECT_DOUBLE_EQ(4.0, dbbs.get_merge_ratio());
+}
+
 int main(int argc, char **argv) {
     LoggingInit();
     ::testing::InitGoogleTest(&argc, argv);
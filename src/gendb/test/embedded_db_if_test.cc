@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <boost/assign/list_of.hpp>
+#include "testing/gunit.h"
+
+#include "base/logging.h"
+#include "../embedded_db_if.h"
+
+using namespace GenDb;
+using boost::assign::list_of;
+
+class EmbeddedDbIfTest : public ::testing::Test {
+protected:
+    EmbeddedDbIfTest() :
+        store_(new EmbeddedDbStore),
+        dbif_(store_) {
+    }
+
+    virtual void SetUp() {
+        ASSERT_TRUE(dbif_.Db_Init("EmbeddedDbIfTest", -1));
+        ASSERT_TRUE(dbif_.Db_AddSetTablespace("TestKeyspace"));
+        // Row key: T2, Column name: (T1, string), Column value: string
+        DbDataTypeVec key_type = list_of(DbDataType::Unsigned32Type);
+        DbDataTypeVec comp_type = list_of(DbDataType::Unsigned32Type)
+            (DbDataType::AsciiType);
+        DbDataTypeVec valid_class = list_of(DbDataType::AsciiType);
+        ASSERT_TRUE(dbif_.Db_AddColumnfamily(NewCf("NoSqlTable", key_type,
+            comp_type, valid_class)));
+        NewCf::SqlColumnMap columns = boost::assign::map_list_of
+            ("col1", DbDataType::AsciiType)
+            ("col2", DbDataType::Unsigned64Type);
+        ASSERT_TRUE(dbif_.Db_AddColumnfamily(NewCf("SqlTable", key_type,
+            columns)));
+    }
+
+    // Writes count columns to row t2 of NoSqlTable, with T1 from 0 and a
+    // name of "a" and "b" at each T1
+    void AddNoSqlRow(uint32_t t2, uint32_t count) {
+        std::auto_ptr<ColList> cl(new ColList);
+        cl->cfname_ = "NoSqlTable";
+        cl->rowkey_.push_back(t2);
+        for (uint32_t t1 = 0; t1 < count; t1++) {
+            const char *names[] = { "b", "a" };
+            for (int i = 0; i < 2; i++) {
+                DbDataValueVec *name(new DbDataValueVec);
+                name->push_back(t1);
+                name->push_back(std::string(names[i]));
+                DbDataValueVec *value(new DbDataValueVec(1,
+                    std::string(names[i]) + integerToString(t1)));
+                cl->columns_.push_back(new NewCol(name, value));
+            }
+        }
+        EXPECT_TRUE(dbif_.Db_AddColumn(cl));
+    }
+
+    static std::string ColumnValue(const NewCol &col) {
+        return boost::get<std::string>(col.value->at(0));
+    }
+
+    EmbeddedDbIf::StorePtr store_;
+    EmbeddedDbIf dbif_;
+};
+
+TEST_F(EmbeddedDbIfTest, Tablespace) {
+    EXPECT_TRUE(dbif_.Db_FindTablespace("TestKeyspace"));
+    EXPECT_FALSE(dbif_.Db_FindTablespace("NoKeyspace"));
+    EXPECT_FALSE(dbif_.Db_SetTablespace("NoKeyspace"));
+    // A second instance on the store sees the tablespace and tables
+    EmbeddedDbIf dbif(store_);
+    EXPECT_TRUE(dbif.Db_SetTablespace("TestKeyspace"));
+    AddNoSqlRow(1, 1);
+    ColList ret;
+    EXPECT_TRUE(dbif.Db_GetRow(ret, "NoSqlTable", list_of(DbDataValue(1U))));
+    EXPECT_EQ(2U, ret.columns_.size());
+}
+
+TEST_F(EmbeddedDbIfTest, GetRow) {
+    AddNoSqlRow(1, 2);
+    ColList ret;
+    EXPECT_TRUE(dbif_.Db_GetRow(ret, "NoSqlTable",
+        list_of(DbDataValue(1U))));
+    // Columns are sorted by name
+    ASSERT_EQ(4U, ret.columns_.size());
+    EXPECT_EQ("a0", ColumnValue(ret.columns_[0]));
+    EXPECT_EQ("b0", ColumnValue(ret.columns_[1]));
+    EXPECT_EQ("a1", ColumnValue(ret.columns_[2]));
+    EXPECT_EQ("b1", ColumnValue(ret.columns_[3]));
+    EXPECT_EQ(NewCf::COLUMN_FAMILY_NOSQL, ret.columns_[0].cftype_);
+
+    // Missing row has no columns
+    ColList empty;
+    EXPECT_TRUE(dbif_.Db_GetRow(empty, "NoSqlTable",
+        list_of(DbDataValue(2U))));
+    EXPECT_EQ(0U, empty.columns_.size());
+
+    // Missing table is an error
+    ColList error;
+    EXPECT_FALSE(dbif_.Db_GetRow(error, "NoTable",
+        list_of(DbDataValue(1U))));
+}
+
+TEST_F(EmbeddedDbIfTest, SqlTable) {
+    std::auto_ptr<ColList> cl(new ColList);
+    cl->cfname_ = "SqlTable";
+    cl->rowkey_.push_back(1U);
+    cl->columns_.push_back(new NewCol("col2", DbDataValue(
+        static_cast<uint64_t>(10))));
+    cl->columns_.push_back(new NewCol("col1", DbDataValue(
+        std::string("value1"))));
+    EXPECT_TRUE(dbif_.Db_AddColumnSync(cl));
+    // Later write overwrites the column
+    cl.reset(new ColList);
+    cl->cfname_ = "SqlTable";
+    cl->rowkey_.push_back(1U);
+    cl->columns_.push_back(new NewCol("col2", DbDataValue(
+        static_cast<uint64_t>(20))));
+    EXPECT_TRUE(dbif_.Db_AddColumn(cl));
+
+    ColList ret;
+    EXPECT_TRUE(dbif_.Db_GetRow(ret, "SqlTable", list_of(DbDataValue(1U))));
+    ASSERT_EQ(2U, ret.columns_.size());
+    EXPECT_EQ(NewCol("col1", DbDataValue(std::string("value1"))),
+              ret.columns_[0]);
+    EXPECT_EQ(NewCol("col2", DbDataValue(static_cast<uint64_t>(20))),
+              ret.columns_[1]);
+    EXPECT_EQ(NewCf::COLUMN_FAMILY_SQL, ret.columns_[0].cftype_);
+    EXPECT_EQ(1U, store_->RowCount("SqlTable"));
+    EXPECT_EQ(2U, store_->ColumnCount("SqlTable"));
+}
+
+TEST_F(EmbeddedDbIfTest, GetMultiRow) {
+    AddNoSqlRow(1, 4);
+    AddNoSqlRow(3, 4);
+    std::vector<DbDataValueVec> keys;
+    for (uint32_t t2 = 1; t2 <= 3; t2++) {
+        keys.push_back(list_of(DbDataValue(t2)));
+    }
+
+    // All columns
+    ColListVec all;
+    EXPECT_TRUE(dbif_.Db_GetMultiRow(all, "NoSqlTable", keys));
+    ASSERT_EQ(3U, all.size());
+    EXPECT_EQ(keys[0], all[0].rowkey_);
+    EXPECT_EQ(8U, all[0].columns_.size());
+    EXPECT_EQ(0U, all[1].columns_.size());
+    EXPECT_EQ(8U, all[2].columns_.size());
+
+    // Column range, a finish that is a prefix excludes the longer names,
+    // integers of different widths compare by value
+    ColumnNameRange crange;
+    crange.start_.push_back(static_cast<uint64_t>(1));
+    crange.finish_.push_back(2U);
+    crange.finish_.push_back(std::string("a"));
+    ColListVec range;
+    EXPECT_TRUE(dbif_.Db_GetMultiRow(range, "NoSqlTable", keys, &crange));
+    ASSERT_EQ(3U, range.size());
+    ASSERT_EQ(3U, range[0].columns_.size());
+    EXPECT_EQ("a1", ColumnValue(range[0].columns_[0]));
+    EXPECT_EQ("b1", ColumnValue(range[0].columns_[1]));
+    EXPECT_EQ("a2", ColumnValue(range[0].columns_[2]));
+
+    // Column count
+    crange.count = 2;
+    ColListVec count;
+    EXPECT_TRUE(dbif_.Db_GetMultiRow(count, "NoSqlTable", keys, &crange));
+    ASSERT_EQ(3U, count.size());
+    EXPECT_EQ(2U, count[0].columns_.size());
+    EXPECT_EQ(2U, count[2].columns_.size());
+
+    // Start after finish
+    crange.start_ = list_of(DbDataValue(3U));
+    crange.finish_ = list_of(DbDataValue(1U));
+    ColListVec inverted;
+    EXPECT_TRUE(dbif_.Db_GetMultiRow(inverted, "NoSqlTable", keys, &crange));
+    ASSERT_EQ(3U, inverted.size());
+    EXPECT_EQ(0U, inverted[0].columns_.size());
+}
+
+TEST_F(EmbeddedDbIfTest, GetRangeSlices) {
+    AddNoSqlRow(1, 200);
+    // The range is not limited by count
+    ColumnNameRange crange;
+    crange.start_.push_back(10U);
+    crange.finish_.push_back(0xffffffff);
+    crange.count = 10;
+    ColList ret;
+    EXPECT_TRUE(dbif_.Db_GetRangeSlices(ret, "NoSqlTable", crange,
+        list_of(DbDataValue(1U))));
+    ASSERT_EQ(380U, ret.columns_.size());
+    EXPECT_EQ("a10", ColumnValue(ret.columns_[0]));
+    EXPECT_EQ("b199", ColumnValue(ret.columns_[379]));
+
+    ColList error;
+    EXPECT_FALSE(dbif_.Db_GetRangeSlices(error, "NoTable", crange,
+        list_of(DbDataValue(1U))));
+}
+
+TEST_F(EmbeddedDbIfTest, Stats) {
+    AddNoSqlRow(1, 1);
+    std::auto_ptr<ColList> cl(new ColList);
+    cl->cfname_ = "NoTable";
+    EXPECT_FALSE(dbif_.Db_AddColumn(cl));
+    ColList ret;
+    EXPECT_TRUE(dbif_.Db_GetRow(ret, "NoSqlTable", list_of(DbDataValue(1U))));
+
+    std::vector<DbTableInfo> vdbti;
+    DbErrors dbe;
+    DbBatchStats dbbs;
+    EXPECT_TRUE(dbif_.Db_GetStats(vdbti, dbe, dbbs));
+    ASSERT_EQ(2U, vdbti.size());
+    EXPECT_EQ("NoSqlTable", vdbti[0].get_table_name());
+    EXPECT_EQ(1U, vdbti[0].get_writes());
+    EXPECT_EQ(1U, vdbti[0].get_reads());
+    EXPECT_EQ("NoTable", vdbti[1].get_table_name());
+    EXPECT_EQ(1U, vdbti[1].get_write_fails());
+    EXPECT_EQ(1U, dbe.get_write_table_fails());
+    // No write batching
+    EXPECT_EQ(0U, dbbs.get_batches());
+
+    uint64_t queue_count, enqueues;
+    EXPECT_TRUE(dbif_.Db_GetQueueStats(queue_count, enqueues));
+    EXPECT_EQ(0U, queue_count);
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -5,15 +5,104 @@
 #include "Thrift.h"
 
 #include "io/event_manager.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <boost/bind.hpp>
+#include <tbb/task_scheduler_init.h>
+#include <tbb/tbb_thread.h>
+
 #include "base/logging.h"
+#include "base/task.h"
 #include "io/io_log.h"
 
 using namespace boost::asio;
 
 SandeshTraceBufferPtr IOTraceBuf(SandeshTraceBufferCreate(IO_TRACE_BUF, 1000));
 
+//
+// Runs one io_service of the pool until it is stopped.
+//
+class EventManager::PoolThread {
+public:
+    PoolThread(boost::asio::io_service *service, int cpu)
+        : service_(service), cpu_(cpu),
+          thread_(boost::bind(&PoolThread::Run, this)) {
+    }
+
+    void Join() {
+        thread_.join();
+    }
+
+private:
+    void Run() {
+#if defined(__linux__)
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu_, &cpuset);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+#endif
+        // Handlers enqueue tasks, as they do from the main io_service thread.
+        tbb::task_scheduler_init init(TaskScheduler::GetThreadCount() + 1);
+        while (true) {
+            boost::system::error_code ec;
+            service_->run(ec);
+            if (!ec)
+                break;
+            EVENT_MANAGER_LOG_ERROR("io_service run failed: " << ec.message());
+        }
+    }
+
+    boost::asio::io_service *service_;
+    int cpu_;
+    tbb::tbb_thread thread_;
+
+    DISALLOW_COPY_AND_ASSIGN(PoolThread);
+};
+
 EventManager::EventManager() {
     shutdown_ = false;
+    pool_next_ = 0;
+}
+
+EventManager::~EventManager() {
+    StopIoServicePool();
+}
+
+//
+// Pool threads are pinned to cores in order starting with core 1, leaving
+// core 0 to the thread running the main io_service until the pool wraps
+// around.
+//
+void EventManager::StartIoServicePool(size_t count) {
+    assert(pool_.empty());
+    int cpus = tbb::tbb_thread::hardware_concurrency();
+    if (cpus <= 0)
+        cpus = 1;
+    for (size_t i = 0; i < count; i++) {
+        boost::asio::io_service *service = new boost::asio::io_service;
+        pool_.push_back(service);
+        pool_work_.push_back(new boost::asio::io_service::work(*service));
+        pool_threads_.push_back(new PoolThread(service, (i + 1) % cpus));
+    }
+}
+
+void EventManager::StopIoServicePool() {
+    pool_work_.clear();
+    for (size_t i = 0; i < pool_.size(); i++) {
+        pool_[i].stop();
+    }
+    for (size_t i = 0; i < pool_threads_.size(); i++) {
+        pool_threads_[i]->Join();
+        delete pool_threads_[i];
+    }
+    pool_threads_.clear();
+}
+
+boost::asio::io_service *EventManager::session_io_service() {
+    if (pool_.empty())
+        return &io_service_;
+    return &pool_[pool_next_.fetch_and_increment() % pool_.size()];
 }
 
 void EventManager::Shutdown() {
@@ -21,6 +110,9 @@ void EventManager::Shutdown() {
 
     // TODO: make sure that are no users of this event manager.
     io_service_.stop();
+    for (size_t i = 0; i < pool_.size(); i++) {
+        pool_[i].stop();
+    }
 }
 
 void EventManager::Run() {
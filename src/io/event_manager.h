@@ -4,7 +4,10 @@
 
 #pragma once
 
+#include <vector>
 #include <boost/asio/io_service.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <tbb/atomic.h>
 #include <tbb/spin_mutex.h>
 
 #include "base/util.h"
@@ -18,9 +21,20 @@
 // Poll directly or indirectly after having started a ServerThread (which
 // calls Run).
 //
+// Optionally, the EventManager also runs a pool of io_services, each in a
+// thread of its own that is pinned to a core. TcpServer places the sockets
+// of new sessions on the pool in round robin order, so that the completion
+// handlers of different sessions run in parallel. Acceptors, timers and
+// everything else stay on the main io_service.
+//
 class EventManager {
 public:
     EventManager();
+    ~EventManager();
+
+    // Start a pool of count io_service threads. Must be called at most once,
+    // before any session is created.
+    void StartIoServicePool(size_t count);
 
     // Run until shutdown.
     void Run();
@@ -36,10 +50,25 @@ public:
 
     boost::asio::io_service *io_service() { return &io_service_; }
 
+    // The io_service for the socket of a new session. This is the next one
+    // in the pool or, without a pool, the main io_service.
+    boost::asio::io_service *session_io_service();
+
+    size_t io_service_pool_size() const { return pool_.size(); }
+
 private:
+    class PoolThread;
+
+    void StopIoServicePool();
+
     boost::asio::io_service io_service_;
     bool shutdown_;
     tbb::spin_mutex mutex_;
 
+    boost::ptr_vector<boost::asio::io_service> pool_;
+    boost::ptr_vector<boost::asio::io_service::work> pool_work_;
+    std::vector<PoolThread *> pool_threads_;
+    tbb::atomic<size_t> pool_next_;
+
     DISALLOW_COPY_AND_ASSIGN(EventManager);
 };
@@ -19,6 +19,7 @@ SocketStats::SocketStats() {
     write_errors = 0;
     write_blocked = 0;
     write_blocked_duration_usecs = 0;
+    write_bytes_copied = 0;
 }
 
 void SocketStats::GetRxStats(SocketIOStats &socket_stats) const {
@@ -46,6 +47,7 @@ void SocketStats::GetTxStats(SocketIOStats &socket_stats) const {
                      write_blocked);
     }
     socket_stats.errors = write_errors;
+    socket_stats.bytes_copied = write_bytes_copied;
 }
 
 }  // namespace io
@@ -25,6 +25,8 @@ struct SocketStats {
     tbb::atomic<uint64_t> write_errors;
     tbb::atomic<uint64_t> write_blocked;
     tbb::atomic<uint64_t> write_blocked_duration_usecs;
+    // Bytes copied to the write queue when the socket is not write ready.
+    tbb::atomic<uint64_t> write_bytes_copied;
 };
 
 }  // namespace io
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __TCP_MESSAGE_BUFFER_H__
+#define __TCP_MESSAGE_BUFFER_H__
+
+#include <stdint.h>
+#include <string>
+#include <boost/intrusive_ptr.hpp>
+#include <tbb/atomic.h>
+#include "base/util.h"
+
+//
+// Immutable, reference counted message data. A message that is sent to many
+// sessions is built once into a TcpMessageBuffer, and each TcpMessageWriter
+// that cannot write it right away queues a reference to the buffer instead
+// of a copy of the data.
+//
+class TcpMessageBuffer {
+public:
+    // Takes the contents of data, which is left empty.
+    explicit TcpMessageBuffer(std::string *data) {
+        refcount_ = 0;
+        data_.swap(*data);
+    }
+    TcpMessageBuffer(const uint8_t *data, size_t size)
+        : data_(reinterpret_cast<const char *>(data), size) {
+        refcount_ = 0;
+    }
+
+    const uint8_t *data() const {
+        return reinterpret_cast<const uint8_t *>(data_.data());
+    }
+    size_t size() const { return data_.size(); }
+
+private:
+    friend void intrusive_ptr_add_ref(TcpMessageBuffer *buffer);
+    friend void intrusive_ptr_release(TcpMessageBuffer *buffer);
+
+    std::string data_;
+    tbb::atomic<int> refcount_;
+
+    DISALLOW_COPY_AND_ASSIGN(TcpMessageBuffer);
+};
+
+typedef boost::intrusive_ptr<TcpMessageBuffer> TcpMessageBufferPtr;
+
+inline void intrusive_ptr_add_ref(TcpMessageBuffer *buffer) {
+    buffer->refcount_.fetch_and_increment();
+}
+
+inline void intrusive_ptr_release(TcpMessageBuffer *buffer) {
+    int prev = buffer->refcount_.fetch_and_decrement();
+    if (prev == 1) {
+        delete buffer;
+    }
+}
+
+#endif
@@ -18,15 +18,26 @@ TcpMessageWriter::TcpMessageWriter(Socket *socket, TcpSession *session) :
 }
 
 TcpMessageWriter::~TcpMessageWriter() {
-    for (BufferQueue::iterator iter = buffer_queue_.begin();
-         iter != buffer_queue_.end(); ++iter) {
-        DeleteBuffer(*iter);
-    }
     buffer_queue_.clear();
 }
 
 int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
+    return Send(data, len, NULL, ec, NULL);
+}
+
+//
+// The header and the body are written with a single gather write. Whatever
+// is left of the header is copied to the buffer queue, and the body is
+// queued by reference, so that a body sent to many sessions is not copied
+// for the ones that are blocked.
+//
+int TcpMessageWriter::Send(const uint8_t *header, size_t header_len,
+                           TcpMessageBuffer *body, error_code &ec,
+                           size_t *copied) {
     int wrote = 0;
+    size_t body_len = body ? body->size() : 0;
+    size_t len = header_len + body_len;
+    if (copied) *copied = 0;
 
     // Update socket write call statistics.
     session_->stats_.write_calls++;
@@ -36,7 +47,11 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
     session_->server_->stats_.write_bytes += len;
 
     if (buffer_queue_.empty()) {
-        wrote = socket_->write_some(boost::asio::buffer(data, len), ec);
+        boost::array<const_buffer, 2> buffers = {{
+            boost::asio::buffer(header, header_len),
+            boost::asio::buffer(body ? body->data() : NULL, body_len)
+        }};
+        wrote = socket_->write_some(buffers, ec);
         if (TcpSession::IsSocketErrorHard(ec)) return -1;
         assert(wrote >= 0);
 
@@ -44,13 +59,23 @@ int TcpMessageWriter::Send(const uint8_t *data, size_t len, error_code &ec) {
             TCP_SESSION_LOG_UT_DEBUG(session_, TCP_DIR_OUT,
                 "Encountered partial send of " << wrote << " bytes when "
                 "sending " << len << " bytes, Error: " << ec);
-            BufferAppend(data + wrote, len - wrote);
+            if ((size_t)wrote < header_len) {
+                BufferAppend(header + wrote, header_len - wrote);
+                if (copied) *copied = header_len - wrote;
+                if (body_len)
+                    BufferAppend(body, 0);
+            } else {
+                BufferAppend(body, wrote - header_len);
+            }
             DeferWrite();
         }
     } else {
         TCP_SESSION_LOG_UT_DEBUG(session_, TCP_DIR_OUT,
             "Write not ready. Enqueue buffer (len = " << len << ") and return");
-        BufferAppend(data, len);
+        BufferAppend(header, header_len);
+        if (copied) *copied = header_len;
+        if (body_len)
+            BufferAppend(body, 0);
     }
     return wrote;
 }
@@ -90,9 +115,9 @@ void TcpMessageWriter::HandleWriteReady(TcpSessionPtr session_ptr,
     if (session_->IsClosedLocked()) return;
 
     while (!buffer_queue_.empty()) {
-        boost::asio::mutable_buffer head = buffer_queue_.front();
-        const uint8_t *data = buffer_cast<const uint8_t *>(head) + offset_;
-        int remaining = buffer_size(head) - offset_;
+        const TcpMessageBuffer *head = buffer_queue_.front().get();
+        const uint8_t *data = head->data() + offset_;
+        int remaining = head->size() - offset_;
         error_code ec;
         int wrote = socket_->write_some(buffer(data, remaining), ec);
         if (TcpSession::IsSocketErrorHard(ec)) {
@@ -107,7 +132,6 @@ void TcpMessageWriter::HandleWriteReady(TcpSessionPtr session_ptr,
             return;
         } else {
             offset_ = 0;
-            DeleteBuffer(head);
             buffer_queue_.pop_front();
         }
     }
@@ -125,16 +149,21 @@ done:
 }
 
 void TcpMessageWriter::BufferAppend(const uint8_t *src, int bytes) {
-    u_int8_t *data = new u_int8_t[bytes];
-    memcpy(data, src, bytes);
-    mutable_buffer buffer = mutable_buffer(data, bytes);
-    buffer_queue_.push_back(buffer);
+    session_->stats_.write_bytes_copied += bytes;
+    session_->server_->stats_.write_bytes_copied += bytes;
+    buffer_queue_.push_back(TcpMessageBufferPtr(
+        new TcpMessageBuffer(src, bytes)));
 }
 
-void TcpMessageWriter::DeleteBuffer(mutable_buffer buffer) {
-    const uint8_t *data = buffer_cast<const uint8_t *>(buffer);
-    delete[] data;
-    return;
+// Queue a reference to buffer. The offset of the first byte to write can
+// only be non-zero when the buffer is at the head of the queue.
+void TcpMessageWriter::BufferAppend(TcpMessageBuffer *buffer, size_t offset) {
+    if (buffer_queue_.empty()) {
+        offset_ = offset;
+    } else {
+        assert(offset == 0);
+    }
+    buffer_queue_.push_back(TcpMessageBufferPtr(buffer));
 }
 
 void TcpMessageWriter::RegisterNotification(SendReadyCb cb) {
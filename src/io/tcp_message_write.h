@@ -6,6 +6,7 @@
 #define __MESSAGE_WRITE_H__
 
 #include <list>
+#include <boost/array.hpp>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/asio/buffer.hpp>
@@ -13,6 +14,7 @@
 #include <boost/system/error_code.hpp>
 #include <tbb/mutex.h>
 #include "base/util.h"
+#include "io/tcp_message_buffer.h"
 
 using namespace boost::system;
 
@@ -27,15 +29,20 @@ public:
 
     // return false for send  
     int Send(const uint8_t *msg, size_t len, error_code &ec);
+    // Sends header followed by body, which may be NULL. Unwritten header
+    // bytes are copied, while the body is queued by reference. The number of
+    // bytes copied is returned in copied, if provided.
+    int Send(const uint8_t *header, size_t header_len,
+             TcpMessageBuffer *body, error_code &ec, size_t *copied);
 
     typedef boost::function<void(const error_code &ec)> SendReadyCb;
     void RegisterNotification(SendReadyCb);
 
 private:
     typedef boost::intrusive_ptr<TcpSession> TcpSessionPtr;
-    typedef std::list<boost::asio::mutable_buffer> BufferQueue;
+    typedef std::list<TcpMessageBufferPtr> BufferQueue;
     void BufferAppend(const uint8_t *data, int len);
-    void DeleteBuffer(boost::asio::mutable_buffer buffer); 
+    void BufferAppend(TcpMessageBuffer *buffer, size_t offset);
     void DeferWrite();
     void HandleWriteReady(TcpSessionPtr session_ref, const error_code &ec,
                           uint64_t block_start_time);
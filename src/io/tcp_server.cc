@@ -138,7 +138,7 @@ void TcpServer::ClearSessions() {
 }
 
 TcpSession *TcpServer::CreateSession() {
-    Socket *socket = new Socket(*evm_->io_service());
+    Socket *socket = new Socket(*evm_->session_io_service());
     TcpSession *session = AllocSession(socket);
     {
         tbb::mutex::scoped_lock lock(mutex_);
@@ -213,7 +213,9 @@ void TcpServer::AsyncAccept() {
     if (acceptor_ == NULL) {
         return;
     }
-    so_accept_.reset(new Socket(*evm_->io_service()));
+    // The acceptor runs on the main io_service, while the completion
+    // handlers of the accepted socket run on the session io_service.
+    so_accept_.reset(new Socket(*evm_->session_io_service()));
     acceptor_->async_accept(*so_accept_.get(),
         boost::bind(&TcpServer::AcceptHandlerInternal, this,
             TcpServerPtr(this), boost::asio::placeholders::error));
@@ -4,6 +4,7 @@
 
 #include "io/tcp_session.h"
 
+#include <boost/array.hpp>
 #include <boost/asio.hpp>
 #include <boost/bind.hpp>
 #include <boost/scoped_array.hpp>
@@ -262,12 +263,28 @@ void TcpSession::AsyncWriteHandler(TcpSessionPtr session,
     }
 }
 
+// Keeps a reference to the buffer until the write completes.
+void TcpSession::AsyncWriteBufferHandler(
+    TcpSessionPtr session, TcpMessageBufferPtr buffer,
+    const boost::system::error_code &error) {
+    AsyncWriteHandler(session, error);
+}
+
 bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
+    return SendParts(data, size, NULL, sent);
+}
+
+bool TcpSession::SendParts(const u_int8_t *header, size_t header_size,
+                           TcpMessageBuffer *body, size_t *sent,
+                           size_t *copied) {
     bool ret = true;
+    size_t body_size = body ? body->size() : 0;
+    size_t size = header_size + body_size;
     tbb::mutex::scoped_lock lock(mutex_);
 
-    // Reset sent, if provided.
+    // Reset sent and copied, if provided.
     if (sent) *sent = 0;
+    if (copied) *copied = 0;
 
     //
     // If the session closed in the mean while, bail out
@@ -276,7 +293,7 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
 
     if (socket_->non_blocking()) {
         boost::system::error_code error;
-        int len = writer_->Send(data, size, error);
+        int len = writer_->Send(header, header_size, body, error, copied);
         lock.release();
         if (len < 0) {
             TCP_SESSION_LOG_INFO(this, TCP_DIR_OUT,
@@ -288,9 +305,14 @@ bool TcpSession::Send(const u_int8_t *data, size_t size, size_t *sent) {
         if (len < 0 || (size_t)len != size) ret = false;
         if (sent) *sent = (len > 0) ? len : 0;
     } else {
+        boost::array<const_buffer, 2> buffers = {{
+            buffer(header, header_size),
+            buffer(body ? body->data() : NULL, body_size)
+        }};
         boost::asio::async_write(
-            *socket_.get(), buffer(data, size),
-            boost::bind(&TcpSession::AsyncWriteHandler, TcpSessionPtr(this),
+            *socket_.get(), buffers,
+            boost::bind(&TcpSession::AsyncWriteBufferHandler,
+                        TcpSessionPtr(this), TcpMessageBufferPtr(body),
                         boost::asio::placeholders::error));
         if (sent) *sent = size;
     }
@@ -21,6 +21,7 @@
 #include <tbb/compat/condition_variable>
 #endif
 #include "base/util.h"
+#include "io/tcp_message_buffer.h"
 #include "io/tcp_server.h"
 
 class EventManager;
@@ -58,6 +59,13 @@ public:
                bool async_read_ready = true);
     // Performs a non-blocking send operation.
     virtual bool Send(const u_int8_t *data, size_t size, size_t *sent);
+    // Sends header followed by body, which may be NULL, with a single
+    // gather write. The body is shared with the writer rather than copied
+    // if it cannot be written right away. The number of header bytes that
+    // had to be copied is returned in copied, if provided.
+    bool SendParts(const u_int8_t *header, size_t header_size,
+                   TcpMessageBuffer *body, size_t *sent,
+                   size_t *copied = NULL);
 
     // Called by TcpServer to trigger async read.
     virtual bool Connected(Endpoint remote);
@@ -162,6 +170,9 @@ private:
                                  size_t size);
     static void AsyncWriteHandler(TcpSessionPtr session,
                                   const boost::system::error_code &error);
+    static void AsyncWriteBufferHandler(TcpSessionPtr session,
+                                        TcpMessageBufferPtr buffer,
+                                        const boost::system::error_code &error);
 
     void ReleaseBufferLocked(Buffer buffer);
     void CloseInternal(bool call_observer, bool notify_server = true);
@@ -103,6 +103,10 @@ class EchoServer : public TcpServer {
     bool Send(const u_int8_t *data, size_t size, size_t *actual) {
         return session_->Send(data, size, actual);
     }
+    bool SendParts(const u_int8_t *header, size_t header_size,
+                   TcpMessageBuffer *body, size_t *actual, size_t *copied) {
+        return session_->SendParts(header, header_size, body, actual, copied);
+    }
 
     EchoSession *GetSession() const { return session_; }
     void SetSocketOptions() { session_->SetSocketOptions(); }
@@ -250,6 +254,75 @@ TEST_F(EchoServerTest, Basic) {
     server_->GetSession()->ResetTotal();
 }
 
+// A shared body is queued by reference when the socket is not write ready,
+// so only header bytes are copied
+TEST_F(EchoServerTest, SharedBuffer) {
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();		// Must be called after initialization
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+
+    client_->CreateSession();
+    client_->EchoServer::ConnectTest(port);
+    client_->SetSocketOptions();
+    task_util::WaitForIdle();
+    TASK_UTIL_ASSERT_TRUE((server_->GetSession() != NULL));
+
+    const char header[] = "Header";
+    std::string data(4096, 'x');
+    TcpMessageBufferPtr body(new TcpMessageBuffer(&data));
+    EXPECT_TRUE(data.empty());
+    EXPECT_EQ(4096U, body->size());
+
+    size_t sent = 0;
+    size_t copied = 0;
+    uint64_t total_copied = 0;
+    int count = 0;
+    bool res = true;
+    while (res) {
+        count++;
+        res = client_->SendParts((const u_int8_t *) header, sizeof(header),
+                                 body.get(), &sent, &copied);
+        total_copied += copied;
+    }
+    for (int i = 0 ; i < 5; i++) {
+        res = client_->SendParts((const u_int8_t *) header, sizeof(header),
+                                 body.get(), &sent, &copied);
+        EXPECT_FALSE(res);
+        EXPECT_EQ(0U, sent);
+        EXPECT_EQ(sizeof(header), copied);
+        total_copied += copied;
+        count++;
+    }
+
+    // The writer holds on to the body after it is released here
+    body.reset();
+    const io::SocketStats &stats = client_->GetSession()->GetSocketStats();
+    uint64_t bytes_copied = stats.write_bytes_copied;
+    EXPECT_LT(0U, bytes_copied);
+    EXPECT_GE(count * sizeof(header), bytes_copied);
+    // The sends returned the header bytes they copied
+    EXPECT_EQ(total_copied, bytes_copied);
+
+    size_t total = count * (sizeof(header) + 4096);
+    TASK_UTIL_ASSERT_EQ(total, server_->GetSession()->GetTotal());
+
+    // Data sent without a shared body is copied when it is queued
+    server_->GetSession()->ResetTotal();
+    char msg[4096];
+    res = true;
+    count = 0;
+    while (res) {
+        count++;
+        res = client_->Send((const u_int8_t *) msg, sizeof(msg), &sent);
+    }
+    EXPECT_EQ(bytes_copied + sizeof(msg) - sent,
+              (uint64_t) stats.write_bytes_copied);
+    TASK_UTIL_ASSERT_EQ(count * sizeof(msg),
+                        server_->GetSession()->GetTotal());
+}
+
 TEST_F(EchoServerTest, ReadInterrupt) {
     server_->Initialize(0);
     task_util::WaitForIdle();
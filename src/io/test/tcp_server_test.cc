@@ -3,6 +3,7 @@
  */
 
 #include <memory>
+#include <set>
 
 #include <pthread.h>
 #include <sys/types.h>
@@ -57,6 +58,7 @@ public:
     }
     virtual TcpSession *AllocSession(Socket *socket) {
         session_ =  new EchoSession(this, socket);
+        io_services_.insert(&socket->get_io_service());
         return session_;
     }
 
@@ -79,9 +81,13 @@ public:
     }
 
     EchoSession *GetSession() const { return session_; }
+    const set<boost::asio::io_service *> &io_services() const {
+        return io_services_;
+    }
 
 private:
     EchoSession *session_;
+    set<boost::asio::io_service *> io_services_;
 };
 
 EchoSession::EchoSession(EchoServer *server, Socket *socket)
@@ -221,6 +227,43 @@ TEST_F(EchoServerTest, Basic) {
     client.Close();
 }
 
+// Sessions are spread over the io_service pool of the event manager
+TEST_F(EchoServerTest, IoServicePool) {
+    evm_->StartIoServicePool(2);
+    EXPECT_EQ(2U, evm_->io_service_pool_size());
+    server_->Initialize(0);
+    task_util::WaitForIdle();
+    thread_->Start();		// Must be called after initialization
+    int port = server_->GetPort();
+    ASSERT_LT(0, port);
+
+    vector<TcpLocalClient *> clients;
+    for (int i = 0; i < 4; i++) {
+        TcpLocalClient *client = new TcpLocalClient(port);
+        clients.push_back(client);
+        TASK_UTIL_EXPECT_TRUE(client->Connect());
+    }
+    TASK_UTIL_EXPECT_EQ(4U, server_->GetSessionCount());
+
+    const char msg[] = "Test Message";
+    for (size_t i = 0; i < clients.size(); i++) {
+        int len = clients[i]->Send((const u_int8_t *) msg, sizeof(msg));
+        EXPECT_EQ((int) sizeof(msg), len);
+        u_int8_t data[1024];
+        int rlen = clients[i]->Recv(data, sizeof(data));
+        EXPECT_EQ(len, rlen);
+        EXPECT_EQ(0, memcmp(data, msg, rlen));
+    }
+
+    EXPECT_EQ(2U, server_->io_services().size());
+    EXPECT_EQ(0U, server_->io_services().count(evm_->io_service()));
+
+    for (size_t i = 0; i < clients.size(); i++) {
+        clients[i]->Close();
+    }
+    STLDeleteValues(&clients);
+}
+
 TEST_F(EchoServerTest, Connect) {
     EchoServer *client = new EchoServer(evm_.get());
 
@@ -10,6 +10,7 @@
 
 #include "testing/gunit.h"
 #include "base/task.h"
+#include "base/util.h"
 #include "base/test/task_test_util.h"
 #include "io/event_manager.h"
 #include "io/udp_server.h"
@@ -355,6 +356,224 @@ TEST_F(UdpRecvTest, Basic) {
     task_util::WaitForIdle();
 }
 
+class UdpBatchServer : public UdpServer {
+ public:
+    explicit UdpBatchServer(EventManager *evm) : UdpServer(evm) {
+        recv_msg_ = 0;
+        recv_batch_ = 0;
+        last_recv_usecs_ = 0;
+    }
+
+    virtual void OnReadBatch(const DatagramList &datagrams) {
+        recv_batch_++;
+        UdpServer::OnReadBatch(datagrams);
+    }
+
+    virtual void OnRead(boost::asio::const_buffer &recv_buffer,
+                        const udp::endpoint &remote_endpoint) {
+        recv_msg_++;
+        last_recv_usecs_ = ClockMonotonicUsec();
+        DeallocateBuffer(recv_buffer);
+    }
+
+    uint64_t recv_msg() const { return recv_msg_; }
+    uint64_t recv_batch() const { return recv_batch_; }
+    uint64_t last_recv_usecs() const { return last_recv_usecs_; }
+
+ private:
+    tbb::atomic<uint64_t> recv_msg_;
+    tbb::atomic<uint64_t> recv_batch_;
+    tbb::atomic<uint64_t> last_recv_usecs_;
+};
+
+class UdpBatchTest : public ::testing::Test {
+ protected:
+    static const size_t kPacketSize = 64;
+
+    UdpBatchTest() : evm_(new EventManager()) {
+    }
+    virtual void SetUp() {
+        thread_.reset(new ServerThread(evm_.get()));
+        thread_->Start();
+    }
+    virtual void TearDown() {
+        task_util::WaitForIdle();
+        evm_->Shutdown();
+        task_util::WaitForIdle();
+        if (thread_.get() != NULL) {
+            thread_->Join();
+        }
+        task_util::WaitForIdle();
+    }
+
+    // Number of datagrams sent by the benchmark. Can be overridden with
+    // UDP_IO_TEST_PACKETS.
+    static size_t PacketCount() {
+        char *str = getenv("UDP_IO_TEST_PACKETS");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 200 * 1000;
+    }
+
+    static uint64_t TxCalls(const UdpServer *server) {
+        SocketIOStats tx_stats;
+        server->GetTxSocketStats(tx_stats);
+        return tx_stats.calls;
+    }
+
+    void DeleteServer(UdpServer *server) {
+        server->Shutdown();
+        task_util::WaitForIdle();
+        UdpServerManager::DeleteServer(server);
+        task_util::WaitForIdle();
+    }
+
+    // Sends count datagrams from client to ep, batch_size at a time, and
+    // keeps at most kMaxOutstanding unbatched sends in progress
+    void Send(UdpServer *client, const udp::endpoint &ep, size_t count,
+              size_t batch_size) {
+        static const uint64_t kMaxOutstanding = 1024;
+        UdpServer::DatagramList datagrams;
+        for (size_t i = 0; i < count; i++) {
+            mutable_buffer b = client->AllocateBuffer(kPacketSize);
+            memset(buffer_cast<uint8_t *>(b), i & 0xff, kPacketSize);
+            datagrams.push_back(UdpServer::Datagram(
+                boost::asio::const_buffer(buffer_cast<const uint8_t *>(b),
+                                          kPacketSize), ep));
+            if (datagrams.size() < batch_size && i + 1 < count)
+                continue;
+            if (batch_size > 1) {
+                client->StartSendBatch(datagrams);
+            } else {
+                client->StartSend(ep, kPacketSize, datagrams[0].buffer);
+            }
+            datagrams.clear();
+            const io::SocketStats &stats = client->GetSocketStats();
+            while (stats.write_calls + stats.write_errors + kMaxOutstanding
+                   < i + 1) {
+                usleep(10);
+            }
+        }
+    }
+
+    // Returns the number of datagrams received per second when sending
+    // PacketCount() datagrams over loopback, with send and receive batches
+    // of batch_size
+    uint64_t Benchmark(size_t batch_size, uint64_t *received) {
+        UdpBatchServer *server = new UdpBatchServer(evm_.get());
+        server->set_batch_size(batch_size);
+        server->Initialize("127.0.0.1", 0);
+        server->StartReceive();
+        UdpServer *client = new UdpServer(evm_.get());
+        client->Initialize("127.0.0.1", 0);
+        boost::system::error_code ec;
+        udp::endpoint ep = server->GetLocalEndpoint(&ec);
+
+        uint64_t start = ClockMonotonicUsec();
+        Send(client, ep, PacketCount(), batch_size);
+        // Wait for the datagrams that were not dropped
+        uint64_t count;
+        do {
+            count = server->recv_msg();
+            usleep(100 * 1000);
+        } while (count != server->recv_msg());
+        uint64_t elapsed = server->last_recv_usecs() - start;
+
+        *received = count;
+        DeleteServer(client);
+        DeleteServer(server);
+        if (elapsed == 0)
+            return 0;
+        return count * 1000 * 1000 / elapsed;
+    }
+
+    std::auto_ptr<ServerThread> thread_;
+    std::auto_ptr<EventManager> evm_;
+};
+
+TEST_F(UdpBatchTest, Receive) {
+    UdpBatchServer *server = new UdpBatchServer(evm_.get());
+    server->set_batch_size(16);
+    EXPECT_EQ(16U, server->batch_size());
+    server->Initialize(0);
+    server->StartReceive();
+    boost::system::error_code ec;
+    udp::endpoint ep = server->GetLocalEndpoint(&ec);
+    UdpLocalClient client(ep.port());
+    TASK_UTIL_EXPECT_TRUE(client.Connect());
+    const char msg[] = "Test Message";
+    int len = 0;
+    for (int i = 0; i < 100; i++) {
+        len += client.Send((const u_int8_t *) msg, sizeof(msg));
+    }
+    TASK_UTIL_EXPECT_EQ(100U, server->recv_msg());
+    EXPECT_LE(1U, server->recv_batch());
+    EXPECT_GE(100U, server->recv_batch());
+    SocketIOStats rx_stats;
+    server->GetRxSocketStats(rx_stats);
+    EXPECT_EQ(100, rx_stats.calls);
+    EXPECT_EQ(len, rx_stats.bytes);
+    client.Close();
+    DeleteServer(server);
+}
+
+// More datagrams than there are buffers in the ring, which are reused once
+// OnRead() releases them
+TEST_F(UdpBatchTest, RingReuse) {
+    UdpBatchServer *server = new UdpBatchServer(evm_.get());
+    server->set_batch_size(2);
+    server->Initialize("127.0.0.1", 0);
+    server->StartReceive();
+    UdpServer *client = new UdpServer(evm_.get());
+    client->Initialize("127.0.0.1", 0);
+    boost::system::error_code ec;
+    udp::endpoint ep = server->GetLocalEndpoint(&ec);
+    size_t count = 20 * UdpServer::kBatchRingFactor;
+    for (size_t i = 0; i < count; i++) {
+        Send(client, ep, 1, 4);
+        TASK_UTIL_EXPECT_EQ(i + 1, server->recv_msg());
+    }
+    DeleteServer(client);
+    DeleteServer(server);
+}
+
+TEST_F(UdpBatchTest, SendBatch) {
+    UdpBatchServer *server = new UdpBatchServer(evm_.get());
+    server->Initialize("127.0.0.1", 0);
+    server->StartReceive();
+    UdpServer *client = new UdpServer(evm_.get());
+    client->Initialize("127.0.0.1", 0);
+    boost::system::error_code ec;
+    udp::endpoint ep = server->GetLocalEndpoint(&ec);
+    Send(client, ep, 100, UdpServer::kMaxBatchSize + 1);
+    TASK_UTIL_EXPECT_EQ(100U, server->recv_msg());
+    EXPECT_EQ(0U, server->recv_batch());
+    TASK_UTIL_EXPECT_EQ(100U, TxCalls(client));
+    SocketIOStats tx_stats;
+    client->GetTxSocketStats(tx_stats);
+    EXPECT_EQ(100U * kPacketSize, tx_stats.bytes);
+    DeleteServer(client);
+    DeleteServer(server);
+}
+
+// Compare the rate at which datagrams are received over loopback with and
+// without batching
+TEST_F(UdpBatchTest, Benchmark) {
+    uint64_t received, batched_received;
+    uint64_t pps = Benchmark(1, &received);
+    uint64_t batched_pps = Benchmark(UdpServer::kDefaultBatchSize,
+                                     &batched_received);
+    std::cout << PacketCount() << " datagrams of " << kPacketSize
+              << " bytes" << std::endl;
+    std::cout << "Unbatched : " << received << " received, " << pps
+              << " packets/sec" << std::endl;
+    std::cout << "Batched   : " << batched_received << " received, "
+              << batched_pps << " packets/sec" << std::endl;
+    EXPECT_LT(0U, received);
+    EXPECT_LT(0U, batched_received);
+}
+
 }  // namespace
 
 int main(int argc, char **argv) {
@@ -2,6 +2,11 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <map>
 #include <boost/bind.hpp>
 #include <base/logging.h>
 #include <io/udp_server.h>
@@ -14,6 +19,9 @@ using boost::asio::mutable_buffers_1;
 using boost::asio::const_buffer;
 using boost::asio::ip::udp;
 
+const size_t UdpServer::kDefaultBatchSize;
+const size_t UdpServer::kMaxBatchSize;
+const size_t UdpServer::kBatchRingFactor;
 int UdpServer::reader_task_id_ = -1;
 
 class UdpServer::Reader : public Task {
@@ -40,11 +48,34 @@ private:
     const_buffer buffer_;
 };
 
+class UdpServer::BatchReader : public Task {
+public:
+    BatchReader(UdpServerPtr server, int instance, DatagramList *datagrams)
+        : Task(server->reader_task_id(), instance),
+        server_(server) {
+        datagrams_.swap(*datagrams);
+    }
+
+    virtual bool Run() {
+        if (server_->GetServerState() == OK) {
+            server_->OnReadBatch(datagrams_);
+        }
+        return true;
+    }
+
+private:
+    UdpServerPtr server_;
+    DatagramList datagrams_;
+};
+
 UdpServer::UdpServer(boost::asio::io_service *io_service, int buffer_size):
     socket_(*io_service),
     buffer_size_(buffer_size),
     state_(Uninitialized),
-    evm_(NULL) {
+    evm_(NULL),
+    batch_size_(1),
+    ring_(NULL),
+    ring_size_(0) {
     if (reader_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         reader_task_id_ = scheduler->GetTaskId("io::udp::ReaderTask");
@@ -57,7 +88,10 @@ UdpServer::UdpServer(EventManager *evm, int buffer_size):
     socket_(*(evm->io_service())),
     buffer_size_(buffer_size),
     state_(Uninitialized),
-    evm_(evm) {
+    evm_(evm),
+    batch_size_(1),
+    ring_(NULL),
+    ring_size_(0) {
     if (reader_task_id_ == -1) {
         TaskScheduler *scheduler = TaskScheduler::GetInstance();
         reader_task_id_ = scheduler->GetTaskId("io::udp::ReaderTask");
@@ -81,6 +115,7 @@ UdpServer::~UdpServer() {
     assert(state_ == Uninitialized || state_ == SocketOpenFailed ||
            state_ == SocketBindFailed);
     assert(pbuf_.empty());
+    delete[] ring_;
 }
 
 void UdpServer::Shutdown() {
@@ -149,6 +184,26 @@ bool UdpServer::Initialize(udp::endpoint local_endpoint) {
     return true;
 }
 
+void UdpServer::set_batch_size(size_t batch_size) {
+    batch_size = std::max(batch_size, static_cast<size_t>(1));
+    batch_size = std::min(batch_size, kMaxBatchSize);
+    tbb::mutex::scoped_lock lock(mutex_);
+    assert(ring_ == NULL);
+    batch_size_ = batch_size;
+    if (batch_size_ == 1)
+        return;
+    ring_size_ = batch_size_ * kBatchRingFactor;
+    ring_ = new u_int8_t[ring_size_ * buffer_size_];
+    ring_free_.reserve(ring_size_);
+    for (size_t i = 0; i < ring_size_; i++) {
+        ring_free_.push_back(ring_ + i * buffer_size_);
+    }
+}
+
+bool UdpServer::IsRingBuffer(const u_int8_t *p) const {
+    return (p >= ring_ && p < ring_ + ring_size_ * buffer_size_);
+}
+
 mutable_buffer UdpServer::AllocateBuffer(std::size_t s) {
     u_int8_t *p = new u_int8_t[s];
     {
@@ -166,6 +221,10 @@ void UdpServer::DeallocateBuffer(const_buffer &buffer) {
     const u_int8_t *p = buffer_cast<const uint8_t *>(buffer);
     {
         tbb::mutex::scoped_lock lock(mutex_);
+        if (ring_ != NULL && IsRingBuffer(p)) {
+            ring_free_.push_back(const_cast<u_int8_t *>(p));
+            return;
+        }
         std::vector<u_int8_t *>::iterator f = std::find(pbuf_.begin(),
             pbuf_.end(), p);
         if (f != pbuf_.end())
@@ -190,6 +249,62 @@ void UdpServer::StartSend(udp::endpoint ep, std::size_t bytes_to_send,
     }
 }
 
+void UdpServer::StartSendBatch(const DatagramList &datagrams) {
+    if (state_ != OK) {
+        stats_.write_errors += datagrams.size();
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_NA,
+            "StartSendBatch UDP server in WRONG state: " << state_);
+        for (DatagramList::const_iterator it = datagrams.begin();
+             it != datagrams.end(); ++it) {
+            const_buffer buffer(it->buffer);
+            DeallocateBuffer(buffer);
+        }
+        return;
+    }
+
+    size_t sent = 0;
+#if defined(__linux__)
+    struct mmsghdr msgs[kMaxBatchSize];
+    struct iovec iov[kMaxBatchSize];
+    while (sent < datagrams.size()) {
+        size_t count = std::min(datagrams.size() - sent, kMaxBatchSize);
+        memset(msgs, 0, count * sizeof(msgs[0]));
+        for (size_t i = 0; i < count; i++) {
+            const Datagram &datagram = datagrams[sent + i];
+            iov[i].iov_base = const_cast<uint8_t *>(
+                buffer_cast<const uint8_t *>(datagram.buffer));
+            iov[i].iov_len = buffer_size(datagram.buffer);
+            msgs[i].msg_hdr.msg_name = const_cast<struct sockaddr *>(
+                datagram.remote_endpoint.data());
+            msgs[i].msg_hdr.msg_namelen = datagram.remote_endpoint.size();
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int res = sendmmsg(socket_.native_handle(), msgs, count,
+                           MSG_DONTWAIT);
+        if (res <= 0)
+            break;
+        for (int i = 0; i < res; i++) {
+            const Datagram &datagram = datagrams[sent + i];
+            stats_.write_calls++;
+            stats_.write_bytes += msgs[i].msg_len;
+            HandleSend(datagram.buffer, datagram.remote_endpoint,
+                       msgs[i].msg_len, boost::system::error_code());
+        }
+        sent += res;
+        if (static_cast<size_t>(res) < count)
+            break;
+    }
+#endif
+
+    // Datagrams that could not be sent right away are sent one at a time
+    for (; sent < datagrams.size(); sent++) {
+        const Datagram &datagram = datagrams[sent];
+        StartSend(datagram.remote_endpoint, buffer_size(datagram.buffer),
+                  datagram.buffer);
+    }
+}
+
 void UdpServer::HandleSendInternal(const_buffer send_buffer,
     udp::endpoint remote_endpoint, std::size_t bytes_transferred,
     const boost::system::error_code& error) {
@@ -215,7 +330,9 @@ void UdpServer::HandleSendInternal(const_buffer send_buffer,
 }
 
 void UdpServer::StartReceive() {
-    if (state_ == OK) {
+    if (state_ == OK && batch_size_ > 1) {
+        StartReceiveBatch();
+    } else if (state_ == OK) {
         mutable_buffer b(AllocateBuffer());
         const_buffer buffer(buffer_cast<const uint8_t*>(b),
                             buffer_size(b));
@@ -268,6 +385,146 @@ void UdpServer::HandleReceive(const_buffer &recv_buffer,
     scheduler->Enqueue(task);
 }
 
+void UdpServer::StartReceiveBatch() {
+    socket_.async_receive(boost::asio::null_buffers(),
+        boost::bind(&UdpServer::HandleReceiveBatchInternal,
+            UdpServerPtr(this), boost::asio::placeholders::error));
+}
+
+//
+// Reads the datagrams queued on the socket, up to the batch size, into free
+// ring buffers. If the ring is exhausted because the readers are behind, a
+// single datagram is read into a buffer from the heap.
+//
+size_t UdpServer::ReceiveBatch(DatagramList *datagrams,
+                               boost::system::error_code *error) {
+    u_int8_t *buffers[kMaxBatchSize];
+    size_t count = 0;
+    {
+        tbb::mutex::scoped_lock lock(mutex_);
+        while (count < batch_size_ && !ring_free_.empty()) {
+            buffers[count++] = ring_free_.back();
+            ring_free_.pop_back();
+        }
+    }
+    if (count == 0) {
+        buffers[count++] = buffer_cast<u_int8_t *>(AllocateBuffer());
+    }
+
+    size_t received = 0;
+#if defined(__linux__)
+    struct mmsghdr msgs[kMaxBatchSize];
+    struct iovec iov[kMaxBatchSize];
+    struct sockaddr_storage addrs[kMaxBatchSize];
+    memset(msgs, 0, count * sizeof(msgs[0]));
+    for (size_t i = 0; i < count; i++) {
+        iov[i].iov_base = buffers[i];
+        iov[i].iov_len = buffer_size_;
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(addrs[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    int res = recvmmsg(socket_.native_handle(), msgs, count, MSG_DONTWAIT,
+                       NULL);
+    if (res < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        *error = boost::system::error_code(errno,
+            boost::asio::error::get_system_category());
+    }
+    for (int i = 0; i < res; i++) {
+        udp::endpoint remote_endpoint;
+        memcpy(remote_endpoint.data(), &addrs[i],
+               msgs[i].msg_hdr.msg_namelen);
+        remote_endpoint.resize(msgs[i].msg_hdr.msg_namelen);
+        datagrams->push_back(Datagram(
+            const_buffer(buffers[i], msgs[i].msg_len), remote_endpoint));
+        received++;
+    }
+#else
+    while (received < count && socket_.available(*error) > 0 && !*error) {
+        udp::endpoint remote_endpoint;
+        size_t bytes = socket_.receive_from(
+            boost::asio::buffer(buffers[received], buffer_size_),
+            remote_endpoint, 0, *error);
+        if (*error)
+            break;
+        datagrams->push_back(Datagram(
+            const_buffer(buffers[received], bytes), remote_endpoint));
+        received++;
+    }
+#endif
+
+    for (size_t i = received; i < count; i++) {
+        const_buffer buffer(buffers[i], buffer_size_);
+        DeallocateBuffer(buffer);
+    }
+    return received;
+}
+
+void UdpServer::HandleReceiveBatchInternal(
+    const boost::system::error_code& error) {
+    if (state_ != OK) {
+        stats_.read_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN,
+            "Receive UDP server in WRONG state: " << state_);
+        return;
+    }
+    if (error) {
+        stats_.read_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN,
+            "Read FAILED due to error: " << error.value() << " : " <<
+            error.message());
+        StartReceive();
+        return;
+    }
+
+    DatagramList datagrams;
+    boost::system::error_code ec;
+    ReceiveBatch(&datagrams, &ec);
+    if (ec) {
+        stats_.read_errors++;
+        UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN,
+            "Read FAILED due to error: " << ec.value() << " : " <<
+            ec.message());
+    }
+    if (!datagrams.empty()) {
+        // Update read statistics, per datagram as in the unbatched mode.
+        stats_.read_calls += datagrams.size();
+        for (DatagramList::const_iterator it = datagrams.begin();
+             it != datagrams.end(); ++it) {
+            stats_.read_bytes += buffer_size(it->buffer);
+        }
+        // Call the handler
+        HandleReceiveBatch(datagrams);
+    }
+    StartReceive();
+}
+
+void UdpServer::HandleReceiveBatch(const DatagramList &datagrams) {
+    // Datagrams that the derived class wants read in the same task instance
+    // are passed to one task
+    typedef std::map<int, DatagramList> InstanceMap;
+    InstanceMap instance_map;
+    for (DatagramList::const_iterator it = datagrams.begin();
+         it != datagrams.end(); ++it) {
+        instance_map[reader_task_instance(it->remote_endpoint)].push_back(*it);
+    }
+    TaskScheduler *scheduler = TaskScheduler::GetInstance();
+    for (InstanceMap::iterator it = instance_map.begin();
+         it != instance_map.end(); ++it) {
+        scheduler->Enqueue(new BatchReader(UdpServerPtr(this), it->first,
+                                           &it->second));
+    }
+}
+
+void UdpServer::OnReadBatch(const DatagramList &datagrams) {
+    for (DatagramList::const_iterator it = datagrams.begin();
+         it != datagrams.end(); ++it) {
+        const_buffer buffer(it->buffer);
+        OnRead(buffer, it->remote_endpoint);
+    }
+}
+
 void UdpServer::OnRead(const_buffer &recv_buffer,
     const udp::endpoint &remote_endpoint) {
     UDP_SERVER_LOG_ERROR(this, UDP_DIR_IN, "Receive UDP: " <<
@@ -24,6 +24,21 @@ class UdpServer {
         SocketBindFailed,
     };
     static const int kDefaultBufferSize = 4 * 1024;
+    static const size_t kDefaultBatchSize = 32;
+    static const size_t kMaxBatchSize = 64;
+    // Receive buffers in the ring, as a multiple of the batch size
+    static const size_t kBatchRingFactor = 8;
+
+    // Datagram received from, or to be sent to, remote_endpoint
+    struct Datagram {
+        Datagram(boost::asio::const_buffer buffer,
+                 const boost::asio::ip::udp::endpoint &remote_endpoint)
+            : buffer(buffer), remote_endpoint(remote_endpoint) {
+        }
+        boost::asio::const_buffer buffer;
+        boost::asio::ip::udp::endpoint remote_endpoint;
+    };
+    typedef std::vector<Datagram> DatagramList;
 
     explicit UdpServer(EventManager *evm, int buffer_size = kDefaultBufferSize);
     explicit UdpServer(boost::asio::io_service *io_service,
@@ -39,6 +54,18 @@ class UdpServer {
     void StartSend(boost::asio::ip::udp::endpoint ep, std::size_t bytes_to_send,
             boost::asio::const_buffer buffer);
     void StartReceive();
+    // Sends the datagrams with as few system calls as possible. The buffers
+    // are owned by the server, as with StartSend(). HandleSend() is called
+    // from this function for the datagrams that could be sent right away,
+    // and from the io thread for the rest.
+    void StartSendBatch(const DatagramList &datagrams);
+    // Batched receive mode, which must be enabled before StartReceive().
+    // With a batch size larger than 1 the server waits for the socket to be
+    // readable and reads up to batch_size datagrams at once into buffers
+    // from a preallocated ring. The datagrams are passed together to
+    // HandleReceiveBatch(), and HandleReceive() is not called.
+    void set_batch_size(size_t batch_size);
+    size_t batch_size() const { return batch_size_; }
     // state
     ServerState GetServerState() { return state_; }
     boost::asio::ip::udp::endpoint GetLocalEndpoint(
@@ -65,6 +92,12 @@ class UdpServer {
             const boost::system::error_code& error);
     virtual void OnRead(boost::asio::const_buffer &recv_buffer,
         const boost::asio::ip::udp::endpoint &remote_endpoint);
+    // Batched mode counterparts of HandleReceive() and OnRead(). The default
+    // HandleReceiveBatch() runs one reader task per reader_task_instance()
+    // of the datagrams, which calls OnReadBatch() with the datagrams for the
+    // instance. The default OnReadBatch() calls OnRead() for each datagram.
+    virtual void HandleReceiveBatch(const DatagramList &datagrams);
+    virtual void OnReadBatch(const DatagramList &datagrams);
     virtual int reader_task_id() const {
         return reader_task_id_;
     }
@@ -86,6 +119,7 @@ class UdpServer {
 
  private:
     class Reader;
+    class BatchReader;
     friend void intrusive_ptr_add_ref(UdpServer *server);
     friend void intrusive_ptr_release(UdpServer *server);
     virtual void SetName(boost::asio::ip::udp::endpoint ep);
@@ -97,6 +131,11 @@ class UdpServer {
             boost::asio::ip::udp::endpoint remote_endpoint,
             std::size_t bytes_transferred,
             const boost::system::error_code& error);
+    void StartReceiveBatch();
+    void HandleReceiveBatchInternal(const boost::system::error_code& error);
+    size_t ReceiveBatch(DatagramList *datagrams,
+                        boost::system::error_code *error);
+    bool IsRingBuffer(const u_int8_t *p) const;
 
     static int reader_task_id_;
     boost::asio::ip::udp::socket socket_;
@@ -107,6 +146,10 @@ class UdpServer {
     boost::asio::ip::udp::endpoint remote_endpoint_;
     tbb::mutex mutex_;
     std::vector<u_int8_t *> pbuf_;
+    size_t batch_size_;
+    u_int8_t *ring_;
+    size_t ring_size_;
+    std::vector<u_int8_t *> ring_free_;
     tbb::atomic<int> refcount_;
     io::SocketStats stats_;
 
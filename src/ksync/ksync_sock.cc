@@ -39,6 +39,10 @@
 
 using namespace boost::asio;
 
+// Room left in a kBufLen bulk message for the netlink headers
+static const uint32_t kBulkMsgBufLen = KSyncSock::kBufLen -
+    (NLMSG_HDRLEN + GENL_HDRLEN + NLA_HDRLEN);
+
 /* Note SO_RCVBUFFORCE is supported only for linux version 2.6.14 and above */
 typedef boost::asio::detail::socket_option::integer<SOL_SOCKET,
         SO_RCVBUFFORCE> ReceiveBuffForceSize;
@@ -166,13 +170,17 @@ void KSyncSockNetlink::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
     struct nlmsghdr *nlh = (struct nlmsghdr *)cl.cl_buf;
     nlh->nlmsg_pid = KSyncSock::GetPid();
     nlh->nlmsg_seq = ioc->GetSeqno();
+    if (ioc->IsBulk()) {
+        nlh->nlmsg_flags |= NLM_F_MULTI;
+    }
 
     boost::asio::netlink::raw::endpoint ep;
     sock_.async_send_to(iovec, ep, cb);
     free(cl.cl_buf);
 }
 
-size_t KSyncSockNetlink::SendTo(const_buffers_1 buf, uint32_t seq_no) {
+size_t KSyncSockNetlink::SendTo(const_buffers_1 buf, uint32_t seq_no,
+                                bool bulk) {
     struct nl_client cl;
     unsigned char *nl_buf;
     uint32_t nl_buf_len;
@@ -194,6 +202,9 @@ size_t KSyncSockNetlink::SendTo(const_buffers_1 buf, uint32_t seq_no) {
     struct nlmsghdr *nlh = (struct nlmsghdr *)cl.cl_buf;
     nlh->nlmsg_pid = KSyncSock::GetPid();
     nlh->nlmsg_seq = seq_no;
+    if (bulk) {
+        nlh->nlmsg_flags |= NLM_F_MULTI;
+    }
 
     boost::asio::netlink::raw::endpoint ep;
     size_t ret_val = sock_.send_to(iovec, ep);
@@ -259,7 +270,7 @@ void KSyncSockUdp::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
     struct uvr_msg_hdr hdr;
     std::vector<mutable_buffers_1> iovec;
     hdr.seq_no = ioc->GetSeqno();
-    hdr.flags = 0;
+    hdr.flags = ioc->IsBulk() ? UVR_MORE : 0;
     hdr.msg_len = buffer_size(buf);
 
     iovec.push_back(buffer((char *)(&hdr), sizeof(hdr)));
@@ -268,11 +279,11 @@ void KSyncSockUdp::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
     sock_.async_send_to(iovec, server_ep_, cb);
 }
 
-size_t KSyncSockUdp::SendTo(const_buffers_1 buf, uint32_t seq_no) {
+size_t KSyncSockUdp::SendTo(const_buffers_1 buf, uint32_t seq_no, bool bulk) {
     struct uvr_msg_hdr hdr;
     std::vector<const_buffers_1> iovec;
     hdr.seq_no = seq_no;
-    hdr.flags = 0;
+    hdr.flags = bulk ? UVR_MORE : 0;
     hdr.msg_len = buffer_size(buf);
 
     iovec.push_back(buffer((const char *)(&hdr), sizeof(hdr)));
@@ -292,7 +303,9 @@ void KSyncSockUdp::Receive(mutable_buffers_1 buf) {
     sock_.receive_from(buf, ep);
 }
 
-KSyncSock::KSyncSock() : tx_count_(0), err_count_(0), run_sync_mode_(true) {
+KSyncSock::KSyncSock() : tx_count_(0), err_count_(0), run_sync_mode_(true),
+    bulk_mode_(false), bulk_send_count_(0), bulk_msg_count_(0),
+    bulk_bytes_(0), bulk_max_msg_count_(0) {
     for(int i = 0; i < IoContext::MAX_WORK_QUEUES; i++) {
         receive_work_queue[i] = new WorkQueue<char *>(TaskScheduler::GetInstance()->
                              GetTaskId(IoContext::io_wq_names[i]), 0,
@@ -342,6 +355,52 @@ void KSyncSock::Start(bool run_sync_mode) {
     }
 }
 
+void KSyncSock::SetBulkMode(bool enable) {
+    for (std::vector<KSyncSock *>::iterator it = sock_table_.begin();
+         it != sock_table_.end(); ++it) {
+        KSyncSock *sock = *it;
+        bool bulk = enable;
+        if (bulk && !sock->BulkSupported()) {
+            LOG(INFO, "Bulk messages not supported by vrouter, sending "
+                "one message per request");
+            bulk = false;
+        }
+        sock->bulk_mode_ = bulk;
+        if (bulk) {
+            sock->async_send_queue_->SetBatchCallback(
+                boost::bind(&KSyncSock::SendBulkImpl, sock, _1),
+                kBulkBatchSize);
+        } else {
+            sock->async_send_queue_->SetBatchCallback(
+                WorkQueue<IoContext *>::BatchCallback());
+        }
+    }
+}
+
+void KSyncSockBulkStatsReq::HandleRequest() const {
+    std::vector<KSyncSockBulkStats> list;
+    for (size_t i = 0; i < KSyncSock::sock_table_.size(); i++) {
+        KSyncSock *sock = KSyncSock::sock_table_[i];
+        if (sock == NULL) {
+            continue;
+        }
+        KSyncSockBulkStats stats;
+        stats.set_index(i);
+        stats.set_bulk_mode(sock->bulk_mode());
+        stats.set_bulk_send_count(sock->bulk_send_count());
+        stats.set_bulk_msg_count(sock->bulk_msg_count());
+        stats.set_bulk_bytes(sock->bulk_bytes());
+        stats.set_bulk_max_msg_count(sock->bulk_max_msg_count());
+        list.push_back(stats);
+    }
+
+    KSyncSockBulkStatsResp *resp = new KSyncSockBulkStatsResp();
+    resp->set_sock_list(list);
+    resp->set_context(context());
+    resp->set_more(false);
+    resp->Response();
+}
+
 void KSyncSock::SetSockTableEntry(int i, KSyncSock *sock) {
     sock_table_[i] = sock;
 }
@@ -418,12 +477,8 @@ bool KSyncSock::ValidateAndEnqueue(char *data) {
     return true;
 }
 
-// Process kernel data - executes in the task specified by IoContext
-// Currently only Agent::KSync and Agent::Uve are possibilities
-bool KSyncSock::ProcessKernelData(char *data) {
-    Tree::iterator it = GetIoContext(data);
-    IoContext *context = it.operator->();
-
+// Decode a response message for context
+void KSyncSock::DecodeResponse(IoContext *context, char *data) {
     AgentSandeshContext *ctxt = context->GetSandeshContext();
     ctxt->SetErrno(0);
     ctxt->set_ksync_io_ctx(static_cast<KSyncIoContext *>(context));
@@ -432,6 +487,39 @@ bool KSyncSock::ProcessKernelData(char *data) {
     if (ctxt->GetErrno() != 0) {
         context->ErrorHandler(ctxt->GetErrno());
     }
+}
+
+// Each part of a bulk response completes the next IoContext in the bulk
+// message. The final NLMSG_DONE is handled like any other end of response
+void KSyncSock::ProcessBulkData(KSyncBulkIoContext *bulk, char *data) {
+    if (!IsMoreData(data)) {
+        return;
+    }
+
+    IoContext *context = bulk->NextContext();
+    if (context == NULL) {
+        LOG(ERROR, "Unexpected response for bulk message with seqno "
+            << bulk->GetSeqno() << ". Message count "
+            << bulk->GetMsgCount());
+        return;
+    }
+
+    DecodeResponse(context, data);
+    context->Handler();
+    delete context;
+}
+
+// Process kernel data - executes in the task specified by IoContext
+// Currently only Agent::KSync and Agent::Uve are possibilities
+bool KSyncSock::ProcessKernelData(char *data) {
+    Tree::iterator it = GetIoContext(data);
+    IoContext *context = it.operator->();
+
+    if (context->IsBulk()) {
+        ProcessBulkData(static_cast<KSyncBulkIoContext *>(context), data);
+    } else {
+        DecodeResponse(context, data);
+    }
 
     if (!IsMoreData(data)) {
         context->Handler();
@@ -469,7 +557,7 @@ KSyncSock *KSyncSock::Get(int idx) {
 }
 
 size_t KSyncSock::BlockingSend(const char *msg, int msg_len) {
-    return SendTo(buffer(msg, msg_len), 0);
+    return SendTo(buffer(msg, msg_len), 0, false);
 }
 
 bool KSyncSock::BlockingRecv() {
@@ -518,7 +606,7 @@ bool KSyncSock::SendAsyncImpl(IoContext *ioc) {
                                 placeholders::bytes_transferred));
     } else {
         SendTo(boost::asio::buffer((const char *)ioc->GetMsg(),
-                    ioc->GetMsgLen()), ioc->GetSeqno());
+                    ioc->GetMsgLen()), ioc->GetSeqno(), ioc->IsBulk());
         bool more_data = false;
         do {
             char *rxbuf = new char[kBufLen];
@@ -530,6 +618,99 @@ bool KSyncSock::SendAsyncImpl(IoContext *ioc) {
     return true;
 }
 
+// Batch callback for async_send_queue_ in bulk mode. Consecutive messages
+// that allow bulk are packed together, others are sent as they are
+bool KSyncSock::SendBulkImpl(WorkQueue<IoContext *>::EntryList &list) {
+    KSyncBulkIoContext::IoContextList bulk_list;
+    uint32_t bulk_len = 0;
+
+    for (WorkQueue<IoContext *>::EntryList::iterator it = list.begin();
+         it != list.end(); ++it) {
+        IoContext *ioc = *it;
+        if (ioc->AllowBulk() == false) {
+            SendBulk(&bulk_list, bulk_len);
+            bulk_len = 0;
+            SendAsyncImpl(ioc);
+            continue;
+        }
+
+        if (bulk_list.size() &&
+            (bulk_len + ioc->GetMsgLen() > kBulkMsgBufLen)) {
+            SendBulk(&bulk_list, bulk_len);
+            bulk_len = 0;
+        }
+        bulk_list.push_back(ioc);
+        bulk_len += ioc->GetMsgLen();
+    }
+    SendBulk(&bulk_list, bulk_len);
+    return true;
+}
+
+// Send the IoContexts in list as one bulk message of len bytes
+void KSyncSock::SendBulk(KSyncBulkIoContext::IoContextList *list,
+                         uint32_t len) {
+    if (list->empty()) {
+        return;
+    }
+
+    // Nothing to gain in wrapping a single message
+    if (list->size() == 1) {
+        SendAsyncImpl(list->front());
+        list->clear();
+        return;
+    }
+
+    char *msg = (char *)malloc(len);
+    uint32_t offset = 0;
+    for (KSyncBulkIoContext::IoContextList::iterator it = list->begin();
+         it != list->end(); ++it) {
+        memcpy(msg + offset, (*it)->GetMsg(), (*it)->GetMsgLen());
+        offset += (*it)->GetMsgLen();
+    }
+
+    bulk_send_count_++;
+    bulk_msg_count_ += list->size();
+    bulk_bytes_ += len;
+    if (list->size() > bulk_max_msg_count_) {
+        bulk_max_msg_count_ = list->size();
+    }
+
+    KSyncBulkIoContext *bulk =
+        new KSyncBulkIoContext(msg, len, AllocSeqNo(false), list);
+    SendAsyncImpl(bulk);
+}
+
+KSyncBulkIoContext::KSyncBulkIoContext(char *msg, uint32_t len,
+                                       uint32_t seqno, IoContextList *list) :
+    IoContext(msg, len, seqno, KSyncSock::GetAgentSandeshContext()),
+    next_(0) {
+    list_.swap(*list);
+}
+
+KSyncBulkIoContext::~KSyncBulkIoContext() {
+    for (size_t i = next_; i < list_.size(); i++) {
+        delete list_[i];
+    }
+}
+
+IoContext *KSyncBulkIoContext::NextContext() {
+    if (next_ == list_.size()) {
+        return NULL;
+    }
+    return list_[next_++];
+}
+
+void KSyncBulkIoContext::Handler() {
+    while (IoContext *context = NextContext()) {
+        LOG(ERROR, "No response for message with seqno "
+            << context->GetSeqno() << " in bulk message with seqno "
+            << GetSeqno());
+        context->ErrorHandler(EIO);
+        context->Handler();
+        delete context;
+    }
+}
+
 KSyncIoContext::KSyncIoContext(KSyncEntry *sync_entry, int msg_len,
                                char *msg, uint32_t seqno,
                                KSyncEntry::KSyncEvent event) :
@@ -92,6 +92,12 @@ public:
     virtual void Handler() {};
     virtual void ErrorHandler(int err) {};
 
+    // True if the message can be packed with others into a bulk message.
+    // The responder must then send exactly one response message for it.
+    virtual bool AllowBulk() const { return false; }
+    // True for the context carrying a bulk message
+    virtual bool IsBulk() const { return false; }
+
     AgentSandeshContext *GetSandeshContext() { return ctx_; }
     IoContextWorkQId GetWorkQId() { return work_q_id_; }
 
@@ -121,11 +127,42 @@ public:
     void ErrorHandler(int err);
     const KSyncEntry *GetKSyncEntry() const {return entry_;};
     KSyncEntry::KSyncEvent event() const {return event_;}
+    virtual bool AllowBulk() const { return true; }
 private:
     KSyncEntry *entry_;
     KSyncEntry::KSyncEvent event_;
 };
 
+/* IoContext for a bulk message. The message is the concatenation of the
+ * messages of a list of IoContexts and is sent with a seqno of its own.
+ *
+ * The responder sends one NLM_F_MULTI response per packed message, in the
+ * order they were packed, followed by NLMSG_DONE. Each response is handed
+ * to the next IoContext in the list.
+ */
+class KSyncBulkIoContext : public IoContext {
+public:
+    typedef std::vector<IoContext *> IoContextList;
+
+    KSyncBulkIoContext(char *msg, uint32_t len, uint32_t seqno,
+                       IoContextList *list);
+    virtual ~KSyncBulkIoContext();
+
+    virtual bool IsBulk() const { return true; }
+    // Invoked on NLMSG_DONE. Completes IoContexts that got no response
+    virtual void Handler();
+
+    // Returns the IoContext owning the next response. Ownership passes to
+    // the caller
+    IoContext *NextContext();
+    size_t GetMsgCount() const { return list_.size(); }
+
+private:
+    IoContextList list_;
+    size_t next_;
+    DISALLOW_COPY_AND_ASSIGN(KSyncBulkIoContext);
+};
+
 typedef boost::intrusive::member_hook<IoContext,
         boost::intrusive::set_member_hook<>,
         &IoContext::node_> KSyncSockNode;
@@ -135,6 +172,8 @@ class KSyncSock {
 public:
     const static int kMsgGrowSize = 16;
     const static unsigned kBufLen = 4096;
+    // Max number of messages taken off the send queue to pack in bulk mode
+    const static int kBulkBatchSize = 32;
 
     typedef boost::function<void(const boost::system::error_code &, size_t)> HandlerCb;
     KSyncSock();
@@ -143,6 +182,10 @@ public:
     // Start Ksync Asio operations
     static void Start(bool run_sync_mode);
     static void Shutdown();
+    // Pack messages queued for send into bulk messages of up to kBufLen.
+    // Only enabled on sockets whose responder supports bulk messages, the
+    // others keep sending one message per request
+    static void SetBulkMode(bool enable);
 
     // Partition to KSyncSock mapping
     static KSyncSock *Get(DBTablePartBase *partition);
@@ -173,6 +216,19 @@ public:
         agent_sandesh_ctx_ = ctx;
     }
     virtual void Decoder(char *data, SandeshContext *ctxt) = 0;
+    // True if the responder understands bulk messages. vrouter does not
+    // advertise support for them, so it is not assumed by default
+    virtual bool BulkSupported() const { return false; }
+
+    bool bulk_mode() const { return bulk_mode_; }
+    // Bulk messages sent
+    uint64_t bulk_send_count() const { return bulk_send_count_; }
+    // Messages packed in bulk messages
+    uint64_t bulk_msg_count() const { return bulk_msg_count_; }
+    // Bytes of messages packed in bulk messages
+    uint64_t bulk_bytes() const { return bulk_bytes_; }
+    // Largest number of messages packed in a bulk message
+    uint32_t bulk_max_msg_count() const { return bulk_max_msg_count_; }
 protected:
     static void Init(int count);
     static void SetSockTableEntry(int i, KSyncSock *sock);
@@ -192,9 +248,13 @@ private:
                       size_t bytes_transferred);
 
     bool ProcessKernelData(char *data);
+    void ProcessBulkData(KSyncBulkIoContext *bulk, char *data);
+    void DecodeResponse(IoContext *context, char *data);
     virtual bool Validate(char *data) = 0;
     bool ValidateAndEnqueue(char *data);
     bool SendAsyncImpl(IoContext *ioc);
+    bool SendBulkImpl(WorkQueue<IoContext *>::EntryList &list);
+    void SendBulk(KSyncBulkIoContext::IoContextList *list, uint32_t len);
 
     bool SendAsyncStart() {
         tbb::mutex::scoped_lock lock(mutex_);
@@ -204,7 +264,8 @@ private:
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb) = 0;
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
                              HandlerCb) = 0;
-    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t) = 0;
+    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t,
+                               bool bulk) = 0;
     virtual void Receive(boost::asio::mutable_buffers_1) = 0;
 
     virtual uint32_t GetSeqno(char *data) = 0;
@@ -226,7 +287,15 @@ private:
     int ack_count_;
     int err_count_;
     bool run_sync_mode_;
+    bool bulk_mode_;
+
+    // Bulk mode stats
+    uint64_t bulk_send_count_;
+    uint64_t bulk_msg_count_;
+    uint64_t bulk_bytes_;
+    uint32_t bulk_max_msg_count_;
 
+    friend class KSyncSockBulkStatsReq;
     DISALLOW_COPY_AND_ASSIGN(KSyncSock);
 };
 
@@ -244,7 +313,8 @@ public:
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb);
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
                              HandlerCb);
-    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t);
+    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t,
+                               bool bulk);
     virtual void Receive(boost::asio::mutable_buffers_1);
 private:
     boost::asio::netlink::raw::socket sock_;
@@ -264,7 +334,8 @@ public:
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb);
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
                              HandlerCb);
-    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t);
+    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t,
+                               bool bulk);
     virtual void Receive(boost::asio::mutable_buffers_1);
 private:
     boost::asio::ip::udp::socket sock_;
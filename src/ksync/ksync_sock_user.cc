@@ -41,6 +41,8 @@
 KSyncSockTypeMap *KSyncSockTypeMap::singleton_; 
 vr_flow_entry *KSyncSockTypeMap::flow_table_;
 int KSyncSockTypeMap::error_code_;
+int KSyncSockTypeMap::response_flags_;
+bool KSyncSockTypeMap::bulk_supported_ = true;
 using namespace boost::asio;
 
 //store ops data
@@ -70,6 +72,38 @@ void KSyncSockTypeMap::ProcessSandesh(const uint8_t *parse_buf, size_t buf_len,
     }
 }
 
+//process a bulk message. Each message in it gets a response of its own
+//with NLM_F_MULTI set, and NLMSG_DONE terminates the bulk response
+void KSyncSockTypeMap::ProcessBulkSandesh(const uint8_t *parse_buf,
+                                          size_t buf_len, uint32_t seq_num) {
+    KSyncSockTypeMap *sock = KSyncSockTypeMap::GetKSyncSockTypeMap();
+    //blocked messages would be responded to after NLMSG_DONE
+    assert(sock->IsBlockMsgProcessing() == false);
+
+    int decode_len;
+    uint8_t *decode_buf;
+    int err = 0;
+    int decode_buf_len = buf_len;
+    decode_buf = (uint8_t *)(parse_buf);
+    response_flags_ = NLM_F_MULTI;
+    while(decode_buf_len > 0) {
+        KSyncUserSockContext ctx(true, seq_num);
+        decode_len = Sandesh::ReceiveBinaryMsgOne(decode_buf, decode_buf_len,
+                                                  &err, &ctx);
+        if (decode_len < 0) {
+            LOG(DEBUG, "Incorrect decode len " << decode_len);
+            break;
+        }
+        if (ctx.IsResponseReqd()) {
+            SimulateResponse(seq_num, 0, NLM_F_MULTI);
+        }
+        decode_buf += decode_len;
+        decode_buf_len -= decode_len;
+    }
+    response_flags_ = 0;
+    SendNetlinkDoneMsg(seq_num);
+}
+
 void KSyncSockTypeMap::FlowNatResponse(uint32_t seq_num, vr_flow_req *req) {
     KSyncSockTypeMap *sock = KSyncSockTypeMap::GetKSyncSockTypeMap();
     int flow_error = sock->GetKSyncError(KSyncSockTypeMap::KSYNC_FLOW_ENTRY_TYPE);
@@ -88,6 +122,7 @@ void KSyncSockTypeMap::FlowNatResponse(uint32_t seq_num, vr_flow_req *req) {
 
     nlh = (struct nlmsghdr *)cl.cl_buf;
     nlh->nlmsg_seq = seq_num;
+    nlh->nlmsg_flags |= response_flags_;
 
     uint32_t fwd_flow_idx = req->get_fr_index();
     bool add_error = false;
@@ -505,6 +540,12 @@ bool KSyncSockTypeMap::Validate(char *data) {
 //send or store in map
 void KSyncSockTypeMap::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
                                    HandlerCb cb) {
+    if (ioc->IsBulk()) {
+        ProcessBulkSandesh(buffer_cast<const uint8_t *>(buf), buffer_size(buf),
+                           ioc->GetSeqno());
+        return;
+    }
+
     KSyncUserSockContext ctx(true, ioc->GetSeqno());
     //parse and store info in map [done in Process() callbacks]
     ProcessSandesh(buffer_cast<const uint8_t *>(buf), buffer_size(buf), &ctx);
@@ -516,7 +557,14 @@ void KSyncSockTypeMap::AsyncSendTo(IoContext *ioc, mutable_buffers_1 buf,
 }
 
 //send or store in map
-size_t KSyncSockTypeMap::SendTo(const_buffers_1 buf, uint32_t seq_no) {
+size_t KSyncSockTypeMap::SendTo(const_buffers_1 buf, uint32_t seq_no,
+                                bool bulk) {
+    if (bulk) {
+        ProcessBulkSandesh(buffer_cast<const uint8_t *>(buf), buffer_size(buf),
+                           seq_no);
+        return 0;
+    }
+
     KSyncUserSockContext ctx(true, seq_no);
     //parse and store info in map [done in Process() callbacks]
     ProcessSandesh(buffer_cast<const uint8_t *>(buf), buffer_size(buf), &ctx);
@@ -131,12 +131,16 @@ public:
     virtual void AsyncReceive(boost::asio::mutable_buffers_1, HandlerCb);
     virtual void AsyncSendTo(IoContext *, boost::asio::mutable_buffers_1,
                              HandlerCb);
-    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t);
+    virtual std::size_t SendTo(boost::asio::const_buffers_1, uint32_t,
+                               bool bulk);
     virtual void Receive(boost::asio::mutable_buffers_1);
+    virtual bool BulkSupported() const { return bulk_supported_; }
 
+    static void set_bulk_supported(bool value) { bulk_supported_ = value; }
     static void set_error_code(int code) { error_code_ = code; }
     static int error_code() { return error_code_; }
     static void ProcessSandesh(const uint8_t *, std::size_t, KSyncUserSockContext *);
+    static void ProcessBulkSandesh(const uint8_t *, std::size_t, uint32_t);
     static void SimulateResponse(uint32_t, int, int);
     static void SendNetlinkDoneMsg(int seq_num);
     static void IfDumpResponse(uint32_t);
@@ -213,6 +217,10 @@ private:
     static KSyncSockTypeMap *singleton_;
     static vr_flow_entry *flow_table_;
     static int error_code_;
+    // Netlink flags set in responses, NLM_F_MULTI while processing a bulk
+    // message
+    static int response_flags_;
+    static bool bulk_supported_;
     DISALLOW_COPY_AND_ASSIGN(KSyncSockTypeMap);
 };
 
@@ -397,11 +397,29 @@ public:
 // leaf node's child nodes are DbQueryUnit
 class SetOperationUnit: public QueryUnit {
 public:
+    typedef std::vector<query_result_unit_t> ResultVec;
+    typedef std::vector<const ResultVec *> ResultVecList;
+
+    // Inputs with fewer entries in total are not split across threads
+    static const size_t kParallelMinSize = 64 * 1024;
+    static const int kMaxThreads = 4;
+
     SetOperationUnit(QueryUnit *p_query, QueryUnit *m_query):
         QueryUnit(p_query, m_query), set_operation(UNION_OP), 
         is_leaf_node(false) {};
     virtual query_status_t process_query();
 
+    // Union and intersection of any number of sorted inputs, giving the
+    // same result as std::set_union/std::set_intersection applied to the
+    // inputs in turn. Inputs are merged in a single pass without
+    // intermediate results. Large inputs are split into key ranges that are
+    // merged by up to thread_count threads.
+    static void Union(const ResultVecList &inputs, ResultVec *output,
+                      int thread_count);
+    static void Intersection(const ResultVecList &inputs, ResultVec *output,
+                             int thread_count);
+    static int ThreadCount();
+
     enum {UNION_OP, INTERSECTION_OP} set_operation;
     bool is_leaf_node;
 
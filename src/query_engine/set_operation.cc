@@ -2,6 +2,7 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <tbb/tbb_thread.h>
 #include "query.h"
 
 // for sorting and set operations
@@ -24,6 +25,265 @@ bool query_result_unit_t::operator<(const query_result_unit_t& rhs) const
     return (timestamp < rhs.timestamp);
 }
 
+namespace {
+
+typedef SetOperationUnit::ResultVec ResultVec;
+typedef ResultVec::const_iterator ResultIter;
+
+// Part of a sorted input that is left to be merged
+struct ResultRange {
+    ResultRange() {}
+    ResultRange(ResultIter b, ResultIter e) : begin(b), end(e) {}
+    ResultIter begin;
+    ResultIter end;
+};
+typedef std::vector<ResultRange> ResultRangeList;
+typedef void (*ResultRangeOp)(ResultRangeList, ResultVec *);
+
+// Number of entries at the start of the range equivalent to value
+static size_t RunLength(const ResultRange &range,
+                        const query_result_unit_t &value) {
+    ResultIter it = range.begin;
+    while (it != range.end && !(value < *it)) {
+        it++;
+    }
+    return it - range.begin;
+}
+
+// Orders ranges in a heap by their next entry. The heap functions keep the
+// largest element at the front, so the order is reversed to have the range
+// with the lowest entry, and the lowest index among equivalent entries, first.
+class ResultRangeHeapCmp {
+public:
+    explicit ResultRangeHeapCmp(const ResultRangeList &ranges) :
+        ranges_(ranges) {
+    }
+    bool operator()(size_t lhs, size_t rhs) const {
+        const query_result_unit_t &l = *ranges_[lhs].begin;
+        const query_result_unit_t &r = *ranges_[rhs].begin;
+        if (r < l) {
+            return true;
+        }
+        if (l < r) {
+            return false;
+        }
+        return lhs > rhs;
+    }
+private:
+    const ResultRangeList &ranges_;
+};
+
+// K-way merge of the ranges. An entry present n times in some input is
+// present max(n) times in the output, as with std::set_union applied to the
+// inputs in turn: the first input's run is copied, then from each following
+// input the entries beyond the longest run copied so far.
+static void UnionRanges(ResultRangeList ranges, ResultVec *output) {
+    ResultRangeHeapCmp cmp(ranges);
+    std::vector<size_t> heap;
+    for (size_t i = 0; i < ranges.size(); i++) {
+        if (ranges[i].begin != ranges[i].end) {
+            heap.push_back(i);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), cmp);
+
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), cmp);
+        size_t index = heap.back();
+        heap.pop_back();
+        const query_result_unit_t &value = *ranges[index].begin;
+        size_t count = 0;
+
+        // Consume the entries equivalent to value from all the inputs. The
+        // heap yields equivalent entries in input order.
+        while (true) {
+            ResultRange &range = ranges[index];
+            size_t run = RunLength(range, value);
+            if (run > count) {
+                output->insert(output->end(), range.begin + count,
+                               range.begin + run);
+                count = run;
+            }
+            range.begin += run;
+            if (range.begin != range.end) {
+                heap.push_back(index);
+                std::push_heap(heap.begin(), heap.end(), cmp);
+            }
+            if (heap.empty() || value < *ranges[heap.front()].begin) {
+                break;
+            }
+            std::pop_heap(heap.begin(), heap.end(), cmp);
+            index = heap.back();
+            heap.pop_back();
+        }
+    }
+}
+
+// Intersection of the ranges. Every input is moved with a binary search to
+// the largest of the next entries of all inputs, until all are at the same
+// entry. An entry present n times in every input is present min(n) times in
+// the output, as with std::set_intersection applied to the inputs in turn.
+static void IntersectionRanges(ResultRangeList ranges, ResultVec *output) {
+    if (ranges.empty()) {
+        return;
+    }
+
+    while (true) {
+        ResultIter max = ranges[0].begin;
+        for (size_t i = 0; i < ranges.size(); i++) {
+            if (ranges[i].begin == ranges[i].end) {
+                return;
+            }
+            if (*max < *ranges[i].begin) {
+                max = ranges[i].begin;
+            }
+        }
+
+        bool match = true;
+        for (size_t i = 0; i < ranges.size(); i++) {
+            ResultRange &range = ranges[i];
+            range.begin = std::lower_bound(range.begin, range.end, *max);
+            if (range.begin == range.end) {
+                return;
+            }
+            if (*max < *range.begin) {
+                match = false;
+            }
+        }
+        if (!match) {
+            continue;
+        }
+
+        // The entries are copied from the first input
+        ResultIter value = ranges[0].begin;
+        size_t count = RunLength(ranges[0], *value);
+        for (size_t i = 1; i < ranges.size(); i++) {
+            count = std::min(count, RunLength(ranges[i], *value));
+        }
+        output->insert(output->end(), value, value + count);
+        for (size_t i = 0; i < ranges.size(); i++) {
+            ranges[i].begin += RunLength(ranges[i], *value);
+        }
+    }
+}
+
+// Splits the inputs into chunk_count lists of ranges at the same keys, so
+// that equivalent entries of all inputs are in the same list. The keys are
+// taken at even positions of the pivot input.
+static void SplitInputs(const SetOperationUnit::ResultVecList &inputs,
+                        size_t pivot, size_t chunk_count,
+                        std::vector<ResultRangeList> *chunks) {
+    const ResultVec &split = *inputs[pivot];
+    std::vector<ResultIter> starts;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        starts.push_back(inputs[i]->begin());
+    }
+
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        ResultRangeList ranges;
+        for (size_t i = 0; i < inputs.size(); i++) {
+            ResultIter end = inputs[i]->end();
+            if (chunk + 1 < chunk_count) {
+                const query_result_unit_t &key =
+                    split[(chunk + 1) * split.size() / chunk_count];
+                end = std::lower_bound(starts[i], end, key);
+            }
+            ranges.push_back(ResultRange(starts[i], end));
+            starts[i] = end;
+        }
+        chunks->push_back(ranges);
+    }
+}
+
+// Runs op on the inputs, split across up to thread_count threads when they
+// are large. The calling thread merges the first chunk itself. Plain threads
+// are used as the query is processed from a TaskScheduler task, which must
+// not wait for other tasks.
+static void RunSetOperation(ResultRangeOp op,
+                            const SetOperationUnit::ResultVecList &inputs,
+                            size_t pivot, ResultVec *output,
+                            int thread_count) {
+    size_t total = 0;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        total += inputs[i]->size();
+    }
+
+    size_t chunk_count = 1;
+    if (thread_count > 1 && total >= SetOperationUnit::kParallelMinSize) {
+        chunk_count = std::min((size_t)thread_count, inputs[pivot]->size());
+    }
+    std::vector<ResultRangeList> chunks;
+    SplitInputs(inputs, pivot, std::max(chunk_count, (size_t)1), &chunks);
+
+    if (chunks.size() == 1) {
+        op(chunks[0], output);
+        return;
+    }
+
+    std::vector<ResultVec> chunk_outputs(chunks.size());
+    std::vector<tbb::tbb_thread *> threads;
+    for (size_t i = 1; i < chunks.size(); i++) {
+        threads.push_back(new tbb::tbb_thread(
+            boost::bind(op, chunks[i], &chunk_outputs[i])));
+    }
+    op(chunks[0], &chunk_outputs[0]);
+    for (size_t i = 0; i < threads.size(); i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    size_t size = output->size();
+    for (size_t i = 0; i < chunk_outputs.size(); i++) {
+        size += chunk_outputs[i].size();
+    }
+    output->reserve(size);
+    for (size_t i = 0; i < chunk_outputs.size(); i++) {
+        output->insert(output->end(), chunk_outputs[i].begin(),
+                       chunk_outputs[i].end());
+    }
+}
+
+} // namespace
+
+const size_t SetOperationUnit::kParallelMinSize;
+const int SetOperationUnit::kMaxThreads;
+
+int SetOperationUnit::ThreadCount()
+{
+    int count = tbb::tbb_thread::hardware_concurrency();
+    return std::max(1, std::min(count, kMaxThreads));
+}
+
+void SetOperationUnit::Union(const ResultVecList &inputs, ResultVec *output,
+                             int thread_count)
+{
+    if (inputs.empty())
+        return;
+
+    // Split at keys of the largest input to get chunks of similar size
+    size_t pivot = 0;
+    for (size_t i = 1; i < inputs.size(); i++) {
+        if (inputs[i]->size() > inputs[pivot]->size())
+            pivot = i;
+    }
+    RunSetOperation(UnionRanges, inputs, pivot, output, thread_count);
+}
+
+void SetOperationUnit::Intersection(const ResultVecList &inputs,
+                                    ResultVec *output, int thread_count)
+{
+    if (inputs.empty())
+        return;
+
+    // The result is no larger than the smallest input
+    size_t pivot = 0;
+    for (size_t i = 1; i < inputs.size(); i++) {
+        if (inputs[i]->size() < inputs[pivot]->size())
+            pivot = i;
+    }
+    RunSetOperation(IntersectionRanges, inputs, pivot, output, thread_count);
+}
+
 void SetOperationUnit::or_operation()
 {
     if (sub_queries.size() == 0)
@@ -32,24 +292,18 @@ void SetOperationUnit::or_operation()
         return;
     }
 
-    // with one query no need to do any operation
-    query_result = sub_queries[0]->query_result;
-
-    for (unsigned int i = 1; i < sub_queries.size(); i++)
+    ResultVecList inputs;
+    for (unsigned int i = 0; i < sub_queries.size(); i++)
     {
-        std::vector<query_result_unit_t> tmp_query_result;
-
-        QE_TRACE(DEBUG, "UNION between tables of sizes " << 
-                query_result.size() << " and " <<
+        QE_TRACE(DEBUG, "UNION input table of size " <<
                 sub_queries[i]->query_result.size());
-        set_union(query_result.begin(), query_result.end(),
-                sub_queries[i]->query_result.begin(), 
-                sub_queries[i]->query_result.end(),
-                std::back_inserter(tmp_query_result));
-
-        query_result = tmp_query_result;    // keep the result in output var
-        QE_TRACE(DEBUG, "Resulting size of set " << query_result.size());
+        inputs.push_back(&sub_queries[i]->query_result);
     }
+
+    ResultVec result;
+    Union(inputs, &result, ThreadCount());
+    query_result.swap(result);  // keep the result in output var
+    QE_TRACE(DEBUG, "Resulting size of set " << query_result.size());
 }
 
 void SetOperationUnit::and_operation()
@@ -60,24 +314,18 @@ void SetOperationUnit::and_operation()
         return;
     }
 
-    // with one query no need to do any operation
-    query_result = sub_queries[0]->query_result;
-
-    for (unsigned int i = 1; i < sub_queries.size(); i++)
+    ResultVecList inputs;
+    for (unsigned int i = 0; i < sub_queries.size(); i++)
     {
-        std::vector<query_result_unit_t> tmp_query_result;
-
-        QE_TRACE(DEBUG, "INT between tables of sizes " << 
-                query_result.size() << " and " <<
+        QE_TRACE(DEBUG, "INT input table of size " <<
                 sub_queries[i]->query_result.size());
-        set_intersection(query_result.begin(), query_result.end(),
-                sub_queries[i]->query_result.begin(), 
-                sub_queries[i]->query_result.end(),
-                std::back_inserter(tmp_query_result));
-
-        query_result = tmp_query_result;    // keep the result in output var
-        QE_TRACE(DEBUG, "Resulting size of set " << query_result.size());
+        inputs.push_back(&sub_queries[i]->query_result);
     }
+
+    ResultVec result;
+    Intersection(inputs, &result, ThreadCount());
+    query_result.swap(result);  // keep the result in output var
+    QE_TRACE(DEBUG, "Resulting size of set " << query_result.size());
 }
 
 
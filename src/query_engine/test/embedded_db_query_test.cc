@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <boost/uuid/uuid_generators.hpp>
+#include <boost/uuid/uuid_io.hpp>
+#include "testing/gunit.h"
+#include "base/logging.h"
+#include "sandesh/sandesh_types.h"
+#include "sandesh/sandesh.h"
+#include "sandesh/sandesh_message_builder.h"
+
+#include "embedded_db_if.h"
+#include "analytics/db_handler.h"
+#include "analytics/ruleeng.h"
+#include "analytics/viz_constants.h"
+#include "query.h"
+
+using namespace pugi;
+
+// End to end ingest and query benchmark. Sandesh messages and flow records
+// are replayed through the collector's message processing into an embedded
+// store, and then queried with the query engine, timing both.
+class EmbeddedDbQueryTest : public ::testing::Test {
+protected:
+    static const int kSources = 8;
+    static const int kVns = 16;
+    static const uint64_t kReplayDuration = 5 * 60 * 1000000ULL;  // 5 min
+
+    EmbeddedDbQueryTest() :
+        store_(new EmbeddedDbStore),
+        db_handler_(new EmbeddedDbIf(store_)),
+        ruleeng_(&db_handler_, NULL),
+        end_time_(UTCTimestampUsec()),
+        start_time_(end_time_ - kReplayDuration) {
+    }
+
+    virtual void SetUp() {
+        QueryEngine::max_slice_ = 100;
+        ASSERT_TRUE(db_handler_.Init(true, -1));
+    }
+
+    // Number of messages and flow records replayed. Can be overridden
+    // with EMBEDDED_DB_QUERY_TEST_MESSAGES.
+    static int MessageCount() {
+        char *str = getenv("EMBEDDED_DB_QUERY_TEST_MESSAGES");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 16 * 1024;
+    }
+
+    class SandeshXMLMessageTest : public SandeshXMLMessage {
+    public:
+        SandeshXMLMessageTest() {}
+        virtual ~SandeshXMLMessageTest() {}
+
+        virtual bool Parse(const uint8_t *xml_msg, size_t size) {
+            xml_parse_result result = xdoc_.load_buffer(xml_msg, size,
+                parse_default & ~parse_escapes);
+            if (!result) {
+                LOG(ERROR, __func__ << ": Unable to load Sandesh XML Test." <<
+                    "(status=" << result.status << ", offset=" <<
+                    result.offset << "): " << xml_msg);
+                return false;
+            }
+            message_node_ = xdoc_.first_child();
+            message_type_ = message_node_.name();
+            size_ = size;
+            return true;
+        }
+
+        void SetHeader(const SandeshHeader &header) { header_ = header; }
+    };
+
+    // Timestamp of the i-th of count messages, spread over the replay
+    // duration
+    uint64_t Timestamp(int i, int count) const {
+        return start_time_ + (kReplayDuration * i) / count;
+    }
+
+    void Replay(const std::string &xmlmessage, const SandeshHeader &header) {
+        SandeshXMLMessageTest msg;
+        msg.Parse(reinterpret_cast<const uint8_t *>(xmlmessage.c_str()),
+            xmlmessage.size());
+        msg.SetHeader(header);
+        VizMsg vmsg(&msg, rgen_());
+        ruleeng_.rule_execute(&vmsg, false, &db_handler_);
+    }
+
+    void ReplaySystemLog(int i, int count) {
+        SandeshHeader header;
+        header.set_Source("host" + integerToString(i % kSources));
+        header.set_Module("VizdTest");
+        header.set_InstanceId("0");
+        header.set_NodeType("Test");
+        header.set_Type(SandeshType::SYSTEM);
+        header.set_Timestamp(Timestamp(i, count));
+        std::string xmlmessage = "<SandeshAsyncTest2 type=\"sandesh\"><file type=\"string\" identifier=\"-32768\">src/analytics/test/viz_collector_test.cc</file><line type=\"i32\" identifier=\"-32767\">80</line><f1 type=\"struct\" identifier=\"1\"><SAT2_struct><f1 type=\"string\" identifier=\"1\">sat2string" + integerToString(i) + "</f1><f2 type=\"i32\" identifier=\"2\">" + integerToString(i) + "</f2></SAT2_struct></f1><f2 type=\"i32\" identifier=\"2\">" + integerToString(i) + "</f2></SandeshAsyncTest2>";
+        Replay(xmlmessage, header);
+    }
+
+    void ReplayFlowRecord(int i, int count) {
+        SandeshHeader header;
+        header.set_Source("vrouter" + integerToString(i % kSources));
+        header.set_Module("VRouterAgent");
+        header.set_InstanceId("0");
+        header.set_NodeType("Compute");
+        header.set_Type(SandeshType::FLOW);
+        header.set_Timestamp(Timestamp(i, count));
+        std::string flowuuid(boost::uuids::to_string(rgen_()));
+        std::string xmlmessage = "<FlowDataIpv4Object type=\"sandesh\"><flowdata type=\"struct\" identifier=\"1\"><FlowDataIpv4><flowuuid type=\"string\" identifier=\"1\">" + flowuuid + "</flowuuid><direction_ing type=\"byte\" identifier=\"2\">1</direction_ing><sourcevn type=\"string\" identifier=\"3\">default-domain:demo:vn" + integerToString(i % kVns) + "</sourcevn><sourceip type=\"i32\" identifier=\"4\">" + integerToString(167772160 + i) + "</sourceip><destvn type=\"string\" identifier=\"5\">default-domain:demo:dest</destvn><destip type=\"i32\" identifier=\"6\">-1062731267</destip><protocol type=\"byte\" identifier=\"7\">6</protocol><sport type=\"i16\" identifier=\"8\">" + integerToString(i % 32768) + "</sport><dport type=\"i16\" identifier=\"9\">80</dport><bytes type=\"i64\" identifier=\"23\">1000</bytes><packets type=\"i64\" identifier=\"24\">10</packets><diff_bytes type=\"i64\" identifier=\"26\">1000</diff_bytes><diff_packets type=\"i64\" identifier=\"27\">10</diff_packets></FlowDataIpv4></flowdata></FlowDataIpv4Object>";
+        Replay(xmlmessage, header);
+    }
+
+    // Runs the query and returns the number of rows in the result, -1 if
+    // the query failed
+    int RunQuery(const std::string &table, const std::string &where,
+                 const std::string &select, const std::string &dir) {
+        std::map<std::string, std::string> json_api_data;
+        json_api_data.insert(std::make_pair("table", "\"" + table + "\""));
+        json_api_data.insert(std::make_pair("start_time",
+            integerToString(start_time_)));
+        json_api_data.insert(std::make_pair("end_time",
+            integerToString(end_time_)));
+        json_api_data.insert(std::make_pair("where", where));
+        json_api_data.insert(std::make_pair("select_fields", select));
+        if (!dir.empty()) {
+            json_api_data.insert(std::make_pair("dir", dir));
+        }
+        AnalyticsQuery query("EmbeddedDbQueryTest", new EmbeddedDbIf(store_),
+            json_api_data, 0, 0, 1);
+        uint64_t start(UTCTimestampUsec());
+        query_status_t status(query.process_query());
+        uint64_t elapsed(UTCTimestampUsec() - start);
+        if (status != QUERY_SUCCESS) {
+            return -1;
+        }
+        int rows(query.final_result->size());
+        LOG(DEBUG, table << " query: " << rows << " rows in " <<
+            elapsed / 1000 << " ms");
+        return rows;
+    }
+
+    EmbeddedDbIf::StorePtr store_;
+    DbHandler db_handler_;
+    Ruleeng ruleeng_;
+    boost::uuids::random_generator rgen_;
+    uint64_t end_time_;
+    uint64_t start_time_;
+};
+
+const int EmbeddedDbQueryTest::kSources;
+const int EmbeddedDbQueryTest::kVns;
+const uint64_t EmbeddedDbQueryTest::kReplayDuration;
+
+TEST_F(EmbeddedDbQueryTest, IngestAndQuery) {
+    int count(MessageCount());
+
+    uint64_t start(UTCTimestampUsec());
+    for (int i = 0; i < count; i++) {
+        ReplaySystemLog(i, count);
+    }
+    uint64_t elapsed(UTCTimestampUsec() - start);
+    LOG(DEBUG, "Ingest: " << count << " messages in " << elapsed / 1000 <<
+        " ms, " << (count * 1000000ULL) / (elapsed + 1) << " messages/sec");
+    EXPECT_EQ(static_cast<size_t>(count),
+              store_->RowCount(g_viz_constants.COLLECTOR_GLOBAL_TABLE));
+
+    start = UTCTimestampUsec();
+    for (int i = 0; i < count; i++) {
+        ReplayFlowRecord(i, count);
+    }
+    elapsed = UTCTimestampUsec() - start;
+    LOG(DEBUG, "Ingest: " << count << " flow records in " <<
+        elapsed / 1000 << " ms, " << (count * 1000000ULL) / (elapsed + 1) <<
+        " flow records/sec");
+    EXPECT_EQ(static_cast<size_t>(count),
+              store_->RowCount(g_viz_constants.FLOW_TABLE));
+
+    // Messages from one source
+    EXPECT_EQ(count / kSources, RunQuery(
+        g_viz_constants.COLLECTOR_GLOBAL_TABLE,
+        "[[{\"name\":\"Source\", \"value\":\"host0\", \"op\":1}]]",
+        "[\"MessageTS\", \"Source\", \"ModuleId\", \"Messagetype\"]", ""));
+
+    // Flow records from one virtual network
+    EXPECT_EQ(count / kVns, RunQuery(g_viz_constants.FLOW_TABLE,
+        "[[{\"name\":\"sourcevn\", \"value\":\"default-domain:demo:vn0\", "
+        "\"op\":1}]]",
+        "[\"UuidKey\", \"sourcevn\", \"destvn\", \"agg-bytes\", "
+        "\"agg-packets\"]", "1"));
+
+    // Traffic from one virtual network, aggregated
+    EXPECT_EQ(1, RunQuery(g_viz_constants.FLOW_SERIES_TABLE,
+        "[[{\"name\":\"sourcevn\", \"value\":\"default-domain:demo:vn0\", "
+        "\"op\":1}]]",
+        "[\"sourcevn\", \"destvn\", \"sum(bytes)\", \"sum(packets)\"]", "1"));
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "testing/gunit.h"
+#include "base/logging.h"
+#include <boost/random/linear_congruential.hpp>
+#include <boost/random/uniform_int.hpp>
+
+#include "query.h"
+
+typedef SetOperationUnit::ResultVec ResultVec;
+typedef SetOperationUnit::ResultVecList ResultVecList;
+
+class SetOperationTest : public ::testing::Test {
+protected:
+    SetOperationTest() : rng_(1) {
+    }
+
+    virtual void TearDown() {
+        for (size_t i = 0; i < inputs_.size(); i++) {
+            delete inputs_[i];
+        }
+        inputs_.clear();
+    }
+
+    // Number of entries per input for the scale comparison. Can be
+    // overridden with SET_OPERATION_TEST_ENTRIES.
+    static size_t EntryCount() {
+        char *str = getenv("SET_OPERATION_TEST_ENTRIES");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 256 * 1024;
+    }
+
+    static query_result_unit_t MakeEntry(uint64_t timestamp, uint64_t id) {
+        query_result_unit_t entry;
+        entry.timestamp = timestamp;
+        entry.info.push_back(id);
+        return entry;
+    }
+
+    // Sorted input of count entries with timestamps below max_timestamp, and
+    // a few ids per timestamp so that inputs have entries in common and
+    // duplicates
+    void AddInput(size_t count, uint64_t max_timestamp) {
+        boost::uniform_int<uint64_t> timestamp(0, max_timestamp - 1);
+        boost::uniform_int<uint64_t> id(0, 3);
+        ResultVec *input = new ResultVec;
+        for (size_t i = 0; i < count; i++) {
+            input->push_back(MakeEntry(timestamp(rng_), id(rng_)));
+        }
+        std::sort(input->begin(), input->end());
+        inputs_.push_back(input);
+    }
+
+    ResultVecList Inputs() const {
+        return ResultVecList(inputs_.begin(), inputs_.end());
+    }
+
+    // Previous implementation, one input at a time
+    void PairwiseUnion(ResultVec *output) const {
+        *output = *inputs_[0];
+        for (size_t i = 1; i < inputs_.size(); i++) {
+            ResultVec tmp;
+            std::set_union(output->begin(), output->end(),
+                           inputs_[i]->begin(), inputs_[i]->end(),
+                           std::back_inserter(tmp));
+            *output = tmp;
+        }
+    }
+
+    void PairwiseIntersection(ResultVec *output) const {
+        *output = *inputs_[0];
+        for (size_t i = 1; i < inputs_.size(); i++) {
+            ResultVec tmp;
+            std::set_intersection(output->begin(), output->end(),
+                                  inputs_[i]->begin(), inputs_[i]->end(),
+                                  std::back_inserter(tmp));
+            *output = tmp;
+        }
+    }
+
+    // Compares the full rows, not only the sort order
+    static void ExpectEqual(const ResultVec &expected,
+                            const ResultVec &result) {
+        ASSERT_EQ(expected.size(), result.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            EXPECT_EQ(expected[i].timestamp, result[i].timestamp);
+            EXPECT_TRUE(expected[i].info == result[i].info);
+        }
+    }
+
+    void CheckResults(int thread_count) {
+        ResultVec expected, result;
+        PairwiseUnion(&expected);
+        SetOperationUnit::Union(Inputs(), &result, thread_count);
+        ExpectEqual(expected, result);
+
+        expected.clear();
+        result.clear();
+        PairwiseIntersection(&expected);
+        SetOperationUnit::Intersection(Inputs(), &result, thread_count);
+        ExpectEqual(expected, result);
+    }
+
+    boost::rand48 rng_;
+    std::vector<ResultVec *> inputs_;
+};
+
+TEST_F(SetOperationTest, Basic) {
+    inputs_.push_back(new ResultVec);
+    inputs_[0]->push_back(MakeEntry(1, 0));
+    inputs_[0]->push_back(MakeEntry(2, 0));
+    inputs_[0]->push_back(MakeEntry(2, 0));
+    inputs_[0]->push_back(MakeEntry(3, 0));
+    inputs_.push_back(new ResultVec);
+    inputs_[1]->push_back(MakeEntry(2, 0));
+    inputs_[1]->push_back(MakeEntry(3, 0));
+    inputs_[1]->push_back(MakeEntry(3, 1));
+    inputs_.push_back(new ResultVec);
+    inputs_[2]->push_back(MakeEntry(0, 0));
+    inputs_[2]->push_back(MakeEntry(2, 0));
+    inputs_[2]->push_back(MakeEntry(3, 0));
+
+    ResultVec result;
+    SetOperationUnit::Union(Inputs(), &result, 1);
+    EXPECT_EQ(6U, result.size());
+    result.clear();
+    SetOperationUnit::Intersection(Inputs(), &result, 1);
+    ASSERT_EQ(2U, result.size());
+    EXPECT_EQ(2U, result[0].timestamp);
+    EXPECT_EQ(3U, result[1].timestamp);
+    CheckResults(1);
+}
+
+TEST_F(SetOperationTest, EmptyInput) {
+    ResultVec result;
+    SetOperationUnit::Union(Inputs(), &result, 1);
+    EXPECT_TRUE(result.empty());
+
+    AddInput(100, 50);
+    inputs_.push_back(new ResultVec);
+    AddInput(100, 50);
+    CheckResults(1);
+    CheckResults(4);
+    result.clear();
+    SetOperationUnit::Intersection(Inputs(), &result, 4);
+    EXPECT_TRUE(result.empty());
+}
+
+TEST_F(SetOperationTest, SingleInput) {
+    AddInput(1000, 100);
+    CheckResults(1);
+    CheckResults(4);
+}
+
+TEST_F(SetOperationTest, ManyInputs) {
+    for (int i = 0; i < 8; i++) {
+        AddInput(1000 + i * 100, 2000);
+    }
+    CheckResults(1);
+}
+
+// Inputs large enough to be split across threads, with chunk boundaries in
+// runs of duplicate entries
+TEST_F(SetOperationTest, Parallel) {
+    size_t count = SetOperationUnit::kParallelMinSize;
+    for (int i = 0; i < 4; i++) {
+        AddInput(count, count / 8);
+    }
+    CheckResults(2);
+    CheckResults(3);
+    CheckResults(SetOperationUnit::kMaxThreads);
+}
+
+// Compare the time taken by the pairwise set operations previously used by
+// SetOperationUnit with the k-way ones, for 8 inputs of EntryCount() entries
+TEST_F(SetOperationTest, Scale) {
+    size_t count = EntryCount();
+    for (int i = 0; i < 8; i++) {
+        AddInput(count, count * 2);
+    }
+    int thread_count = SetOperationUnit::ThreadCount();
+
+    ResultVec expected, result;
+    uint64_t start = UTCTimestampUsec();
+    PairwiseUnion(&expected);
+    uint64_t pairwise_union_time = UTCTimestampUsec() - start;
+    start = UTCTimestampUsec();
+    SetOperationUnit::Union(Inputs(), &result, 1);
+    uint64_t union_time = UTCTimestampUsec() - start;
+    ExpectEqual(expected, result);
+    result.clear();
+    start = UTCTimestampUsec();
+    SetOperationUnit::Union(Inputs(), &result, thread_count);
+    uint64_t parallel_union_time = UTCTimestampUsec() - start;
+    ExpectEqual(expected, result);
+
+    expected.clear();
+    result.clear();
+    start = UTCTimestampUsec();
+    PairwiseIntersection(&expected);
+    uint64_t pairwise_intersection_time = UTCTimestampUsec() - start;
+    start = UTCTimestampUsec();
+    SetOperationUnit::Intersection(Inputs(), &result, 1);
+    uint64_t intersection_time = UTCTimestampUsec() - start;
+    ExpectEqual(expected, result);
+    result.clear();
+    start = UTCTimestampUsec();
+    SetOperationUnit::Intersection(Inputs(), &result, thread_count);
+    uint64_t parallel_intersection_time = UTCTimestampUsec() - start;
+    ExpectEqual(expected, result);
+
+    std::cout << "8 inputs of " << count << " entries, " << thread_count
+              << " threads" << std::endl;
+    std::cout << "Union        : pairwise " << pairwise_union_time
+              << " usec, k-way " << union_time << " usec, parallel "
+              << parallel_union_time << " usec" << std::endl;
+    std::cout << "Intersection : pairwise " << pairwise_intersection_time
+              << " usec, k-way " << intersection_time << " usec, parallel "
+              << parallel_intersection_time << " usec" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -186,6 +186,10 @@ public:
     static const uint32_t kMaxOtherOpenFds = 64;
     // default timeout zero means, this timeout is not used
     static const uint32_t kDefaultFlowCacheTimeout = 0;
+    // default zero means, flow records are exported one per message
+    static const uint32_t kDefaultFlowExportBatchSize = 0;
+    // default number of flow table partitions
+    static const uint16_t kDefaultFlowThreadCount = 1;
 
     enum VxLanNetworkIdentifierMode {
         AUTOMATIC,
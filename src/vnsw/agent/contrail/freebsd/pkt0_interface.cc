@@ -151,6 +151,11 @@ void Pkt0Interface::InitControlInterface() {
     boost::system::error_code ec;
     input_.assign(tap_fd_, ec);
     assert(ec == 0);
+
+    // Packets after the first in a read batch are read without waiting for
+    // the reactor, make sure those reads don't block
+    input_.non_blocking(true, ec);
+    assert(ec == 0);
     
     VrouterControlInterface::InitControlInterface();  
     AsyncRead();
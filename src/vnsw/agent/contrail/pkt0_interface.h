@@ -15,6 +15,9 @@
 // pkt0 interface implementation of VrouterControlInterface
 class Pkt0Interface: public VrouterControlInterface {
 public:
+    // Max packets read from the tap interface for every read event
+    static const uint32_t kReadBatchSize = 64;
+
     Pkt0Interface(const std::string &name, boost::asio::io_service *io);
     virtual ~Pkt0Interface();
     
@@ -25,9 +28,14 @@ public:
     const std::string &Name() const { return name_; }
     int Send(uint8_t *buff, uint16_t buff_len, const PacketBufferPtr &pkt);
     const unsigned char *mac_address() const { return mac_address_; }
+
+    // Setting read batch size to 1 reads one packet per read event
+    uint32_t read_batch_size() const { return read_batch_size_; }
+    void set_read_batch_size(uint32_t size) { read_batch_size_ = size; }
 protected:
     void AsyncRead();
     void ReadHandler(const boost::system::error_code &err, std::size_t length);
+    void ProcessReadBuffer(std::size_t length);
     void WriteHandler(const boost::system::error_code &error,
                       std::size_t length, PacketBufferPtr pkt, uint8_t *buff);
 
@@ -37,6 +45,7 @@ protected:
     boost::asio::posix::stream_descriptor input_;
     
     uint8_t *read_buff_;
+    uint32_t read_batch_size_;
     PktHandler *pkt_handler_;
     DISALLOW_COPY_AND_ASSIGN(Pkt0Interface);
 };
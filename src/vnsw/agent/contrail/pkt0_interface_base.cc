@@ -11,6 +11,8 @@
 
 #include <net/if.h>
 
+#include <boost/static_assert.hpp>
+
 #include "base/logging.h"
 #include "cmn/agent_cmn.h"
 #include "sandesh/sandesh_types.h"
@@ -18,6 +20,7 @@
 #include "sandesh/sandesh_trace.h"
 #include "pkt/pkt_types.h"
 #include "pkt/pkt_init.h"
+#include "pkt/packet_buffer.h"
 #include "pkt0_interface.h"
 
 #define TAP_TRACE(obj, ...)                                              \
@@ -25,17 +28,22 @@ do {                                                                     \
     Tap##obj::TraceMsg(PacketTraceBuf, __FILE__, __LINE__, __VA_ARGS__); \
 } while (false)                                                          \
 
+BOOST_STATIC_ASSERT(PacketBufferManager::kRxBufferLen >=
+                    ControlInterface::kMaxPacketSize);
+
 ///////////////////////////////////////////////////////////////////////////////
 
 Pkt0Interface::Pkt0Interface(const std::string &name,
                              boost::asio::io_service *io) :
-    name_(name), tap_fd_(-1), input_(*io), read_buff_(NULL), pkt_handler_(NULL) {
+    name_(name), tap_fd_(-1), input_(*io), read_buff_(NULL),
+    read_batch_size_(kReadBatchSize), pkt_handler_(NULL) {
     memset(mac_address_, 0, sizeof(mac_address_));
 }
 
 Pkt0Interface::~Pkt0Interface() {
     if (read_buff_) {
-        delete [] read_buff_;
+        pkt_handler()->agent()->pkt()->packet_buffer_manager()->PutRxBuffer
+            (read_buff_);
     }
 }
 
@@ -58,8 +66,14 @@ void Pkt0Interface::WriteHandler(const boost::system::error_code &error,
 }
 
 
+// Buffers come from the receive buffer pool of PacketBufferManager. The
+// buffer is retained across reads that fail, so a new one is needed only
+// after a packet is handed off to PktHandler
 void Pkt0Interface::AsyncRead() {
-    read_buff_ = new uint8_t[kMaxPacketSize];
+    if (read_buff_ == NULL) {
+        Agent *agent = pkt_handler()->agent();
+        read_buff_ = agent->pkt()->packet_buffer_manager()->GetRxBuffer();
+    }
     input_.async_read_some(
             boost::asio::buffer(read_buff_, kMaxPacketSize), 
             boost::bind(&Pkt0Interface::ReadHandler, this,
@@ -78,16 +92,35 @@ void Pkt0Interface::ReadHandler(const boost::system::error_code &error,
     }
 
     if (!error) {
-        Agent *agent = pkt_handler()->agent();
-        PacketBufferPtr pkt(agent->pkt()->packet_buffer_manager()->Allocate
-            (PktHandler::RX_PACKET, read_buff_, kMaxPacketSize, 0, length,
-             0));
-        VrouterControlInterface::Process(pkt);
+        ProcessReadBuffer(length);
+
+        // Drain packets already queued on the tap interface before going
+        // back to the reactor. The descriptor is non-blocking, so the read
+        // fails with would_block once the tap interface is empty.
+        PacketBufferManager *mgr =
+            pkt_handler()->agent()->pkt()->packet_buffer_manager();
+        for (uint32_t count = 1; count < read_batch_size_; count++) {
+            read_buff_ = mgr->GetRxBuffer();
+            boost::system::error_code ec;
+            std::size_t len = input_.read_some(
+                boost::asio::buffer(read_buff_, kMaxPacketSize), ec);
+            if (ec)
+                break;
+            ProcessReadBuffer(len);
+        }
     }
 
     AsyncRead();
 }
 
+void Pkt0Interface::ProcessReadBuffer(std::size_t length) {
+    Agent *agent = pkt_handler()->agent();
+    PacketBufferPtr pkt(agent->pkt()->packet_buffer_manager()->AllocateRx
+        (PktHandler::RX_PACKET, read_buff_, 0, length, 0));
+    read_buff_ = NULL;
+    VrouterControlInterface::Process(pkt);
+}
+
 int Pkt0Interface::Send(uint8_t *buff, uint16_t buff_len,
                         const PacketBufferPtr &pkt) {
     std::vector<boost::asio::const_buffer> buff_list;
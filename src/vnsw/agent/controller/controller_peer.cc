@@ -105,7 +105,7 @@ bool AgentXmppChannel::SendUpdate(uint8_t *msg, size_t size) {
 }
 
 void AgentXmppChannel::ReceiveEvpnUpdate(XmlPugi *pugi) {
-    pugi::xml_node node = pugi->FindNode("items");
+    pugi::xml_node node = pugi->FindItems();
     pugi::xml_attribute attr = node.attribute("node");
 
     char *saveptr;
@@ -117,61 +117,59 @@ void AgentXmppChannel::ReceiveEvpnUpdate(XmlPugi *pugi) {
         static_cast<Layer2AgentRouteTable *>
         (agent_->vrf_table()->GetLayer2RouteTable(vrf_name));
 
-    pugi::xml_node node_check = pugi->FindNode("retract");
+    pugi::xml_node node_check = pugi->FindRetract();
     if (!pugi->IsNull(node_check)) {
-        for (node = node.first_child(); node; node = node.next_sibling()) {
-            if (strcmp(node.name(), "retract") == 0)  {
-                std::string id = node.first_attribute().value();
-                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                 "EVPN Delete Node id:" + id);
-
-                char buff[id.length() + 1];
-                uint16_t offset = 0;
-                strcpy(buff, id.c_str());
-
-                char *mac_str = strtok_r(buff + offset, "-", &saveptr);
-                uint32_t ethernet_tag = 0;
-                //retract id expected are:
-                //00:00:00:01:01:01,1.1.1.1 - Mac and IP
-                //10-00:00:00:01:01:01,1.1.1.1 - Ehernet tag, mac, ip.
-                //In case of not finding pattern "-" whole string will be
-                //returned in mac_str. So dont use it for ethernet_tag.
-                //Check for string length of saveptr to know if string was
-                //tokenised.
-                if ((strlen(saveptr) != 0) && mac_str) {
-                    ethernet_tag = atoi(mac_str);
-                    offset += strlen(mac_str) + 1;
-                }
+        for (node = node_check; node; node = XmlPugi::NextRetract(node)) {
+            std::string id = node.first_attribute().value();
+            CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                             "EVPN Delete Node id:" + id);
+
+            char buff[id.length() + 1];
+            uint16_t offset = 0;
+            strcpy(buff, id.c_str());
+
+            char *mac_str = strtok_r(buff + offset, "-", &saveptr);
+            uint32_t ethernet_tag = 0;
+            //retract id expected are:
+            //00:00:00:01:01:01,1.1.1.1 - Mac and IP
+            //10-00:00:00:01:01:01,1.1.1.1 - Ehernet tag, mac, ip.
+            //In case of not finding pattern "-" whole string will be
+            //returned in mac_str. So dont use it for ethernet_tag.
+            //Check for string length of saveptr to know if string was
+            //tokenised.
+            if ((strlen(saveptr) != 0) && mac_str) {
+                ethernet_tag = atoi(mac_str);
+                offset += strlen(mac_str) + 1;
+            }
 
-                mac_str = strtok_r(buff + offset, ",", &saveptr);
-                if (mac_str == NULL) {
-                    CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                     "Error parsing MAC from retract-id: " +id);
-                    continue;
-                }
+            mac_str = strtok_r(buff + offset, ",", &saveptr);
+            if (mac_str == NULL) {
+                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                                 "Error parsing MAC from retract-id: " +id);
+                continue;
+            }
 
-                boost::system::error_code ec;
-                MacAddress mac(mac_str, &ec);
-                if (ec) {
-                    CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                     "Error decoding MAC from retract-id: "+id);
-                    continue;
-                }
+            boost::system::error_code ec;
+            MacAddress mac(mac_str, &ec);
+            if (ec) {
+                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                                 "Error decoding MAC from retract-id: "+id);
+                continue;
+            }
 
-                if (mac == MacAddress::BroadcastMac()) {
-                    //Deletes the peer path for all boradcast and
-                    //traverses the subnet route in VRF to issue delete of peer
-                    //for them as well.
-                    TunnelOlist olist;
-                    agent_->oper_db()->multicast()->
-                        ModifyEvpnMembers(bgp_peer_id(),
-                                          vrf_name, olist,
-                                          ethernet_tag,
-                             ControllerPeerPath::kInvalidPeerIdentifier);
-                } else {
-                    rt_table->DeleteReq(bgp_peer_id(), vrf_name, mac, ethernet_tag,
-                                        new ControllerVmRoute(bgp_peer_id()));
-                }
+            if (mac == MacAddress::BroadcastMac()) {
+                //Deletes the peer path for all boradcast and
+                //traverses the subnet route in VRF to issue delete of peer
+                //for them as well.
+                TunnelOlist olist;
+                agent_->oper_db()->multicast()->
+                    ModifyEvpnMembers(bgp_peer_id(),
+                                      vrf_name, olist,
+                                      ethernet_tag,
+                         ControllerPeerPath::kInvalidPeerIdentifier);
+            } else {
+                rt_table->DeleteReq(bgp_peer_id(), vrf_name, mac, ethernet_tag,
+                                    new ControllerVmRoute(bgp_peer_id()));
             }
         }
         return;
@@ -250,7 +248,7 @@ GetMcastTypeBitmap(const McastTunnelEncapsulationListType &encap) {
 
 void AgentXmppChannel::ReceiveMulticastUpdate(XmlPugi *pugi) {
 
-    pugi::xml_node node = pugi->FindNode("items");
+    pugi::xml_node node = pugi->FindItems();
     pugi::xml_attribute attr = node.attribute("node");
 
     char *saveptr;
@@ -260,7 +258,7 @@ void AgentXmppChannel::ReceiveMulticastUpdate(XmlPugi *pugi) {
     const std::string vrf(vrf_name);
     TunnelOlist olist;
 
-    pugi::xml_node node_check = pugi->FindNode("retract");
+    pugi::xml_node node_check = pugi->FindRetract();
     if (!pugi->IsNull(node_check)) {
         pugi->ReadNode("retract"); //sets the context
         std::string retract_id = pugi->ReadAttrib("id");
@@ -272,53 +270,51 @@ void AgentXmppChannel::ReceiveMulticastUpdate(XmlPugi *pugi) {
             return;
         }
 
-        for (node = node.first_child(); node; node = node.next_sibling()) {
-            if (strcmp(node.name(), "retract") == 0) {
-                std::string id = node.first_attribute().value();
+        for (node = node_check; node; node = XmlPugi::NextRetract(node)) {
+            std::string id = node.first_attribute().value();
+            CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                            "Multicast Delete Node id:" + id);
+
+            // Parse identifier to obtain group,source
+            // <addr:VRF:Group,Source)
+            strtok_r(const_cast<char *>(id.c_str()), ":", &saveptr);
+            strtok_r(NULL, ":", &saveptr);
+            char *group = strtok_r(NULL, ",", &saveptr);
+            char *source = strtok_r(NULL, "", &saveptr);
+            if (group == NULL || source == NULL) {
                 CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                "Multicast Delete Node id:" + id);
-
-                // Parse identifier to obtain group,source
-                // <addr:VRF:Group,Source)
-                strtok_r(const_cast<char *>(id.c_str()), ":", &saveptr);
-                strtok_r(NULL, ":", &saveptr);
-                char *group = strtok_r(NULL, ",", &saveptr);
-                char *source = strtok_r(NULL, "", &saveptr);
-                if (group == NULL || source == NULL) {
-                    CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                       "Error parsing multicast group address from retract id");
-                    return;
-                }
-
-                boost::system::error_code ec;
-                IpAddress g_addr =
-                    IpAddress::from_string(group, ec);
-                if (ec.value() != 0) {
-                    CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                            "Error parsing multicast group address");
-                    return;
-                }
+                   "Error parsing multicast group address from retract id");
+                return;
+            }
 
-                IpAddress s_addr =
-                    IpAddress::from_string(source, ec);
-                if (ec.value() != 0) {
-                    CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                            "Error parsing multicast source address");
-                    return;
-                }
+            boost::system::error_code ec;
+            IpAddress g_addr =
+                IpAddress::from_string(group, ec);
+            if (ec.value() != 0) {
+                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                        "Error parsing multicast group address");
+                return;
+            }
 
-                //Retract with invalid identifier
-                agent_->oper_db()->multicast()->
-                    ModifyFabricMembers(agent_->multicast_tree_builder_peer(),
-                                        vrf, g_addr.to_v4(),
-                                        s_addr.to_v4(), 0, olist,
-                                        ControllerPeerPath::kInvalidPeerIdentifier);
+            IpAddress s_addr =
+                IpAddress::from_string(source, ec);
+            if (ec.value() != 0) {
+                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                        "Error parsing multicast source address");
+                return;
             }
+
+            //Retract with invalid identifier
+            agent_->oper_db()->multicast()->
+                ModifyFabricMembers(agent_->multicast_tree_builder_peer(),
+                                    vrf, g_addr.to_v4(),
+                                    s_addr.to_v4(), 0, olist,
+                                    ControllerPeerPath::kInvalidPeerIdentifier);
         }
         return;
     }
 
-    pugi::xml_node items_node = pugi->FindNode("item");
+    pugi::xml_node items_node = pugi->FindItem();
     if (!pugi->IsNull(items_node)) {
         pugi->ReadNode("item"); //sets the context
         std::string item_id = pugi->ReadAttrib("id");
@@ -397,7 +393,7 @@ void AgentXmppChannel::ReceiveMulticastUpdate(XmlPugi *pugi) {
 
 void AgentXmppChannel::ReceiveV4V6Update(XmlPugi *pugi) {
 
-    pugi::xml_node node = pugi->FindNode("items");
+    pugi::xml_node node = pugi->FindItems();
     pugi::xml_attribute attr = node.attribute("node");
 
     const char *af = NULL;
@@ -431,40 +427,38 @@ void AgentXmppChannel::ReceiveV4V6Update(XmlPugi *pugi) {
 
     if (!pugi->IsNull(node)) {
   
-        pugi::xml_node node_check = pugi->FindNode("retract");
+        pugi::xml_node node_check = pugi->FindRetract();
         if (!pugi->IsNull(node_check)) {
-            for (node = node.first_child(); node; node = node.next_sibling()) {
-                if (strcmp(node.name(), "retract") == 0)  {
-                    std::string id = node.first_attribute().value();
-                    CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                     "Delete Node id:" + id);
-
-                    boost::system::error_code ec;
-                    int prefix_len;
-                    if (atoi(af) == BgpAf::IPv4) {
-                        Ip4Address prefix_addr;
-                        ec = Ip4PrefixParse(id, &prefix_addr, &prefix_len);
-                        if (ec.value() != 0) {
-                            CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                    "Error parsing v4 prefix for delete");
-                            return;
-                        }
-
-                        rt_table->DeleteReq(bgp_peer_id(), vrf_name,
-                                            prefix_addr, prefix_len,
-                                            new ControllerVmRoute(bgp_peer_id()));
-
-                    } else if (atoi(af) == BgpAf::IPv6) {
-                        Ip6Address prefix_addr;
-                        ec = Inet6PrefixParse(id, &prefix_addr, &prefix_len);
-                        if (ec.value() != 0) {
-                            CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
-                                    "Error parsing v6 prefix for delete");
-                            return;
-                        }
-                        rt_table->DeleteReq(bgp_peer_id(), vrf_name,
-                                            prefix_addr, prefix_len, NULL);
+            for (node = node_check; node; node = XmlPugi::NextRetract(node)) {
+                std::string id = node.first_attribute().value();
+                CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                                 "Delete Node id:" + id);
+
+                boost::system::error_code ec;
+                int prefix_len;
+                if (atoi(af) == BgpAf::IPv4) {
+                    Ip4Address prefix_addr;
+                    ec = Ip4PrefixParse(id, &prefix_addr, &prefix_len);
+                    if (ec.value() != 0) {
+                        CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                                "Error parsing v4 prefix for delete");
+                        return;
+                    }
+
+                    rt_table->DeleteReq(bgp_peer_id(), vrf_name,
+                                        prefix_addr, prefix_len,
+                                        new ControllerVmRoute(bgp_peer_id()));
+
+                } else if (atoi(af) == BgpAf::IPv6) {
+                    Ip6Address prefix_addr;
+                    ec = Inet6PrefixParse(id, &prefix_addr, &prefix_len);
+                    if (ec.value() != 0) {
+                        CONTROLLER_TRACE(Trace, GetBgpPeerName(), vrf_name,
+                                "Error parsing v6 prefix for delete");
+                        return;
                     }
+                    rt_table->DeleteReq(bgp_peer_id(), vrf_name,
+                                        prefix_addr, prefix_len, NULL);
                 }
             }
             return;
@@ -947,7 +941,6 @@ void AgentXmppChannel::ReceiveUpdate(const XmppStanza::XmppMessage *msg) {
 
         XmlBase *impl = msg->dom.get();
         XmlPugi *pugi = reinterpret_cast<XmlPugi *>(impl);
-        pugi->FindNode("items");
         pugi->ReadNode("items"); //sets the context
         std::string nodename = pugi->ReadAttrib("node");
 
@@ -37,6 +37,10 @@ using namespace autogen;
 
 SandeshTraceBufferPtr AclTraceBuf(SandeshTraceBufferCreate("Acl", 32000));
 
+const size_t AclDBEntry::kDefaultClassifierMinEntries;
+size_t AclDBEntry::classifier_min_entries_ =
+    AclDBEntry::kDefaultClassifierMinEntries;
+
 FlowPolicyInfo::FlowPolicyInfo(const std::string &u)
     : uuid(u), drop(false), terminal(false), other(false) {
 }
@@ -113,6 +117,7 @@ DBEntry *AclTable::Add(const DBRequest *req) {
          ++it) {
         acl->AddAclEntry(*it, acl->acl_entries_);
     }
+    acl->BuildClassifier();
     return acl;
 }
 
@@ -123,6 +128,7 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
 
     if (data->ace_id_to_del_) {
         acl->DeleteAclEntry(data->ace_id_to_del_);
+        acl->BuildClassifier();
         return true;
     }
 
@@ -144,6 +150,7 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
     // entries
     if (!data->ace_add) {
         if (acl->Changed(entries)) {
+            acl->UpdateAceChanges(entries);
             //Delete All acl entries for now and set newly created one.
             acl->DeleteAllAclEntries();
             acl->SetAclEntries(entries);
@@ -151,7 +158,9 @@ bool AclTable::OnChange(DBEntry *entry, const DBRequest *req) {
         }
     }
 
-    if (changed == false) {
+    if (changed) {
+        acl->BuildClassifier();
+    } else {
         //Remove temporary create acl entries
         AclDBEntry::AclEntries::iterator iter;
         iter = entries.begin();
@@ -196,6 +205,10 @@ DBTableBase *AclTable::CreateTable(DB *db, const std::string &name) {
     acl_table_ = new AclTable(db, name);
     acl_table_->Init();
     acl_table_->ActionInit();
+    char *count = getenv("ACL_CLASSIFIER_MIN_ENTRIES");
+    if (count) {
+        AclDBEntry::SetClassifierMinEntries(strtoul(count, NULL, 0));
+    }
     return acl_table_;
 }
 
@@ -409,6 +422,7 @@ bool AclTable::IFNodeToReq(IFMapNode *node, DBRequest &req) {
 // ACL methods
 void AclDBEntry::SetAclEntries(AclEntries &entries)
 {
+    classifier_.reset();
     AclEntries::iterator it, tmp;
     it = entries.begin();
     while (it != entries.end()) {
@@ -441,6 +455,10 @@ AclEntry *AclDBEntry::AddAclEntry(const AclEntrySpec &acl_entry_spec, AclEntries
     
     AclEntry *entry = new AclEntry();
     entry->PopulateAclEntry(acl_entry_spec);
+    if (&entries == &acl_entries_) {
+        classifier_.reset();
+        added_ace_ids_.insert(entry->id());
+    }
     
     std::vector<ActionSpec>::const_iterator it;
     for (it = acl_entry_spec.action_l.begin(); it != acl_entry_spec.action_l.end();
@@ -472,6 +490,8 @@ bool AclDBEntry::DeleteAclEntry(const uint32_t acl_entry_id)
          iter != acl_entries_.end(); ++iter) {
         if (acl_entry_id == iter->id()) {
             AclEntry *ae = iter.operator->();
+            classifier_.reset();
+            removed_ace_ids_.insert(acl_entry_id);
             acl_entries_.erase(acl_entries_.iterator_to(*iter));
             ACL_TRACE(Info, "acl entry " + integerToString(acl_entry_id) + " deleted");
             delete ae;
@@ -484,6 +504,7 @@ bool AclDBEntry::DeleteAclEntry(const uint32_t acl_entry_id)
 
 void AclDBEntry::DeleteAllAclEntries()
 {
+    classifier_.reset();
     AclEntries::iterator iter;
     iter = acl_entries_.begin();
     while (iter != acl_entries_.end()) {
@@ -494,72 +515,155 @@ void AclDBEntry::DeleteAllAclEntries()
     return;
 }
 
+// Accumulates the actions of entry in m_acl if it matches the packet. Sets
+// m_acl.terminal_rule if the entry is a terminal rule.
+bool AclDBEntry::EntryMatch(const AclEntry *entry,
+                            const PacketHeader &packet_header,
+                            MatchAclParams &m_acl,
+                            FlowPolicyInfo *info) const {
+    const AclEntry::ActionList &al = entry->PacketMatch(packet_header);
+    if (al.empty()) {
+        return false;
+    }
+
+    AclEntry::ActionList::const_iterator al_it;
+    for (al_it = al.begin(); al_it != al.end(); ++al_it) {
+        TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
+        m_acl.action_info.action |= 1 << ta->GetAction();
+        if (ta->GetActionType() == TrafficAction::MIRROR_ACTION) {
+            MirrorAction *a = static_cast<MirrorAction *>(*al_it.operator->());
+            MirrorActionSpec as;
+            as.ip = a->GetIp();
+            as.port = a->GetPort();
+            as.vrf_name = a->vrf_name();
+            as.analyzer_name = a->GetAnalyzerName();
+            as.encap = a->GetEncap();
+            m_acl.action_info.mirror_l.push_back(as);
+        }
+        if (ta->GetActionType() == TrafficAction::VRF_TRANSLATE_ACTION) {
+            const VrfTranslateAction *a =
+                static_cast<VrfTranslateAction *>(*al_it.operator->());
+            VrfTranslateActionSpec vrf_translate_action(a->vrf_name(),
+                                                        a->ignore_acl());
+            m_acl.action_info.vrf_translate_action_ = vrf_translate_action;
+        }
+        if (info && ta->IsDrop()) {
+            if (!info->drop) {
+                info->drop = true;
+                info->terminal = false;
+                info->other = false;
+                info->uuid = entry->uuid();
+            }
+        }
+    }
+
+    m_acl.ace_id_list.push_back((int32_t)(entry->id()));
+    if (entry->IsTerminal()) {
+        m_acl.terminal_rule = true;
+        /* Set uuid only if it is NOT already set as
+         * drop/terminal uuid */
+        if (info && !info->drop && !info->terminal) {
+            info->terminal = true;
+            info->other = false;
+            info->uuid = entry->uuid();
+        }
+        return true;
+    }
+    /* If the ace action is not drop and if ace is not terminal rule
+     * then set the uuid with the first matching uuid */
+    if (info && !info->drop && !info->terminal && !info->other) {
+        info->other = true;
+        info->uuid = entry->uuid();
+    }
+    return true;
+}
+
 bool AclDBEntry::PacketMatch(const PacketHeader &packet_header, 
-			                 MatchAclParams &m_acl, FlowPolicyInfo *info) const
+                             MatchAclParams &m_acl, FlowPolicyInfo *info) const
 {
-    AclEntries::const_iterator iter;
     bool ret_val = false;
     m_acl.terminal_rule = false;
-	m_acl.action_info.action = 0;
+    m_acl.action_info.action = 0;
+
+    // Only the candidate entries given by the classifier can match, and
+    // they are matched in the same order as the entries
+    if (classifier_.get()) {
+        AclClassifier::Bitmap candidates;
+        classifier_->Lookup(packet_header, &candidates);
+        for (size_t i = candidates.find_first();
+             i != AclClassifier::Bitmap::npos; i = candidates.find_next(i)) {
+            if (EntryMatch(classifier_->entry(i), packet_header, m_acl,
+                           info)) {
+                ret_val = true;
+                if (m_acl.terminal_rule) {
+                    break;
+                }
+            }
+        }
+        return ret_val;
+    }
+
+    AclEntries::const_iterator iter;
     for (iter = acl_entries_.begin();
          iter != acl_entries_.end();
          ++iter) {
-        const AclEntry::ActionList &al = iter->PacketMatch(packet_header);
-	AclEntry::ActionList::const_iterator al_it;
-	for (al_it = al.begin(); al_it != al.end(); ++al_it) {
-	     TrafficAction *ta = static_cast<TrafficAction *>(*al_it.operator->());
-	     m_acl.action_info.action |= 1 << ta->GetAction();
-	     if (ta->GetActionType() == TrafficAction::MIRROR_ACTION) {
-	         MirrorAction *a = static_cast<MirrorAction *>(*al_it.operator->());
-                 MirrorActionSpec as;
-		 as.ip = a->GetIp();
-		 as.port = a->GetPort();
-                 as.vrf_name = a->vrf_name();
-                 as.analyzer_name = a->GetAnalyzerName();
-                 as.encap = a->GetEncap();
-                 m_acl.action_info.mirror_l.push_back(as);
-	     }
-         if (ta->GetActionType() == TrafficAction::VRF_TRANSLATE_ACTION) {
-             const VrfTranslateAction *a =
-                 static_cast<VrfTranslateAction *>(*al_it.operator->());
-             VrfTranslateActionSpec vrf_translate_action(a->vrf_name(),
-                                                         a->ignore_acl());
-             m_acl.action_info.vrf_translate_action_ = vrf_translate_action;
-         }
-         if (info && ta->IsDrop()) {
-             if (!info->drop) {
-                 info->drop = true;
-                 info->terminal = false;
-                 info->other = false;
-                 info->uuid = iter->uuid();
-             }
-         }
-	}
-        if (!(al.empty())) {
+        if (EntryMatch(iter.operator->(), packet_header, m_acl, info)) {
             ret_val = true;
-            m_acl.ace_id_list.push_back((int32_t)(iter->id()));
-            if (iter->IsTerminal()) {
-                m_acl.terminal_rule = true;
-                /* Set uuid only if it is NOT already set as
-                 * drop/terminal uuid */
-                if (info && !info->drop && !info->terminal) {
-                    info->terminal = true;
-                    info->other = false;
-                    info->uuid = iter->uuid();
-                }
-                return ret_val;
-            }
-            /* If the ace action is not drop and if ace is not terminal rule
-             * then set the uuid with the first matching uuid */
-            if (info && !info->drop && !info->terminal && !info->other) {
-                info->other = true;
-                info->uuid = iter->uuid();
+            if (m_acl.terminal_rule) {
+                break;
             }
         }
     }
     return ret_val;
 }
 
+void AclDBEntry::BuildClassifier() {
+    classifier_.reset();
+    if (acl_entries_.size() < classifier_min_entries_) {
+        return;
+    }
+    AclClassifier::AclEntryList entries;
+    entries.reserve(acl_entries_.size());
+    AclEntries::const_iterator iter;
+    for (iter = acl_entries_.begin(); iter != acl_entries_.end(); ++iter) {
+        entries.push_back(iter.operator->());
+    }
+    classifier_.reset(new AclClassifier(entries));
+}
+
+// Records the entries that differ between the current entries and
+// new_entries, which replace them.
+void AclDBEntry::UpdateAceChanges(const AclEntries &new_entries) {
+    std::map<uint32_t, const AclEntry *> old_entries;
+    AclEntries::const_iterator it;
+    for (it = acl_entries_.begin(); it != acl_entries_.end(); ++it) {
+        old_entries.insert(std::make_pair(it->id(), it.operator->()));
+    }
+    for (it = new_entries.begin(); it != new_entries.end(); ++it) {
+        std::map<uint32_t, const AclEntry *>::iterator old_it =
+            old_entries.find(it->id());
+        if (old_it == old_entries.end()) {
+            added_ace_ids_.insert(it->id());
+            continue;
+        }
+        if (!(*old_it->second == *it)) {
+            removed_ace_ids_.insert(it->id());
+            added_ace_ids_.insert(it->id());
+        }
+        old_entries.erase(old_it);
+    }
+    std::map<uint32_t, const AclEntry *>::const_iterator old_it;
+    for (old_it = old_entries.begin(); old_it != old_entries.end();
+         ++old_it) {
+        removed_ace_ids_.insert(old_it->first);
+    }
+}
+
+void AclDBEntry::ClearAceChanges() {
+    removed_ace_ids_.clear();
+    added_ace_ids_.clear();
+}
+
 bool AclDBEntry::Changed(const AclEntries &new_entries) const {
     AclEntries::const_iterator it = acl_entries_.begin();
     AclEntries::const_iterator new_entries_it = new_entries.begin();
@@ -5,15 +5,18 @@
 #ifndef __AGENT_ACL_N_H__
 #define __AGENT_ACL_N_H__
 
+#include <set>
 #include <boost/intrusive/list.hpp>
 #include <boost/uuid/uuid.hpp>
 #include <boost/intrusive_ptr.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <tbb/atomic.h>
 
 #include <filter/traffic_action.h>
 #include <filter/acl_entry_match.h>
 #include <filter/acl_entry_spec.h>
 #include <filter/acl_entry.h>
+#include <filter/acl_classifier.h>
 
 struct FlowKey;
 
@@ -80,6 +83,12 @@ public:
             boost::intrusive::list_member_hook<>, 
             &AclEntry::acl_list_node> AclEntryNode;
     typedef boost::intrusive::list<AclEntry, AclEntryNode> AclEntries;
+    typedef std::set<uint32_t> AceIdSet;
+
+    // ACLs with fewer entries are matched with a linear scan of the entries
+    // instead of an AclClassifier. Can be overridden with the
+    // ACL_CLASSIFIER_MIN_ENTRIES environment variable.
+    static const size_t kDefaultClassifierMinEntries = 16;
     
     AclDBEntry(uuid id) : uuid_(id), dynamic_acl_(false) { };
     ~AclDBEntry() { };
@@ -112,12 +121,39 @@ public:
                      FlowPolicyInfo *info) const;
     bool Changed(const AclEntries &new_acl_entries) const;
     uint32_t ace_count() const { return acl_entries_.size();}
+
+    // Compiles the entries into an AclClassifier. Called by AclTable once
+    // the entries are updated, the classifier is discarded when they are
+    // modified.
+    void BuildClassifier();
+    bool has_classifier() const { return classifier_.get() != NULL; }
+    static void SetClassifierMinEntries(size_t count) {
+        classifier_min_entries_ = count;
+    }
+    static size_t classifier_min_entries() { return classifier_min_entries_; }
+
+    // Ids of the entries deleted or modified, and of the entries added or
+    // modified, since the last call to ClearAceChanges(). Only the flows
+    // that matched a removed entry, or that were not stopped by a terminal
+    // entry ahead of an added one, can get a different result.
+    const AceIdSet &removed_ace_ids() const { return removed_ace_ids_; }
+    const AceIdSet &added_ace_ids() const { return added_ace_ids_; }
+    void ClearAceChanges();
+
 private:
     friend class AclTable;
+    bool EntryMatch(const AclEntry *entry, const PacketHeader &packet_header,
+                    MatchAclParams &m_acl, FlowPolicyInfo *info) const;
+    void UpdateAceChanges(const AclEntries &new_entries);
+
+    static size_t classifier_min_entries_;
     uuid uuid_;
     bool dynamic_acl_;
     std::string name_;
     AclEntries acl_entries_;
+    boost::scoped_ptr<AclClassifier> classifier_;
+    AceIdSet removed_ace_ids_;
+    AceIdSet added_ace_ids_;
     DISALLOW_COPY_AND_ASSIGN(AclDBEntry);
 };
 
@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include <netinet/in.h>
+
+#include <filter/acl_entry_match.h>
+#include <filter/acl_entry.h>
+#include <filter/packet_header.h>
+#include <filter/acl_classifier.h>
+
+using std::string;
+using std::vector;
+
+const size_t AclClassifier::kMaxIndexSize;
+
+// Index of the entries with a condition on an integer field in [0, max].
+// The ranges of the entries divide the field into elementary intervals, and
+// the index keeps the sorted list of the first values of the intervals with,
+// for each interval, the entries that have a range covering it. Adjacent
+// intervals covered by the same entries are merged. Entries without a
+// condition on the field, or with a range covering the whole field, are in
+// the wildcard bitmap.
+class RangeIndex {
+public:
+    typedef AclClassifier::Bitmap Bitmap;
+
+    RangeIndex(uint64_t max, size_t size)
+        : max_(max), wildcard_(size), has_wildcard_(false), index_size_(0) {
+    }
+
+    void AddWildcard(uint32_t id) {
+        wildcard_.set(id);
+        has_wildcard_ = true;
+    }
+
+    void AddRange(uint32_t id, uint64_t min, uint64_t max) {
+        if (max > max_) {
+            max = max_;
+        }
+        if (min > max) {
+            return;
+        }
+        if (min == 0 && max == max_) {
+            AddWildcard(id);
+            return;
+        }
+        events_.push_back(Event(min, id, 1));
+        events_.push_back(Event(max + 1, id, -1));
+    }
+
+    // Returns false if the index would be larger than kMaxIndexSize.
+    bool Build();
+
+    // Sets the bits of the entries that may match value.
+    void Lookup(uint64_t value, Bitmap *bitmap) const {
+        if (has_wildcard_) {
+            *bitmap |= wildcard_;
+        }
+        vector<uint64_t>::const_iterator it =
+            std::upper_bound(bounds_.begin(), bounds_.end(), value);
+        const vector<uint32_t> &list = lists_[it - bounds_.begin() - 1];
+        for (vector<uint32_t>::const_iterator id = list.begin();
+             id != list.end(); ++id) {
+            bitmap->set(*id);
+        }
+    }
+
+    // Sets the bits of the entries that have a range in the index, after
+    // Build() failed.
+    void GetRangeEntries(Bitmap *bitmap) const {
+        for (vector<Event>::const_iterator it = events_.begin();
+             it != events_.end(); ++it) {
+            bitmap->set(it->id);
+        }
+    }
+
+private:
+    struct Event {
+        Event(uint64_t pos, uint32_t id, int delta)
+            : pos(pos), id(id), delta(delta) {
+        }
+        bool operator<(const Event &rhs) const {
+            return pos < rhs.pos;
+        }
+        uint64_t pos;
+        uint32_t id;
+        int delta;
+    };
+
+    uint64_t max_;
+    Bitmap wildcard_;
+    bool has_wildcard_;
+    vector<Event> events_;
+    vector<uint64_t> bounds_;
+    vector<vector<uint32_t> > lists_;
+    size_t index_size_;
+
+    DISALLOW_COPY_AND_ASSIGN(RangeIndex);
+};
+
+bool RangeIndex::Build() {
+    std::sort(events_.begin(), events_.end());
+
+    bounds_.push_back(0);
+    lists_.push_back(vector<uint32_t>());
+
+    // Number of ranges of each entry covering the current interval
+    std::map<uint32_t, int> active;
+    size_t i = 0;
+    while (i < events_.size()) {
+        uint64_t pos = events_[i].pos;
+        for (; i < events_.size() && events_[i].pos == pos; i++) {
+            int count = (active[events_[i].id] += events_[i].delta);
+            if (count == 0) {
+                active.erase(events_[i].id);
+            }
+        }
+        if (pos > max_) {
+            break;
+        }
+
+        vector<uint32_t> list;
+        list.reserve(active.size());
+        for (std::map<uint32_t, int>::const_iterator it = active.begin();
+             it != active.end(); ++it) {
+            list.push_back(it->first);
+        }
+        if (list == lists_.back()) {
+            continue;
+        }
+        index_size_ += list.size();
+        if (index_size_ > AclClassifier::kMaxIndexSize) {
+            return false;
+        }
+        if (pos == bounds_.back()) {
+            lists_.back().swap(list);
+        } else {
+            bounds_.push_back(pos);
+            lists_.push_back(vector<uint32_t>());
+            lists_.back().swap(list);
+        }
+    }
+    vector<Event>().swap(events_);
+    return true;
+}
+
+AclClassifier::AddressIndex::AddressIndex(size_t size)
+    : wildcard(size), ipv4(new RangeIndex(0xFFFFFFFFULL, size)) {
+}
+
+AclClassifier::AddressIndex::~AddressIndex() {
+    delete ipv4;
+}
+
+static bool IsContiguousMask(uint32_t mask) {
+    uint32_t host = ~mask;
+    return (host & (host + 1)) == 0;
+}
+
+void AclClassifier::AddAddress(AddressIndex *index, uint32_t id,
+                               const AddressMatch *match) {
+    if (match->policy_id_str() == "any") {
+        index->wildcard.set(id);
+        return;
+    }
+
+    switch (match->addr_type()) {
+    case AddressMatch::IP_ADDR: {
+        const IpAddress &ip = match->ip_addr();
+        const IpAddress &mask = match->ip_mask();
+        if (!ip.is_v4() || !mask.is_v4() ||
+            !IsContiguousMask(mask.to_v4().to_ulong())) {
+            index->wildcard.set(id);
+            break;
+        }
+        uint32_t addr = ip.to_v4().to_ulong();
+        uint32_t mask4 = mask.to_v4().to_ulong();
+        // Address with bits outside of the mask never matches
+        if ((addr & ~mask4) == 0) {
+            index->ipv4->AddRange(id, addr, addr | ~mask4);
+        }
+        break;
+    }
+    case AddressMatch::NETWORK_ID:
+        index->policy_ids[match->policy_id_str()].push_back(id);
+        break;
+    case AddressMatch::SG:
+        index->sg_ids[match->sg_id()].push_back(id);
+        break;
+    default:
+        index->wildcard.set(id);
+        break;
+    }
+}
+
+void AclClassifier::BuildAddress(AddressIndex *index) {
+    if (!index->ipv4->Build()) {
+        index->ipv4->GetRangeEntries(&index->wildcard);
+        delete index->ipv4;
+        index->ipv4 = NULL;
+    }
+}
+
+static RangeIndex *BuildRangeIndex(RangeIndex *index) {
+    if (!index->Build()) {
+        delete index;
+        return NULL;
+    }
+    return index;
+}
+
+static void AddRanges(RangeIndex *index, uint32_t id,
+                      const RangeSList &ranges) {
+    for (RangeSList::const_iterator it = ranges.begin(); it != ranges.end();
+         ++it) {
+        index->AddRange(id, it->min, it->max);
+    }
+}
+
+AclClassifier::AclClassifier(const AclEntryList &entries)
+    : entries_(entries),
+      protocol_(new RangeIndex(0xFF, entries.size())),
+      src_port_(new RangeIndex(0xFFFF, entries.size())),
+      dst_port_(new RangeIndex(0xFFFF, entries.size())),
+      src_addr_(entries.size()), dst_addr_(entries.size()) {
+    for (uint32_t id = 0; id < entries_.size(); id++) {
+        const ProtocolMatch *protocol = NULL;
+        const PortMatch *src_port = NULL;
+        const PortMatch *dst_port = NULL;
+        const AddressMatch *src_addr = NULL;
+        const AddressMatch *dst_addr = NULL;
+
+        // Only the first condition of each kind is indexed, the others are
+        // checked by AclEntry::PacketMatch()
+        const vector<AclEntryMatch *> &matches = entries_[id]->matches();
+        for (vector<AclEntryMatch *>::const_iterator it = matches.begin();
+             it != matches.end(); ++it) {
+            switch ((*it)->type()) {
+            case AclEntryMatch::PROTOCOL_MATCH:
+                if (!protocol)
+                    protocol = static_cast<const ProtocolMatch *>(*it);
+                break;
+            case AclEntryMatch::SOURCE_PORT_MATCH:
+                if (!src_port)
+                    src_port = static_cast<const PortMatch *>(*it);
+                break;
+            case AclEntryMatch::DESTINATION_PORT_MATCH:
+                if (!dst_port)
+                    dst_port = static_cast<const PortMatch *>(*it);
+                break;
+            case AclEntryMatch::ADDRESS_MATCH: {
+                const AddressMatch *addr =
+                    static_cast<const AddressMatch *>(*it);
+                if (addr->is_source() && !src_addr) {
+                    src_addr = addr;
+                } else if (!addr->is_source() && !dst_addr) {
+                    dst_addr = addr;
+                }
+                break;
+            }
+            }
+        }
+
+        if (protocol) {
+            AddRanges(protocol_, id, protocol->protocol_ranges());
+        } else {
+            protocol_->AddWildcard(id);
+        }
+        if (src_port) {
+            AddRanges(src_port_, id, src_port->port_ranges());
+        } else {
+            src_port_->AddWildcard(id);
+        }
+        if (dst_port) {
+            AddRanges(dst_port_, id, dst_port->port_ranges());
+        } else {
+            dst_port_->AddWildcard(id);
+        }
+        if (src_addr) {
+            AddAddress(&src_addr_, id, src_addr);
+        } else {
+            src_addr_.wildcard.set(id);
+        }
+        if (dst_addr) {
+            AddAddress(&dst_addr_, id, dst_addr);
+        } else {
+            dst_addr_.wildcard.set(id);
+        }
+    }
+
+    protocol_ = BuildRangeIndex(protocol_);
+    src_port_ = BuildRangeIndex(src_port_);
+    dst_port_ = BuildRangeIndex(dst_port_);
+    BuildAddress(&src_addr_);
+    BuildAddress(&dst_addr_);
+}
+
+AclClassifier::~AclClassifier() {
+    delete protocol_;
+    delete src_port_;
+    delete dst_port_;
+}
+
+static void SetIndexList(const vector<uint32_t> &list,
+                         AclClassifier::Bitmap *bitmap) {
+    for (vector<uint32_t>::const_iterator it = list.begin(); it != list.end();
+         ++it) {
+        bitmap->set(*it);
+    }
+}
+
+void AclClassifier::AddressLookup(const AddressIndex &index,
+                                  const IpAddress &ip,
+                                  const string *policy_id,
+                                  const SecurityGroupList *sg_id_l,
+                                  Bitmap *bitmap) const {
+    *bitmap = index.wildcard;
+    if (index.ipv4 && ip.is_v4()) {
+        index.ipv4->Lookup(ip.to_v4().to_ulong(), bitmap);
+    }
+    if (policy_id && !index.policy_ids.empty()) {
+        PolicyIdMap::const_iterator it = index.policy_ids.find(*policy_id);
+        if (it != index.policy_ids.end()) {
+            SetIndexList(it->second, bitmap);
+        }
+    }
+    if (sg_id_l && !index.sg_ids.empty()) {
+        SgIdMap::const_iterator it = index.sg_ids.find(AddressMatch::kAny);
+        if (it != index.sg_ids.end()) {
+            SetIndexList(it->second, bitmap);
+        }
+        for (SecurityGroupList::const_iterator sg = sg_id_l->begin();
+             sg != sg_id_l->end(); ++sg) {
+            it = index.sg_ids.find(*sg);
+            if (it != index.sg_ids.end()) {
+                SetIndexList(it->second, bitmap);
+            }
+        }
+    }
+}
+
+void AclClassifier::Lookup(const PacketHeader &packet_header,
+                           Bitmap *candidates) const {
+    candidates->resize(entries_.size());
+    candidates->set();
+    Bitmap bitmap(entries_.size());
+
+    if (protocol_) {
+        protocol_->Lookup(packet_header.protocol, &bitmap);
+        *candidates &= bitmap;
+    }
+
+    // Port conditions only apply to TCP and UDP
+    if (packet_header.protocol == IPPROTO_TCP ||
+        packet_header.protocol == IPPROTO_UDP) {
+        if (src_port_) {
+            bitmap.reset();
+            src_port_->Lookup(packet_header.src_port, &bitmap);
+            *candidates &= bitmap;
+        }
+        if (dst_port_) {
+            bitmap.reset();
+            dst_port_->Lookup(packet_header.dst_port, &bitmap);
+            *candidates &= bitmap;
+        }
+    }
+
+    AddressLookup(src_addr_, packet_header.src_ip,
+                  packet_header.src_policy_id, packet_header.src_sg_id_l,
+                  &bitmap);
+    *candidates &= bitmap;
+    AddressLookup(dst_addr_, packet_header.dst_ip,
+                  packet_header.dst_policy_id, packet_header.dst_sg_id_l,
+                  &bitmap);
+    *candidates &= bitmap;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef __AGENT_ACL_CLASSIFIER_H__
+#define __AGENT_ACL_CLASSIFIER_H__
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <boost/dynamic_bitset.hpp>
+#include <cmn/agent_cmn.h>
+#include <cmn/agent.h>
+
+class AclEntry;
+class AddressMatch;
+class RangeIndex;
+struct PacketHeader;
+
+// Packet classifier compiled from the entries of an ACL.
+//
+// Each of the protocol, source and destination port and source and
+// destination address fields of the packet header selects a bitmap of the
+// entries whose condition on the field may be met, and the entries in the
+// intersection of the bitmaps are the candidates that AclDBEntry matches
+// in order with AclEntry::PacketMatch(). A bitmap is a superset of the
+// entries matching on the field: entries without a condition on the field,
+// or whose condition is not indexed (IPv6 or non contiguous subnets), are
+// in all the bitmaps of the field. A field whose index would take more than
+// kMaxIndexSize entries is not indexed at all.
+//
+// Built when the entries of the ACL change, read only afterwards.
+class AclClassifier {
+public:
+    typedef boost::dynamic_bitset<> Bitmap;
+    typedef std::vector<const AclEntry *> AclEntryList;
+
+    static const size_t kMaxIndexSize = 1024 * 1024;
+
+    // Entries in ACL order
+    explicit AclClassifier(const AclEntryList &entries);
+    ~AclClassifier();
+
+    // Sets candidates to the entries that may match the packet
+    void Lookup(const PacketHeader &packet_header, Bitmap *candidates) const;
+
+    size_t size() const { return entries_.size(); }
+    const AclEntry *entry(size_t index) const { return entries_[index]; }
+
+private:
+    typedef std::vector<uint32_t> IndexList;
+    typedef std::map<std::string, IndexList> PolicyIdMap;
+    typedef std::map<int, IndexList> SgIdMap;
+
+    struct AddressIndex {
+        explicit AddressIndex(size_t size);
+        ~AddressIndex();
+
+        // Entries without an address condition that is indexed
+        Bitmap wildcard;
+        RangeIndex *ipv4;
+        PolicyIdMap policy_ids;
+        SgIdMap sg_ids;
+    };
+
+    static void AddAddress(AddressIndex *index, uint32_t id,
+                           const AddressMatch *match);
+    static void BuildAddress(AddressIndex *index);
+    void AddressLookup(const AddressIndex &index, const IpAddress &ip,
+                       const std::string *policy_id,
+                       const SecurityGroupList *sg_id_l,
+                       Bitmap *bitmap) const;
+
+    AclEntryList entries_;
+    RangeIndex *protocol_;
+    RangeIndex *src_port_;
+    RangeIndex *dst_port_;
+    AddressIndex src_addr_;
+    AddressIndex dst_addr_;
+
+    DISALLOW_COPY_AND_ASSIGN(AclClassifier);
+};
+
+#endif
@@ -55,6 +55,7 @@ public:
     bool IsTerminal() const;
 
     uint32_t id() const { return id_; }
+    const std::vector<AclEntryMatch *> &matches() const { return matches_; }
     const std::string &uuid() const { return uuid_; }
 
     boost::intrusive::list_member_hook<> acl_list_node;
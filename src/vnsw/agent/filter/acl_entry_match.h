@@ -34,6 +34,7 @@ public:
         }
         return Compare(rhs);
     }
+    Type type() const { return type_; }
 private:
     Type type_;
 };
@@ -75,6 +76,7 @@ public:
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data) = 0;
     virtual bool Match(const PacketHeader *packet_header) const = 0;
     virtual bool Compare(const AclEntryMatch &rhs) const;
+    const RangeSList &port_ranges() const { return port_ranges_; }
 protected:
     RangeSList port_ranges_;
 };
@@ -100,6 +102,7 @@ public:
     bool Match(const PacketHeader *packet_header) const;
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data);
     virtual bool Compare(const AclEntryMatch &rhs) const;
+    const RangeSList &protocol_ranges() const { return protocol_ranges_; }
 
 private:
     RangeSList protocol_ranges_;
@@ -133,6 +136,13 @@ public:
     bool Match(const PacketHeader *packet_header) const;
     void SetAclEntryMatchSandeshData(AclEntrySandeshData &data);
     virtual bool Compare(const AclEntryMatch &rhs) const;
+
+    AddressType addr_type() const { return addr_type_; }
+    bool is_source() const { return src_; }
+    const IpAddress &ip_addr() const { return ip_addr_; }
+    const IpAddress &ip_mask() const { return ip_mask_; }
+    const std::string &policy_id_str() const { return policy_id_s_; }
+    int sg_id() const { return sg_id_; }
 private:
     AddressType addr_type_;
     bool src_;
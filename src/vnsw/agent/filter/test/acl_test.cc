@@ -4,6 +4,8 @@
 
 #include "base/os.h"
 #include <boost/uuid/string_generator.hpp>
+#include <boost/random/linear_congruential.hpp>
+#include <boost/random/uniform_int.hpp>
 #include <test_cmn_util.h>
 #include <filter/packet_header.h>
 
@@ -15,6 +17,150 @@ void RouterIdDepInit(Agent *agent) {
 namespace {
 class AclTest : public ::testing::Test {
 protected:
+    AclTest() : rng_(1) {
+    }
+
+    // Number of entries of the largest ACL for the scale comparison. Can be
+    // overridden with ACL_TEST_ENTRIES.
+    static size_t EntryCount() {
+        char *str = getenv("ACL_TEST_ENTRIES");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 10000;
+    }
+
+    int Random(int min, int max) {
+        boost::uniform_int<int> value(min, max);
+        return value(rng_);
+    }
+
+    // Entries with a mix of subnet, network and security group addresses,
+    // protocols and destination port ranges, most of them terminal
+    void BuildEntrySpecs(size_t count, vector<AclEntrySpec> *specs) {
+        for (size_t i = 0; i < count; i++) {
+            AclEntrySpec ae_spec;
+            ae_spec.id = i + 1;
+            ae_spec.terminal = (Random(0, 9) != 0);
+
+            ae_spec.src_addr_type = AddressMatch::IP_ADDR;
+            ae_spec.src_ip_addr = Ip4Address(0x0A000000 |
+                                             (Random(0, 255) << 8));
+            ae_spec.src_ip_mask = Ip4Address(0xFFFFFF00);
+            switch (Random(0, 3)) {
+            case 0:
+                ae_spec.dst_addr_type = AddressMatch::NETWORK_ID;
+                ae_spec.dst_policy_id_str = (Random(0, 1) ? "vn1" : "vn2");
+                break;
+            case 1:
+                ae_spec.dst_addr_type = AddressMatch::SG;
+                ae_spec.dst_sg_id = Random(1, 16);
+                break;
+            default:
+                ae_spec.dst_addr_type = AddressMatch::IP_ADDR;
+                ae_spec.dst_ip_addr = Ip4Address(0x14000000 |
+                                                 (Random(0, 4095) << 4));
+                ae_spec.dst_ip_mask = Ip4Address(0xFFFFFFF0);
+                break;
+            }
+
+            RangeSpec protocol;
+            protocol.min = protocol.max = (Random(0, 1) ? 6 : 17);
+            ae_spec.protocol.push_back(protocol);
+            RangeSpec port;
+            port.min = Random(1, 60000);
+            port.max = port.min + Random(0, 15);
+            ae_spec.dst_port.push_back(port);
+
+            ActionSpec action;
+            action.ta_type = TrafficAction::SIMPLE_ACTION;
+            action.simple_action = (Random(0, 1) ? TrafficAction::PASS :
+                                    TrafficAction::DENY);
+            ae_spec.action_l.push_back(action);
+            specs->push_back(ae_spec);
+        }
+    }
+
+    void BuildPacket(PacketHeader *packet) {
+        packet->src_ip = Ip4Address(0x0A000000 | Random(0, 0xFFFF));
+        packet->dst_ip = Ip4Address(0x14000000 | Random(0, 0xFFFF));
+        packet->src_policy_id = &vn1_;
+        packet->dst_policy_id = (Random(0, 1) ? &vn1_ : &vn2_);
+        packet->src_sg_id_l = &sg_list_;
+        packet->dst_sg_id_l = &sg_list_;
+        packet->protocol = (Random(0, 1) ? 6 : 17);
+        packet->src_port = Random(1, 65535);
+        packet->dst_port = Random(1, 60015);
+    }
+
+    AclDBEntry *AddAclSpec(const uuid &acl_id,
+                           const vector<AclEntrySpec> &specs) {
+        AclSpec acl_spec;
+        acl_spec.acl_id = acl_id;
+        acl_spec.acl_entry_specs_ = specs;
+        DBRequest req;
+        req.key.reset(new AclKey(acl_id));
+        req.data.reset(new AclData(acl_spec));
+        req.oper = DBRequest::DB_ENTRY_ADD_CHANGE;
+        Agent::GetInstance()->acl_table()->Enqueue(&req);
+        client->WaitForIdle();
+        AclKey key(acl_id);
+        return static_cast<AclDBEntry *>(
+            Agent::GetInstance()->acl_table()->FindActiveEntry(&key));
+    }
+
+    void DeleteAclSpec(const uuid &acl_id) {
+        DBRequest req;
+        req.key.reset(new AclKey(acl_id));
+        req.oper = DBRequest::DB_ENTRY_DELETE;
+        Agent::GetInstance()->acl_table()->Enqueue(&req);
+        client->WaitForIdle();
+    }
+
+    // Adds an ACL that is matched with a linear scan of its entries and an
+    // ACL with the same entries that is matched with a classifier
+    void AddAclPair(const vector<AclEntrySpec> &specs, AclDBEntry **linear,
+                    AclDBEntry **classified) {
+        AclDBEntry::SetClassifierMinEntries(specs.size() + 1);
+        *linear = AddAclSpec(linear_id_, specs);
+        AclDBEntry::SetClassifierMinEntries(0);
+        *classified = AddAclSpec(classified_id_, specs);
+        AclDBEntry::SetClassifierMinEntries(
+            AclDBEntry::kDefaultClassifierMinEntries);
+        ASSERT_TRUE(*linear != NULL);
+        ASSERT_TRUE(*classified != NULL);
+        EXPECT_FALSE((*linear)->has_classifier());
+        EXPECT_TRUE((*classified)->has_classifier());
+    }
+
+    void DeleteAclPair() {
+        DeleteAclSpec(linear_id_);
+        DeleteAclSpec(classified_id_);
+    }
+
+    static void ExpectSameMatch(const MatchAclParams &expected,
+                                const MatchAclParams &result) {
+        EXPECT_EQ(expected.action_info.action, result.action_info.action);
+        EXPECT_EQ(expected.terminal_rule, result.terminal_rule);
+        EXPECT_TRUE(expected.ace_id_list == result.ace_id_list);
+    }
+
+    virtual void SetUp() {
+        boost::uuids::string_generator gen;
+        linear_id_ = gen("00000000-0000-0000-0000-000000000101");
+        classified_id_ = gen("00000000-0000-0000-0000-000000000102");
+        vn1_ = "vn1";
+        vn2_ = "vn2";
+        sg_list_.clear();
+        sg_list_.push_back(Random(1, 16));
+    }
+
+    boost::rand48 rng_;
+    uuid linear_id_;
+    uuid classified_id_;
+    string vn1_;
+    string vn2_;
+    SecurityGroupList sg_list_;
 };
 
 static string AddAclXmlString(const char *node_name, const char *name, int id) {
@@ -317,6 +463,105 @@ TEST_F(AclTest, Config) {
     EXPECT_EQ(action, m_acl.action_info.action);
     delete packet1;
 }
+// The classifier gives the same result as a linear scan of the entries, as
+// the ACL is modified
+TEST_F(AclTest, ClassifierMatch) {
+    vector<AclEntrySpec> specs;
+    BuildEntrySpecs(500, &specs);
+    AclDBEntry *linear, *classified;
+    AddAclPair(specs, &linear, &classified);
+
+    for (int i = 0; i < 20000; i++) {
+        PacketHeader packet;
+        BuildPacket(&packet);
+        MatchAclParams expected, result;
+        FlowPolicyInfo expected_info(""), result_info("");
+        bool match = linear->PacketMatch(packet, expected, &expected_info);
+        EXPECT_EQ(match, classified->PacketMatch(packet, result,
+                                                 &result_info));
+        ExpectSameMatch(expected, result);
+        EXPECT_EQ(expected_info.uuid, result_info.uuid);
+        EXPECT_EQ(expected_info.drop, result_info.drop);
+    }
+
+    // Packet that only matches the first entry, made non terminal, and an
+    // entry added at the end
+    PacketHeader packet;
+    packet.src_ip = specs[0].src_ip_addr;
+    packet.dst_ip = Ip4Address(0x1E000000);
+    packet.src_policy_id = &vn1_;
+    packet.protocol = specs[0].protocol[0].min;
+    packet.dst_port = specs[0].dst_port[0].min;
+    specs[0].terminal = false;
+    specs[0].dst_addr_type = AddressMatch::NETWORK_ID;
+    specs[0].dst_policy_id_str = "any";
+    AclEntrySpec ae_spec;
+    ae_spec.id = specs.size() + 1;
+    ae_spec.terminal = true;
+    ActionSpec action;
+    action.ta_type = TrafficAction::SIMPLE_ACTION;
+    action.simple_action = TrafficAction::DENY;
+    ae_spec.action_l.push_back(action);
+    specs.push_back(ae_spec);
+    AddAclPair(specs, &linear, &classified);
+
+    MatchAclParams expected, result;
+    EXPECT_TRUE(linear->PacketMatch(packet, expected, NULL));
+    EXPECT_TRUE(classified->PacketMatch(packet, result, NULL));
+    ExpectSameMatch(expected, result);
+    ASSERT_EQ(2U, result.ace_id_list.size());
+    EXPECT_EQ((int32_t)specs[0].id, result.ace_id_list[0]);
+    EXPECT_EQ((int32_t)ae_spec.id, result.ace_id_list[1]);
+    EXPECT_TRUE(result.terminal_rule);
+
+    DeleteAclPair();
+}
+
+// Compare the time taken to match packets with a linear scan of the entries
+// and with the classifier, for ACLs of 1000 and EntryCount() entries
+TEST_F(AclTest, ClassifierScale) {
+    const size_t kPacketCount = 10000;
+    vector<size_t> counts;
+    counts.push_back(1000);
+    counts.push_back(EntryCount());
+
+    for (size_t i = 0; i < counts.size(); i++) {
+        vector<AclEntrySpec> specs;
+        BuildEntrySpecs(counts[i], &specs);
+        AclDBEntry *linear, *classified;
+        uint64_t start = ClockMonotonicUsec();
+        AddAclPair(specs, &linear, &classified);
+        uint64_t add_time = ClockMonotonicUsec() - start;
+
+        vector<PacketHeader> packets(kPacketCount);
+        for (size_t j = 0; j < kPacketCount; j++) {
+            BuildPacket(&packets[j]);
+        }
+
+        vector<MatchAclParams> expected(kPacketCount);
+        start = ClockMonotonicUsec();
+        for (size_t j = 0; j < kPacketCount; j++) {
+            linear->PacketMatch(packets[j], expected[j], NULL);
+        }
+        uint64_t linear_time = ClockMonotonicUsec() - start;
+
+        vector<MatchAclParams> result(kPacketCount);
+        start = ClockMonotonicUsec();
+        for (size_t j = 0; j < kPacketCount; j++) {
+            classified->PacketMatch(packets[j], result[j], NULL);
+        }
+        uint64_t classifier_time = ClockMonotonicUsec() - start;
+
+        for (size_t j = 0; j < kPacketCount; j++) {
+            ExpectSameMatch(expected[j], result[j]);
+        }
+        cout << counts[i] << " entries, " << kPacketCount << " packets, "
+             << "add " << add_time << " usec" << endl;
+        cout << "Linear     : " << linear_time << " usec" << endl;
+        cout << "Classifier : " << classifier_time << " usec" << endl;
+        DeleteAclPair();
+    }
+}
 } //namespace
 
 int main (int argc, char **argv) {
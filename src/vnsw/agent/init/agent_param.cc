@@ -403,6 +403,11 @@ void AgentParam::ParseDefaultSection() {
                                     "DEFAULT.flow_cache_timeout")) {
         flow_cache_timeout_ = Agent::kDefaultFlowCacheTimeout;
     }
+
+    if (!GetValueFromTree<uint16_t>(flow_export_batch_size_,
+                                    "DEFAULT.flow_export_batch_size")) {
+        flow_export_batch_size_ = Agent::kDefaultFlowExportBatchSize;
+    }
     
     if (!GetValueFromTree<string>(log_level_, "DEFAULT.log_level")) {
         log_level_ = "SYS_DEBUG";
@@ -465,6 +470,10 @@ void AgentParam::ParseFlows() {
         "FLOWS.max_vm_linklocal_flows")) {
         linklocal_vm_flows_ = Agent::kDefaultMaxLinkLocalOpenFds;
     }
+    if (!GetValueFromTree<uint16_t>(flow_thread_count_,
+        "FLOWS.thread_count")) {
+        flow_thread_count_ = Agent::kDefaultFlowThreadCount;
+    }
 }
 
 void AgentParam::ParseHeadlessMode() {
@@ -584,6 +593,8 @@ void AgentParam::ParseDefaultSectionArguments
     (const boost::program_options::variables_map &var_map) {
     GetOptValue<uint16_t>(var_map, flow_cache_timeout_, 
                           "DEFAULT.flow_cache_timeout");
+    GetOptValue<uint16_t>(var_map, flow_export_batch_size_,
+                          "DEFAULT.flow_export_batch_size");
     GetOptValue<string>(var_map, host_name_, "DEFAULT.hostname");
     GetOptValue<string>(var_map, agent_name_, "DEFAULT.agent_name");
     GetOptValue<uint16_t>(var_map, http_server_port_, 
@@ -621,6 +632,7 @@ void AgentParam::ParseFlowArguments
                           "FLOWS.max_system_linklocal_flows");
     GetOptValue<uint16_t>(var_map, linklocal_vm_flows_,
                           "FLOWS.max_vm_linklocal_flows");
+    GetOptValue<uint16_t>(var_map, flow_thread_count_, "FLOWS.thread_count");
 }
 
 void AgentParam::ParseHeadlessModeArguments
@@ -723,6 +735,10 @@ void AgentParam::ComputeFlowLimits() {
         cout << "Updating flows configuration max-vm-flows to : 0%\n";
         max_vm_flows_ = 0;
     }
+    if (flow_thread_count_ == 0) {
+        cout << "Updating flows configuration thread-count to : 1\n";
+        flow_thread_count_ = 1;
+    }
 
     struct rlimit rl;
     int result = getrlimit(RLIMIT_NOFILE, &rl);
@@ -890,7 +906,9 @@ void AgentParam::LogConfig() const {
     LOG(DEBUG, "Max Vm Flows                : " << max_vm_flows_);
     LOG(DEBUG, "Linklocal Max System Flows  : " << linklocal_system_flows_);
     LOG(DEBUG, "Linklocal Max Vm Flows      : " << linklocal_vm_flows_);
+    LOG(DEBUG, "Flow Thread Count           : " << flow_thread_count_);
     LOG(DEBUG, "Flow cache timeout          : " << flow_cache_timeout_);
+    LOG(DEBUG, "Flow export batch size      : " << flow_export_batch_size_);
     LOG(DEBUG, "Headless Mode               : " << headless_mode_);
     if (simulate_evpn_tor_) {
         LOG(DEBUG, "Simulate EVPN TOR           : " << simulate_evpn_tor_);
@@ -966,7 +984,9 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
         mgmt_ip_(), mode_(MODE_KVM), xen_ll_(),
         tunnel_type_(), metadata_shared_secret_(), max_vm_flows_(),
         linklocal_system_flows_(), linklocal_vm_flows_(),
-        flow_cache_timeout_(), config_file_(), program_name_(),
+        flow_thread_count_(Agent::kDefaultFlowThreadCount),
+        flow_cache_timeout_(), flow_export_batch_size_(),
+        config_file_(), program_name_(),
         log_file_(), log_local_(false), log_flow_(false), log_level_(),
         log_category_(), use_syslog_(false),
         http_server_port_(), host_name_(),
@@ -1001,6 +1021,9 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
         ("DEFAULT.flow_cache_timeout", 
          opt::value<uint16_t>()->default_value(agent->kDefaultFlowCacheTimeout),
          "Flow aging time in seconds")
+        ("DEFAULT.flow_export_batch_size",
+         opt::value<uint16_t>()->default_value(agent->kDefaultFlowExportBatchSize),
+         "Flow records sent per flow log message, 0 to send one per message")
         ("DEFAULT.hostname", opt::value<string>(), 
          "Hostname of compute-node")
         ("DEFAULT.headless", opt::value<bool>(),
@@ -1056,6 +1079,8 @@ AgentParam::AgentParam(Agent *agent, bool enable_flow_options,
              "Maximum number of link-local flows allowed across all VMs")
             ("FLOWS.max_vm_linklocal_flows", opt::value<uint16_t>(), 
              "Maximum number of link-local flows allowed per VM")
+            ("FLOWS.thread_count", opt::value<uint16_t>(),
+             "Number of flow table partitions, each set up by its own thread")
             ;
         options_.add(flow);
     }
@@ -95,7 +95,9 @@ public:
     float max_vm_flows() const { return max_vm_flows_; }
     uint32_t linklocal_system_flows() const { return linklocal_system_flows_; }
     uint32_t linklocal_vm_flows() const { return linklocal_vm_flows_; }
+    uint16_t flow_thread_count() const { return flow_thread_count_; }
     uint32_t flow_cache_timeout() const {return flow_cache_timeout_;}
+    uint32_t flow_export_batch_size() const {return flow_export_batch_size_;}
     bool headless_mode() const {return headless_mode_;}
     bool simulate_evpn_tor() const {return simulate_evpn_tor_;}
     std::string si_netns_command() const {return si_netns_command_;}
@@ -128,6 +130,7 @@ public:
     int vrouter_stats_interval() const { return vrouter_stats_interval_; }
     void set_agent_stats_interval(int val) { agent_stats_interval_ = val; }
     void set_flow_stats_interval(int val) { flow_stats_interval_ = val; }
+    void set_flow_thread_count(uint16_t count) { flow_thread_count_ = count; }
     void set_vrouter_stats_interval(int val) { vrouter_stats_interval_ = val; }
     VirtualGatewayConfigTable *vgw_config_table() const { 
         return vgw_config_table_.get();
@@ -274,7 +277,9 @@ private:
     float max_vm_flows_;
     uint16_t linklocal_system_flows_;
     uint16_t linklocal_vm_flows_;
+    uint16_t flow_thread_count_;
     uint16_t flow_cache_timeout_;
+    uint16_t flow_export_batch_size_;
 
     // Parameters configured from command line arguments only (for now)
     std::string config_file_;
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/os.h"
+#include <cmn/agent_cmn.h>
+#include <ksync/ksync_sock.h>
+#include <ksync/ksync_sock_user.h>
+
+#include "test/test_cmn_util.h"
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+#define MAX_TEST_PORTS 16
+
+struct PortInfo input[MAX_TEST_PORTS];
+
+class TestKSyncBulk : public ::testing::Test {
+public:
+    virtual void SetUp() {
+        sock_ = KSyncSock::Get(0);
+        for (int i = 0; i < MAX_TEST_PORTS; i++) {
+            sprintf(input[i].name, "vnet%d", i + 1);
+            input[i].intf_id = i + 1;
+            sprintf(input[i].addr, "1.1.1.%d", i + 1);
+            sprintf(input[i].mac, "00:00:00:01:01:%02x", i + 1);
+            input[i].vn_id = 1;
+            input[i].vm_id = i + 1;
+        }
+        if_count_ = KSyncSockTypeMap::IfCount();
+        nh_count_ = KSyncSockTypeMap::NHCount();
+        rt_count_ = KSyncSockTypeMap::RouteCount();
+        mpls_count_ = KSyncSockTypeMap::MplsCount();
+    }
+
+    virtual void TearDown() {
+        KSyncSock::SetBulkMode(false);
+        KSyncSockTypeMap::set_bulk_supported(true);
+    }
+
+    // Add and delete ports, checking that vrouter state in
+    // KSyncSockTypeMap is the same as in non-bulk mode
+    void AddDeletePorts() {
+        CreateVmportEnv(input, MAX_TEST_PORTS);
+        client->WaitForIdle();
+        for (int i = 0; i < MAX_TEST_PORTS; i++) {
+            EXPECT_TRUE(VmPortActive(input, i));
+        }
+        added_if_count_ = KSyncSockTypeMap::IfCount();
+        added_nh_count_ = KSyncSockTypeMap::NHCount();
+        added_rt_count_ = KSyncSockTypeMap::RouteCount();
+        added_mpls_count_ = KSyncSockTypeMap::MplsCount();
+        EXPECT_EQ(if_count_ + MAX_TEST_PORTS, added_if_count_);
+
+        DeleteVmportEnv(input, MAX_TEST_PORTS, true);
+        client->WaitForIdle();
+        for (int i = 0; i < MAX_TEST_PORTS; i++) {
+            WAIT_FOR(1000, 100, (VmPortFindRetDel(i + 1) == false));
+        }
+        EXPECT_EQ(if_count_, KSyncSockTypeMap::IfCount());
+        EXPECT_EQ(nh_count_, KSyncSockTypeMap::NHCount());
+        EXPECT_EQ(rt_count_, KSyncSockTypeMap::RouteCount());
+        EXPECT_EQ(mpls_count_, KSyncSockTypeMap::MplsCount());
+    }
+
+    KSyncSock *sock_;
+    int if_count_;
+    int nh_count_;
+    int rt_count_;
+    int mpls_count_;
+    int added_if_count_;
+    int added_nh_count_;
+    int added_rt_count_;
+    int added_mpls_count_;
+};
+
+TEST_F(TestKSyncBulk, NonBulk) {
+    uint64_t bulk_send_count = sock_->bulk_send_count();
+    AddDeletePorts();
+    EXPECT_EQ(bulk_send_count, sock_->bulk_send_count());
+}
+
+TEST_F(TestKSyncBulk, Bulk) {
+    AddDeletePorts();
+    int if_count = added_if_count_;
+    int nh_count = added_nh_count_;
+    int rt_count = added_rt_count_;
+    int mpls_count = added_mpls_count_;
+
+    KSyncSock::SetBulkMode(true);
+    EXPECT_TRUE(sock_->bulk_mode());
+    uint64_t bulk_send_count = sock_->bulk_send_count();
+    uint64_t bulk_msg_count = sock_->bulk_msg_count();
+
+    AddDeletePorts();
+    EXPECT_EQ(if_count, added_if_count_);
+    EXPECT_EQ(nh_count, added_nh_count_);
+    EXPECT_EQ(rt_count, added_rt_count_);
+    EXPECT_EQ(mpls_count, added_mpls_count_);
+
+    // Messages were packed, with more than one message per bulk message
+    uint64_t sent = sock_->bulk_send_count() - bulk_send_count;
+    uint64_t packed = sock_->bulk_msg_count() - bulk_msg_count;
+    EXPECT_LT(0U, sent);
+    EXPECT_LT(sent, packed);
+    EXPECT_LE(2U, sock_->bulk_max_msg_count());
+    EXPECT_GE((uint32_t) KSyncSock::kBulkBatchSize,
+              sock_->bulk_max_msg_count());
+    EXPECT_GE(sock_->bulk_send_count() * KSyncSock::kBufLen,
+              sock_->bulk_bytes());
+}
+
+// Bulk mode is not enabled if the responder does not support it
+TEST_F(TestKSyncBulk, BulkNotSupported) {
+    KSyncSockTypeMap::set_bulk_supported(false);
+    KSyncSock::SetBulkMode(true);
+    EXPECT_FALSE(sock_->bulk_mode());
+
+    uint64_t bulk_send_count = sock_->bulk_send_count();
+    AddDeletePorts();
+    EXPECT_EQ(bulk_send_count, sock_->bulk_send_count());
+}
+
+int main(int argc, char *argv[]) {
+    GETUSERARGS();
+
+    /* Bulk responses are simulated by KSyncSockTypeMap */
+    ksync_init = false;
+
+    client = TestInit(init_file, ksync_init);
+    int ret = RUN_ALL_TESTS();
+    TestShutdown();
+    delete client;
+    return ret;
+}
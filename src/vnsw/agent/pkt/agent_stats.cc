@@ -50,15 +50,23 @@ void AgentStatsReq::HandleRequest() const {
     pkt->set_more(true);
     pkt->Response();
 
+    FlowTable *flow_table = agent->pkt()->flow_table();
+    size_t flow_count = flow_table->Size();
+    size_t flow_bytes = flow_table->allocated_bytes();
     FlowStatsResp *flow = new FlowStatsResp();
-    flow->set_flow_active(agent->pkt()->flow_table()->Size());
+    flow->set_flow_active(flow_count);
     flow->set_flow_created(stats->flow_created());
     flow->set_flow_aged(stats->flow_aged());
     flow->set_flow_drop_due_to_max_limit(stats->flow_drop_due_to_max_limit());
     flow->set_flow_drop_due_to_linklocal_limit(
             stats->flow_drop_due_to_linklocal_limit());
     flow->set_flow_max_system_flows(agent->flow_table_size());
-    flow->set_flow_max_vm_flows(agent->pkt()->flow_table()->max_vm_flows());
+    flow->set_flow_max_vm_flows(flow_table->max_vm_flows());
+    flow->set_flow_memory_bytes(flow_bytes);
+    flow->set_flow_memory_bytes_per_flow(flow_count ?
+                                         flow_bytes / flow_count : 0);
+    flow->set_flow_lookups(flow_table->lookup_count());
+    flow->set_flow_lookup_avg_nsec(flow_table->lookup_avg_nsec());
     flow->set_context(context());
     flow->set_more(true);
     flow->Response();
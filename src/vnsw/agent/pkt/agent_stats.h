@@ -7,6 +7,8 @@
 #ifndef vnsw_agent_stats_hpp
 #define vnsw_agent_stats_hpp
 
+#include <tbb/atomic.h>
+
 class AgentStats {
 public:
     AgentStats(Agent *agent)
@@ -14,11 +16,13 @@ public:
         sandesh_reconnects_(0U), sandesh_in_msgs_(0U), sandesh_out_msgs_(0U),
         sandesh_http_sessions_(0U), nh_count_(0U), pkt_exceptions_(0U),
         pkt_invalid_agent_hdr_(0U), pkt_invalid_interface_(0U), 
-        pkt_no_handler_(0U), pkt_dropped_(0U), flow_created_(0U),
-        flow_aged_(0U), flow_active_(0U), flow_drop_due_to_max_limit_(0),
-        flow_drop_due_to_linklocal_limit_(0), ipc_in_msgs_(0U),
-        ipc_out_msgs_(0U), in_tpkts_(0U), in_bytes_(0U), out_tpkts_(0U),
-        out_bytes_(0U) {
+        pkt_no_handler_(0U), pkt_dropped_(0U), flow_active_(0U),
+        ipc_in_msgs_(0U), ipc_out_msgs_(0U), in_tpkts_(0U), in_bytes_(0U),
+        out_tpkts_(0U), out_bytes_(0U) {
+        flow_created_ = 0;
+        flow_aged_ = 0;
+        flow_drop_due_to_max_limit_ = 0;
+        flow_drop_due_to_linklocal_limit_ = 0;
         assert(singleton_ == NULL);
         singleton_ = this;
     }
@@ -122,12 +126,12 @@ private:
     uint64_t pkt_no_handler_;
     uint64_t pkt_dropped_;
 
-    // Flow stats
-    uint64_t flow_created_;
-    uint64_t flow_aged_;
+    // Flow stats, updated by the flow handler of each flow table partition
+    tbb::atomic<uint64_t> flow_created_;
+    tbb::atomic<uint64_t> flow_aged_;
     uint64_t flow_active_;
-    uint64_t flow_drop_due_to_max_limit_;
-    uint64_t flow_drop_due_to_linklocal_limit_;
+    tbb::atomic<uint64_t> flow_drop_due_to_max_limit_;
+    tbb::atomic<uint64_t> flow_drop_due_to_linklocal_limit_;
 
     // Kernel IPC
     uint64_t ipc_in_msgs_;
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include <algorithm>
+#include <functional>
+#include <pkt/flow_index.h>
+#include <pkt/flow_table.h>
+
+static inline uint32_t HashCombine(uint32_t seed, uint32_t value) {
+    return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+static uint32_t AddressHash(uint32_t seed, const IpAddress &addr) {
+    if (addr.is_v4()) {
+        return HashCombine(seed, addr.to_v4().to_ulong());
+    }
+    const Ip6Address::bytes_type bytes = addr.to_v6().to_bytes();
+    for (size_t i = 0; i < bytes.size(); i += 4) {
+        seed = HashCombine(seed, (bytes[i] << 24) | (bytes[i + 1] << 16) |
+                           (bytes[i + 2] << 8) | bytes[i + 3]);
+    }
+    return seed;
+}
+
+const size_t FlowEntryPool::kTrimFreeCount;
+
+FlowEntryIndex::FlowEntryIndex() :
+    slots_(kMinBuckets + kMaxProbe), bucket_count_(kMinBuckets),
+    hash_shift_(32), size_(0), deleted_count_(0), probe_count_(0) {
+    for (size_t count = bucket_count_; count > 1; count >>= 1) {
+        hash_shift_--;
+    }
+}
+
+FlowEntryIndex::~FlowEntryIndex() {
+}
+
+// Unlike FlowTable::PartitionHash() the hash covers the complete key, and
+// the result is mixed so that the low order bits used to pick a bucket are
+// not the ones that picked the partition.
+uint32_t FlowEntryIndex::Hash(const FlowKey &key) {
+    uint32_t hash = HashCombine(key.family, key.nh);
+    hash = AddressHash(hash, key.src_addr);
+    hash = AddressHash(hash, key.dst_addr);
+    hash = HashCombine(hash, ((uint32_t)key.src_port << 16) | key.dst_port);
+    hash = HashCombine(hash, key.protocol);
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6b;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+size_t FlowEntryIndex::FindSlot(const FlowKey &key, uint32_t hash) const {
+    size_t slot = HomeSlot(hash);
+    for (size_t end = slot + kMaxProbe; slot < end; slot++) {
+        const Slot &entry = slots_[slot];
+        if (entry.state == EMPTY) {
+            break;
+        }
+        probe_count_++;
+        if (entry.state == USED && entry.hash == hash &&
+            entry.flow->key().IsEqual(key)) {
+            return slot;
+        }
+    }
+    return slots_.size();
+}
+
+FlowEntry *FlowEntryIndex::Find(const FlowKey &key) const {
+    size_t slot = FindSlot(key, Hash(key));
+    if (slot == slots_.size()) {
+        return NULL;
+    }
+    return slots_[slot].flow;
+}
+
+bool FlowEntryIndex::InsertSlot(FlowEntry *flow, uint32_t hash) {
+    size_t slot = HomeSlot(hash);
+    for (size_t end = slot + kMaxProbe; slot < end; slot++) {
+        Slot &entry = slots_[slot];
+        if (entry.state == USED) {
+            continue;
+        }
+        if (entry.state == DELETED) {
+            deleted_count_--;
+        }
+        entry.flow = flow;
+        entry.hash = hash;
+        entry.state = USED;
+        size_++;
+        return true;
+    }
+    return false;
+}
+
+void FlowEntryIndex::Insert(FlowEntry *flow) {
+    uint32_t hash = Hash(flow->key());
+    // Keep the load factor, tombstones included, at or below one half. The
+    // index is rebuilt without tombstones when it goes above, grown or
+    // shrunk so that flows take at most a quarter of the buckets.
+    if ((size_ + deleted_count_ + 1) * 2 > bucket_count_) {
+        size_t bucket_count = kMinBuckets;
+        while ((size_ + 1) * 4 > bucket_count) {
+            bucket_count *= 2;
+        }
+        Resize(bucket_count);
+    }
+    while (InsertSlot(flow, hash) == false) {
+        Resize(bucket_count_ * 2);
+    }
+}
+
+bool FlowEntryIndex::Remove(FlowEntry *flow) {
+    const FlowKey &key = flow->key();
+    size_t slot = FindSlot(key, Hash(key));
+    if (slot == slots_.size() || slots_[slot].flow != flow) {
+        return false;
+    }
+    Slot &entry = slots_[slot];
+    entry.flow = NULL;
+    entry.state = DELETED;
+    size_--;
+    deleted_count_++;
+    return true;
+}
+
+// True if the flow in entry is ordered after hash and key
+bool FlowEntryIndex::IsAfter(const Slot &entry, uint32_t hash,
+                             const FlowKey &key) {
+    if (entry.hash != hash) {
+        return entry.hash > hash;
+    }
+    return key.IsLess(entry.flow->key());
+}
+
+// Flow ordered next after hash and key, or the first flow if key is NULL.
+// A flow is at most kMaxProbe slots past its home slot, so once a candidate
+// is found only the slots upto kMaxProbe past its home slot can hold a flow
+// ordered before it.
+FlowEntry *FlowEntryIndex::FindNext(uint32_t hash, const FlowKey *key) const {
+    size_t slot = key ? HomeSlot(hash) : 0;
+    size_t end = slots_.size();
+    const Slot *next = NULL;
+    for (; slot < end; slot++) {
+        const Slot &entry = slots_[slot];
+        if (entry.state != USED) {
+            continue;
+        }
+        if (key && !IsAfter(entry, hash, *key)) {
+            continue;
+        }
+        if (next == NULL || IsAfter(*next, entry.hash, entry.flow->key())) {
+            next = &entry;
+            end = std::min(end, HomeSlot(entry.hash) + kMaxProbe);
+        }
+    }
+    return next ? next->flow : NULL;
+}
+
+FlowEntry *FlowEntryIndex::GetFirst() const {
+    return FindNext(0, NULL);
+}
+
+FlowEntry *FlowEntryIndex::GetNext(const FlowKey &key) const {
+    return FindNext(Hash(key), &key);
+}
+
+void FlowEntryIndex::Resize(size_t bucket_count) {
+    if (bucket_count < kMinBuckets) {
+        bucket_count = kMinBuckets;
+    }
+
+    SlotList old_slots;
+    old_slots.swap(slots_);
+    while (true) {
+        bucket_count_ = bucket_count;
+        hash_shift_ = 32;
+        for (size_t count = bucket_count_; count > 1; count >>= 1) {
+            hash_shift_--;
+        }
+        slots_.assign(bucket_count_ + kMaxProbe, Slot());
+        size_ = 0;
+        deleted_count_ = 0;
+
+        SlotList::const_iterator it = old_slots.begin();
+        for (; it != old_slots.end(); ++it) {
+            if (it->state == USED && InsertSlot(it->flow, it->hash) == false) {
+                break;
+            }
+        }
+        if (it == old_slots.end()) {
+            return;
+        }
+        // A probe ran past the overflow slots, try with more buckets
+        bucket_count *= 2;
+    }
+}
+
+FlowEntryPool::FlowEntryPool() :
+    slab_list_(), free_list_(NULL), entry_size_(sizeof(FlowEntry)),
+    in_use_count_(0), free_count_(0), trim_free_count_(kTrimFreeCount) {
+    // Keep entries aligned as the heap would
+    const size_t align = 2 * sizeof(void *);
+    entry_size_ = (entry_size_ + align - 1) & ~(align - 1);
+}
+
+FlowEntryPool::~FlowEntryPool() {
+    for (SlabList::iterator it = slab_list_.begin(); it != slab_list_.end();
+         ++it) {
+        delete [] *it;
+    }
+}
+
+void FlowEntryPool::AddSlab() {
+    char *slab = new char[kSlabSize * entry_size_];
+    slab_list_.insert(std::upper_bound(slab_list_.begin(), slab_list_.end(),
+                                       slab, std::less<char *>()), slab);
+    // Entries of the slab are handed out in address order
+    for (size_t i = kSlabSize; i > 0; i--) {
+        FreeEntry *entry =
+            reinterpret_cast<FreeEntry *>(slab + (i - 1) * entry_size_);
+        entry->next = free_list_;
+        free_list_ = entry;
+    }
+    free_count_ += kSlabSize;
+}
+
+void *FlowEntryPool::Allocate() {
+    if (free_list_ == NULL) {
+        AddSlab();
+        trim_free_count_ = kTrimFreeCount;
+    }
+    FreeEntry *entry = free_list_;
+    free_list_ = entry->next;
+    free_count_--;
+    in_use_count_++;
+    return entry;
+}
+
+void FlowEntryPool::Free(void *ptr) {
+    FreeEntry *entry = static_cast<FreeEntry *>(ptr);
+    entry->next = free_list_;
+    free_list_ = entry;
+    free_count_++;
+    in_use_count_--;
+    if (free_count_ > trim_free_count_ && free_count_ > in_use_count_) {
+        Trim();
+    }
+}
+
+// Index of the slab holding entry
+size_t FlowEntryPool::SlabIndex(const void *entry) const {
+    SlabList::const_iterator it =
+        std::upper_bound(slab_list_.begin(), slab_list_.end(),
+                         static_cast<char *>(const_cast<void *>(entry)),
+                         std::less<char *>());
+    assert(it != slab_list_.begin());
+    return (it - slab_list_.begin()) - 1;
+}
+
+void FlowEntryPool::Trim() {
+    std::vector<size_t> free_entries(slab_list_.size(), 0);
+    for (FreeEntry *entry = free_list_; entry != NULL; entry = entry->next) {
+        free_entries[SlabIndex(entry)]++;
+    }
+
+    // Unlink the entries of free slabs, keeping the order of the others
+    FreeEntry **prev = &free_list_;
+    while (*prev != NULL) {
+        if (free_entries[SlabIndex(*prev)] == kSlabSize) {
+            *prev = (*prev)->next;
+        } else {
+            prev = &(*prev)->next;
+        }
+    }
+
+    SlabList slab_list;
+    for (size_t i = 0; i < slab_list_.size(); i++) {
+        if (free_entries[i] == kSlabSize) {
+            delete [] slab_list_[i];
+            free_count_ -= kSlabSize;
+        } else {
+            slab_list.push_back(slab_list_[i]);
+        }
+    }
+    slab_list_.swap(slab_list);
+    // Scanning the free list is paid for by the entries freed till the next
+    // trim
+    trim_free_count_ =
+        free_count_ + std::max(kTrimFreeCount, free_count_ / 2);
+}
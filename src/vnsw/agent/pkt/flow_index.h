@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#ifndef vnsw_agent_flow_index_h
+#define vnsw_agent_flow_index_h
+
+#include <stdint.h>
+#include <vector>
+#include <base/util.h>
+
+class FlowEntry;
+struct FlowKey;
+
+// Open addressing hash index of the flows in a flow table partition.
+//
+// Flows are placed with linear probing from the bucket picked by the high
+// order bits of the flow hash. Probes do not wrap around: the slot array has
+// kMaxProbe overflow slots past the last bucket and the index is grown when
+// a probe would run past them. The slot of a deleted flow is left as a
+// tombstone, so flows only move when Insert() resizes the index to drop
+// tombstones or change the number of buckets.
+//
+// Iteration is in order of flow hash, and of key for flows with the same
+// hash, which does not depend on where the flows are in the slot array. So
+// GetNext() of a key, present or not, resumes at the same point across
+// resizes and reuse of slots: flows present throughout the iteration are
+// visited once, and flows added during the iteration are visited only if
+// they are ordered after the last key.
+//
+// Not thread safe.
+class FlowEntryIndex {
+public:
+    static const size_t kMinBuckets = 256;
+    static const size_t kMaxProbe = 64;
+
+    FlowEntryIndex();
+    ~FlowEntryIndex();
+
+    static uint32_t Hash(const FlowKey &key);
+
+    FlowEntry *Find(const FlowKey &key) const;
+    // Flow must not be present in the index
+    void Insert(FlowEntry *flow);
+    // Returns false if flow is not present in the index
+    bool Remove(FlowEntry *flow);
+    FlowEntry *GetFirst() const;
+    FlowEntry *GetNext(const FlowKey &key) const;
+
+    size_t size() const { return size_; }
+    size_t bucket_count() const { return bucket_count_; }
+    size_t allocated_bytes() const { return slots_.size() * sizeof(Slot); }
+    // Slots compared by Find() since the index was created
+    uint64_t probe_count() const { return probe_count_; }
+
+private:
+    enum SlotState {
+        EMPTY,
+        USED,
+        DELETED
+    };
+    struct Slot {
+        Slot() : flow(NULL), hash(0), state(EMPTY) { }
+        FlowEntry *flow;
+        uint32_t hash;
+        uint8_t state;
+    };
+    typedef std::vector<Slot> SlotList;
+
+    // Buckets are in hash order, so a flow is never in a slot before that of
+    // a flow with a lower hash, less kMaxProbe
+    size_t HomeSlot(uint32_t hash) const {
+        return hash >> hash_shift_;
+    }
+    static bool IsAfter(const Slot &entry, uint32_t hash, const FlowKey &key);
+    size_t FindSlot(const FlowKey &key, uint32_t hash) const;
+    bool InsertSlot(FlowEntry *flow, uint32_t hash);
+    FlowEntry *FindNext(uint32_t hash, const FlowKey *key) const;
+    void Resize(size_t bucket_count);
+
+    SlotList slots_;
+    size_t bucket_count_;
+    // Shift of the hash giving the bucket, 32 - log2(bucket_count_)
+    uint32_t hash_shift_;
+    size_t size_;
+    size_t deleted_count_;
+    mutable uint64_t probe_count_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlowEntryIndex);
+};
+
+// Allocator for FlowEntry objects. Memory is taken from the heap in slabs of
+// kSlabSize entries and freed entries are kept on a free list, so that flow
+// churn does not go through malloc. Once there are more free entries than
+// both kTrimFreeCount and the entries in use, slabs without any entry in use
+// are returned to the heap.
+//
+// Not thread safe.
+class FlowEntryPool {
+public:
+    static const size_t kSlabSize = 256;
+    static const size_t kTrimFreeCount = 4 * kSlabSize;
+
+    FlowEntryPool();
+    ~FlowEntryPool();
+
+    void *Allocate();
+    void Free(void *entry);
+    // Returns slabs without any entry in use to the heap
+    void Trim();
+
+    size_t entry_size() const { return entry_size_; }
+    size_t allocated_bytes() const {
+        return slab_list_.size() * kSlabSize * entry_size_;
+    }
+    size_t in_use_count() const { return in_use_count_; }
+    size_t free_count() const { return free_count_; }
+
+private:
+    struct FreeEntry {
+        FreeEntry *next;
+    };
+    // Sorted by address
+    typedef std::vector<char *> SlabList;
+
+    void AddSlab();
+    size_t SlabIndex(const void *entry) const;
+
+    SlabList slab_list_;
+    FreeEntry *free_list_;
+    size_t entry_size_;
+    size_t in_use_count_;
+    size_t free_count_;
+    // Free entries above which Free() trims the pool. Set past the free
+    // entries left by a trim, so that a fragmented pool is not scanned on
+    // every Free()
+    size_t trim_free_count_;
+
+    DISALLOW_COPY_AND_ASSIGN(FlowEntryPool);
+};
+
+#endif // vnsw_agent_flow_index_h
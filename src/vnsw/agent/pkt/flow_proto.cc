@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/os.h"
+#include "base/util.h"
+#include "pkt/flow_proto.h"
+
+FlowProto::FlowProto(Agent *agent, boost::asio::io_service &io) :
+    Proto(agent, PktHandler::FLOW, io) {
+    agent->SetFlowProto(this);
+    int task_id = TaskScheduler::GetInstance()->GetTaskId("Agent::FlowHandler");
+    uint32_t count = agent->pkt()->flow_table()->partition_count();
+    for (uint32_t i = 0; i < count; i++) {
+        flow_work_queue_list_.push_back
+            (new FlowWorkQueue(task_id, i,
+                               boost::bind(&FlowProto::ProcessProto, this,
+                                           _1)));
+    }
+}
+
+FlowProto::~FlowProto() {
+    for (uint32_t i = 0; i < flow_work_queue_list_.size(); i++) {
+        flow_work_queue_list_[i]->Shutdown();
+    }
+    STLDeleteValues(&flow_work_queue_list_);
+}
+
+// Flow messages go to the partition of the flow they refer to. Packets go to
+// the partition of their flow key, which is symmetric for forward and
+// reverse packets of a flow.
+uint32_t FlowProto::FlowPartition(const PktInfo *msg) const {
+    const FlowTable *table = agent()->pkt()->flow_table();
+    if (msg->type == PktType::MESSAGE) {
+        const FlowTaskMsg *ipc = static_cast<const FlowTaskMsg *>(msg->ipc);
+        return table->PartitionIndex(ipc->fe_ptr->key());
+    }
+    return table->PartitionIndex(msg->ip_saddr, msg->ip_daddr, msg->ip_proto,
+                                 msg->sport, msg->dport);
+}
+
+bool FlowProto::Enqueue(boost::shared_ptr<PktInfo> msg) {
+    return flow_work_queue_list_[FlowPartition(msg.get())]->Enqueue(msg);
+}
@@ -6,6 +6,7 @@
 #define vnsw_agent_flow_proto_hpp
 
 #include <net/if.h>
+#include <vector>
 #include "cmn/agent_cmn.h"
 #include "base/queue_task.h"
 #include "pkt/proto.h"
@@ -13,13 +14,15 @@
 #include "pkt/flow_table.h"
 #include "pkt/flow_handler.h"
 
+// Flow setup is done by one instance of the flow handler task per flow table
+// partition. Packets and flow messages are steered to the work queue of the
+// partition their flow key hashes to.
 class FlowProto : public Proto {
 public:
-    FlowProto(Agent *agent, boost::asio::io_service &io) :
-        Proto(agent, "Agent::FlowHandler", PktHandler::FLOW, io) {
-        agent->SetFlowProto(this);
-    }
-    virtual ~FlowProto() {}
+    typedef WorkQueue<boost::shared_ptr<PktInfo> > FlowWorkQueue;
+
+    FlowProto(Agent *agent, boost::asio::io_service &io);
+    virtual ~FlowProto();
     void Init() {}
     void Shutdown() {}
 
@@ -43,6 +46,16 @@ public:
     bool RemovePktBuff() {
         return true;
     }
+
+    bool Enqueue(boost::shared_ptr<PktInfo> msg);
+    uint32_t FlowPartition(const PktInfo *msg) const;
+    const FlowWorkQueue *flow_work_queue(uint32_t index) const {
+        return flow_work_queue_list_[index];
+    }
+
+private:
+    std::vector<FlowWorkQueue *> flow_work_queue_list_;
+    DISALLOW_COPY_AND_ASSIGN(FlowProto);
 };
 
 extern SandeshTraceBufferPtr PktFlowTraceBuf;
@@ -2,6 +2,7 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <new>
 #include <vector>
 #include <bitset>
 
@@ -55,7 +56,6 @@ const std::map<FlowEntry::FlowPolicyState, const char*>
                             (LINKLOCAL_FLOW, "00000000-0000-0000-0000-000000000004")
                             (MULTICAST_FLOW, "00000000-0000-0000-0000-000000000005");
 
-boost::uuids::random_generator FlowTable::rand_gen_ = boost::uuids::random_generator();
 tbb::atomic<int> FlowEntry::alloc_count_;
 SecurityGroupList FlowTable::default_sg_list_;
 
@@ -92,8 +92,8 @@ FlowEntry::FlowEntry(const FlowKey &k) :
     linklocal_src_port_fd_(PktFlowInfo::kLinkLocalInvalidFd),
     peer_vrouter_(), tunnel_type_(TunnelType::INVALID),
     underlay_source_port_(0) {
-    flow_uuid_ = FlowTable::rand_gen_(); 
-    egress_uuid_ = FlowTable::rand_gen_(); 
+    flow_uuid_ = nil_uuid();
+    egress_uuid_ = nil_uuid();
     refcount_ = 0;
     nw_ace_uuid_ = FlowPolicyStateStr.at(NOT_EVALUATED);
     sg_rule_uuid_= FlowPolicyStateStr.at(NOT_EVALUATED);
@@ -806,6 +806,7 @@ uint32_t FlowEntry::acl_assigned_vrf_index() const {
 }
 
 void FlowEntry::UpdateKSync(const FlowTable* table) {
+    tbb::recursive_mutex::scoped_lock lock(table->mutex_);
     FlowInfo flow_info;
     FillFlowInfo(flow_info);
     if (stats_.last_modified_time != stats_.setup_time) {
@@ -901,7 +902,10 @@ void FlowTable::Add(FlowEntry *flow, FlowEntry *rflow) {
     /* reverse flow may not be aviable always, eg: Flow Audit */
     if (rflow != NULL)
         rflow->set_flags(FlowEntry::ReverseFlow);
-    UpdateReverseFlow(flow, rflow);
+    {
+        tbb::recursive_mutex::scoped_lock lock(mutex_);
+        UpdateReverseFlow(flow, rflow);
+    }
 
     flow->GetPolicyInfo();
     // Add the forward flow after adding the reverse flow first to avoid 
@@ -1492,38 +1496,208 @@ void FlowEntry::InitAuditFlow(uint32_t flow_idx) {
     data_.dest_sg_id_l = FlowTable::default_sg_list();
 }
 
-FlowEntry *FlowTable::Allocate(const FlowKey &key) {
-    FlowEntry *flow = new FlowEntry(key);
-    std::pair<FlowEntryMap::iterator, bool> ret;
-    ret = flow_entry_map_.insert(std::pair<FlowKey, FlowEntry*>(key, flow));
-    if (ret.second == false) {
-        delete flow;
-        flow = ret.first->second;
-        flow->set_deleted(false);
-        DeleteFlowInfo(flow);
-    } else {
-        flow->stats_.setup_time = UTCTimestampUsec();
-        agent_->stats()->incr_flow_created();
+FlowPairLock::FlowPairLock(FlowEntry *flow, FlowEntry *rflow) {
+    if (flow == NULL || (rflow != NULL && rflow < flow)) {
+        std::swap(flow, rflow);
+    }
+    if (flow) {
+        lock1_.acquire(flow->mutex());
+    }
+    if (rflow && rflow != flow) {
+        lock2_.acquire(rflow->mutex());
+    }
+}
+
+FlowTable::Partition::Partition() :
+    flow_index(), flow_pool(), lookup_count(0), lookup_samples(0),
+    lookup_time_nsec(0), inet4_route_key(NULL, Ip4Address(), 32, false),
+    inet6_route_key(NULL, Ip6Address(), 128, false) {
+}
+
+static uint32_t AddressHash(const IpAddress &addr) {
+    if (addr.is_v4()) {
+        return addr.to_v4().to_ulong();
+    }
+    uint32_t hash = 0;
+    const Ip6Address::bytes_type bytes = addr.to_v6().to_bytes();
+    for (size_t i = 0; i < bytes.size(); i += 4) {
+        hash ^= (bytes[i] << 24) | (bytes[i + 1] << 16) |
+            (bytes[i + 2] << 8) | bytes[i + 3];
+    }
+    return hash;
+}
+
+// Hash is symmetric in source and destination so that the reverse flow of a
+// non-NAT flow lands in the same partition. The flow key nexthop is not
+// known when a packet is assigned to a partition, so it is not part of the
+// hash.
+uint32_t FlowTable::PartitionHash(const IpAddress &sip, const IpAddress &dip,
+                                  uint8_t proto, uint16_t sport,
+                                  uint16_t dport) {
+    uint32_t hash = AddressHash(sip) ^ AddressHash(dip);
+    hash ^= ((uint32_t)(sport ^ dport) << 8) | proto;
+    // Mix the bits so that sequential addresses spread over partitions
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+size_t FlowTable::Size() const {
+    size_t size = 0;
+    for (PartitionList::const_iterator it = partition_list_.begin();
+         it != partition_list_.end(); ++it) {
+        size += (*it)->flow_index.size();
+    }
+    return size;
+}
+
+size_t FlowTable::allocated_bytes() const {
+    size_t bytes = 0;
+    for (PartitionList::const_iterator it = partition_list_.begin();
+         it != partition_list_.end(); ++it) {
+        tbb::mutex::scoped_lock lock((*it)->mutex);
+        bytes += (*it)->flow_index.allocated_bytes() +
+            (*it)->flow_pool.allocated_bytes();
+    }
+    return bytes;
+}
+
+uint64_t FlowTable::lookup_count() const {
+    uint64_t count = 0;
+    for (PartitionList::const_iterator it = partition_list_.begin();
+         it != partition_list_.end(); ++it) {
+        tbb::mutex::scoped_lock lock((*it)->mutex);
+        count += (*it)->lookup_count;
+    }
+    return count;
+}
+
+uint64_t FlowTable::lookup_avg_nsec() const {
+    uint64_t samples = 0;
+    uint64_t time = 0;
+    for (PartitionList::const_iterator it = partition_list_.begin();
+         it != partition_list_.end(); ++it) {
+        tbb::mutex::scoped_lock lock((*it)->mutex);
+        samples += (*it)->lookup_samples;
+        time += (*it)->lookup_time_nsec;
+    }
+    if (samples == 0) {
+        return 0;
+    }
+    return time / samples;
+}
+
+// Partition whose flow handler is the running task. Must only be called
+// from the flow handler of a partition.
+FlowTable::Partition *FlowTable::RunningPartition() const {
+    Task *task = Task::Running();
+    assert(task && task->GetTaskId() == flow_task_id_);
+    assert(task->GetTaskInstance() >= 0 &&
+           task->GetTaskInstance() < (int)partition_list_.size());
+    return partition_list_[task->GetTaskInstance()];
+}
+
+// Called with the partition lock held
+FlowEntry *FlowTable::Lookup(Partition *partition, const FlowKey &key) {
+    if ((partition->lookup_count++ % kLookupSampleInterval) != 0) {
+        return partition->flow_index.Find(key);
+    }
+    uint64_t start = ClockMonotonicNsec();
+    FlowEntry *flow = partition->flow_index.Find(key);
+    partition->lookup_time_nsec += ClockMonotonicNsec() - start;
+    partition->lookup_samples++;
+    return flow;
+}
+
+FlowEntryPtr FlowTable::Allocate(const FlowKey &key) {
+    Partition *partition = partition_list_[PartitionIndex(key)];
+    FlowEntryPtr flow;
+    {
+        tbb::mutex::scoped_lock lock(partition->mutex);
+        flow = Lookup(partition, key);
+        if (flow.get() == NULL) {
+            flow = new (partition->flow_pool.Allocate()) FlowEntry(key);
+            flow->flow_uuid_ = partition->rand_gen();
+            flow->egress_uuid_ = partition->rand_gen();
+            flow->stats_.setup_time = UTCTimestampUsec();
+            partition->flow_index.Insert(flow.get());
+            agent_->stats()->incr_flow_created();
+            return flow;
+        }
     }
 
+    // Flow info is updated without the partition lock held, as releasing
+    // a flow with the table lock held takes the partition lock
+    tbb::mutex::scoped_lock lock(flow->mutex());
+    flow->set_deleted(false);
+    DeleteFlowInfo(flow.get());
     return flow;
 }
 
 FlowEntry *FlowTable::Find(const FlowKey &key) {
-    FlowEntryMap::iterator it;
+    Partition *partition = partition_list_[PartitionIndex(key)];
+    tbb::mutex::scoped_lock lock(partition->mutex);
+    return Lookup(partition, key);
+}
 
-    it = flow_entry_map_.find(key);
-    if (it != flow_entry_map_.end()) {
-        return it->second;
+// Find with a reference taken under the partition lock
+FlowEntryPtr FlowTable::Acquire(const FlowKey &key) {
+    Partition *partition = partition_list_[PartitionIndex(key)];
+    tbb::mutex::scoped_lock lock(partition->mutex);
+    return FlowEntryPtr(Lookup(partition, key));
+}
+
+FlowEntry *FlowTable::GetNext(const FlowKey &key) {
+    uint32_t index = 0;
+    FlowEntry *flow = NULL;
+    if (key.family == Address::UNSPEC) {
+        Partition *partition = partition_list_[index];
+        tbb::mutex::scoped_lock lock(partition->mutex);
+        flow = partition->flow_index.GetFirst();
     } else {
-        return NULL;
+        index = PartitionIndex(key);
+        Partition *partition = partition_list_[index];
+        tbb::mutex::scoped_lock lock(partition->mutex);
+        flow = partition->flow_index.GetNext(key);
     }
+
+    while (flow == NULL) {
+        if (++index == partition_list_.size()) {
+            return NULL;
+        }
+        Partition *partition = partition_list_[index];
+        tbb::mutex::scoped_lock lock(partition->mutex);
+        flow = partition->flow_index.GetFirst();
+    }
+    return flow;
 }
 
-void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
+// Drops the last reference to a flow. The reference is dropped and the flow
+// removed from the index under the partition lock, so a flow found in the
+// index under the lock always has a reference and can be acquired.
+void FlowTable::ReleaseFlowEntry(FlowEntry *fe) {
+    Partition *partition = partition_list_[PartitionIndex(fe->key())];
+    {
+        tbb::mutex::scoped_lock lock(partition->mutex);
+        if (fe->refcount_.fetch_and_decrement() != 1) {
+            // Acquired after the caller saw the last reference
+            return;
+        }
+        bool removed = partition->flow_index.Remove(fe);
+        assert(removed);
+    }
+    // The destructor releases the reverse flow, which may be freed to the
+    // same partition
+    fe->~FlowEntry();
+    tbb::mutex::scoped_lock lock(partition->mutex);
+    partition->flow_pool.Free(fe);
+}
+
+void FlowTable::DeleteInternal(FlowEntry *fe)
 {
+    tbb::recursive_mutex::scoped_lock lock(mutex_);
     FlowInfo flow_info;
-    FlowEntry *fe = it->second;
     if (fe->deleted()) {
         /* Already deleted return from here. */
         return;
@@ -1571,63 +1745,30 @@ void FlowTable::DeleteInternal(FlowEntryMap::iterator &it)
     agent_->stats()->incr_flow_aged();
 }
 
-bool FlowTable::Delete(FlowEntryMap::iterator &it, bool rev_flow)
-{
-    FlowEntry *fe;
-    FlowEntryMap::iterator rev_it;
-
-    fe = it->second;
-    FlowEntry *reverse_flow = NULL;
-    if (fe->is_flags_set(FlowEntry::NatFlow) || rev_flow) {
-        reverse_flow = fe->reverse_flow_entry();
-    }
-    DeleteInternal(it);
-
-    if (!reverse_flow) {
-        return true;
-    }
-    /* If reverse-flow is valid and the present iterator is pointing to it,
-     * use that iterator to delete reverse flow
-     */
-    if (reverse_flow == it->second) {
-        DeleteInternal(it);
-        return true;
-    }
-
-    rev_it = flow_entry_map_.find(reverse_flow->key());
-    if (rev_it != flow_entry_map_.end()) {
-        DeleteInternal(rev_it);
-        return true;
-    }
-    return false;
-}
-
 bool FlowTable::Delete(const FlowKey &key, bool del_reverse_flow)
 {
-    FlowEntryMap::iterator it;
-    FlowEntry *fe;
-
-    it = flow_entry_map_.find(key);
-    if (it == flow_entry_map_.end()) {
+    // Flows are deleted from the flow handlers of other partitions too,
+    // hold a reference while they are deleted
+    FlowEntryPtr fe = Acquire(key);
+    if (fe.get() == NULL) {
         return false;
     }
-    fe = it->second;
 
-    FlowEntry *reverse_flow = NULL;
+    FlowEntryPtr reverse_flow;
     if (del_reverse_flow) {
         reverse_flow = fe->reverse_flow_entry();
     }
 
     /* Delete the forward flow */
-    DeleteInternal(it);
+    DeleteInternal(fe.get());
 
     if (!reverse_flow) {
         return true;
     }
 
-    it = flow_entry_map_.find(reverse_flow->key());
-    if (it != flow_entry_map_.end()) {
-        DeleteInternal(it);
+    fe = Acquire(reverse_flow->key());
+    if (fe.get() != NULL) {
+        DeleteInternal(fe.get());
         return true;
     }
     return false;
@@ -1635,17 +1776,16 @@ bool FlowTable::Delete(const FlowKey &key, bool del_reverse_flow)
 
 void FlowTable::DeleteAll()
 {
-    FlowEntryMap::iterator it;
-
-    it = flow_entry_map_.begin();
-    while (it != flow_entry_map_.end()) {
-        FlowEntry *entry = it->second;
-        ++it;
-        if (it != flow_entry_map_.end() &&
-            it->second == entry->reverse_flow_entry()) {
-            ++it;
+    FlowKey key;
+    key.Reset();
+    FlowEntry *entry = GetNext(key);
+    while (entry != NULL) {
+        FlowEntry *next = GetNext(entry->key());
+        if (next != NULL && next == entry->reverse_flow_entry()) {
+            next = GetNext(next->key());
         }
         Delete(entry->key(), true);
+        entry = next;
     }
 }
 
@@ -1816,7 +1956,7 @@ void FlowTable::AclNotify(DBTablePartBase *part, DBEntryBase *e)
         // no need to do any here.
         DeleteAclFlows(acl);
     } else {
-        ResyncAclFlows(acl);
+        ResyncAclChanges(acl);
     }
 }
 
@@ -2031,6 +2171,34 @@ void FlowTable::ResyncAclFlows(const AclDBEntry *acl)
     }
 }
 
+// Evaluates again only the flows whose result can change with the entries
+// added, deleted or modified in the ACL since the last notification
+void FlowTable::ResyncAclChanges(AclDBEntry *acl)
+{
+    AclFlowTree::iterator acl_it;
+    acl_it = acl_flow_tree_.find(acl);
+    if (acl_it == acl_flow_tree_.end()) {
+        acl->ClearAceChanges();
+        return;
+    }
+
+    FlowEntryTree fet;
+    acl_it->second->GetChangedFlows(acl, &fet);
+    acl->ClearAceChanges();
+    acl_resync_flow_count_ += fet.size();
+    FlowEntryTree::iterator it;
+    for (it = fet.begin(); it != fet.end(); ++it) {
+        FlowEntry *fe = (*it).get();
+        DeleteFlowInfo(fe);
+        fe->GetPolicyInfo();
+        ResyncAFlow(fe);
+        AddFlowInfo(fe);
+        FlowInfo flow_info;
+        fe->FillFlowInfo(flow_info);
+        FLOW_TRACE(Trace, "Evaluate Acl Flows", flow_info);
+    }
+}
+
 void FlowTable::ResyncRpfNH(const RouteFlowKey &key, const AgentRoute *rt) {
     RouteFlowInfo *rt_info;
     RouteFlowInfo rt_key(key);
@@ -2189,6 +2357,7 @@ void FlowTable::DeleteRouteFlows(const RouteFlowKey &key)
 
 void FlowTable::DeleteFlowInfo(FlowEntry *fe) 
 {
+    tbb::recursive_mutex::scoped_lock lock(mutex_);
     AgentUve *f_uve = static_cast<AgentUve *>(agent_->uve());
     f_uve->DeleteFlow(fe);
     // Remove from AclFlowTree
@@ -2196,49 +2365,49 @@ void FlowTable::DeleteFlowInfo(FlowEntry *fe)
     std::list<MatchAclParams>::const_iterator acl_it;
     for (acl_it = fe->match_p().m_acl_l.begin(); acl_it != fe->match_p().m_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
     for (acl_it = fe->match_p().m_sg_acl_l.begin(); 
          acl_it != fe->match_p().m_sg_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
 
     for (acl_it = fe->match_p().m_out_acl_l.begin();
          acl_it != fe->match_p().m_out_acl_l.end(); ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
     for (acl_it = fe->match_p().m_out_sg_acl_l.begin(); 
          acl_it != fe->match_p().m_out_sg_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
 
     for (acl_it = fe->match_p().m_reverse_sg_acl_l.begin();
          acl_it != fe->match_p().m_reverse_sg_acl_l.end(); ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
     for (acl_it = fe->match_p().m_reverse_out_sg_acl_l.begin();
          acl_it != fe->match_p().m_reverse_out_sg_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
 
     for (acl_it = fe->match_p().m_mirror_acl_l.begin(); 
          acl_it != fe->match_p().m_mirror_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
 
     for (acl_it = fe->match_p().m_out_mirror_acl_l.begin(); 
          acl_it != fe->match_p().m_out_mirror_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
     for (acl_it = fe->match_p().m_vrf_assign_acl_l.begin();
          acl_it != fe->match_p().m_vrf_assign_acl_l.end();
          ++acl_it) {
-        DeleteAclFlowInfo((*acl_it).acl.get(), fe, (*acl_it).ace_id_list);
+        DeleteAclFlowInfo(fe, *acl_it);
     }
 
     // Remove from IntfFlowTree
@@ -2270,20 +2439,39 @@ void FlowTable::DeleteVnFlowInfo(FlowEntry *fe)
     }
 }
 
-void FlowTable::DeleteAclFlowInfo(const AclDBEntry *acl, FlowEntry* flow,
-        const AclEntryIDList &id_list)
+static void EraseAceFlow(AclFlowInfo::AceIdFlowMap *map, int ace_id,
+                         FlowEntry *flow) {
+    AclFlowInfo::AceIdFlowMap::iterator it = map->find(ace_id);
+    if (it == map->end()) {
+        return;
+    }
+    it->second.erase(flow);
+    if (it->second.empty()) {
+        map->erase(it);
+    }
+}
+
+void FlowTable::DeleteAclFlowInfo(FlowEntry *flow,
+                                  const MatchAclParams &params)
 {
     AclFlowTree::iterator acl_it;
-    acl_it = acl_flow_tree_.find(acl);
+    acl_it = acl_flow_tree_.find(params.acl.get());
     if (acl_it == acl_flow_tree_.end()) {
         return;
     }
 
     // Delete flow entry from the Flow entry list
     AclFlowInfo *af_info = acl_it->second;
+    const AclEntryIDList &id_list = params.ace_id_list;
     AclEntryIDList::const_iterator id_it;
     for (id_it = id_list.begin(); id_it != id_list.end(); ++id_it) {
         af_info->aceid_cnt_map[*id_it] -= 1;
+        EraseAceFlow(&af_info->ace_flow_map, *id_it, flow);
+    }
+    if (params.terminal_rule && !id_list.empty()) {
+        EraseAceFlow(&af_info->terminal_flow_map, id_list.back(), flow);
+    } else {
+        af_info->non_terminal_fet.erase(flow);
     }
     af_info->fet.erase(flow);
     if (af_info->fet.empty()) {
@@ -2371,6 +2559,7 @@ void FlowTable::DeleteRouteFlowInfo (FlowEntry *fe)
 
 void FlowTable::AddFlowInfo(FlowEntry *fe)
 {
+    tbb::recursive_mutex::scoped_lock lock(mutex_);
     AgentUve *f_uve = static_cast<AgentUve *>(agent_->uve());
     f_uve->NewFlow(fe);
     // Add AclFlowTree
@@ -2391,56 +2580,56 @@ void FlowTable::AddAclFlowInfo (FlowEntry *fe)
     for (it = fe->match_p().m_acl_l.begin();
          it != fe->match_p().m_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
     for (it = fe->match_p().m_sg_acl_l.begin();
          it != fe->match_p().m_sg_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
 
     for (it = fe->match_p().m_out_acl_l.begin();
          it != fe->match_p().m_out_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
     for (it = fe->match_p().m_out_sg_acl_l.begin();
          it != fe->match_p().m_out_sg_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
 
     for (it = fe->match_p().m_reverse_sg_acl_l.begin();
          it != fe->match_p().m_reverse_sg_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
     for (it = fe->match_p().m_reverse_out_sg_acl_l.begin();
          it != fe->match_p().m_reverse_out_sg_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
 
     for (it = fe->match_p().m_mirror_acl_l.begin();
          it != fe->match_p().m_mirror_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
     for (it = fe->match_p().m_out_mirror_acl_l.begin();
          it != fe->match_p().m_out_mirror_acl_l.end();
          ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
     for (it = fe->match_p().m_vrf_assign_acl_l.begin();
             it != fe->match_p().m_vrf_assign_acl_l.end();
             ++it) {
-        UpdateAclFlow(it->acl.get(), fe, it->ace_id_list);
+        UpdateAclFlow(fe, *it);
     }
 }
 
-void FlowTable::UpdateAclFlow(const AclDBEntry *acl, FlowEntry* flow,
-                              const AclEntryIDList &id_list)
+void FlowTable::UpdateAclFlow(FlowEntry *flow, const MatchAclParams &params)
 {
+    const AclDBEntry *acl = params.acl.get();
     AclFlowTree::iterator it;
     pair<set<FlowEntryPtr>::iterator,bool> ret;
 
@@ -2458,14 +2647,51 @@ void FlowTable::UpdateAclFlow(const AclDBEntry *acl, FlowEntry* flow,
         ret = af_info->fet.insert(flow);
     }
     
+    const AclEntryIDList &id_list = params.ace_id_list;
     if (id_list.size()) {
         AclEntryIDList::const_iterator id_it;
         for (id_it = id_list.begin(); id_it != id_list.end(); ++id_it) {
             af_info->aceid_cnt_map[*id_it] += 1;
+            af_info->ace_flow_map[*id_it].insert(flow);
         }        
     } else {
         af_info->flow_miss++;
     }
+
+    // Entries are matched in the order of their ids, so the terminal entry
+    // is the last one matched
+    if (params.terminal_rule && id_list.size()) {
+        af_info->terminal_flow_map[id_list.back()].insert(flow);
+    } else {
+        af_info->non_terminal_fet.insert(flow);
+    }
+}
+
+void AclFlowInfo::GetChangedFlows(const AclDBEntry *acl,
+                                  FlowEntryTree *changed) const {
+    // Flows that matched an entry that was deleted or modified
+    const AclDBEntry::AceIdSet &removed = acl->removed_ace_ids();
+    for (AclDBEntry::AceIdSet::const_iterator id_it = removed.begin();
+         id_it != removed.end(); ++id_it) {
+        AceIdFlowMap::const_iterator it = ace_flow_map.find(*id_it);
+        if (it != ace_flow_map.end()) {
+            changed->insert(it->second.begin(), it->second.end());
+        }
+    }
+
+    // An entry that was added or modified can only be matched by the flows
+    // that did not stop at a terminal entry ahead of it
+    const AclDBEntry::AceIdSet &added = acl->added_ace_ids();
+    if (added.empty()) {
+        return;
+    }
+    int first_added = *added.begin();
+    AceIdFlowMap::const_iterator it =
+        terminal_flow_map.upper_bound(first_added);
+    for (; it != terminal_flow_map.end(); ++it) {
+        changed->insert(it->second.begin(), it->second.end());
+    }
+    changed->insert(non_terminal_fet.begin(), non_terminal_fet.end());
 }
 
 void FlowTable::AddIntfFlowInfo(FlowEntry *fe)
@@ -2599,6 +2825,7 @@ void FlowTable::VnFlowCounters(const VnEntry *vn, uint32_t *in_count,
 }
 
 uint32_t FlowTable::VmFlowCount(const VmEntry *vm) {
+    tbb::recursive_mutex::scoped_lock lock(mutex_);
     VmFlowTree::iterator it = vm_flow_tree_.find(vm);
     if (it != vm_flow_tree_.end()) {
         VmFlowInfo *vm_flow_info = it->second;
@@ -2609,6 +2836,7 @@ uint32_t FlowTable::VmFlowCount(const VmEntry *vm) {
 }
 
 uint32_t FlowTable::VmLinkLocalFlowCount(const VmEntry *vm) {
+    tbb::recursive_mutex::scoped_lock lock(mutex_);
     VmFlowTree::iterator it = vm_flow_tree_.find(vm);
     if (it != vm_flow_tree_.end()) {
         VmFlowInfo *vm_flow_info = it->second;
@@ -2730,12 +2958,13 @@ DBTableBase::ListenerId FlowTable::nh_listener_id() {
 AgentRoute *FlowTable::GetUcRoute(const VrfEntry *entry,
                                   const IpAddress &addr) {
     AgentRoute *rt = NULL;
+    Partition *partition = RunningPartition();
     if (addr.is_v4()) {
-        inet4_route_key_.set_addr(addr.to_v4());
-        rt = entry->GetUcRoute(inet4_route_key_);
+        partition->inet4_route_key.set_addr(addr.to_v4());
+        rt = entry->GetUcRoute(partition->inet4_route_key);
     } else {
-        inet6_route_key_.set_addr(addr.to_v6());
-        rt = entry->GetUcRoute(inet6_route_key_);
+        partition->inet6_route_key.set_addr(addr.to_v6());
+        rt = entry->GetUcRoute(partition->inet6_route_key);
     }
     if (rt != NULL && rt->IsRPFInvalid()) {
         return NULL;
@@ -2956,12 +3185,19 @@ void FlowTable::SetAclFlowSandeshData(const AclDBEntry *acl, AclFlowResp &data,
 }
 
 FlowTable::FlowTable(Agent *agent) : 
-    agent_(agent), flow_entry_map_(), acl_flow_tree_(),
-    linklocal_flow_count_(), acl_listener_id_(),
+    agent_(agent), partition_list_(),
+    flow_task_id_(TaskScheduler::GetInstance()->GetTaskId("Agent::FlowHandler")),
+    acl_flow_tree_(),
+    linklocal_flow_count_(), acl_resync_flow_count_(0), acl_listener_id_(),
     intf_listener_id_(), vn_listener_id_(), vm_listener_id_(),
-    vrf_listener_id_(), nh_listener_(NULL),
-    inet4_route_key_(NULL, Ip4Address(), 32, false),
-    inet6_route_key_(NULL, Ip6Address(), 128, false) {
+    vrf_listener_id_(), nh_listener_(NULL) {
+    uint16_t partition_count = agent->params()->flow_thread_count();
+    if (partition_count == 0) {
+        partition_count = 1;
+    }
+    for (uint16_t i = 0; i < partition_count; i++) {
+        partition_list_.push_back(new Partition());
+    }
     max_vm_flows_ = (uint32_t)
         (agent->ksync()->flowtable_ksync_obj()->flow_table_entries_count() *
          agent->params()->max_vm_flows()) / 100;
@@ -2974,5 +3210,6 @@ FlowTable::~FlowTable() {
     agent_->vm_table()->Unregister(vm_listener_id_);
     agent_->vrf_table()->Unregister(vrf_listener_id_);
     delete nh_listener_;
+    STLDeleteValues(&partition_list_);
 }
 
@@ -22,6 +22,7 @@
 #include <boost/intrusive_ptr.hpp>
 #include <tbb/atomic.h>
 #include <tbb/mutex.h>
+#include <tbb/recursive_mutex.h>
 #include <base/util.h>
 #include <net/address.h>
 #include <cmn/agent_cmn.h>
@@ -33,6 +34,7 @@
 #include <pkt/pkt_handler.h>
 #include <pkt/pkt_init.h>
 #include <pkt/pkt_flow_info.h>
+#include <pkt/flow_index.h>
 #include <sandesh/sandesh_trace.h>
 #include <oper/vn.h>
 #include <oper/vm.h>
@@ -148,6 +150,13 @@ struct FlowKey {
         return dst_port < key.dst_port;
     }
 
+    bool IsEqual(const FlowKey &key) const {
+        return family == key.family && nh == key.nh &&
+            src_addr == key.src_addr && dst_addr == key.dst_addr &&
+            protocol == key.protocol && src_port == key.src_port &&
+            dst_port == key.dst_port;
+    }
+
     void Reset() {
         family = Address::UNSPEC;
         nh = -1;
@@ -177,7 +186,7 @@ struct Inet4FlowKeyCmp {
 struct FlowStats {
     FlowStats() : setup_time(0), teardown_time(0), last_modified_time(0),
         bytes(0), packets(0), intf_in(0), exported(false), fip(0),
-        fip_vm_port_id(Interface::kInvalidIndex) {}
+        fip_vm_port_id(Interface::kInvalidIndex), kernel_order_sweep(0) {}
 
     uint64_t setup_time;
     uint64_t teardown_time;
@@ -189,6 +198,8 @@ struct FlowStats {
     // Following fields are required for FIP stats accounting
     uint32_t fip;
     uint32_t fip_vm_port_id;
+    // Last kernel order sweep of FlowStatsCollector that visited the flow
+    uint32_t kernel_order_sweep;
 };
 
 typedef std::list<MatchAclParams> MatchAclParamsList;
@@ -447,6 +458,7 @@ class FlowEntry {
     }
     uint16_t short_flow_reason() const { return short_flow_reason_; }
     bool set_pending_recompute(bool value);
+    tbb::mutex &mutex() { return mutex_; }
 private:
     friend class FlowTable;
     friend class FlowStatsCollector;
@@ -486,6 +498,22 @@ private:
     uint16_t underlay_source_port_;
     // atomic refcount
     tbb::atomic<int> refcount_;
+    // Serializes flow setup of the flow pair this flow belongs to
+    tbb::mutex mutex_;
+};
+
+// Locks both flows of a flow pair. The reverse flow of a NAT flow can hash
+// to another partition than the forward flow, so the flows are locked in
+// address order to avoid deadlock between flow handler instances.
+class FlowPairLock {
+public:
+    FlowPairLock(FlowEntry *flow, FlowEntry *rflow);
+    ~FlowPairLock() { }
+
+private:
+    tbb::mutex::scoped_lock lock1_;
+    tbb::mutex::scoped_lock lock2_;
+    DISALLOW_COPY_AND_ASSIGN(FlowPairLock);
 };
  
 struct FlowEntryCmp {
@@ -541,7 +569,31 @@ struct RouteFlowInfo {
 class FlowTable {
 public:
     static const int MaxResponses = 100;
-    typedef std::map<FlowKey, FlowEntry *, Inet4FlowKeyCmp> FlowEntryMap;
+    // One in kLookupSampleInterval flow lookups is timed
+    static const uint32_t kLookupSampleInterval = 64;
+
+    // Flows are spread over partitions by a hash of the flow key. Each
+    // partition is set up by its own instance of the flow handler task.
+    // The hash is symmetric, so both flows of a non-NAT flow pair are in
+    // the same partition.
+    struct Partition {
+        Partition();
+        ~Partition() { }
+
+        FlowEntryIndex flow_index;
+        FlowEntryPool flow_pool;
+        // Protects flow_index, flow_pool, rand_gen and the lookup stats from
+        // flow setup in other partitions
+        tbb::mutex mutex;
+        uint64_t lookup_count;
+        uint64_t lookup_samples;
+        uint64_t lookup_time_nsec;
+        boost::uuids::random_generator rand_gen;
+        // Keys for route lookups done by the flow handler of the partition
+        InetUnicastRouteEntry inet4_route_key;
+        InetUnicastRouteEntry inet6_route_key;
+    };
+    typedef std::vector<Partition *> PartitionList;
 
     typedef std::map<int, int> AceIdFlowCntMap;
     typedef std::map<const AclDBEntry *, AclFlowInfo *> AclFlowTree;
@@ -552,7 +604,6 @@ public:
 
     typedef std::map<const Interface *, IntfFlowInfo *> IntfFlowTree;
     typedef std::pair<const Interface *, IntfFlowInfo *> IntfFlowPair;
-    static boost::uuids::random_generator rand_gen_;
 
     typedef std::map<const VmEntry *, VmFlowInfo *> VmFlowTree;
     typedef std::pair<const VmEntry *, VmFlowInfo *> VmFlowPair;
@@ -596,12 +647,45 @@ public:
     void InitDone();
     void Shutdown();
 
-    FlowEntry *Allocate(const FlowKey &key);
+    // Returns the flow with a reference taken under the partition lock, so
+    // that it can be allocated from the flow handler of any partition
+    FlowEntryPtr Allocate(const FlowKey &key);
     void Add(FlowEntry *flow, FlowEntry *rflow);
+    // The returned flow stays valid only while flows are not deleted, e.g.
+    // from a task exclusive with the flow handlers. Flow handlers must use
+    // Allocate, or look up flows of their own partition.
     FlowEntry *Find(const FlowKey &key);
     bool Delete(const FlowKey &key, bool del_reverse_flow);
 
-    size_t Size() { return flow_entry_map_.size(); }
+    size_t Size() const;
+    uint32_t partition_count() const { return partition_list_.size(); }
+    size_t PartitionSize(uint32_t index) const {
+        return partition_list_[index]->flow_index.size();
+    }
+    // Memory used by the flow index and flow entry pools
+    size_t allocated_bytes() const;
+    uint64_t lookup_count() const;
+    // Average time of the sampled lookups
+    uint64_t lookup_avg_nsec() const;
+    static uint32_t PartitionHash(const IpAddress &sip, const IpAddress &dip,
+                                  uint8_t proto, uint16_t sport,
+                                  uint16_t dport);
+    uint32_t PartitionIndex(const IpAddress &sip, const IpAddress &dip,
+                            uint8_t proto, uint16_t sport,
+                            uint16_t dport) const {
+        return PartitionHash(sip, dip, proto, sport, dport) %
+            partition_list_.size();
+    }
+    uint32_t PartitionIndex(const FlowKey &key) const {
+        return PartitionIndex(key.src_addr, key.dst_addr, key.protocol,
+                              key.src_port, key.dst_port);
+    }
+    // Flow following key, visiting partitions in order and flows in
+    // FlowEntryIndex order within a partition. Iteration starts from a key
+    // reset with FlowKey::Reset(). Each partition is looked up under its
+    // lock, the returned flow stays valid only while flows are not deleted,
+    // e.g. from a task exclusive with the flow handlers.
+    FlowEntry *GetNext(const FlowKey &key);
     void VnFlowCounters(const VnEntry *vn, uint32_t *in_count, 
                         uint32_t *out_count);
     uint32_t VmFlowCount(const VmEntry *vm);
@@ -609,6 +693,8 @@ public:
     uint32_t max_vm_flows() const { return max_vm_flows_; }
     void set_max_vm_flows(uint32_t num_flows) { max_vm_flows_ = num_flows; }
     uint32_t linklocal_flow_count() const { return linklocal_flow_count_; }
+    // Flows evaluated again on changes to the entries of their ACLs
+    uint64_t acl_resync_flow_count() const { return acl_resync_flow_count_; }
     Agent *agent() const { return agent_; }
 
     // Test code only used method
@@ -620,20 +706,14 @@ public:
                                const int last_count);
     void SetAceSandeshData(const AclDBEntry *acl, AclFlowCountResp &data, 
                            int ace_id);
-   
-    FlowTable::FlowEntryMap::iterator begin() {
-        return flow_entry_map_.begin();
-    }
 
-    FlowTable::FlowEntryMap::iterator end() {
-        return flow_entry_map_.end(); 
-    }
 
     DBTableBase::ListenerId nh_listener_id();
     AgentRoute *GetUcRoute(const VrfEntry *entry, const IpAddress &addr);
     static const SecurityGroupList &default_sg_list() {return default_sg_list_;}
     bool ValidFlowMove(const FlowEntry *new_flow,
                        const FlowEntry *old_flow) const;
+    friend class FlowEntry;
     friend class FlowStatsCollector;
     friend class PktSandeshFlow;
     friend class FetchFlowRecord;
@@ -645,7 +725,12 @@ private:
     static SecurityGroupList default_sg_list_;
 
     Agent *agent_;
-    FlowEntryMap flow_entry_map_;
+    PartitionList partition_list_;
+    int flow_task_id_;
+    // Protects the flow info trees, reverse flow links and the KSync and UVE
+    // state of flows against concurrent flow setup in other partitions.
+    // Ordered after FlowPairLock and before the partition mutex.
+    mutable tbb::recursive_mutex mutex_;
 
     AclFlowTree acl_flow_tree_;
     VnFlowTree vn_flow_tree_;
@@ -655,6 +740,7 @@ private:
 
     uint32_t max_vm_flows_;     // maximum flow count allowed per vm
     uint32_t linklocal_flow_count_;  // total linklocal flows in the agent
+    uint64_t acl_resync_flow_count_;
 
     DBTableBase::ListenerId acl_listener_id_;
     DBTableBase::ListenerId intf_listener_id_;
@@ -663,8 +749,6 @@ private:
     DBTableBase::ListenerId vrf_listener_id_;
     NhListener *nh_listener_;
 
-    InetUnicastRouteEntry inet4_route_key_;
-    InetUnicastRouteEntry inet6_route_key_;
 
     void AclNotify(DBTablePartBase *part, DBEntryBase *e);
     void IntfNotify(DBTablePartBase *part, DBEntryBase *e);
@@ -691,7 +775,7 @@ private:
     void DeleteIntfFlowInfo(FlowEntry *fe);
     void DeleteRouteFlowInfoInternal(FlowEntry *fe, RouteFlowKey &key);
     void DeleteRouteFlowInfo(FlowEntry *fe);
-    void DeleteAclFlowInfo(const AclDBEntry *acl, FlowEntry* flow, const AclEntryIDList &id_list);
+    void DeleteAclFlowInfo(FlowEntry *flow, const MatchAclParams &params);
 
     void DeleteVnFlows(const VnEntry *vn);
     void DeleteVmIntfFlows(const Interface *intf);
@@ -699,7 +783,8 @@ private:
 
     void AddFlowInfo(FlowEntry *fe);
     void AddAclFlowInfo(FlowEntry *fe);
-    void UpdateAclFlow(const AclDBEntry *acl, FlowEntry* flow, const AclEntryIDList &id_list);
+    void UpdateAclFlow(FlowEntry *flow, const MatchAclParams &params);
+    void ResyncAclChanges(AclDBEntry *acl);
     void AddIntfFlowInfo(FlowEntry *fe);
     void AddVnFlowInfo(FlowEntry *fe);
     void AddVmFlowInfo(FlowEntry *fe);
@@ -707,9 +792,13 @@ private:
     void AddRouteFlowInfoInternal(FlowEntry *fe, RouteFlowKey &key);
     void AddRouteFlowInfo(FlowEntry *fe);
 
+    Partition *RunningPartition() const;
+    FlowEntry *Lookup(Partition *partition, const FlowKey &key);
+    FlowEntryPtr Acquire(const FlowKey &key);
+    void ReleaseFlowEntry(FlowEntry *fe);
+
     void DeleteAclFlows(const AclDBEntry *acl);
-    void DeleteInternal(FlowEntryMap::iterator &it);
-    bool Delete(FlowEntryMap::iterator &it, bool rev_flow);
+    void DeleteInternal(FlowEntry *fe);
 
     void UpdateReverseFlow(FlowEntry *flow, FlowEntry *rflow);
 
@@ -719,15 +808,19 @@ private:
 inline void intrusive_ptr_add_ref(FlowEntry *fe) {
     fe->refcount_.fetch_and_increment();
 }
+// Only the last reference is dropped under the partition lock, see
+// FlowTable::ReleaseFlowEntry
 inline void intrusive_ptr_release(FlowEntry *fe) {
-    int prev = fe->refcount_.fetch_and_decrement();
-    if (prev == 1) {
-        FlowTable *table = Agent::GetInstance()->pkt()->flow_table();
-        FlowTable::FlowEntryMap::iterator it = table->flow_entry_map_.find(fe->key());
-        assert(it != table->flow_entry_map_.end());
-        table->flow_entry_map_.erase(it);
-        delete fe;
+    int count = fe->refcount_;
+    while (count > 1) {
+        int prev = fe->refcount_.compare_and_swap(count - 1, count);
+        if (prev == count) {
+            return;
+        }
+        count = prev;
     }
+    FlowTable *table = Agent::GetInstance()->pkt()->flow_table();
+    table->ReleaseFlowEntry(fe);
 }
 
 class Inet4RouteUpdate {
@@ -800,10 +893,21 @@ private:
 };
 
 struct AclFlowInfo {
+    typedef std::map<int, FlowEntryTree> AceIdFlowMap;
+
     AclFlowInfo() : flow_count(0), flow_miss(0) { }
     ~AclFlowInfo() { }
+    // Flows whose result can change with the entry changes of the ACL
+    void GetChangedFlows(const AclDBEntry *acl, FlowEntryTree *changed) const;
+
     FlowEntryTree fet;
     FlowTable::AceIdFlowCntMap aceid_cnt_map;
+    // Flows that matched each entry of the ACL
+    AceIdFlowMap ace_flow_map;
+    // Flows by the terminal entry they matched, and flows that did not
+    // match a terminal entry
+    AceIdFlowMap terminal_flow_map;
+    FlowEntryTree non_terminal_fet;
     void AddAclEntryIDFlowCnt(AclEntryIDList &idlist);
     void RemoveAclEntryIDFlowCnt(AclEntryIDList &idlist);
     int32_t flow_count;
@@ -1,16 +1,36 @@
 /*
  * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
  */
+#include <assert.h>
 #include <string>
 #include <boost/shared_ptr.hpp>
 #include <pkt/packet_buffer.h>
 #include <pkt/control_interface.h>
 
+// Deleter for PacketBuffers created with AllocateRx. Returns the buffer
+// to the receive buffer pool
+struct RxBufferRelease {
+    explicit RxBufferRelease(PacketBufferManager *mgr) : mgr_(mgr) { }
+    void operator()(uint8_t *buff) const { mgr_->PutRxBuffer(buff); }
+    PacketBufferManager *mgr_;
+};
+
 PacketBufferManager::PacketBufferManager(PktModule *pkt_module) :
     alloc_(0), free_(0), pkt_module_(pkt_module) {
+    rx_pool_count_ = 0;
+    rx_buffer_alloc_ = 0;
+    rx_buffer_reuse_ = 0;
+    rx_buffer_outstanding_ = 0;
 }
 
 PacketBufferManager::~PacketBufferManager() {
+    // A receive buffer still held would be returned to a deleted manager
+    assert(rx_buffer_outstanding_ == 0);
+    uint8_t *buff;
+    while (rx_pool_.try_pop(buff)) {
+        delete [] buff;
+    }
+    rx_pool_count_ = 0;
 }
 
 PacketBufferPtr PacketBufferManager::Allocate(uint32_t module, uint16_t len,
@@ -31,6 +51,41 @@ PacketBufferPtr PacketBufferManager::Allocate(uint32_t module, uint8_t *buff,
     return ptr;
 }
 
+uint8_t *PacketBufferManager::GetRxBuffer() {
+    rx_buffer_outstanding_++;
+    uint8_t *buff;
+    if (rx_pool_.try_pop(buff)) {
+        rx_pool_count_--;
+        rx_buffer_reuse_++;
+        return buff;
+    }
+    rx_buffer_alloc_++;
+    return new uint8_t[kRxBufferLen];
+}
+
+void PacketBufferManager::PutRxBuffer(uint8_t *buff) {
+    rx_buffer_outstanding_--;
+    // Count is only a bound on the pool size, its fine if concurrent puts
+    // let it go slightly above kRxBufferPoolMax
+    if (rx_pool_count_ >= kRxBufferPoolMax) {
+        delete [] buff;
+        return;
+    }
+    rx_pool_count_++;
+    rx_pool_.push(buff);
+}
+
+PacketBufferPtr PacketBufferManager::AllocateRx(uint32_t module, uint8_t *buff,
+                                                uint16_t data_offset,
+                                                uint16_t data_len,
+                                                uint32_t mdata) {
+    boost::shared_ptr<uint8_t> rx_buff(buff, RxBufferRelease(this));
+    PacketBufferPtr ptr(new PacketBuffer(this, module, rx_buff, kRxBufferLen,
+                                         data_offset, data_len, mdata));
+    alloc_++;
+    return ptr;
+}
+
 void PacketBufferManager::FreeIndication(PacketBuffer *pkt) {
     free_++;
 }
@@ -48,6 +103,14 @@ PacketBuffer::PacketBuffer(PacketBufferManager *mgr, uint32_t module,
     data_len_(data_len), module_(module), mdata_(mdata), mgr_(mgr) {
 }
 
+PacketBuffer::PacketBuffer(PacketBufferManager *mgr, uint32_t module,
+                           const boost::shared_ptr<uint8_t> &buff,
+                           uint16_t len, uint16_t data_offset,
+                           uint16_t data_len, uint32_t mdata) :
+    buffer_(buff), buffer_len_(len), data_(buffer_.get() + data_offset),
+    data_len_(data_len), module_(module), mdata_(mdata), mgr_(mgr) {
+}
+
 PacketBuffer::~PacketBuffer() {
     mgr_->FreeIndication(this);
     data_ = NULL;
@@ -8,6 +8,8 @@
 #include <string>
 #include <stdint.h>
 #include <boost/shared_ptr.hpp>
+#include <tbb/atomic.h>
+#include <tbb/concurrent_queue.h>
 #include <base/util.h>
 
 class PacketBuffer;
@@ -43,6 +45,11 @@ private:
                  uint16_t len, uint16_t data_offset, uint16_t data_len,
                  uint32_t mdata);
 
+    // Create PacketBuffer from memory owned by the shared pointer
+    PacketBuffer(PacketBufferManager *mgr, uint32_t module,
+                 const boost::shared_ptr<uint8_t> &buff, uint16_t len,
+                 uint16_t data_offset, uint16_t data_len, uint32_t mdata);
+
     boost::shared_ptr<uint8_t> buffer_;
     uint16_t buffer_len_;
 
@@ -55,8 +62,20 @@ private:
     DISALLOW_COPY_AND_ASSIGN(PacketBuffer);
 };
 
+// PacketBufferManager also keeps a pool of receive buffers of kRxBufferLen
+// bytes. Control interfaces read packets into buffers from GetRxBuffer and
+// wrap them with AllocateRx. The buffer goes back to the pool, instead of
+// being freed, when the PacketBuffer is released. Buffers are released from
+// multiple tasks, hence the pool is a concurrent queue. The release keeps a
+// pointer to the PacketBufferManager, so every buffer got from GetRxBuffer
+// must be returned before the PacketBufferManager is destroyed.
 class PacketBufferManager {
 public:
+    // Must be atleast ControlInterface::kMaxPacketSize
+    static const uint32_t kRxBufferLen = 9060;
+    // Max buffers kept in the pool. Buffers released beyond this are freed
+    static const uint32_t kRxBufferPoolMax = 1024;
+
     PacketBufferManager(PktModule *pkt_module);
     virtual ~PacketBufferManager();
 
@@ -65,6 +84,22 @@ public:
     PacketBufferPtr Allocate(uint32_t module, uint8_t *buff, uint16_t len,
                              uint16_t data_offset, uint16_t data_len,
                              uint32_t mdata);
+
+    // Get a buffer of kRxBufferLen bytes from the receive buffer pool
+    uint8_t *GetRxBuffer();
+    // Return a buffer got from GetRxBuffer to the pool
+    void PutRxBuffer(uint8_t *buff);
+    // Create PacketBuffer for buffer got from GetRxBuffer. The buffer is
+    // returned to the pool when the PacketBuffer is released
+    PacketBufferPtr AllocateRx(uint32_t module, uint8_t *buff,
+                               uint16_t data_offset, uint16_t data_len,
+                               uint32_t mdata);
+
+    uint32_t rx_pool_size() const { return rx_pool_count_; }
+    uint64_t rx_buffer_alloc() const { return rx_buffer_alloc_; }
+    uint64_t rx_buffer_reuse() const { return rx_buffer_reuse_; }
+    // Buffers got from GetRxBuffer and not yet returned
+    uint32_t rx_buffer_outstanding() const { return rx_buffer_outstanding_; }
 private:
     friend class PacketBuffer;
     void FreeIndication(PacketBuffer *);
@@ -73,6 +108,12 @@ private:
     uint64_t free_;
     PktModule *pkt_module_;
 
+    tbb::concurrent_queue<uint8_t *> rx_pool_;
+    tbb::atomic<uint32_t> rx_pool_count_;
+    tbb::atomic<uint64_t> rx_buffer_alloc_;
+    tbb::atomic<uint64_t> rx_buffer_reuse_;
+    tbb::atomic<uint32_t> rx_buffer_outstanding_;
+
     DISALLOW_COPY_AND_ASSIGN(PacketBufferManager);
 };
 
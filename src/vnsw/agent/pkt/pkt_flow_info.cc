@@ -1083,6 +1083,7 @@ void PktFlowInfo::Add(const PktInfo *pkt, PktControlInfo *in,
         flow = Agent::GetInstance()->pkt()->flow_table()->Allocate(key);
     } else {
         flow = flow_entry;
+        tbb::mutex::scoped_lock lock(flow->mutex());
         Agent::GetInstance()->pkt()->flow_table()->DeleteFlowInfo(flow.get());
     }
 
@@ -1164,6 +1165,9 @@ void PktFlowInfo::Add(const PktInfo *pkt, PktControlInfo *in,
         swap_flows = true;
     }
 
+    // Flow handlers of other partitions can share a flow with this flow
+    // pair if it is NAT-ed
+    FlowPairLock lock(flow.get(), rflow.get());
     tcp_ack = pkt->tcp_ack;
     flow->InitFwdFlow(this, pkt, in, out);
     rflow->InitRevFlow(this, out, in);
@@ -1254,7 +1258,8 @@ void PktFlowInfo::RewritePktInfo(uint32_t flow_index) {
         return;
     }
 
-    FlowEntry *flow = Agent::GetInstance()->pkt()->flow_table()->Find(key);
+    // The flow may be in the partition of another flow handler
+    FlowEntryPtr flow = Agent::GetInstance()->pkt()->flow_table()->Acquire(key);
     if (!flow) {
         std::ostringstream ostr;  
         ostr << "ECMP Resolve: unable to find flow index " << flow_index;
@@ -22,7 +22,12 @@ PktModule::PktModule(Agent *agent)
     packet_buffer_manager_(new PacketBufferManager(this)) {
 }
 
+// The flow work queues hold PacketBuffers that refer to
+// packet_buffer_manager_, release them before it is destroyed
 PktModule::~PktModule() {
+    flow_proto_.reset(NULL);
+    flow_table_.reset(NULL);
+    pkt_handler_.reset(NULL);
 }
 
 void PktModule::Init(bool run_with_vrouter) {
@@ -254,6 +254,11 @@ string PktSandeshFlow::GetFlowKey(const FlowKey &key) {
 }
 
 bool PktSandeshFlow::SetFlowKey(string key) {
+    // Iteration from the start key visits all partitions of the flow table
+    if (key == start_key) {
+        flow_iteration_key_.Reset();
+        return true;
+    }
     size_t n = std::count(key.begin(), key.end(), ':');
     if (n != 5) {
         return false;
@@ -290,7 +295,7 @@ bool PktSandeshFlow::SetFlowKey(string key) {
 }
 
 bool PktSandeshFlow::Run() {
-    FlowTable::FlowEntryMap::iterator it;
+    FlowEntry *fe;
     std::vector<SandeshFlowData>& list =
         const_cast<std::vector<SandeshFlowData>&>(resp_obj_->get_flow_list());
     int count = 0;
@@ -304,24 +309,24 @@ bool PktSandeshFlow::Run() {
     }
 
     if (key_valid_) {
-        it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
+        fe = flow_obj->GetNext(flow_iteration_key_);
     } else {
         FlowErrorResp *resp = new FlowErrorResp();
         SendResponse(resp);
         return true;
     }
-    while (it != flow_obj->flow_entry_map_.end()) {
-        FlowEntry *fe = it->second;
+    while (fe != NULL) {
         SetSandeshFlowData(list, fe);
-        ++it;
+        FlowEntry *next = flow_obj->GetNext(fe->key());
         count++;
         if (count == kMaxFlowResponse) {
-            if (it != flow_obj->flow_entry_map_.end()) {
+            if (next != NULL) {
                 resp_obj_->set_flow_key(GetFlowKey(fe->key()));
                 flow_key_set = true;
             }
             break;
         }
+        fe = next;
     }
     if (!flow_key_set) {
         resp_obj_->set_flow_key(PktSandeshFlow::start_key);
@@ -371,13 +376,11 @@ void FetchFlowRecord::HandleRequest() const {
     key.dst_port = (unsigned)get_dst_port();
     key.protocol = get_protocol();
 
-    FlowTable::FlowEntryMap::iterator it;
     FlowTable *flow_obj = Agent::GetInstance()->pkt()->flow_table();
-    it = flow_obj->flow_entry_map_.find(key);
+    FlowEntry *fe = flow_obj->Find(key);
     SandeshResponse *resp;
-    if (it != flow_obj->flow_entry_map_.end()) {
+    if (fe != NULL) {
         FlowRecordResp *flow_resp = new FlowRecordResp();
-        FlowEntry *fe = it->second;
         SandeshFlowData data;
         SET_SANDESH_FLOW_DATA(data, fe);
         flow_resp->set_record(data);
@@ -12,14 +12,24 @@
 Proto::Proto(Agent *agent, const char *task_name, PktHandler::PktModuleName mod,
              boost::asio::io_service &io) 
     : agent_(agent), io_(io),
-      work_queue_(TaskScheduler::GetInstance()->GetTaskId(task_name), mod,
-                  boost::bind(&Proto::ProcessProto, this, _1)) {
+      work_queue_(new WorkQueue<boost::shared_ptr<PktInfo> >
+                  (TaskScheduler::GetInstance()->GetTaskId(task_name), mod,
+                   boost::bind(&Proto::ProcessProto, this, _1))) {
+    agent->pkt()->pkt_handler()->Register(mod,
+           boost::bind(&Proto::ValidateAndEnqueueMessage, this, _1) );
+}
+
+Proto::Proto(Agent *agent, PktHandler::PktModuleName mod,
+             boost::asio::io_service &io)
+    : agent_(agent), io_(io) {
     agent->pkt()->pkt_handler()->Register(mod,
            boost::bind(&Proto::ValidateAndEnqueueMessage, this, _1) );
 }
 
 Proto::~Proto() { 
-    work_queue_. Shutdown();
+    if (work_queue_.get()) {
+        work_queue_->Shutdown();
+    }
 }
 
 bool Proto::ValidateAndEnqueueMessage(boost::shared_ptr<PktInfo> msg) {
@@ -36,7 +46,11 @@ bool Proto::ValidateAndEnqueueMessage(boost::shared_ptr<PktInfo> msg) {
         msg->data = NULL;
     }
 
-    return work_queue_.Enqueue(msg);
+    return Enqueue(msg);
+}
+
+bool Proto::Enqueue(boost::shared_ptr<PktInfo> msg) {
+    return work_queue_->Enqueue(msg);
 }
 
 bool Proto::ProcessProto(boost::shared_ptr<PktInfo> msg_info) {
@@ -5,6 +5,7 @@
 #ifndef vnsw_agent_proto_hpp
 #define vnsw_agent_proto_hpp
 
+#include <boost/scoped_ptr.hpp>
 #include "pkt_handler.h"
 
 class Agent;
@@ -30,14 +31,19 @@ public:
     virtual ProtoHandler *AllocProtoHandler(boost::shared_ptr<PktInfo> info,
                                             boost::asio::io_service &io) = 0;
     virtual bool ValidateAndEnqueueMessage(boost::shared_ptr<PktInfo> msg);
+    virtual bool Enqueue(boost::shared_ptr<PktInfo> msg);
     bool ProcessProto(boost::shared_ptr<PktInfo> msg_info);
 
 protected:
+    // For protocols that run their own work queues and override Enqueue()
+    Proto(Agent *agent, PktHandler::PktModuleName mod,
+          boost::asio::io_service &io);
+
     Agent *agent_;
     boost::asio::io_service &io_;
 
 private:
-    WorkQueue<boost::shared_ptr<PktInfo> > work_queue_;
+    boost::scoped_ptr<WorkQueue<boost::shared_ptr<PktInfo> > > work_queue_;
     DISALLOW_COPY_AND_ASSIGN(Proto);
 };
 
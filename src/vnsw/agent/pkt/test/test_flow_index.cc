@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/os.h"
+#include <map>
+#include <set>
+#include <vector>
+#include "base/logging.h"
+#include "base/test/counting_allocator.h"
+#include "testing/gunit.h"
+#include "pkt/flow_table.h"
+#include "pkt/flow_index.h"
+
+using namespace std;
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+// The flow container used by FlowTable before FlowEntryIndex
+typedef map<FlowKey, FlowEntry *, Inet4FlowKeyCmp,
+    CountingAllocator<pair<const FlowKey, FlowEntry *> > > FlowEntryMap;
+
+class FlowIndexTest : public ::testing::Test {
+protected:
+    // Number of flows for the scale comparison. Can be overridden with
+    // FLOW_INDEX_TEST_FLOWS.
+    static size_t FlowCount() {
+        char *str = getenv("FLOW_INDEX_TEST_FLOWS");
+        if (str) {
+            return strtoul(str, NULL, 0);
+        }
+        return 512 * 1024;
+    }
+
+    static FlowKey MakeKey(uint32_t i) {
+        return FlowKey(i % 16, Ip4Address(0x01010101),
+                       Ip4Address(0x05000000 + i), 6, 1000 + (i % 1000), 80);
+    }
+
+    virtual void TearDown() {
+        for (vector<FlowEntry *>::iterator it = flow_list_.begin();
+             it != flow_list_.end(); ++it) {
+            (*it)->~FlowEntry();
+            pool_.Free(*it);
+        }
+        flow_list_.clear();
+        EXPECT_EQ(0U, pool_.in_use_count());
+    }
+
+    FlowEntry *AddFlow(uint32_t i) {
+        FlowEntry *flow = new (pool_.Allocate()) FlowEntry(MakeKey(i));
+        flow_list_.push_back(flow);
+        index_.Insert(flow);
+        return flow;
+    }
+
+    FlowEntryIndex index_;
+    FlowEntryPool pool_;
+    vector<FlowEntry *> flow_list_;
+};
+
+TEST_F(FlowIndexTest, Basic) {
+    EXPECT_TRUE(index_.GetFirst() == NULL);
+    EXPECT_TRUE(index_.Find(MakeKey(1)) == NULL);
+
+    FlowEntry *flow1 = AddFlow(1);
+    FlowEntry *flow2 = AddFlow(2);
+    EXPECT_EQ(2U, index_.size());
+    EXPECT_EQ(flow1, index_.Find(MakeKey(1)));
+    EXPECT_EQ(flow2, index_.Find(MakeKey(2)));
+    EXPECT_TRUE(index_.Find(MakeKey(3)) == NULL);
+
+    // Key differing only in nexthop is a different flow
+    FlowKey key = MakeKey(1);
+    key.nh++;
+    EXPECT_TRUE(index_.Find(key) == NULL);
+
+    EXPECT_TRUE(index_.Remove(flow1));
+    EXPECT_FALSE(index_.Remove(flow1));
+    EXPECT_EQ(1U, index_.size());
+    EXPECT_TRUE(index_.Find(MakeKey(1)) == NULL);
+    EXPECT_EQ(flow2, index_.Find(MakeKey(2)));
+    EXPECT_EQ(flow2, index_.GetFirst());
+    EXPECT_TRUE(index_.GetNext(MakeKey(2)) == NULL);
+
+    EXPECT_TRUE(index_.Remove(flow2));
+    EXPECT_TRUE(index_.GetFirst() == NULL);
+}
+
+// Index is grown as flows are added, and lookups still find all flows
+TEST_F(FlowIndexTest, Resize) {
+    size_t count = 10 * FlowEntryIndex::kMinBuckets;
+    for (size_t i = 0; i < count; i++) {
+        AddFlow(i);
+    }
+    EXPECT_EQ(count, index_.size());
+    EXPECT_LE(2 * count, index_.bucket_count());
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(flow_list_[i], index_.Find(MakeKey(i)));
+    }
+
+    // Removing flows does not move the rest
+    for (size_t i = 0; i < count; i += 2) {
+        EXPECT_TRUE(index_.Remove(flow_list_[i]));
+    }
+    for (size_t i = 1; i < count; i += 2) {
+        EXPECT_EQ(flow_list_[i], index_.Find(MakeKey(i)));
+    }
+}
+
+// Every flow is visited once when the flow returned last is deleted before
+// moving to the next one, as FlowTable::DeleteAll() does
+TEST_F(FlowIndexTest, IterateWithDelete) {
+    size_t count = 10000;
+    for (size_t i = 0; i < count; i++) {
+        AddFlow(i);
+    }
+
+    set<FlowEntry *> visited;
+    FlowEntry *flow = index_.GetFirst();
+    while (flow != NULL) {
+        EXPECT_TRUE(visited.insert(flow).second);
+        FlowKey key = flow->key();
+        if (visited.size() % 2) {
+            EXPECT_TRUE(index_.Remove(flow));
+        }
+        flow = index_.GetNext(key);
+    }
+    EXPECT_EQ(count, visited.size());
+    EXPECT_EQ(count / 2, index_.size());
+}
+
+// Flows present throughout an iteration are visited once, even when flows
+// added and removed meanwhile resize the index and reuse slots
+TEST_F(FlowIndexTest, IterateWithResize) {
+    size_t count = 2000;
+    for (size_t i = 0; i < count; i++) {
+        AddFlow(i);
+    }
+
+    set<FlowEntry *> visited;
+    size_t added = count;
+    FlowEntry *flow = index_.GetFirst();
+    while (flow != NULL) {
+        EXPECT_TRUE(visited.insert(flow).second);
+        FlowKey key = flow->key();
+        // Add flows, and remove some of them, till the index is resized
+        size_t bucket_count = index_.bucket_count();
+        while (index_.bucket_count() == bucket_count && added < 16 * count) {
+            FlowEntry *added_flow = AddFlow(added++);
+            if (added % 2) {
+                EXPECT_TRUE(index_.Remove(added_flow));
+            }
+        }
+        flow = index_.GetNext(key);
+    }
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(1U, visited.count(flow_list_[i]));
+    }
+}
+
+// Freed entries are reused before more memory is taken from the heap
+TEST_F(FlowIndexTest, Pool) {
+    EXPECT_EQ(0U, pool_.allocated_bytes());
+    void *entry = pool_.Allocate();
+    EXPECT_EQ(FlowEntryPool::kSlabSize * pool_.entry_size(),
+              pool_.allocated_bytes());
+    EXPECT_EQ(1U, pool_.in_use_count());
+    EXPECT_EQ(FlowEntryPool::kSlabSize - 1, pool_.free_count());
+    pool_.Free(entry);
+    EXPECT_EQ(entry, pool_.Allocate());
+    pool_.Free(entry);
+
+    vector<void *> list;
+    for (size_t i = 0; i < FlowEntryPool::kSlabSize + 1; i++) {
+        list.push_back(pool_.Allocate());
+    }
+    EXPECT_EQ(2 * FlowEntryPool::kSlabSize * pool_.entry_size(),
+              pool_.allocated_bytes());
+    for (size_t i = 0; i < list.size(); i++) {
+        pool_.Free(list[i]);
+    }
+    EXPECT_EQ(0U, pool_.in_use_count());
+}
+
+// Slabs without entries in use are returned to the heap once free entries
+// are more than both kTrimFreeCount and the entries in use. Trims of a
+// fragmented pool are spaced out, so somewhat more may be left free.
+TEST_F(FlowIndexTest, PoolTrim) {
+    size_t count = 4 * FlowEntryPool::kTrimFreeCount;
+    vector<void *> list;
+    for (size_t i = 0; i < count; i++) {
+        list.push_back(pool_.Allocate());
+    }
+    size_t allocated_bytes = pool_.allocated_bytes();
+    EXPECT_EQ(count * pool_.entry_size(), allocated_bytes);
+
+    // Free every other entry, no slab is free
+    for (size_t i = 0; i < count; i += 2) {
+        pool_.Free(list[i]);
+    }
+    EXPECT_EQ(allocated_bytes, pool_.allocated_bytes());
+
+    for (size_t i = 1; i < count; i += 2) {
+        pool_.Free(list[i]);
+    }
+    EXPECT_EQ(0U, pool_.in_use_count());
+    EXPECT_GE(2 * FlowEntryPool::kTrimFreeCount * pool_.entry_size(),
+              pool_.allocated_bytes());
+    EXPECT_EQ(pool_.free_count() * pool_.entry_size(),
+              pool_.allocated_bytes());
+
+    // Remaining entries are still handed out
+    list.clear();
+    for (size_t i = 0; i < count; i++) {
+        list.push_back(pool_.Allocate());
+    }
+    EXPECT_EQ(count, pool_.in_use_count());
+    for (size_t i = 0; i < count; i++) {
+        pool_.Free(list[i]);
+    }
+}
+
+// Compare memory used per flow and lookup time of FlowEntryIndex and the
+// std::map previously used by FlowTable, with FlowCount() flows
+TEST_F(FlowIndexTest, Scale) {
+    size_t count = FlowCount();
+    vector<FlowKey> key_list;
+    for (size_t i = 0; i < count; i++) {
+        key_list.push_back(MakeKey(i));
+    }
+
+    CountingAllocatorBytes() = 0;
+    FlowEntryMap flow_map;
+    uint64_t start = ClockMonotonicUsec();
+    for (size_t i = 0; i < count; i++) {
+        flow_map.insert(make_pair(key_list[i], new FlowEntry(key_list[i])));
+    }
+    uint64_t map_insert_time = ClockMonotonicUsec() - start;
+
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < count; i++) {
+        AddFlow(i);
+    }
+    uint64_t index_insert_time = ClockMonotonicUsec() - start;
+
+    size_t map_found = 0;
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < count; i++) {
+        if (flow_map.find(key_list[i]) != flow_map.end()) {
+            map_found++;
+        }
+    }
+    uint64_t map_lookup_time = ClockMonotonicUsec() - start;
+
+    size_t index_found = 0;
+    uint64_t probes = index_.probe_count();
+    start = ClockMonotonicUsec();
+    for (size_t i = 0; i < count; i++) {
+        if (index_.Find(key_list[i]) != NULL) {
+            index_found++;
+        }
+    }
+    uint64_t index_lookup_time = ClockMonotonicUsec() - start;
+    probes = index_.probe_count() - probes;
+
+    EXPECT_EQ(count, map_found);
+    EXPECT_EQ(count, index_found);
+
+    // Flow entries are allocated one at a time from the heap with std::map
+    size_t map_bytes = CountingAllocatorBytes() + count * sizeof(FlowEntry);
+    for (FlowEntryMap::iterator it = flow_map.begin(); it != flow_map.end();
+         ++it) {
+        delete it->second;
+    }
+    size_t index_bytes = index_.allocated_bytes() + pool_.allocated_bytes();
+    cout << count << " flows, FlowEntry " << sizeof(FlowEntry) << " bytes"
+         << endl;
+    cout << "std::map       : " << map_bytes / count << " bytes/flow, "
+         << "insert " << map_insert_time << " usec, "
+         << "lookup " << map_lookup_time << " usec" << endl;
+    cout << "FlowEntryIndex : " << index_bytes / count << " bytes/flow, "
+         << "insert " << index_insert_time << " usec, "
+         << "lookup " << index_lookup_time << " usec, "
+         << (double)probes / count << " probes/lookup" << endl;
+    EXPECT_LT(index_.allocated_bytes(), CountingAllocatorBytes());
+}
+
+int main(int argc, char **argv) {
+    LoggingInit();
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
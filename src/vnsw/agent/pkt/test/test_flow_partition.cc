@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
+ */
+
+#include "base/os.h"
+#include <vector>
+#include "test/test_cmn_util.h"
+#include "test_pkt_util.h"
+#include "pkt/flow_proto.h"
+
+#define DEFAULT_FLOW_THREAD_COUNT "4"
+
+struct PortInfo input[] = {
+    {"vnet1", 1, "1.1.1.1", "00:00:01:01:01:01", 1, 1},
+};
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+class FlowPartitionTest : public ::testing::Test {
+public:
+    virtual void SetUp() {
+        flow_table_ = Agent::GetInstance()->pkt()->flow_table();
+        CreateVmportEnv(input, 1);
+        client->WaitForIdle();
+        WAIT_FOR(10000, 1000, VmPortActive(input, 0));
+
+        vnet = VmInterfaceGet(1);
+        strcpy(vnet_addr, vnet->ip_addr().to_string().c_str());
+
+        boost::system::error_code ec;
+        Inet4TunnelRouteAdd(NULL, "vrf1",
+                            Ip4Address::from_string("5.0.0.0", ec),
+                            8, Ip4Address::from_string("1.1.1.2", ec),
+                            TunnelType::AllType(), 16, "TestVn",
+                            SecurityGroupList(), PathPreference());
+        client->WaitForIdle();
+        EXPECT_EQ(0U, flow_table_->Size());
+    }
+
+    virtual void TearDown() {
+        int count = flow_table_->Size();
+
+        client->EnqueueFlowFlush();
+        WAIT_FOR(count, 10000, (0 == flow_table_->Size()));
+        int a = count / 500;
+        if (a == 0)
+            a = 1;
+        client->WaitForIdle(a);
+        boost::system::error_code ec;
+        InetUnicastAgentRouteTable::DeleteReq(NULL, "vrf1",
+                Ip4Address::from_string("5.0.0.0", ec), 8, NULL);
+        DeleteVmportEnv(input, 1, 1);
+        client->WaitForIdle();
+    }
+
+    // Packets are built with pkt_gen ahead of time, so that only flow setup
+    // is timed
+    void MakePackets(int count, std::vector<PktGen *> *list) {
+        for (int i = 0; i < count; i++) {
+            PktGen *pkt = new PktGen();
+            Ip4Address addr(0x05000000 + i);
+            MakeIpPacket(pkt, vnet->id(), vnet_addr,
+                         addr.to_string().c_str(), 1, 1);
+            list->push_back(pkt);
+        }
+    }
+
+    void TxPackets(const std::vector<PktGen *> &list) {
+        for (size_t i = 0; i < list.size(); i++) {
+            PktGen *pkt = list[i];
+            uint8_t *ptr(new uint8_t[pkt->GetBuffLen()]);
+            memcpy(ptr, pkt->GetBuff(), pkt->GetBuffLen());
+            client->agent_init()->pkt0()->ProcessFlowPacket
+                (ptr, pkt->GetBuffLen(), pkt->GetBuffLen());
+        }
+    }
+
+    FlowTable *flow_table_;
+    VmInterface *vnet;
+    char vnet_addr[32];
+};
+
+TEST_F(FlowPartitionTest, SymmetricHash) {
+    boost::system::error_code ec;
+    IpAddress sip = Ip4Address::from_string("1.1.1.1", ec);
+    for (int i = 0; i < 1000; i++) {
+        IpAddress dip = Ip4Address(0x05000000 + i);
+        uint16_t sport = 1000 + i;
+        uint16_t dport = 80;
+        EXPECT_EQ(FlowTable::PartitionHash(sip, dip, 6, sport, dport),
+                  FlowTable::PartitionHash(dip, sip, 6, dport, sport));
+    }
+
+    IpAddress sip6 = Ip6Address::from_string("fd11::1", ec);
+    IpAddress dip6 = Ip6Address::from_string("fd11::2", ec);
+    EXPECT_EQ(FlowTable::PartitionHash(sip6, dip6, 17, 1000, 53),
+              FlowTable::PartitionHash(dip6, sip6, 17, 53, 1000));
+}
+
+// Forward and reverse flows are in the same partition, and flows of all
+// partitions are visited by iteration
+TEST_F(FlowPartitionTest, FlowPairs) {
+    int count = 100;
+    std::vector<PktGen *> list;
+    MakePackets(count, &list);
+    TxPackets(list);
+    STLDeleteValues(&list);
+    WAIT_FOR(count * 10, 10000, ((uint32_t) count * 2 == flow_table_->Size()));
+    client->WaitForIdle();
+
+    size_t size = 0;
+    uint32_t used_partitions = 0;
+    for (uint32_t i = 0; i < flow_table_->partition_count(); i++) {
+        size += flow_table_->PartitionSize(i);
+        if (flow_table_->PartitionSize(i)) {
+            used_partitions++;
+        }
+    }
+    EXPECT_EQ(flow_table_->Size(), size);
+    if (flow_table_->partition_count() > 1) {
+        EXPECT_LT(1U, used_partitions);
+    }
+
+    FlowKey key;
+    key.Reset();
+    size_t visited = 0;
+    FlowEntry *fe = flow_table_->GetNext(key);
+    while (fe != NULL) {
+        visited++;
+        EXPECT_TRUE(flow_table_->Find(fe->key()) == fe);
+        FlowEntry *rflow = fe->reverse_flow_entry();
+        EXPECT_TRUE(rflow != NULL);
+        if (rflow) {
+            EXPECT_EQ(fe, rflow->reverse_flow_entry());
+            EXPECT_EQ(flow_table_->PartitionIndex(fe->key()),
+                      flow_table_->PartitionIndex(rflow->key()));
+        }
+        fe = flow_table_->GetNext(fe->key());
+    }
+    EXPECT_EQ(flow_table_->Size(), visited);
+}
+
+// Flow is removed from its partition when the last reference is released,
+// and a flow found in the partition always has a reference to take
+TEST_F(FlowPartitionTest, ReleaseRemovesFlow) {
+    boost::system::error_code ec;
+    FlowKey key(vnet->flow_key_nh()->id(),
+                Ip4Address::from_string(vnet_addr, ec),
+                Ip4Address::from_string("5.0.0.1", ec), 6, 1000, 80);
+    uint32_t index = flow_table_->PartitionIndex(key);
+    FlowEntry *fe = NULL;
+    {
+        FlowEntryPtr flow = flow_table_->Allocate(key);
+        fe = flow.get();
+        EXPECT_EQ(1, fe->GetRefCount());
+        EXPECT_EQ(1U, flow_table_->PartitionSize(index));
+        EXPECT_TRUE(flow_table_->Find(key) == fe);
+
+        {
+            FlowEntryPtr flow2 = flow;
+            EXPECT_EQ(2, fe->GetRefCount());
+        }
+        EXPECT_EQ(1, fe->GetRefCount());
+        EXPECT_EQ(1U, flow_table_->PartitionSize(index));
+    }
+    EXPECT_EQ(0U, flow_table_->PartitionSize(index));
+    EXPECT_TRUE(flow_table_->Find(key) == NULL);
+}
+
+// Flow setup rate for the configured number of partitions. Run with
+// AGENT_FLOW_THREAD_COUNT set to 1, 2, 4... to compare scaling and with
+// AGENT_FLOW_BENCHMARK_COUNT to set the number of flows
+TEST_F(FlowPartitionTest, FlowSetupRate) {
+    int count = 1000;
+    if (getenv("AGENT_FLOW_BENCHMARK_COUNT")) {
+        count = strtoul(getenv("AGENT_FLOW_BENCHMARK_COUNT"), NULL, 0);
+    }
+    std::vector<PktGen *> list;
+    MakePackets(count, &list);
+
+    FlowProto *proto = Agent::GetInstance()->GetFlowProto();
+    std::vector<size_t> enqueues;
+    for (uint32_t i = 0; i < flow_table_->partition_count(); i++) {
+        enqueues.push_back(proto->flow_work_queue(i)->NumEnqueues());
+    }
+
+    uint64_t start = ClockMonotonicUsec();
+    TxPackets(list);
+    WAIT_FOR(count * 100, 1000, ((uint32_t) count * 2 == flow_table_->Size()));
+    uint64_t elapsed = ClockMonotonicUsec() - start;
+    STLDeleteValues(&list);
+
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    cout << "Partitions " << flow_table_->partition_count()
+         << " : " << count << " flow pairs in " << elapsed << " usec, "
+         << (count * 1000000ULL) / elapsed << " flow setups/sec" << endl;
+    for (uint32_t i = 0; i < flow_table_->partition_count(); i++) {
+        size_t partition_enqueues =
+            proto->flow_work_queue(i)->NumEnqueues() - enqueues[i];
+        cout << "  Partition " << i << " : " << partition_enqueues
+             << " packets, " << flow_table_->PartitionSize(i) << " flows"
+             << endl;
+        if (flow_table_->partition_count() > 1) {
+            EXPECT_LT(0U, partition_enqueues);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    int ret = 0;
+
+    GETUSERARGS();
+    // Run with more than one flow table partition unless overridden
+    setenv("AGENT_FLOW_THREAD_COUNT", DEFAULT_FLOW_THREAD_COUNT, 0);
+    client = TestInit(init_file, ksync_init, true, true, true, 100*1000);
+    ret = RUN_ALL_TESTS();
+    TestShutdown();
+    delete client;
+    return ret;
+}
@@ -68,10 +68,10 @@ int hash_id;
 
 class SetupTask;
 
-FlowEntry *FlowInit(TestFlowKey *t) {
+FlowEntryPtr FlowInit(TestFlowKey *t) {
     FlowKey key;
     t->InitFlowKey(&key);
-    FlowEntry *flow = Agent::GetInstance()->pkt()->flow_table()->Allocate(key);
+    FlowEntryPtr flow = Agent::GetInstance()->pkt()->flow_table()->Allocate(key);
 
     boost::shared_ptr<PktInfo> pkt_info(new PktInfo(Agent::GetInstance(),
                                                     100, 0, 0));
@@ -259,10 +259,11 @@ public:
         client->WaitForIdle();
     }
 
-    FlowEntry *FlowInit(TestFlowKey *t) {
+    FlowEntryPtr FlowInit(TestFlowKey *t) {
         FlowKey key;
         t->InitFlowKey(&key);
-        FlowEntry *flow = Agent::GetInstance()->pkt()->flow_table()->Allocate(key);
+        FlowEntryPtr flow =
+            Agent::GetInstance()->pkt()->flow_table()->Allocate(key);
 
         boost::shared_ptr<PktInfo> pkt_info(new PktInfo(NULL, 0, 0, 0));
         pkt_info->family = Address::INET;
@@ -391,19 +392,24 @@ class SetupTask : public Task {
         SetupTask(FlowTableTest *test) : Task((TaskScheduler::GetInstance()->GetTaskId("Agent::FlowHandler")), -1), test_(test) {
         }
         virtual bool Run() {
-            test_->flow1 = FlowInit(test_->key1);
-            test_->flow1->set_flags(FlowEntry::LocalFlow);
-
-            test_->flow1_r = FlowInit(test_->key1_r);
-            test_->flow1_r->set_flags(FlowEntry::LocalFlow);
-            FlowAdd(test_->flow1, test_->flow1_r);
-
-            test_->flow2 = FlowInit(test_->key2);
-            test_->flow2->reset_flags(FlowEntry::LocalFlow);
-
-            test_->flow2_r = FlowInit(test_->key2_r);
-            test_->flow2_r->reset_flags(FlowEntry::LocalFlow);
-            FlowAdd(test_->flow2, test_->flow2_r);
+            // The flows are referenced by the flow table once added
+            FlowEntryPtr flow1 = FlowInit(test_->key1);
+            flow1->set_flags(FlowEntry::LocalFlow);
+
+            FlowEntryPtr flow1_r = FlowInit(test_->key1_r);
+            flow1_r->set_flags(FlowEntry::LocalFlow);
+            FlowAdd(flow1.get(), flow1_r.get());
+            test_->flow1 = flow1.get();
+            test_->flow1_r = flow1_r.get();
+
+            FlowEntryPtr flow2 = FlowInit(test_->key2);
+            flow2->reset_flags(FlowEntry::LocalFlow);
+
+            FlowEntryPtr flow2_r = FlowInit(test_->key2_r);
+            flow2_r->reset_flags(FlowEntry::LocalFlow);
+            FlowAdd(flow2.get(), flow2_r.get());
+            test_->flow2 = flow2.get();
+            test_->flow2_r = flow2_r.get();
             return true;
         }
     private:
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2014 Juniper Networks, Inc. All rights reserved.
+ */
+
+// Tap loopback benchmark for packet receive on pkt0. Creates a tap interface
+// read by Pkt0Interface, sends frames to it from an AF_PACKET socket and
+// measures the rate at which packets reach PktHandler. Needs root to create
+// the tap interface, the test is skipped otherwise.
+//
+// AGENT_PKT0_BENCH_COUNT sets the number of packets sent in each run.
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+
+#include "base/os.h"
+#include "base/util.h"
+#include "base/test/task_test_util.h"
+#include "testing/gunit.h"
+#include "test/test_cmn_util.h"
+#include "test_pkt_util.h"
+#include "pkt/packet_buffer.h"
+#include "contrail/pkt0_interface.h"
+
+#define PKT0_BENCH_INTF "pkt0bench"
+
+void RouterIdDepInit(Agent *agent) {
+}
+
+static void SetDone(tbb::atomic<bool> *done) {
+    *done = true;
+}
+
+// Runs in the io_service thread so that it does not race with the read
+// handler. Closing the tap interface queues the cancelled read handler,
+// SetDone is queued behind it.
+static void ShutdownInterface(Pkt0Interface *intf,
+                              boost::asio::io_service *io,
+                              tbb::atomic<bool> *done) {
+    intf->IoShutdown();
+    io->post(boost::bind(&SetDone, done));
+}
+
+class Pkt0RxTest : public ::testing::Test {
+public:
+    virtual void SetUp() {
+        agent_ = Agent::GetInstance();
+        skip_ = (geteuid() != 0 || access("/dev/net/tun", R_OK | W_OK) != 0);
+        count_ = 100000;
+        if (getenv("AGENT_PKT0_BENCH_COUNT")) {
+            count_ = strtoul(getenv("AGENT_PKT0_BENCH_COUNT"), NULL, 0);
+        }
+    }
+
+    int OpenPacketSocket() {
+        int fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+        assert(fd >= 0);
+
+        struct ifreq ifr;
+        memset(&ifr, 0, sizeof(ifr));
+        strncpy(ifr.ifr_name, PKT0_BENCH_INTF, IF_NAMESIZE);
+        int ret = ioctl(fd, SIOCGIFINDEX, (void *)&ifr);
+        assert(ret == 0);
+
+        struct sockaddr_ll sll;
+        memset(&sll, 0, sizeof(sll));
+        sll.sll_family = AF_PACKET;
+        sll.sll_ifindex = ifr.ifr_ifindex;
+        sll.sll_protocol = htons(ETH_P_ALL);
+        ret = bind(fd, (struct sockaddr *)&sll, sizeof(sll));
+        assert(ret == 0);
+        return fd;
+    }
+
+    // Send count_ frames to the tap interface and return the packets per
+    // second received by PktHandler. Frames carry an invalid interface in
+    // the agent header so that PktHandler drops them right after parsing.
+    uint64_t Run(uint32_t batch_size) {
+        std::string pkt_interface_name = agent_->pkt_interface_name();
+        Pkt0Interface *intf = new Pkt0Interface(PKT0_BENCH_INTF,
+            agent_->event_manager()->io_service());
+        intf->set_read_batch_size(batch_size);
+        intf->Init(agent_->pkt()->pkt_handler());
+        agent_->set_pkt_interface_name(pkt_interface_name);
+        int fd = OpenPacketSocket();
+
+        PktGen pkt;
+        pkt.AddEthHdr("00:00:00:00:00:01", "00:00:00:00:00:02", 0x800);
+        pkt.AddAgentHdr(0xFFFF, AgentHdr::TRAP_FLOW_MISS);
+        pkt.AddEthHdr("00:00:00:00:00:01", "00:00:00:00:00:02", 0x800);
+        pkt.AddIpHdr("1.1.1.1", "2.2.2.2", IPPROTO_UDP);
+        pkt.AddUdpHdr(1000, 2000, 64);
+
+        uint64_t start_count = agent_->stats()->pkt_exceptions();
+        uint64_t start = UTCTimestampUsec();
+        for (uint32_t i = 0; i < count_; i++) {
+            while (send(fd, pkt.GetBuff(), pkt.GetBuffLen(), 0) < 0) {
+                usleep(10);
+            }
+        }
+
+        // The tap interface drops frames when its queue is full, so wait
+        // till the received count stops changing rather than for count_
+        uint64_t received = 0;
+        uint64_t end = start;
+        while (true) {
+            usleep(100000);
+            uint64_t current = agent_->stats()->pkt_exceptions() - start_count;
+            if (current == received)
+                break;
+            received = current;
+            end = UTCTimestampUsec();
+        }
+        close(fd);
+        boost::asio::io_service *io = agent_->event_manager()->io_service();
+        tbb::atomic<bool> done;
+        done = false;
+        io->post(boost::bind(&ShutdownInterface, intf, io, &done));
+        TASK_UTIL_EXPECT_TRUE(done);
+        client->WaitForIdle();
+        delete intf;
+
+        // Read buffers are back in the pool once PktHandler is done with
+        // the packets and the interface is deleted
+        EXPECT_EQ(0U, agent_->pkt()->packet_buffer_manager()->
+                  rx_buffer_outstanding());
+
+        uint64_t elapsed = (end > start) ? end - start : 1;
+        uint64_t pps = (received * 1000000) / elapsed;
+        std::cout << "pkt0 receive batch " << batch_size << " : sent "
+            << count_ << " received " << received << " in " << elapsed
+            << " usec, " << pps << " pps" << std::endl;
+        EXPECT_NE(0U, received);
+        return pps;
+    }
+
+    Agent *agent_;
+    bool skip_;
+    uint32_t count_;
+};
+
+TEST_F(Pkt0RxTest, TapLoopback) {
+    if (skip_) {
+        std::cout << "Skipping pkt0 receive benchmark, needs root" << std::endl;
+        return;
+    }
+
+    PacketBufferManager *mgr = agent_->pkt()->packet_buffer_manager();
+    Run(1);
+    uint64_t alloc = mgr->rx_buffer_alloc();
+    Run(Pkt0Interface::kReadBatchSize);
+
+    // Buffers released by PktHandler must be reused from the pool
+    EXPECT_NE(0U, mgr->rx_buffer_reuse());
+    std::cout << "pkt0 receive buffers allocated " << mgr->rx_buffer_alloc()
+        << " reused " << mgr->rx_buffer_reuse() << " (" << alloc
+        << " allocated in first run)" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    GETUSERARGS();
+
+    client = TestInit(init_file, ksync_init, true, true, true);
+    int ret = RUN_ALL_TESTS();
+    client->WaitForIdle();
+    TestShutdown();
+    delete client;
+    return ret;
+}
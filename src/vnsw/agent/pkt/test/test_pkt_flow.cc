@@ -409,6 +409,67 @@ public:
         client->WaitForIdle();
     }
 
+    // ACL with two rules passing protocols proto1 and proto2 between any
+    // networks
+    void AddTwoRuleAcl(const char *name, int id, int proto1, int proto2) {
+        char buff[4096];
+        sprintf(buff,
+                "<?xml version=\"1.0\"?>\n"
+                "<config>\n"
+                "   <update>\n"
+                "       <node type=\"access-control-list\">\n"
+                "           <name>%s</name>\n"
+                "           <id-perms>\n"
+                "               <uuid>\n"
+                "                   <uuid-mslong>0</uuid-mslong>\n"
+                "                   <uuid-lslong>%d</uuid-lslong>\n"
+                "               </uuid>\n"
+                "           </id-perms>\n"
+                "           <access-control-list-entries>\n"
+                "                <dynamic>false</dynamic>\n"
+                "%s%s"
+                "           </access-control-list-entries>\n"
+                "       </node>\n"
+                "   </update>\n"
+                "</config>\n", name, id, AclRuleXml(proto1).c_str(),
+                AclRuleXml(proto2).c_str());
+        pugi::xml_document xdoc_;
+        pugi::xml_parse_result result = xdoc_.load(buff);
+        EXPECT_TRUE(result);
+        Agent::GetInstance()->ifmap_parser()->ConfigParse(xdoc_.first_child(), 0);
+        client->WaitForIdle();
+    }
+
+    static string AclRuleXml(int proto) {
+        char buff[1024];
+        sprintf(buff,
+                "                <acl-rule>\n"
+                "                    <match-condition>\n"
+                "                        <src-address>\n"
+                "                            <virtual-network> any </virtual-network>\n"
+                "                        </src-address>\n"
+                "                        <protocol>%d</protocol>\n"
+                "                        <src-port>\n"
+                "                            <start-port> 0 </start-port>\n"
+                "                            <end-port> 60000 </end-port>\n"
+                "                        </src-port>\n"
+                "                        <dst-address>\n"
+                "                            <virtual-network> any </virtual-network>\n"
+                "                        </dst-address>\n"
+                "                        <dst-port>\n"
+                "                            <start-port> 0 </start-port>\n"
+                "                            <end-port> 60000 </end-port>\n"
+                "                        </dst-port>\n"
+                "                    </match-condition>\n"
+                "                    <action-list>\n"
+                "                        <simple-action>\n"
+                "                            pass\n"
+                "                        </simple-action>\n"
+                "                    </action-list>\n"
+                "                </acl-rule>\n", proto);
+        return string(buff);
+    }
+
     void AddSgEntry(const char *sg_name, const char *name, int id,
                     int proto, const char *action, AclDirection direction,
                     const char *uuid1, const char* uuid2) {
@@ -2780,6 +2841,69 @@ TEST_F(FlowTest, FlowPolicyUuid_2) {
     client->WaitForIdle(5);
 }
 
+// Only the flows whose result can change with the rules modified in an ACL
+// are evaluated again
+TEST_F(FlowTest, AclChangeResync) {
+    AddTwoRuleAcl("acl4", 4, 1, 6);
+    FlowSetup();
+    AddLink("virtual-network", "vn6", "access-control-list", "acl4");
+    client->WaitForIdle();
+
+    TestFlow flow[] = {
+        {  TestFlowPkt(Address::INET, vm_a_ip, vm_b_ip, 1, 0, 0, "vrf6",
+                       flow5->id()),
+        {
+            new VerifyVn("vn6", "vn6"),
+        }
+        },
+        {  TestFlowPkt(Address::INET, vm_b_ip, vm_a_ip, 1, 0, 0, "vrf6",
+                       flow6->id()),
+        {
+            new VerifyVn("vn6", "vn6"),
+        }
+        },
+        {  TestFlowPkt(Address::INET, vm_a_ip, vm_b_ip, 6, 1000, 80, "vrf6",
+                       flow5->id()),
+        {
+            new VerifyVn("vn6", "vn6"),
+        }
+        },
+        {  TestFlowPkt(Address::INET, vm_b_ip, vm_a_ip, 6, 80, 1000, "vrf6",
+                       flow6->id()),
+        {
+            new VerifyVn("vn6", "vn6"),
+        }
+        }
+    };
+    CreateFlow(flow, 4);
+    FlowTable *table = agent()->pkt()->flow_table();
+    EXPECT_EQ(4U, table->Size());
+    uint64_t count = table->acl_resync_flow_count();
+
+    // Same rules, no flow is evaluated
+    AddTwoRuleAcl("acl4", 4, 1, 6);
+    EXPECT_EQ(count, table->acl_resync_flow_count());
+
+    // Second rule only matched the TCP flows, and the ICMP flows stop at
+    // the first rule
+    AddTwoRuleAcl("acl4", 4, 1, 17);
+    EXPECT_EQ(count + 2, table->acl_resync_flow_count());
+
+    // First rule matched the ICMP flows, and the TCP flows no longer match
+    // any rule
+    AddTwoRuleAcl("acl4", 4, 6, 17);
+    EXPECT_EQ(count + 6, table->acl_resync_flow_count());
+
+    //cleanup
+    FlushFlowTable();
+    client->WaitForIdle();
+    EXPECT_EQ(0U, table->Size());
+    DelLink("virtual-network", "vn6", "access-control-list", "acl4");
+    FlowTeardown();
+    DelNode("access-control-list", "acl4");
+    client->WaitForIdle(5);
+}
+
 /* Create a Local flow for a VN which does not have any ACL attached.
  * Verify that network ACE UUID is set to IMPLICIT_ALLOW.
  * Port 'A' has IP 'X' and port 'B' has IP 'Y'
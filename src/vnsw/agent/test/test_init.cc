@@ -64,6 +64,11 @@ TestClient *TestInit(const char *init_file, bool ksync_init, bool pkt_init,
     param->set_agent_stats_interval(agent_stats_interval);
     param->set_flow_stats_interval(flow_stats_interval);
     param->set_vrouter_stats_interval(vrouter_stats_interval);
+    // Number of flow table partitions can be overridden for flow scale tests
+    if (getenv("AGENT_FLOW_THREAD_COUNT")) {
+        param->set_flow_thread_count
+            (strtoul(getenv("AGENT_FLOW_THREAD_COUNT"), NULL, 0));
+    }
 
     // Initialize the agent-init control class
     int introspect_port = 0;
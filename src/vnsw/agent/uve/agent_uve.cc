@@ -29,6 +29,8 @@ AgentUve::AgentUve(Agent *agent, uint64_t intvl)
                                  agent->params()->flow_stats_interval(),
                                  agent->params()->flow_cache_timeout(),
                                  this)) {
+      flow_stats_collector_->set_flow_export_batch_size
+          (agent->params()->flow_export_batch_size());
       //Override vm_uve_table_ to point to derived class object
       vn_uve_table_.reset(new VnUveTable(agent));
       vm_uve_table_.reset(new VmUveTable(agent));
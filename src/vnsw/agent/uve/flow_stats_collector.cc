@@ -40,6 +40,12 @@ FlowStatsCollector::FlowStatsCollector(boost::asio::io_service &io, int intvl,
             flow_age_time_intvl_ = FlowAgeTime;
         }
         flow_count_per_pass_ = FlowCountPerPass;
+        scan_mode_ = AUTO;
+        kernel_order_scan_ = false;
+        kernel_order_pos_ = 0;
+        kernel_order_sweep_ = 1;
+        flow_export_batch_size_ = 0;
+        flow_export_batch_level_ = SandeshLevel::INVALID;
         UpdateFlowMultiplier();
 }
 
@@ -47,6 +53,7 @@ FlowStatsCollector::~FlowStatsCollector() {
 }
 
 void FlowStatsCollector::Shutdown() {
+    FlushFlowExportBatch();
     StatsCollector::Shutdown();
 }
 
@@ -200,7 +207,58 @@ void FlowStatsCollector::FlowExport(FlowEntry *flow, uint64_t diff_bytes,
 
 void FlowStatsCollector::DispatchFlowMsg(SandeshLevel::type level,
                                          FlowDataIpv4 &flow) {
-    FLOW_DATA_IPV4_OBJECT_LOG("", level, flow);
+    if (flow_export_batch_size_ <= 1) {
+        FLOW_DATA_IPV4_OBJECT_LOG("", level, flow);
+        return;
+    }
+
+    std::vector<FlowDataIpv4> flows;
+    {
+        tbb::mutex::scoped_lock lock(flow_export_mutex_);
+        flow_export_batch_.push_back(flow);
+        // Send the batch at the level of its most severe record
+        if (flow_export_batch_level_ == SandeshLevel::INVALID ||
+            level < flow_export_batch_level_) {
+            flow_export_batch_level_ = level;
+        }
+        if (flow_export_batch_.size() < flow_export_batch_size_) {
+            return;
+        }
+        flows.swap(flow_export_batch_);
+        level = flow_export_batch_level_;
+        flow_export_batch_level_ = SandeshLevel::INVALID;
+    }
+    DispatchFlowBatch(level, flows);
+}
+
+void FlowStatsCollector::DispatchFlowBatch(SandeshLevel::type level,
+                                           std::vector<FlowDataIpv4> &flows) {
+    FLOW_DATA_IPV4_LIST_OBJECT_LOG("", level, flows);
+}
+
+void FlowStatsCollector::FlushFlowExportBatch() {
+    std::vector<FlowDataIpv4> flows;
+    SandeshLevel::type level;
+    {
+        tbb::mutex::scoped_lock lock(flow_export_mutex_);
+        if (flow_export_batch_.empty()) {
+            return;
+        }
+        flows.swap(flow_export_batch_);
+        level = flow_export_batch_level_;
+        flow_export_batch_level_ = SandeshLevel::INVALID;
+    }
+    DispatchFlowBatch(level, flows);
+}
+
+void FlowStatsCollector::set_flow_export_batch_size(uint32_t size) {
+    if (size > kMaxFlowExportBatchSize) {
+        size = kMaxFlowExportBatchSize;
+    }
+    flow_export_batch_size_ = size;
+    if (size <= 1) {
+        FlushFlowExportBatch();
+    }
 }
 
 bool FlowStatsCollector::ShouldBeAged(FlowStats *stats,
@@ -279,32 +337,89 @@ void FlowStatsCollector::UpdateFlowStats(FlowEntry *flow, uint64_t &diff_bytes,
     }
 }
 
-bool FlowStatsCollector::Run() {
-    FlowTable::FlowEntryMap::iterator it;
-    FlowEntry *entry = NULL, *reverse_flow;
-    FlowStats *stats = NULL;
+// Returns true if the flow and its reverse flow, if any, can be aged
+bool FlowStatsCollector::CanAgeFlow(FlowEntry *entry,
+                                    const vr_flow_entry *k_flow,
+                                    uint64_t curr_time) {
+    if (!ShouldBeAged(&(entry->stats_), k_flow, curr_time)) {
+        return false;
+    }
+
+    // If reverse_flow is present, wait till both are aged
+    FlowEntry *reverse_flow = entry->reverse_flow_entry();
+    if (reverse_flow) {
+        FlowTableKSyncObject *ksync_obj =
+            Agent::GetInstance()->ksync()->flowtable_ksync_obj();
+        const vr_flow_entry *k_flow_rev = ksync_obj->GetKernelFlowEntry
+            (reverse_flow->flow_handle(), false);
+        return ShouldBeAged(&(reverse_flow->stats_), k_flow_rev, curr_time);
+    }
+    return true;
+}
+
+// Update the stats of a flow from its kernel flow entry, and export the flow
+// if the stats changed or it was never exported
+void FlowStatsCollector::ProcessFlowStats(FlowEntry *entry,
+                                          const vr_flow_entry *k_flow,
+                                          uint64_t curr_time) {
+    FlowStats *stats = &(entry->stats_);
+    uint64_t k_bytes, bytes;
+    k_bytes = GetFlowStats(k_flow->fe_stats.flow_bytes_oflow,
+                           k_flow->fe_stats.flow_bytes);
+    bytes = 0x0000ffffffffffffULL & stats->bytes;
+    /* Always copy udp source port even though vrouter does not change
+     * it. Vrouter many change this behavior and recompute source port
+     * whenever flow action changes. To keep agent independent of this,
+     * always copy UDP source port */
+    entry->set_underlay_source_port(k_flow->fe_udp_src_port);
+    /* Don't account for agent overflow bits while comparing change in
+     * stats */
+    if (bytes != k_bytes) {
+        uint64_t packets, k_packets, diff_bytes, diff_pkts;
+
+        k_packets = GetFlowStats(k_flow->fe_stats.flow_packets_oflow,
+                                 k_flow->fe_stats.flow_packets);
+        bytes = GetUpdatedFlowBytes(stats, k_bytes);
+        packets = GetUpdatedFlowPackets(stats, k_packets);
+        diff_bytes = bytes - stats->bytes;
+        diff_pkts = packets - stats->packets;
+        //Update Inter-VN stats
+        VnUveTable *vn_table = static_cast<VnUveTable *>
+            (agent_uve_->vn_uve_table());
+        vn_table->UpdateInterVnStats(entry, diff_bytes, diff_pkts);
+        //Update Floating-IP stats
+        VmUveTable *vm_table = static_cast<VmUveTable *>
+            (agent_uve_->vm_uve_table());
+        vm_table->UpdateFloatingIpStats(entry, diff_bytes, diff_pkts);
+        stats->bytes = bytes;
+        stats->packets = packets;
+        stats->last_modified_time = curr_time;
+        FlowExport(entry, diff_bytes, diff_pkts);
+    } else if (!stats->exported && !entry->deleted()) {
+        /* export flow (reverse) for which traffic is not seen yet. */
+        FlowExport(entry, 0, 0);
+    }
+}
+
+// Iterate the flows in FlowTable order starting from flow_iteration_key_.
+// Returns number of flows visited
+uint32_t FlowStatsCollector::RunKeyOrder(uint64_t curr_time) {
+    FlowEntry *entry = NULL, *next, *reverse_flow;
     uint32_t count = 0;
     bool key_updation_reqd = true, deleted;
-    uint64_t diff_bytes, diff_pkts;
     FlowTable *flow_obj = Agent::GetInstance()->pkt()->flow_table();
 
-    run_counter_++;
-    if (!flow_obj->Size()) {
-        return true;
-    }
-    uint64_t curr_time = UTCTimestampUsec();
-    it = flow_obj->flow_entry_map_.upper_bound(flow_iteration_key_);
-    if (it == flow_obj->flow_entry_map_.end()) {
-        it = flow_obj->flow_entry_map_.begin();
+    next = flow_obj->GetNext(flow_iteration_key_);
+    if (next == NULL) {
+        flow_iteration_key_.Reset();
+        next = flow_obj->GetNext(flow_iteration_key_);
     }
     FlowTableKSyncObject *ksync_obj =
         Agent::GetInstance()->ksync()->flowtable_ksync_obj();
 
-    while (it != flow_obj->flow_entry_map_.end()) {
-        entry = it->second;
-        stats = &(entry->stats_);
-        it++;
-        assert(entry);
+    while (next != NULL) {
+        entry = next;
+        next = flow_obj->GetNext(entry->key());
         deleted = false;
 
         if (entry->deleted()) {
@@ -316,26 +431,13 @@ bool FlowStatsCollector::Run() {
             (entry->flow_handle(), false);
         reverse_flow = entry->reverse_flow_entry();
         // Can the flow be aged?
-        if (ShouldBeAged(stats, k_flow, curr_time)) {
-            // If reverse_flow is present, wait till both are aged
-            if (reverse_flow) {
-                const vr_flow_entry *k_flow_rev;
-                k_flow_rev = ksync_obj->GetKernelFlowEntry
-                    (reverse_flow->flow_handle(), false);
-                if (ShouldBeAged(&(reverse_flow->stats_), k_flow_rev,
-                                 curr_time)) {
-                    deleted = true;
-                }
-            } else {
-                deleted = true;
-            }
+        if (CanAgeFlow(entry, k_flow, curr_time)) {
+            deleted = true;
         }
 
         if (deleted == true) {
-            if (it != flow_obj->flow_entry_map_.end()) {
-                if (it->second == reverse_flow) {
-                    it++;
-                }
+            if (next != NULL && next == reverse_flow) {
+                next = flow_obj->GetNext(next->key());
             }
             Agent::GetInstance()->pkt()->flow_table()->Delete
                 (entry->key(), reverse_flow != NULL? true : false);
@@ -349,49 +451,12 @@ bool FlowStatsCollector::Run() {
         }
 
         if (deleted == false && k_flow) {
-            uint64_t k_bytes, bytes;
-            k_bytes = GetFlowStats(k_flow->fe_stats.flow_bytes_oflow,
-                                   k_flow->fe_stats.flow_bytes);
-            bytes = 0x0000ffffffffffffULL & stats->bytes;
-            /* Always copy udp source port even though vrouter does not change
-             * it. Vrouter many change this behavior and recompute source port
-             * whenever flow action changes. To keep agent independent of this,
-             * always copy UDP source port */
-            entry->set_underlay_source_port(k_flow->fe_udp_src_port);
-            /* Don't account for agent overflow bits while comparing change in
-             * stats */
-            if (bytes != k_bytes) {
-                uint64_t packets, k_packets;
-
-                k_packets = GetFlowStats(k_flow->fe_stats.flow_packets_oflow,
-                                         k_flow->fe_stats.flow_packets);
-                bytes = GetUpdatedFlowBytes(stats, k_bytes);
-                packets = GetUpdatedFlowPackets(stats, k_packets);
-                diff_bytes = bytes - stats->bytes;
-                diff_pkts = packets - stats->packets;
-                //Update Inter-VN stats
-                VnUveTable *vn_table = static_cast<VnUveTable *>
-                    (agent_uve_->vn_uve_table());
-                vn_table->UpdateInterVnStats(entry, diff_bytes, diff_pkts);
-                //Update Floating-IP stats
-                VmUveTable *vm_table = static_cast<VmUveTable *>
-                    (agent_uve_->vm_uve_table());
-                vm_table->UpdateFloatingIpStats(entry, diff_bytes, diff_pkts);
-                stats->bytes = bytes;
-                stats->packets = packets;
-                stats->last_modified_time = curr_time;
-                FlowExport(entry, diff_bytes, diff_pkts);
-            } else if (!stats->exported && !entry->deleted()) {
-                /* export flow (reverse) for which traffic is not seen yet. */
-                FlowExport(entry, 0, 0);
-            }
+            ProcessFlowStats(entry, k_flow, curr_time);
         }
 
         if ((!deleted) && entry->is_flags_set(FlowEntry::ShortFlow)) {
-            if (it != flow_obj->flow_entry_map_.end()) {
-                if (it->second == reverse_flow) {
-                    it++;
-                }
+            if (next != NULL && next == reverse_flow) {
+                next = flow_obj->GetNext(next->key());
             }
             Agent::GetInstance()->pkt()->flow_table()->Delete
                 (entry->key(), true);
@@ -411,7 +476,7 @@ bool FlowStatsCollector::Run() {
     }
 
     if (count == flow_count_per_pass_) {
-        if (it != flow_obj->flow_entry_map_.end()) {
+        if (next != NULL) {
             key_updation_reqd = false;
         }
     }
@@ -420,6 +485,172 @@ bool FlowStatsCollector::Run() {
     if (key_updation_reqd) {
         flow_iteration_key_.Reset();
     }
+    return count;
+}
+
+// Age or update the stats of a flow visited in kernel order. Returns number
+// of flows visited, including the reverse flow when it is deleted too
+uint32_t FlowStatsCollector::ProcessKernelOrderFlow(FlowEntry *entry,
+                                                    const vr_flow_entry *k_flow,
+                                                    uint64_t curr_time) {
+    FlowTable *flow_obj = Agent::GetInstance()->pkt()->flow_table();
+    FlowEntry *reverse_flow = entry->reverse_flow_entry();
+    if (CanAgeFlow(entry, k_flow, curr_time)) {
+        flow_obj->Delete(entry->key(), reverse_flow != NULL? true : false);
+        return reverse_flow ? 2 : 1;
+    }
+
+    if (k_flow) {
+        ProcessFlowStats(entry, k_flow, curr_time);
+    }
+
+    if (entry->is_flags_set(FlowEntry::ShortFlow)) {
+        flow_obj->Delete(entry->key(), true);
+        if (reverse_flow) {
+            return 2;
+        }
+    }
+    return 1;
+}
+
+// Sweep the kernel flow table linearly by flow handle from
+// kernel_order_pos_, prefetching kernel flow entries kKernelOrderPrefetch
+// ahead. Each active entry is mapped back to its FlowEntry by the flow key
+// in the kernel entry, and flows visited are marked with
+// kernel_order_sweep_. Past the end of the kernel flow table, the sweep
+// continues with RunKernelOrderUnmapped. Returns number of flows visited
+uint32_t FlowStatsCollector::RunKernelOrder(uint64_t curr_time) {
+    FlowTableKSyncObject *ksync_obj =
+        Agent::GetInstance()->ksync()->flowtable_ksync_obj();
+    FlowTable *flow_obj = Agent::GetInstance()->pkt()->flow_table();
+    uint32_t kflow_count = ksync_obj->flow_table_entries_count();
+
+    if (kernel_order_pos_ >= kflow_count) {
+        return RunKernelOrderUnmapped(curr_time);
+    }
+
+    // Limit the slots examined in a pass so that the sweep takes as many
+    // passes as a key order sweep, however sparse the kernel flow table is
+    uint64_t max_slots = flow_count_per_pass_;
+    uint64_t total_flows = flow_obj->Size();
+    if (total_flows) {
+        max_slots = std::max(max_slots, ((uint64_t)flow_count_per_pass_ *
+                                         kflow_count) / total_flows);
+    }
+    uint32_t end = std::min((uint64_t)kflow_count,
+                            kernel_order_pos_ + max_slots);
+
+    uint32_t count = 0;
+    FlowKey key;
+    while (kernel_order_pos_ < end && count < flow_count_per_pass_) {
+        uint32_t pos = kernel_order_pos_++;
+        if (pos + kKernelOrderPrefetch < kflow_count) {
+            __builtin_prefetch(ksync_obj->GetKernelFlowEntry
+                               (pos + kKernelOrderPrefetch, true));
+        }
+
+        if (!ksync_obj->GetFlowKey(pos, &key)) {
+            continue;
+        }
+        key.family = Address::INET;
+        FlowEntry *entry = flow_obj->Find(key);
+        // Skip kernel entries whose flow is gone or has moved to another
+        // handle, the flow is then visited at its own handle or as unmapped
+        if (entry == NULL || entry->deleted() || entry->flow_handle() != pos) {
+            continue;
+        }
+
+        entry->stats_.kernel_order_sweep = kernel_order_sweep_;
+        count += ProcessKernelOrderFlow
+            (entry, ksync_obj->GetKernelFlowEntry(pos, false), curr_time);
+    }
+    return count;
+}
+
+// Visit, in key order from flow_iteration_key_, the flows not marked as
+// visited by the kernel order part of the sweep. These are the flows
+// without an active kernel flow entry, which are aged based on time alone,
+// and the flows added during the sweep. Ends the sweep once all the flows
+// are visited. Returns number of flows visited
+uint32_t FlowStatsCollector::RunKernelOrderUnmapped(uint64_t curr_time) {
+    FlowTableKSyncObject *ksync_obj =
+        Agent::GetInstance()->ksync()->flowtable_ksync_obj();
+    FlowTable *flow_obj = Agent::GetInstance()->pkt()->flow_table();
+
+    // Flows already visited are only skipped, so more of them are examined
+    // in a pass than the flows processed
+    uint32_t max_examined = flow_count_per_pass_ * kKernelOrderSkipFactor;
+    uint32_t count = 0, examined = 0;
+    FlowEntry *entry = flow_obj->GetNext(flow_iteration_key_);
+    while (entry != NULL && count < flow_count_per_pass_ &&
+           examined < max_examined) {
+        // The next flow is looked up from the key, as processing the flow
+        // may delete its reverse flow too
+        flow_iteration_key_ = entry->key();
+        examined++;
+        if (!entry->deleted() &&
+            entry->stats_.kernel_order_sweep != kernel_order_sweep_) {
+            const vr_flow_entry *k_flow = ksync_obj->GetKernelFlowEntry
+                (entry->flow_handle(), false);
+            count += ProcessKernelOrderFlow(entry, k_flow, curr_time);
+        }
+        entry = flow_obj->GetNext(flow_iteration_key_);
+    }
+
+    if (entry == NULL) {
+        flow_iteration_key_.Reset();
+        ResetKernelOrderScan();
+    }
+    return count;
+}
+
+// Start a new kernel order sweep. Flows marked by the previous sweep are
+// no longer taken as visited
+void FlowStatsCollector::ResetKernelOrderScan() {
+    kernel_order_pos_ = 0;
+    kernel_order_sweep_++;
+}
+
+// Select the scan order at the start of a sweep
+bool FlowStatsCollector::UseKernelOrder(uint32_t total_flows) {
+    if (scan_mode_ == KEY_ORDER) {
+        return false;
+    }
+    if (scan_mode_ == KERNEL_ORDER) {
+        return true;
+    }
+    return (total_flows >= kKernelOrderMinFlows);
+}
+
+bool FlowStatsCollector::Run() {
+    FlowTable *flow_obj = Agent::GetInstance()->pkt()->flow_table();
+
+    run_counter_++;
+    if (!flow_obj->Size()) {
+        // Start a new sweep once flows are added again
+        if (kernel_order_pos_ != 0 ||
+            flow_iteration_key_.family != Address::UNSPEC) {
+            flow_iteration_key_.Reset();
+            ResetKernelOrderScan();
+        }
+        FlushFlowExportBatch();
+        return true;
+    }
+    uint64_t curr_time = UTCTimestampUsec();
+
+    // Switch scan order only between sweeps
+    if (kernel_order_pos_ == 0 &&
+        flow_iteration_key_.family == Address::UNSPEC) {
+        kernel_order_scan_ = UseKernelOrder(flow_obj->Size());
+    }
+
+    if (kernel_order_scan_) {
+        RunKernelOrder(curr_time);
+    } else {
+        RunKeyOrder(curr_time);
+    }
+    FlushFlowExportBatch();
+
     /* Update the flow_timer_interval and flow_count_per_pass_ based on
      * total flows that we have
      */
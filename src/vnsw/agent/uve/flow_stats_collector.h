@@ -5,6 +5,8 @@
 #ifndef vnsw_agent_flow_stats_collector_h
 #define vnsw_agent_flow_stats_collector_h
 
+#include <vector>
+#include <tbb/mutex.h>
 #include <sandesh/common/flow_types.h>
 #include <cmn/agent_cmn.h>
 #include <uve/stats_collector.h>
@@ -16,12 +18,32 @@
 //collector. Also responsible for aging of flow entries. Runs in the context
 //of "Agent::StatsCollector" which has exclusion with "db::DBTable",
 //"Agent::FlowHandler", "sandesh::RecvQueue", "bgp::Config" & "Agent::KSync"
+//
+//Flows are visited either in FlowTable order, or in kernel flow table order
+//by flow handle. The latter reads the shared memory sequentially and is
+//used by default for large flow tables. A kernel order sweep then visits
+//in FlowTable order the flows it did not find in the kernel flow table.
 class FlowStatsCollector : public StatsCollector {
 public:
     static const uint64_t FlowAgeTime = 1000000 * 180;
     static const uint32_t FlowCountPerPass = 200;
     static const uint32_t FlowStatsMinInterval = (100); // time in milliseconds
     static const uint32_t MaxFlows= (256 * 1024); // time in milliseconds
+    // Flow count from which AUTO mode scans in kernel order
+    static const uint32_t kKernelOrderMinFlows = (16 * 1024);
+    // Kernel flow entries prefetched ahead of the one being processed
+    static const uint32_t kKernelOrderPrefetch = 8;
+    // Flows examined per flow processed when visiting the flows not found
+    // in the kernel flow table
+    static const uint32_t kKernelOrderSkipFactor = 8;
+    // Max flow records sent in one FlowDataIpv4ListObject
+    static const uint32_t kMaxFlowExportBatchSize = 1024;
+
+    enum ScanMode {
+        KEY_ORDER,
+        KERNEL_ORDER,
+        AUTO
+    };
 
     FlowStatsCollector(boost::asio::io_service &io, int intvl,
                        uint32_t flow_cache_timeout,
@@ -41,6 +63,19 @@ public:
     void UpdateFlowAgeTimeInSecs(uint32_t secs) {
         UpdateFlowAgeTime(secs * 1000 * 1000);
     }
+    // Flow records are sent in batches of upto size records when size is
+    // more than 1. A batch is sent when full, and at the end of every run
+    // of the collector, which bounds the latency to the run interval
+    void set_flow_export_batch_size(uint32_t size);
+    uint32_t flow_export_batch_size() const { return flow_export_batch_size_; }
+    void FlushFlowExportBatch();
+    virtual void DispatchFlowBatch(SandeshLevel::type level,
+                                   std::vector<FlowDataIpv4> &flows);
+
+    // Takes effect from the next sweep of the flows
+    void set_scan_mode(ScanMode mode) { scan_mode_ = mode; }
+    ScanMode scan_mode() const { return scan_mode_; }
+    bool kernel_order_scan() const { return kernel_order_scan_; }
 
     void FlowExport(FlowEntry *flow, uint64_t diff_bytes,
                     uint64_t diff_pkts);
@@ -52,6 +87,18 @@ private:
     uint64_t GetFlowStats(const uint16_t &oflow_data, const uint32_t &data);
     bool ShouldBeAged(FlowStats *stats, const vr_flow_entry *k_flow,
                       uint64_t curr_time);
+    bool CanAgeFlow(FlowEntry *entry, const vr_flow_entry *k_flow,
+                    uint64_t curr_time);
+    void ProcessFlowStats(FlowEntry *entry, const vr_flow_entry *k_flow,
+                          uint64_t curr_time);
+    uint32_t RunKeyOrder(uint64_t curr_time);
+    uint32_t ProcessKernelOrderFlow(FlowEntry *entry,
+                                    const vr_flow_entry *k_flow,
+                                    uint64_t curr_time);
+    uint32_t RunKernelOrder(uint64_t curr_time);
+    uint32_t RunKernelOrderUnmapped(uint64_t curr_time);
+    void ResetKernelOrderScan();
+    bool UseKernelOrder(uint32_t total_flows);
     void SourceIpOverride(FlowEntry *flow, FlowDataIpv4 &s_flow);
     void SetUnderlayInfo(FlowEntry *flow, FlowDataIpv4 &s_flow);
     uint64_t GetUpdatedFlowPackets(const FlowStats *stats, uint64_t k_flow_pkts);
@@ -62,6 +109,17 @@ private:
     uint32_t flow_count_per_pass_;
     uint32_t flow_multiplier_;
     uint32_t flow_default_interval_;
+    ScanMode scan_mode_;
+    bool kernel_order_scan_;
+    // Next flow handle of the current kernel order sweep
+    uint32_t kernel_order_pos_;
+    // Marks the flows visited in kernel order by the current sweep
+    uint32_t kernel_order_sweep_;
+    // Flows are exported from flow tasks too, hence the mutex
+    tbb::mutex flow_export_mutex_;
+    uint32_t flow_export_batch_size_;
+    SandeshLevel::type flow_export_batch_level_;
+    std::vector<FlowDataIpv4> flow_export_batch_;
     DISALLOW_COPY_AND_ASSIGN(FlowStatsCollector);
 };
 
@@ -26,7 +26,8 @@
 FlowStatsCollectorTest::FlowStatsCollectorTest(boost::asio::io_service &io, int intvl,
                                            uint32_t flow_cache_timeout,
                                            AgentUveBase *uve) :
-    FlowStatsCollector(io, intvl, flow_cache_timeout, uve) {
+    FlowStatsCollector(io, intvl, flow_cache_timeout, uve),
+    flow_batch_count_(0), flow_batch_records_(0) {
 }
 
 FlowStatsCollectorTest::~FlowStatsCollectorTest() { 
@@ -35,6 +36,20 @@ FlowStatsCollectorTest::~FlowStatsCollectorTest() {
 void FlowStatsCollectorTest::DispatchFlowMsg(SandeshLevel::type level,
                                              FlowDataIpv4 &flow) {
     flow_log_ = flow;
+    if (flow_export_batch_size() > 1) {
+        FlowStatsCollector::DispatchFlowMsg(level, flow);
+    }
+}
+
+void FlowStatsCollectorTest::DispatchFlowBatch(SandeshLevel::type level,
+                                        std::vector<FlowDataIpv4> &flows) {
+    flow_batch_count_++;
+    flow_batch_records_ += flows.size();
+}
+
+void FlowStatsCollectorTest::ClearFlowBatchCount() {
+    flow_batch_count_ = 0;
+    flow_batch_records_ = 0;
 }
 
 FlowDataIpv4 FlowStatsCollectorTest::last_sent_flow_log() const {
@@ -15,8 +15,15 @@ public:
                            AgentUveBase *uve);
     virtual ~FlowStatsCollectorTest();
     void DispatchFlowMsg(SandeshLevel::type level, FlowDataIpv4 &flow);
+    void DispatchFlowBatch(SandeshLevel::type level,
+                           std::vector<FlowDataIpv4> &flows);
     FlowDataIpv4 last_sent_flow_log() const;
+    uint32_t flow_batch_count() const { return flow_batch_count_; }
+    uint32_t flow_batch_records() const { return flow_batch_records_; }
+    void ClearFlowBatchCount();
 private:
     FlowDataIpv4 flow_log_;
+    uint32_t flow_batch_count_;
+    uint32_t flow_batch_records_;
 };
 #endif //vnsw_agent_flow_stats_collector_test_h
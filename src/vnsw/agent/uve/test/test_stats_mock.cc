@@ -457,6 +457,98 @@ TEST_F(StatsTestMock, FlowStatsOverflow_AgeTest) {
     f_uve->flow_stats_collector()->UpdateFlowAgeTime(bkp_age_time);
 }
 
+TEST_F(StatsTestMock, FlowStatsKernelOrderTest) {
+    AgentUveBase *uve = Agent::GetInstance()->uve();
+    AgentUve *f_uve = static_cast<AgentUve *>(uve);
+    FlowStatsCollector *collector = f_uve->flow_stats_collector();
+    collector->set_scan_mode(FlowStatsCollector::KERNEL_ORDER);
+
+    hash_id = 1;
+    //Flow creation using TCP packet
+    TxTcpPacketUtil(flow0->id(), "1.1.1.1", "1.1.1.2",
+                    1000, 200, hash_id);
+    client->WaitForIdle(10);
+    EXPECT_TRUE(FlowGet("vrf5", "1.1.1.1", "1.1.1.2", 6, 1000, 200, false,
+                        "vn5", "vn5", hash_id++, flow0->flow_key_nh()->id()));
+    VrfEntry *vrf = Agent::GetInstance()->vrf_table()->FindVrfFromName("vrf5");
+    EXPECT_TRUE(vrf != NULL);
+    FlowEntry *f1 = FlowGet(vrf->vrf_id(), "1.1.1.1", "1.1.1.2", 6, 1000, 200,
+                            flow0->flow_key_nh()->id());
+    EXPECT_TRUE(f1 != NULL);
+    FlowEntry *f1_rev = f1->reverse_flow_entry();
+    EXPECT_TRUE(f1_rev != NULL);
+
+    //Create flow in reverse direction and make sure it is linked to previous flow
+    TxTcpPacketUtil(flow1->id(), "1.1.1.2", "1.1.1.1", 200, 1000,
+                    f1_rev->flow_handle());
+    client->WaitForIdle(10);
+    EXPECT_EQ(2U, Agent::GetInstance()->pkt()->flow_table()->Size());
+
+    //Change the stats and invoke FlowStatsCollector to update the stats
+    KSyncSockTypeMap::IncrFlowStats(1, 1, 30);
+    KSyncSockTypeMap::IncrFlowStats(f1_rev->flow_handle(), 2, 60);
+    util_.EnqueueFlowStatsCollectorTask();
+    client->WaitForIdle(10);
+    EXPECT_TRUE(collector->kernel_order_scan());
+
+    //Verify flow stats
+    EXPECT_TRUE(FlowStatsMatch("vrf5", "1.1.1.1", "1.1.1.2", 6, 1000, 200, 1, 30,
+                               flow0->flow_key_nh()->id()));
+    EXPECT_TRUE(FlowStatsMatch("vrf5", "1.1.1.2", "1.1.1.1", 6, 200, 1000, 2, 60,
+                               flow1->flow_key_nh()->id()));
+
+    //Deactivate the kernel flow entries. The flows are then only visited
+    //after the kernel flow table in a sweep, and aged based on time alone
+    KSyncSockTypeMap::GetFlowEntry(f1->flow_handle())->fe_flags &=
+        ~VR_FLOW_FLAG_ACTIVE;
+    KSyncSockTypeMap::GetFlowEntry(f1_rev->flow_handle())->fe_flags &=
+        ~VR_FLOW_FLAG_ACTIVE;
+
+    //Set the flow age time to 1000 microsecond and verify flows are aged
+    int tmp_age_time = 1000 * 1000;
+    int bkp_age_time = collector->flow_age_time_intvl();
+    collector->UpdateFlowAgeTime(tmp_age_time);
+    usleep(tmp_age_time + 10);
+    client->EnqueueFlowAge();
+    client->WaitForIdle();
+    WAIT_FOR(100, 10000, (Agent::GetInstance()->pkt()->flow_table()->Size() == 0U));
+
+    //Restore flow aging time and scan mode
+    collector->UpdateFlowAgeTime(bkp_age_time);
+    collector->set_scan_mode(FlowStatsCollector::AUTO);
+}
+
+TEST_F(StatsTestMock, FlowExportBatchTest) {
+    AgentUveBase *uve = Agent::GetInstance()->uve();
+    AgentUve *f_uve = static_cast<AgentUve *>(uve);
+    FlowStatsCollectorTest *f = static_cast<FlowStatsCollectorTest *>
+        (f_uve->flow_stats_collector());
+    f->ClearFlowBatchCount();
+    f->set_flow_export_batch_size(2);
+
+    FlowDataIpv4 flow;
+    flow.set_flowuuid("555788e0-513c-4351-8711-3fc481cf2eb4");
+    f->DispatchFlowMsg(SandeshLevel::SYS_INFO, flow);
+    f->DispatchFlowMsg(SandeshLevel::SYS_INFO, flow);
+    //Batch is sent once full
+    EXPECT_EQ(1U, f->flow_batch_count());
+    EXPECT_EQ(2U, f->flow_batch_records());
+
+    //Partial batch is sent on the next run of the collector
+    f->DispatchFlowMsg(SandeshLevel::SYS_INFO, flow);
+    EXPECT_EQ(1U, f->flow_batch_count());
+    util_.EnqueueFlowStatsCollectorTask();
+    client->WaitForIdle(10);
+    EXPECT_EQ(2U, f->flow_batch_count());
+    EXPECT_EQ(3U, f->flow_batch_records());
+
+    //No batches once batching is disabled
+    f->set_flow_export_batch_size(0);
+    f->DispatchFlowMsg(SandeshLevel::SYS_INFO, flow);
+    EXPECT_EQ(2U, f->flow_batch_count());
+    f->ClearFlowBatchCount();
+}
+
 TEST_F(StatsTestMock, DeletedFlowStatsTest) {
     hash_id = 1;
     //Flow creation using IP packet
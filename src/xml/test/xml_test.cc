@@ -7,6 +7,7 @@
 //  Test code for xml_base.h implementation
 
 #include "xml/xml_base.h"
+#include "xml/xml_pugi.h"
 #include <fstream>
 #include <sstream>
 #include <boost/algorithm/string/erase.hpp>
@@ -219,6 +220,78 @@ TEST_F (XmlBaseTest, XmlAppendDoc) {
     ASSERT_STREQ(result.c_str(), encode.c_str());
 };
 
+TEST_F (XmlBaseTest, XmlFindItems) {
+    XmlPugi *pugi = static_cast<XmlPugi *>(doc_);
+
+    // Message event, as sent by the control node to the agent
+    string msg1 = "<message from=\"network-control@contrailsystems.com\" to=\"agent\"><event xmlns=\"http://jabber.org/protocol/pubsub\"><items node=\"1/1/vrf1\"><item id=\"10.1.1.1/32\"><entry><nlri><address>10.1.1.1/32</address></nlri></entry></item><retract id=\"10.1.1.2/32\" /><item id=\"10.1.1.3/32\"><entry><nlri><address>10.1.1.3/32</address></nlri></entry></item><retract id=\"10.1.1.4/32\" /></items></event></message>";
+    doc_->LoadDoc(msg1);
+
+    pugi::xml_node items = pugi->FindItems();
+    EXPECT_STREQ("items", items.name());
+    EXPECT_STREQ("1/1/vrf1", items.attribute("node").value());
+    EXPECT_TRUE(items == pugi->FindNode("items"));
+
+    pugi::xml_node node = pugi->FindItem();
+    EXPECT_TRUE(node == pugi->FindNode("item"));
+    EXPECT_STREQ("10.1.1.1/32", node.attribute("id").value());
+    node = XmlPugi::NextItem(node);
+    EXPECT_STREQ("10.1.1.3/32", node.attribute("id").value());
+    node = XmlPugi::NextItem(node);
+    EXPECT_TRUE(pugi->IsNull(node));
+
+    node = pugi->FindRetract();
+    EXPECT_TRUE(node == pugi->FindNode(string("retract")));
+    EXPECT_STREQ("10.1.1.2/32", node.attribute("id").value());
+    node = XmlPugi::NextRetract(node);
+    EXPECT_STREQ("10.1.1.4/32", node.attribute("id").value());
+    node = XmlPugi::NextRetract(node);
+    EXPECT_TRUE(pugi->IsNull(node));
+
+    // Publish iq, as sent by the agent to the control node
+    string msg2 = "<iq type=\"set\" from=\"agent\" to=\"network-control@contrailsystems.com/bgp-peer\" id=\"pubsub1\"><pubsub xmlns=\"http://jabber.org/protocol/pubsub\"><publish node=\"1/1/vrf1/10.1.1.1\"><item><entry><nlri><address>10.1.1.1/32</address></nlri></entry></item></publish></pubsub></iq>";
+    doc_->LoadDoc(msg2);
+
+    items = pugi->FindItems();
+    EXPECT_STREQ("publish", items.name());
+    node = pugi->FindItem();
+    EXPECT_TRUE(node == pugi->FindNode("item"));
+    EXPECT_STREQ("entry", node.first_child().name());
+    EXPECT_TRUE(!XmlPugi::NextItem(node));
+    node = pugi->FindRetract();
+    EXPECT_TRUE(pugi->IsNull(node));
+
+    // Any other layout falls back to a search of the document
+    string msg3 = "<iq type=\"set\"><config><items><item id=\"1\" /></items></config></iq>";
+    doc_->LoadDoc(msg3);
+
+    EXPECT_TRUE(pugi->FindItems() == pugi->FindNode("items"));
+    EXPECT_STREQ("1", pugi->FindItem().attribute("id").value());
+    EXPECT_TRUE(!pugi->FindRetract());
+};
+
+TEST_F (XmlBaseTest, XmlLoadDocInPlace) {
+    // Stanza followed by the start of the next one, as in a framing buffer
+    string msg = "<message from=\"network-control@contrailsystems.com\" to=\"agent\"><event><items node=\"1/1/vrf1\"><item id=\"10.1.1.1/32\" /></items></event></message>";
+    string buf = msg + "<message from=";
+    EXPECT_EQ(0, doc_->LoadDocInPlace(buf.data(), msg.size()));
+
+    // The buffer is left unmodified and the document does not refer to it
+    EXPECT_EQ(msg + "<message from=", buf);
+    buf.assign(buf.size(), 'x');
+    doc_->ReadNode("message");
+    EXPECT_STREQ("agent", doc_->ReadAttrib("to"));
+    XmlPugi *pugi = static_cast<XmlPugi *>(doc_);
+    EXPECT_STREQ("10.1.1.1/32", pugi->FindItem().attribute("id").value());
+
+    // Reloading replaces the document, a bad stanza fails
+    string iq = "<iq type=\"set\" id=\"pubsub1\" />";
+    EXPECT_EQ(0, doc_->LoadDocInPlace(iq.data(), iq.size()));
+    doc_->ReadNode("iq");
+    EXPECT_STREQ("pubsub1", doc_->ReadAttrib("id"));
+    EXPECT_EQ(-1, doc_->LoadDocInPlace(msg.data(), msg.size() - 1));
+};
+
 } // namespace
 int main(int argc, char **argv) {
     LoggingInit();
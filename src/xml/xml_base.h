@@ -13,6 +13,9 @@ public:
     // Set new xml doc. Null string means reset to new doc. 
     // Resets previous doc
     virtual int LoadDoc(const std::string &doc) = 0;
+    // Same as LoadDoc for the size bytes at data. The doc parses in place
+    // a copy of the bytes that it owns, data is left unmodified.
+    virtual int LoadDocInPlace(const char *data, size_t size) = 0;
 
     // returns bytes encoded. -1 for error.
     virtual int WriteDoc(uint8_t *buf)= 0;
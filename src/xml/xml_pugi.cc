@@ -2,6 +2,7 @@
  * Copyright (c) 2013 Juniper Networks, Inc. All rights reserved.
  */
 
+#include <cstring>
 #include <boost/algorithm/string/replace.hpp>
 #include "xml/xml_base.h"
 #include "xml/xml_pugi.h"
@@ -55,6 +56,41 @@ pugi::xml_node XmlPugi::FindNode(const std::string &name) {
     return node;
 }
 
+pugi::xml_node XmlPugi::FindNode(const char *name) {
+    PugiNamePredicate p1(name);
+
+    pugi::xml_node node = doc_.find_node(p1);
+    return node;
+}
+
+pugi::xml_node XmlPugi::FindItems() {
+    pugi::xml_node root = doc_.first_child();
+    pugi::xml_node node = root.child("event").child("items");
+    if (IsNull(node)) {
+        node = root.child("pubsub").child("publish");
+    }
+    if (IsNull(node)) {
+        node = FindNode("items");
+    }
+    return node;
+}
+
+pugi::xml_node XmlPugi::FindItem() {
+    pugi::xml_node items = FindItems();
+    if (IsNull(items)) {
+        return FindNode("item");
+    }
+    return items.child("item");
+}
+
+pugi::xml_node XmlPugi::FindRetract() {
+    pugi::xml_node items = FindItems();
+    if (IsNull(items)) {
+        return FindNode("retract");
+    }
+    return items.child("retract");
+}
+
 const char *XmlPugi::ReadNodeName(const std::string &name) {
     PugiPredicate p1(name);
 
@@ -186,6 +222,31 @@ int XmlPugi::LoadDoc(const std::string &document) {
     return 0;
 }
 
+// The copy is made into a block from the pugixml allocator and handed to
+// the document, which frees it on reset or destruction. The parse does not
+// copy the buffer again and the node names and values point into it.
+int XmlPugi::LoadDocInPlace(const char *data, size_t size) {
+    RewindDoc();
+    doc_.reset();
+
+    void *buffer = pugi::get_memory_allocation_function()(size);
+    if (buffer == NULL) {
+        return -1;
+    }
+    memcpy(buffer, data, size);
+    pugi::xml_parse_result ret = doc_.load_buffer_inplace_own(buffer, size,
+                                                 pugi::parse_default,
+                                                 pugi::encoding_utf8);
+    if (ret == false) {
+        LOG(DEBUG, "XML doc load failed, code: " << ret << " " << ret.description());
+        LOG(DEBUG, "Error offset: " << ret.offset << " (error at [..." <<
+            std::string(data + ret.offset, data + size) << "]");
+        LOG(DEBUG, "Document: " << std::string(data, size));
+        return -1;
+    }
+    return 0;
+}
+
 void XmlPugi::RewindDoc() {
     SetContext();
 }
@@ -11,6 +11,7 @@ class XmlPugi : public XmlBase {
 public:
 
     virtual int LoadDoc(const std::string &doc);
+    virtual int LoadDocInPlace(const char *data, size_t size);
     virtual int WriteDoc(uint8_t *buf);
     virtual int WriteRawDoc(uint8_t *buf);
     virtual void PrintDoc(std::ostream& os) const;
@@ -48,6 +49,23 @@ public:
 
     pugi::xml_node RootNode();
     pugi::xml_node FindNode(const std::string &name);
+    pugi::xml_node FindNode(const char *name);
+
+    // Typed accessors for the pubsub payload of a received stanza, the
+    // <items> element of a message event or the <publish> element of an
+    // iq, and its <item> and <retract> children. Only the path from the
+    // root element to the payload and the children of the payload are
+    // walked, instead of the whole document. Documents of any other layout
+    // fall back to FindNode().
+    pugi::xml_node FindItems();
+    pugi::xml_node FindItem();
+    pugi::xml_node FindRetract();
+    static pugi::xml_node NextItem(pugi::xml_node node) {
+        return node.next_sibling("item");
+    }
+    static pugi::xml_node NextRetract(pugi::xml_node node) {
+        return node.next_sibling("retract");
+    }
 
     XmlPugi();
     virtual ~XmlPugi();
@@ -87,6 +105,15 @@ private:
         std::string tmp_;
     };
 
+    // Same as PugiPredicate without a copy of the name
+    struct PugiNamePredicate {
+        bool operator()(pugi::xml_node node) const {
+            return (strcmp(node.name(), name_) == 0);
+        }
+        explicit PugiNamePredicate(const char *name) : name_(name) { }
+        const char *name_;
+    };
+
     static pugi::xml_attribute GAttr;
     static pugi::xml_node GNode;
     void SetContext(pugi::xml_node node = GNode, 
@@ -54,10 +54,11 @@ class XmppMockConnection : public XmppClientConnection {
 public:
     XmppMockConnection(XmppClient *server, const XmppChannelConfig *config)
         : XmppClientConnection(server, config), byte_count(0), msg_count(0) {}
-    virtual void ReceiveMsg(XmppSession *session, const string &str) {
-        byte_count += str.size();
+    virtual void ReceiveMsg(XmppSession *session, const char *data,
+                            size_t size) {
+        byte_count += size;
         msg_count++;
-        XmppConnection::ReceiveMsg(session, str);
+        XmppConnection::ReceiveMsg(session, data, size);
     }
     virtual bool IsClient() const { return true; }
     void ResetStats() {
@@ -4,7 +4,25 @@
 
 #include "xmpp/xmpp_channel.h"
 
+#include <vector>
+
+#include "io/tcp_message_buffer.h"
+
 using std::string;
+using std::vector;
+
+bool XmppChannel::SendParts(const uint8_t *header, size_t header_size,
+                            TcpMessageBuffer *body,
+                            xmps::PeerId id, SendReadyCb cb, size_t *copied) {
+    if (body == NULL) {
+        *copied = 0;
+        return Send(header, header_size, id, cb);
+    }
+    vector<uint8_t> msg(header, header + header_size);
+    msg.insert(msg.end(), body->data(), body->data() + body->size());
+    *copied = msg.size();
+    return Send(&msg[0], msg.size(), id, cb);
+}
 
 namespace xmps {
 
@@ -9,6 +9,7 @@
 #include <boost/system/error_code.hpp>
 #include "xmpp/xmpp_proto.h"
 
+class TcpMessageBuffer;
 class XmppConnection;
 
 namespace xmps {
@@ -39,6 +40,12 @@ public:
 
     virtual ~XmppChannel() { }
     virtual bool Send(const uint8_t *, size_t, xmps::PeerId, SendReadyCb) = 0;
+    // Send a message made of a header and a body, which may be NULL, that
+    // follows it. By default the two are copied into one buffer. The number
+    // of bytes copied is returned in copied, 0 if there is no body.
+    virtual bool SendParts(const uint8_t *header, size_t header_size,
+                           TcpMessageBuffer *body,
+                           xmps::PeerId id, SendReadyCb cb, size_t *copied);
     virtual void RegisterReceive(xmps::PeerId, ReceiveCb) = 0;
     virtual void UnRegisterReceive(xmps::PeerId) = 0;
     virtual std::string ToString() const = 0;
@@ -51,6 +51,21 @@ bool XmppChannelMux::Send(const uint8_t *msg, size_t msgsize,
     return res;
 }
 
+bool XmppChannelMux::SendParts(const uint8_t *header, size_t header_size,
+                               TcpMessageBuffer *body,
+                               xmps::PeerId id, SendReadyCb cb,
+                               size_t *copied) {
+    *copied = 0;
+    if (!connection_) return false;
+
+    tbb::mutex::scoped_lock lock(mutex_);
+    bool res = connection_->SendParts(header, header_size, body, copied);
+    if (res == false) {
+        RegisterWriteReady(id, cb);
+    }
+    return res;
+}
+
 void XmppChannelMux::RegisterReceive(xmps::PeerId id, ReceiveCb cb) {
     rxmap_.insert(make_pair(id, cb));
 }
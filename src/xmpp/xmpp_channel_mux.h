@@ -19,6 +19,9 @@ public:
     virtual ~XmppChannelMux();
 
     virtual bool Send(const uint8_t *, size_t, xmps::PeerId, SendReadyCb);
+    virtual bool SendParts(const uint8_t *header, size_t header_size,
+                           TcpMessageBuffer *body,
+                           xmps::PeerId id, SendReadyCb cb, size_t *copied);
     virtual void RegisterReceive(xmps::PeerId, ReceiveCb);
     virtual void UnRegisterReceive(xmps::PeerId);
     size_t ReceiverCount() const;
@@ -4,6 +4,7 @@
 
 #include "xmpp/xmpp_connection.h"
 
+#include <algorithm>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <sstream>
 
@@ -33,6 +34,9 @@
 using namespace std;
 using boost::system::error_code;
 
+// Bytes of the body of a message sent in parts that are traced
+static const size_t kTraceBodyPrefixSize = 64;
+
 XmppConnection::XmppConnection(TcpServer *server, 
                                const XmppChannelConfig *config)
     : server_(server),
@@ -185,6 +189,28 @@ bool XmppConnection::Send(const uint8_t *data, size_t size) {
     return session_->Send(data, size, &sent);
 }
 
+bool XmppConnection::SendParts(const uint8_t *header, size_t header_size,
+                               TcpMessageBuffer *body, size_t *copied) {
+    size_t sent;
+    *copied = 0;
+    tbb::spin_mutex::scoped_lock lock(spin_mutex_);
+    if (session_ == NULL) {
+        return false;
+    }
+    // The body is shared by all the peers the message is sent to, so only
+    // its start is traced along with the header. The size is the full size.
+    size_t body_size = body ? body->size() : 0;
+    XMPP_MESSAGE_TRACE(XmppTxStream, 
+           session_->remote_endpoint().address().to_string(),
+           session_->remote_endpoint().port(), header_size + body_size,
+           string(reinterpret_cast<const char *>(header), header_size) +
+           (body ? string(reinterpret_cast<const char *>(body->data()),
+                          min(body_size, kTraceBodyPrefixSize)) : string()));
+
+    stats_[1].update++;
+    return session_->SendParts(header, header_size, body, &sent, copied);
+}
+
 void XmppConnection::SendOpen(TcpSession *session) {
     if (!session) return;
     XmppProto::XmppStanza::XmppStreamMessage openstream;
@@ -335,29 +361,32 @@ size_t XmppConnection::get_session_close() {
     return error_stats_.session_close;
 }
 
-void XmppConnection::ReceiveMsg(XmppSession *session, const string &msg) {
-    XmppStanza::XmppMessage *minfo = XmppDecode(msg);
+void XmppConnection::ReceiveMsg(XmppSession *session, const char *data,
+                                size_t size) {
+    XmppStanza::XmppMessage *minfo = XmppDecode(data, size);
 
     if (minfo) {
-        session->IncStats((unsigned int)minfo->type, msg.size());
+        session->IncStats((unsigned int)minfo->type, size);
         if (minfo->type != XmppStanza::WHITESPACE_MESSAGE_STANZA) {
             XMPP_MESSAGE_TRACE(XmppRxStream, 
                   session->remote_endpoint().address().to_string(),
-                  session->remote_endpoint().port(), msg.size(), msg);
+                  session->remote_endpoint().port(), size,
+                  string(data, size));
         }
         IncProtoStats((unsigned int)minfo->type);
         state_machine_->OnMessage(session, minfo);
     } else {
-        session->IncStats(XmppStanza::INVALID, msg.size());
+        session->IncStats(XmppStanza::INVALID, size);
         XMPP_MESSAGE_TRACE(XmppRxStreamInvalid,
              session->remote_endpoint().address().to_string(),
-             session->remote_endpoint().port(), msg.size(), msg);
+             session->remote_endpoint().port(), size, string(data, size));
     }
     return;
 }
 
-XmppStanza::XmppMessage *XmppConnection::XmppDecode(const string &msg) {
-    auto_ptr<XmppStanza::XmppMessage> minfo(XmppProto::Decode(msg));
+XmppStanza::XmppMessage *XmppConnection::XmppDecode(const char *data,
+                                                     size_t size) {
+    auto_ptr<XmppStanza::XmppMessage> minfo(XmppProto::Decode(data, size));
     if (minfo.get() == NULL) {
         Clear();
         return NULL;
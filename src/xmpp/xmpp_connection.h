@@ -51,7 +51,10 @@ public:
 
     // Invoked from XmppServer when a session is accepted.
     virtual bool AcceptSession(XmppSession *session);
-    virtual void ReceiveMsg(XmppSession *session, const std::string &); 
+    // Decodes and processes the stanza in the size bytes at data, which
+    // belong to the session's framing buffer and are not modified.
+    virtual void ReceiveMsg(XmppSession *session, const char *data,
+                            size_t size);
     virtual bool EndpointNameIsUnique() { return true; }
 
     virtual boost::asio::ip::tcp::endpoint endpoint() const;
@@ -66,6 +69,8 @@ public:
     std::string FromString() const;
     void SetAdminDown(bool toggle);
     bool Send(const uint8_t *data, size_t size);
+    bool SendParts(const uint8_t *header, size_t header_size,
+                   TcpMessageBuffer *body, size_t *copied);
 
     // Xmpp connection messages
     virtual void SendOpen(TcpSession *session);
@@ -202,7 +207,7 @@ private:
     bool KeepAliveTimerExpired();
     void KeepaliveTimerErrorHanlder(std::string error_name,
                                     std::string error_message);
-    XmppStanza::XmppMessage *XmppDecode(const std::string &msg);
+    XmppStanza::XmppMessage *XmppDecode(const char *data, size_t size);
     void LogKeepAliveSend();
 
     boost::asio::ip::tcp::endpoint endpoint_;
@@ -3,6 +3,8 @@
  */
 
 #include "xmpp/xmpp_proto.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <boost/algorithm/string/replace.hpp>
@@ -163,13 +165,19 @@ int XmppProto::EncodeOpen(uint8_t *buf, string &to, string &from) {
     return len;
 }
 
-XmppStanza::XmppMessage *XmppProto::Decode(const string &ts) {
+// True if str occurs in the size bytes at data
+static bool StanzaContains(const char *data, size_t size, const char *str) {
+    const char *end = data + size;
+    return (std::search(data, end, str, str + strlen(str)) != end);
+}
+
+XmppStanza::XmppMessage *XmppProto::Decode(const char *data, size_t size) {
     auto_ptr<XmlBase> impl(XmppStanza::AllocXmppXmlImpl());
     if (impl.get() == NULL) {
         return NULL;
     }
 
-    XmppStanza::XmppMessage *msg = DecodeInternal(ts, impl.get());
+    XmppStanza::XmppMessage *msg = DecodeInternal(data, size, impl.get());
     if (!msg) {
         return NULL;
     }
@@ -180,7 +188,8 @@ XmppStanza::XmppMessage *XmppProto::Decode(const string &ts) {
     return msg;
 }
 
-XmppStanza::XmppMessage *XmppProto::DecodeInternal(const string &ts, 
+XmppStanza::XmppMessage *XmppProto::DecodeInternal(const char *data,
+                                                   size_t size,
                                                    XmlBase *impl) {
     XmppStanza::XmppMessage *ret = NULL;
 
@@ -188,10 +197,8 @@ XmppStanza::XmppMessage *XmppProto::DecodeInternal(const string &ts,
     string ws(sXMPP_WHITESPACE);
     string iq(sXMPP_IQ_KEY);
 
-    if (ts.find(sXMPP_IQ) != string::npos) {
-        string ts_tmp = ts;
-
-        if (impl->LoadDoc(ts) == -1) {
+    if (StanzaContains(data, size, sXMPP_IQ)) {
+        if (impl->LoadDocInPlace(data, size) == -1) {
             XMPP_WARNING(XmppIqMessageParseFail);
             assert(false);
             goto done;
@@ -230,9 +237,9 @@ XmppStanza::XmppMessage *XmppProto::DecodeInternal(const string &ts,
                    msg->from, msg->to, msg->id, msg->iq_type);
         goto done;
 
-    } else if (ts.find(sXMPP_MESSAGE) != string::npos) {
+    } else if (StanzaContains(data, size, sXMPP_MESSAGE)) {
 
-        if (impl->LoadDoc(ts) == -1) {
+        if (impl->LoadDocInPlace(data, size) == -1) {
             XMPP_WARNING(XmppChatMessageParseFail);
             goto done;
         }
@@ -247,10 +254,10 @@ XmppStanza::XmppMessage *XmppProto::DecodeInternal(const string &ts,
         XMPP_UTDEBUG(XmppChatMessageProcess, msg->type, msg->from, msg->to);
         goto done;
 
-    } else if (ts.find(sXMPP_STREAM_O) != string::npos) {
+    } else if (StanzaContains(data, size, sXMPP_STREAM_O)) {
 
         // ensusre stream open is at the beginning of the message
-        string ts_tmp = ts;
+        string ts_tmp(data, size);
         ts_tmp.erase(std::remove(ts_tmp.begin(), ts_tmp.end(), '\n'), ts_tmp.end());
 
         if ((ts_tmp.compare(0, strlen(sXMPP_STREAM_START), 
@@ -281,7 +288,8 @@ XmppStanza::XmppMessage *XmppProto::DecodeInternal(const string &ts,
 
         XMPP_UTDEBUG(XmppRxOpenMessage, strm->from, strm->to);
 
-    } else if (ts.find_first_of(sXMPP_VALIDWS) != string::npos) {
+    } else if (std::find_first_of(data, data + size, sXMPP_VALIDWS,
+                   sXMPP_VALIDWS + strlen(sXMPP_VALIDWS)) != data + size) {
 
         XmppStanza::XmppMessage *msg = 
             new XmppStanza::XmppMessage(WHITESPACE_MESSAGE_STANZA);
@@ -162,7 +162,9 @@ private:
 class XmppProto : public XmppStanza {
 public:
 
-    static XmppStanza::XmppMessage *Decode(const std::string &ts);
+    // Decodes the stanza in the size bytes at data. Documents are parsed
+    // in place from a copy they own, data is left unmodified.
+    static XmppStanza::XmppMessage *Decode(const char *data, size_t size);
     static int EncodeStream(const XmppStreamMessage &str, std::string &to, 
                             std::string &from, uint8_t *data, size_t size);
     static int EncodeStream(const XmppMessage &str, uint8_t *data, size_t size);
@@ -188,8 +190,9 @@ private:
     static const char *GetAsNode(XmlBase *doc);
     static const char *GetDsNode(XmlBase *doc);
 
-    static XmppStanza::XmppMessage *DecodeInternal(const std::string &ts,
-                                                   XmlBase *impl); 
+    static XmppStanza::XmppMessage *DecodeInternal(const char *data,
+                                                   size_t size,
+                                                   XmlBase *impl);
 
     static std::auto_ptr<XmlBase> open_doc_;
 
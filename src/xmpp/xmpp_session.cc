@@ -66,15 +66,27 @@ boost::regex XmppSession::tag_to_pattern(const char *tag) {
 }
 
 void XmppSession::SetBuf(const std::string &str) {
+    AppendBuf(str.data(), str.size());
+}
+
+void XmppSession::AppendBuf(const char *data, size_t size) {
     if (buf_.empty()) {
-        ReplaceBuf(str);
+        buf_.reserve(kMaxMessageSize+8);
+        buf_.assign(data, size);
+        offset_ = buf_.begin();
     } else {
         int pos = offset_ - buf_.begin();
-        buf_ += str;
+        buf_.append(data, size);
         offset_ = buf_.begin() + pos;
     }
 }
 
+// Drop the messages already processed from the start of the buffer.
+void XmppSession::ConsumeBuf() {
+    buf_.erase(0, offset_ - buf_.begin());
+    offset_ = buf_.begin();
+}
+
 void XmppSession::ReplaceBuf(const std::string &str) {
     buf_ = str;
     buf_.reserve(kMaxMessageSize+8);
@@ -119,9 +131,7 @@ bool XmppSession::Match(Buffer buffer, int *result, bool NewBuf) {
 
     if (NewBuf) {
         const uint8_t *cp = BufferData(buffer);
-        // TODO Avoid this copy
-        std::string str(cp, cp + BufferSize(buffer));
-        XmppSession::SetBuf(str);
+        AppendBuf(reinterpret_cast<const char *>(cp), BufferSize(buffer));
     }
 
     int m;
@@ -189,15 +199,14 @@ void XmppSession::OnRead(Buffer buffer) {
                 // TODO generate error, close connection.
                 break;
             }
-            // We got good match. Process the message
-            std::string::const_iterator st = buf_.begin();
-            std::string xml = string(st, offset_);
-
+            // We got good match. Process the message at the start of the
+            // buffer, the decoder copies out what it keeps
             //
             // XXX Connection gone ?
             //
             if (!connection_) break;
-            connection_->ReceiveMsg(this, xml);
+            connection_->ReceiveMsg(this, buf_.data(),
+                                    offset_ - buf_.begin());
 
         } else {
             // Read more data. Either we have partial match
@@ -207,8 +216,7 @@ void XmppSession::OnRead(Buffer buffer) {
         }
 
         if (LeftOver()) {
-            std::string::const_iterator st = buf_.end();
-            ReplaceBuf(string(offset_, st));
+            ConsumeBuf();
             more = Match(buffer, &result, false);
         } else {
             // No more data in the Buffer
@@ -47,6 +47,8 @@ private:
     int MatchRegex(const boost::regex &patt);
     bool Match(Buffer buffer, int *result, bool NewBuf);
     void SetBuf(const std::string &);
+    void AppendBuf(const char *data, size_t size);
+    void ConsumeBuf();
     void ReplaceBuf(const std::string &);
     bool LeftOver() const;
 